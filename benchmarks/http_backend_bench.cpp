@@ -0,0 +1,163 @@
+// End-to-end request throughput of the epoll and io_uring event loop
+// backends.
+//
+// Each run starts an HttpServer on a loopback port and drives it from
+// client threads that each hold one keep-alive connection, sending
+// GET /api/status either one request at a time or in pipelined batches.
+// Reports requests/second per backend.
+
+#include "web/http_server.h"
+#include "utils/logger.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace AITextAssistant;
+
+namespace {
+
+int connectToPort(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Count complete responses in `data` by their head terminator and
+// Content-Length, consuming them; returns how many were removed
+size_t consumeResponses(std::string& data) {
+    size_t count = 0;
+    size_t offset = 0;
+    while (true) {
+        size_t header_end = data.find("\r\n\r\n", offset);
+        if (header_end == std::string::npos) {
+            break;
+        }
+        size_t pos = data.find("Content-Length: ", offset);
+        size_t length = pos != std::string::npos && pos < header_end ? std::stoul(data.substr(pos + 16, 20)) : 0;
+        if (data.size() < header_end + 4 + length) {
+            break;
+        }
+        offset = header_end + 4 + length;
+        ++count;
+    }
+    data.erase(0, offset);
+    return count;
+}
+
+// One client: keep `depth` requests outstanding until `stop` is set
+void runClient(int port, size_t depth, const std::atomic<bool>& stop, std::atomic<size_t>& completed) {
+    int fd = connectToPort(port);
+    if (fd < 0) {
+        return;
+    }
+
+    std::string batch;
+    for (size_t i = 0; i < depth; ++i) {
+        batch += "GET /api/status HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    }
+
+    std::string pending;
+    char buffer[16384];
+    size_t local = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (send(fd, batch.data(), batch.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(batch.size())) {
+            break;
+        }
+        size_t received = 0;
+        while (received < depth) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                close(fd);
+                completed += local;
+                return;
+            }
+            pending.append(buffer, static_cast<size_t>(n));
+            received += consumeResponses(pending);
+        }
+        local += received;
+    }
+
+    close(fd);
+    completed += local;
+}
+
+double measureBackend(const std::string& backend, size_t clients, size_t depth, std::chrono::milliseconds duration) {
+    ServerConfig config;
+    config.io_backend = backend;
+    config.io_threads = 2;
+    config.worker_threads = 4;
+    config.max_requests_per_connection = 0;
+    config.pin_io_threads = false;
+
+    HttpServer server(0, config);
+    if (!server.start()) {
+        return 0;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> completed(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < clients; ++i) {
+        threads.emplace_back(runClient, server.getPort(), depth, std::cref(stop), std::ref(completed));
+    }
+
+    // Let connections settle before counting
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    size_t start_count = completed.load();
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    server.stop();
+    return (completed.load() - start_count) / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    Logger::getInstance().setLogLevel(LogLevel::ERROR);
+
+    struct Workload {
+        const char* name;
+        size_t clients;
+        size_t depth;
+    };
+    const Workload workloads[] = {
+        {"keep-alive, 8 clients", 8, 1},
+        {"keep-alive, 32 clients", 32, 1},
+        {"pipelined x16, 8 clients", 8, 16},
+    };
+
+    const std::chrono::milliseconds duration(2000);
+
+    std::printf("GET /api/status throughput (2 event loops)\n");
+    for (const auto& workload : workloads) {
+        double epoll_rate = measureBackend("epoll", workload.clients, workload.depth, duration);
+        double uring_rate = measureBackend("io_uring", workload.clients, workload.depth, duration);
+        std::printf("%-26s epoll %9.0f req/s  io_uring %9.0f req/s  ratio %.2fx\n",
+                    workload.name, epoll_rate, uring_rate, epoll_rate > 0 ? uring_rate / epoll_rate : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Parse throughput: incremental HttpRequestParser versus the previous
+// recv-loop + istringstream implementation.
+//
+// Each workload feeds a request to both parsers in recv-sized chunks, the
+// way bytes arrive from the socket, and measures complete requests/second.
+
+#include "web/http_parser.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace AITextAssistant;
+
+namespace {
+
+// --- Previous implementation (HttpServer::handleClient + parseRequest) ---
+
+struct LegacyHttpRequest {
+    std::string method;
+    std::string path;
+    std::string body;
+    std::map<std::string, std::string> headers;
+};
+
+bool legacyIsComplete(const std::string& request_data) {
+    size_t header_end = request_data.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return false;
+    }
+    size_t content_length = 0;
+    size_t content_length_pos = request_data.find("Content-Length:");
+    if (content_length_pos != std::string::npos) {
+        size_t value_start = request_data.find(":", content_length_pos) + 1;
+        size_t value_end = request_data.find("\r\n", value_start);
+        std::string length_str = request_data.substr(value_start, value_end - value_start);
+        length_str.erase(0, length_str.find_first_not_of(" \t"));
+        length_str.erase(length_str.find_last_not_of(" \t") + 1);
+        content_length = std::stoul(length_str);
+    }
+    return request_data.length() - (header_end + 4) >= content_length;
+}
+
+LegacyHttpRequest legacyParseRequest(const std::string& request_data) {
+    LegacyHttpRequest request;
+    std::istringstream stream(request_data);
+    std::string line;
+
+    if (std::getline(stream, line)) {
+        std::istringstream line_stream(line);
+        std::string path_with_query;
+        line_stream >> request.method >> path_with_query;
+        if (size_t query_pos = path_with_query.find('?'); query_pos != std::string::npos) {
+            request.path = path_with_query.substr(0, query_pos);
+        } else {
+            request.path = path_with_query;
+        }
+    }
+
+    while (std::getline(stream, line) && line != "\r") {
+        if (size_t colon_pos = line.find(':'); colon_pos != std::string::npos) {
+            std::string key = line.substr(0, colon_pos);
+            std::string value = line.substr(colon_pos + 1);
+            value.erase(0, value.find_first_not_of(" \t"));
+            value.erase(value.find_last_not_of(" \t\r") + 1);
+            request.headers[key] = value;
+        }
+    }
+
+    std::string body;
+    while (std::getline(stream, line)) {
+        body += line + "\n";
+    }
+    if (!body.empty()) {
+        body.pop_back();
+    }
+    request.body = body;
+    return request;
+}
+
+size_t runLegacy(const std::vector<std::string>& chunks) {
+    std::string request_data;
+    for (const auto& chunk : chunks) {
+        // The old loop NUL-terminated a char buffer and appended std::string(buffer)
+        request_data += std::string(chunk.c_str());
+        if (legacyIsComplete(request_data)) {
+            break;
+        }
+    }
+    LegacyHttpRequest request = legacyParseRequest(request_data);
+    return request.body.size() + request.headers.size();
+}
+
+// --- Current implementation ---
+
+size_t runIncremental(const std::vector<std::string>& chunks) {
+    HttpRequestParser parser;
+    std::string buffer;
+    for (const auto& chunk : chunks) {
+        buffer.append(chunk);
+        if (parser.parse(buffer) != HttpRequestParser::Result::INCOMPLETE) {
+            break;
+        }
+    }
+    auto storage = std::make_shared<std::string>(std::move(buffer));
+    HttpRequest request;
+    parser.buildRequest(storage, request);
+    return request.body.size() + request.headers.size();
+}
+
+// ---
+
+std::vector<std::string> splitIntoChunks(const std::string& data, size_t chunk_size) {
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < data.size(); i += chunk_size) {
+        chunks.push_back(data.substr(i, chunk_size));
+    }
+    return chunks;
+}
+
+template <typename Fn>
+double measure(Fn fn, const std::vector<std::string>& chunks, size_t iterations, size_t& sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink += fn(chunks);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return iterations / elapsed.count();
+}
+
+void runWorkload(const char* name, const std::string& request, size_t chunk_size, size_t iterations) {
+    auto chunks = splitIntoChunks(request, chunk_size);
+    size_t sink = 0;
+
+    // Warm-up
+    measure(runLegacy, chunks, iterations / 10, sink);
+    measure(runIncremental, chunks, iterations / 10, sink);
+
+    double legacy = measure(runLegacy, chunks, iterations, sink);
+    double incremental = measure(runIncremental, chunks, iterations, sink);
+    double mb = request.size() / (1024.0 * 1024.0);
+
+    std::printf("%-28s %8zu B  %3zu chunk(s)  legacy %10.0f req/s (%7.1f MB/s)  "
+                "incremental %10.0f req/s (%7.1f MB/s)  speedup %.2fx  [%zu]\n",
+                name, request.size(), chunks.size(),
+                legacy, legacy * mb, incremental, incremental * mb,
+                incremental / legacy, sink % 10);
+}
+
+} // namespace
+
+int main() {
+    std::string small_get =
+        "GET /api/conversations/messages?conversation_id=7f3a9c HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 Chrome/126.0 Safari/537.36\r\n"
+        "Accept: application/json, text/plain, */*\r\n"
+        "Accept-Language: en-US,en;q=0.9\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Referer: http://localhost:3001/enhanced-chat.html\r\n"
+        "Connection: keep-alive\r\n\r\n";
+
+    std::string chat_body = "{\"message\":\"" + std::string(2000, 'x') + "\",\"conversation_id\":\"7f3a9c\"}";
+    std::string chat_post =
+        "POST /api/chat HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: " + std::to_string(chat_body.size()) + "\r\n\r\n" + chat_body;
+
+    std::string large_body = "{\"messages\":[" ;
+    for (int i = 0; i < 400; ++i) {
+        large_body += "{\"role\":\"user\",\"content\":\"line " + std::to_string(i) + "\\nmore text here\"},\n";
+    }
+    large_body += "{}]}";
+    std::string large_post =
+        "POST /v1/chat/completions HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: " + std::to_string(large_body.size()) + "\r\n\r\n" + large_body;
+
+    std::printf("HTTP request parse throughput\n");
+    runWorkload("small GET", small_get, 4096, 200000);
+    runWorkload("chat POST (2 KB body)", chat_post, 4096, 100000);
+    runWorkload("completions POST (4 KB recv)", large_post, 4096, 5000);
+    runWorkload("completions POST (1 KB recv)", large_post, 1024, 5000);
+    return 0;
+}
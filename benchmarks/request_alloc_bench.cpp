@@ -0,0 +1,165 @@
+// Heap allocations per request on the server side.
+//
+// Replaces the global operator new with a counting one, starts an
+// HttpServer on a loopback port and sends sequential keep-alive requests
+// from one client thread whose own allocations are not counted. Reports
+// the server's allocations (event loop, worker and handler) per request.
+
+#include "web/http_server.h"
+#include "utils/logger.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::atomic<size_t> g_allocations(0);
+thread_local bool t_uncounted = false;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (!t_uncounted) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+using namespace AITextAssistant;
+
+namespace {
+
+int connectToPort(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Read one response with a Content-Length body into `buffer`
+bool readResponse(int fd, char* buffer, size_t capacity) {
+    size_t received = 0;
+    while (received < capacity) {
+        ssize_t n = recv(fd, buffer + received, capacity - received, 0);
+        if (n <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(n);
+        const char* end = static_cast<const char*>(memmem(buffer, received, "\r\n\r\n", 4));
+        const char* length = static_cast<const char*>(memmem(buffer, received, "Content-Length: ", 16));
+        if (end && length && length < end) {
+            size_t body = std::strtoul(length + 16, nullptr, 10);
+            if (received >= static_cast<size_t>(end - buffer) + 4 + body) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Server allocations per request over `count` requests
+double measure(int port, const std::string& request, size_t count) {
+    double result = -1;
+    std::thread client([&]() {
+        t_uncounted = true;
+        int fd = connectToPort(port);
+        if (fd < 0) {
+            return;
+        }
+        char buffer[65536];
+        auto run = [&](size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()) ||
+                    !readResponse(fd, buffer, sizeof(buffer))) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        // Warm caches, pools and buffers first
+        if (!run(200)) {
+            close(fd);
+            return;
+        }
+        size_t before = g_allocations.load();
+        if (run(count)) {
+            result = static_cast<double>(g_allocations.load() - before) / static_cast<double>(count);
+        }
+        close(fd);
+    });
+    client.join();
+    return result;
+}
+
+} // namespace
+
+int main() {
+    Logger::getInstance().setLogLevel(LogLevel::ERROR);
+
+    ServerConfig config;
+    config.io_threads = 1;
+    config.worker_threads = 1;
+    config.max_requests_per_connection = 0;
+    config.pin_io_threads = false;
+
+    HttpServer server(0, config);
+    // Stands in for a handler that reads query parameters
+    server.addRoute("GET", "/api/echo", [](const HttpRequest& request) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/plain";
+        response.body = std::string(request.query_params.get("conversation_id"));
+        return response;
+    });
+    if (!server.start()) {
+        std::fprintf(stderr, "Failed to start server\n");
+        return 1;
+    }
+
+    struct Workload {
+        const char* name;
+        std::string request;
+    };
+    const Workload workloads[] = {
+        {"GET /api/status", "GET /api/status HTTP/1.1\r\nHost: localhost\r\n\r\n"},
+        {"GET /api/echo?<3 params>",
+         "GET /api/echo?conversation_id=0f3c2a91-7d4e-4b8a-9c1d-2e5f6a7b8c9d&limit=50&title=Weekly%20planning%20notes "
+         "HTTP/1.1\r\nHost: localhost\r\nUser-Agent: bench\r\nAccept: */*\r\nAccept-Encoding: gzip\r\n\r\n"},
+    };
+
+    const size_t count = 5000;
+    std::printf("Server heap allocations per request (%zu sequential keep-alive requests)\n", count);
+    for (const auto& workload : workloads) {
+        std::printf("%-28s %6.1f\n", workload.name, measure(server.getPort(), workload.request, count));
+    }
+
+    server.stop();
+    return 0;
+}
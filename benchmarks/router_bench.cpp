@@ -0,0 +1,119 @@
+// Route lookup cost: segment-trie Router versus the previous
+// std::map<"METHOD path", handler> lookup.
+//
+// Both tables hold the server's default routes. Each workload resolves the
+// same request line repeatedly and reports lookups/second.
+
+#include "web/router.h"
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace AITextAssistant;
+
+namespace {
+
+struct Route {
+    const char* method;
+    const char* path;
+};
+
+const std::vector<Route> kRoutes = {
+    {"POST", "/api/chat"},
+    {"GET", "/api/conversations"},
+    {"GET", "/api/conversations/messages"},
+    {"DELETE", "/api/conversations"},
+    {"GET", "/api/conversations/{id}/messages"},
+    {"DELETE", "/api/conversations/{id}"},
+    {"GET", "/api/status"},
+    {"POST", "/v1/chat/completions"},
+    {"GET", "/v1/models"},
+    {"OPTIONS", "/api/chat"},
+    {"OPTIONS", "/api/conversations"},
+    {"OPTIONS", "/api/conversations/{id}"},
+    {"OPTIONS", "/api/conversations/{id}/messages"},
+    {"OPTIONS", "/v1/chat/completions"},
+    {"OPTIONS", "/v1/models"},
+};
+
+HttpResponse emptyHandler(const HttpRequest&) {
+    return HttpResponse();
+}
+
+// --- Previous implementation (HttpServer::handleRequest) ---
+
+size_t lookupMap(const std::map<std::string, HttpHandler>& routes, std::string_view method, std::string_view path) {
+    std::string route_key;
+    route_key.reserve(method.size() + 1 + path.size());
+    route_key.append(method).append(" ").append(path);
+    return routes.find(route_key) != routes.end() ? 1 : 0;
+}
+
+// --- Current implementation ---
+
+// `params` lives in the HttpRequest, so it is reused rather than rebuilt
+size_t lookupRouter(const Router& router, std::string_view method, std::string_view path, PathParams& params) {
+    const auto* route = router.match(method, path, params);
+    return route ? 1 + params.count : 0;
+}
+
+// ---
+
+template <typename Fn>
+double measure(Fn fn, size_t iterations, size_t& sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink += fn();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return iterations / elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    std::map<std::string, HttpHandler> routes;
+    Router router;
+    for (const auto& route : kRoutes) {
+        routes[std::string(route.method) + " " + route.path] = emptyHandler;
+        router.add(route.method, route.path, emptyHandler);
+    }
+
+    struct Workload {
+        const char* name;
+        const char* method;
+        const char* path;
+    };
+    const Workload workloads[] = {
+        {"short literal", "GET", "/api/status"},
+        {"long literal", "GET", "/api/conversations/messages"},
+        {"completions", "POST", "/v1/chat/completions"},
+        {"miss (static file)", "GET", "/assets/js/enhanced-chat.min.js"},
+        {"path parameter", "GET", "/api/conversations/7f3a9c1e-2b4d/messages"},
+    };
+
+    const size_t iterations = 5000000;
+    size_t sink = 0;
+    PathParams params;
+
+    std::printf("Route lookup throughput (%zu routes)\n", kRoutes.size());
+    for (const auto& workload : workloads) {
+        auto map_lookup = [&]() { return lookupMap(routes, workload.method, workload.path); };
+        auto trie_lookup = [&]() { return lookupRouter(router, workload.method, workload.path, params); };
+
+        // Warm-up
+        measure(map_lookup, iterations / 10, sink);
+        measure(trie_lookup, iterations / 10, sink);
+
+        double map_rate = measure(map_lookup, iterations, sink);
+        double trie_rate = measure(trie_lookup, iterations, sink);
+
+        // The map can only match parameterised paths by building a key per
+        // candidate pattern, so it reports a miss there
+        std::printf("%-22s map %7.1f M/s  router %7.1f M/s  speedup %.2fx  [%zu]\n",
+                    workload.name, map_rate / 1e6, trie_rate / 1e6, trie_rate / map_rate, sink % 10);
+    }
+    return 0;
+}
@@ -60,10 +60,31 @@ struct PromptConfig {
     int max_history_messages = 10;
 };
 
+// HTTP Server Configuration
+struct ServerConfig {
+    int io_threads = 0;            // 0 = one event loop per core
+    int worker_threads = 8;        // route handler threads
+    int max_queue_size = 256;      // pending requests before 503
+    int retry_after_seconds = 1;   // Retry-After sent with 503
+    int keep_alive_timeout_seconds = 5;     // idle connections (no request byte yet) are closed after this
+    int max_requests_per_connection = 100;  // 0 = unlimited
+    int sendfile_threshold_bytes = 1048576; // larger static files go out via sendfile(), uncached
+    int compression_min_bytes = 1024;       // compress API responses at least this large; 0 disables
+    bool pin_io_threads = true;             // pin each event loop thread to its own core
+    int listen_backlog = 1024;              // accept queue length of each listening socket
+    std::string io_backend = "epoll";       // "epoll" or "io_uring" (falls back to epoll if unavailable)
+    int header_timeout_seconds = 10;        // first request byte to end of headers
+    int body_timeout_seconds = 30;          // end of headers to end of body; per stall when streamed
+    int max_header_bytes = 8192;            // request line and headers; larger gets 431
+    int max_body_bytes = 1048576;           // request body read whole; larger gets 413
+    int max_streamed_body_bytes = 67108864; // request body streamed to the handler
+};
+
 // Application Configuration
 struct AppConfig {
     LLMConfig llm;
     PromptConfig prompt;
+    ServerConfig server;
     std::string database_path;
     std::string log_level = "INFO";
     bool enable_voice = true;
@@ -76,6 +97,7 @@ struct LLMResponse {
     std::string content;
     std::string error_message;
     int status_code = 0;
+    bool cancelled = false; // a stream the caller stopped; content is what it received
     std::map<std::string, std::string> metadata;
 };
 
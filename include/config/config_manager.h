@@ -40,6 +40,7 @@ public:
     const AppConfig& getAppConfig() const { return app_config_; }
     const LLMConfig& getLLMConfig() const { return app_config_.llm; }
     const PromptConfig& getPromptConfig() const { return app_config_.prompt; }
+    const ServerConfig& getServerConfig() const { return app_config_.server; }
     
     // Setters
     void setLLMConfig(const LLMConfig& config);
@@ -68,10 +69,12 @@ private:
     // Validation helpers
     bool validateLLMConfig(const LLMConfig& config) const;
     bool validatePromptConfig(const PromptConfig& config) const;
+    bool validateServerConfig(const ServerConfig& config) const;
     
     // Default configurations
     void setDefaultLLMConfig();
     void setDefaultPromptConfig();
+    void setDefaultServerConfig();
 
     static constexpr double MIN_TEMPERATURE = 0.0;
     static constexpr double MAX_TEMPERATURE = 2.0;
@@ -4,12 +4,18 @@
 #include "config/config_manager.h"
 #include "llm/llm_client.h"
 #include "database/conversation_db.h"
+#include "core/conversation_registry.h"
+#include "utils/task.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 #include <functional>
 #include <atomic>
 #include <mutex>
+#include <optional>
+#include <stdexcept>
 
 namespace AITextAssistant {
 
@@ -35,6 +41,15 @@ struct AssistantConfig {
     bool auto_save_conversations = true;
     double response_timeout = 30.0; // seconds
     int max_conversation_history = 20;
+    int max_pending_messages = 8; // per conversation, counting the one being answered
+};
+
+// Thrown when a conversation already has max_pending_messages waiting
+// for a reply
+class ConversationBusyError : public std::runtime_error {
+public:
+    explicit ConversationBusyError(const ConversationId& conversation_id)
+        : std::runtime_error("Conversation has too many pending messages: " + conversation_id) {}
 };
 
 class TextAssistant {
@@ -51,18 +66,54 @@ public:
     bool saveConfig(const std::string& config_file = "") const;
     void setAssistantConfig(const AssistantConfig& config) { assistant_config_ = config; }
     const AssistantConfig& getAssistantConfig() const { return assistant_config_; }
-    
-    // Conversation management
-    std::string startNewConversation(const std::string& title = "");
-    bool loadConversation(const ConversationId& conversation_id);
-    bool saveCurrentConversation();
+    ServerConfig getServerConfig() const;
+    
+    // Conversation management. Each conversation has its own state and
+    // lock, so requests for different conversations never wait for each
+    // other; the handles are shared with the registry.
+    ConversationHandle startNewConversation(const std::string& title = "");
+    // The conversation, loaded from the database unless it is in memory;
+    // nullptr when it does not exist
+    ConversationHandle openConversation(const ConversationId& conversation_id);
+    bool saveConversation(const ConversationHandle& conversation);
+    // Coroutine forms of the above; the database work runs on the
+    // assistant's conversation executor and the awaiter continues there.
+    // The database calls are synchronous, so they block an executor
+    // thread meanwhile, but not the caller's.
+    Task<ConversationHandle> startNewConversationTask(std::string title = "");
+    Task<ConversationHandle> openConversationTask(ConversationId conversation_id);
+    // Stored conversation with all its messages, read from the database
+    std::optional<Conversation> getConversation(const ConversationId& conversation_id);
     std::vector<Conversation> getRecentConversations(int limit = 10);
     bool deleteConversation(const ConversationId& conversation_id);
     
-    // Text-based interaction
-    std::string processTextInput(const std::string& input);
-    std::string getCurrentConversationId() const { return current_conversation_id_; }
-    std::vector<Message> getCurrentConversationHistory() const;
+    // Text-based interaction within `conversation`. Messages to one
+    // conversation are answered one at a time, in arrival order; all
+    // forms throw ConversationBusyError when its mailbox is full.
+    std::string processTextInput(const ConversationHandle& conversation, const std::string& input);
+    // Same as processTextInput, but on_token receives the reply piece by
+    // piece while the LLM generates it; returning false stops the
+    // generation, and the return value is then what on_token received.
+    // Such a cancelled reply is not stored. Fallback replies are only
+    // returned.
+    std::string processTextInputStream(const ConversationHandle& conversation, const std::string& input,
+                                       LLMClient::DeltaCallback on_token);
+    // Same as processTextInput as a coroutine: the message waits its turn
+    // without holding a thread and the LLM request is awaited. History and
+    // database work run on the conversation executor, blocking one of its
+    // threads while the database answers; the awaiter continues there.
+    Task<std::string> processTextInputTask(ConversationHandle conversation, std::string input);
+    // Same as processTextInputStream as a coroutine. on_token is called on
+    // the LLM client's transfer thread, so it must not block.
+    Task<std::string> processTextInputStreamTask(ConversationHandle conversation, std::string input,
+                                                 LLMClient::DeltaCallback on_token);
+    // Starts processTextInputTask; on_done receives the reply where it
+    // ends, and is not called if the task throws
+    void processTextInputAsync(const ConversationHandle& conversation, const std::string& input,
+                               std::function<void(const std::string&)> on_done);
+    std::vector<Message> getConversationHistory(const ConversationHandle& conversation) const;
+    // Messages waiting for or getting a reply; 0 when not in memory
+    size_t getPendingMessageCount(const ConversationId& conversation_id) const;
     
 
     
@@ -77,7 +128,7 @@ public:
     bool setLLMProvider(const LLMConfig& config);
     
     // Utility methods
-    void clearConversationHistory();
+    void clearConversationHistory(const ConversationHandle& conversation);
     std::string getSystemInfo() const;
     bool testConnections();
     
@@ -95,16 +146,19 @@ private:
     std::unique_ptr<ConfigManager> config_manager_;
     std::unique_ptr<LLMClient> llm_client_;
     std::unique_ptr<ConversationDB> database_;
+    // Threads the coroutine APIs hop to for history and database work,
+    // shared by every conversation's mailbox, so turns of different
+    // conversations use database_ at the same time. The destructor drains
+    // it, so it must not run on one of these threads.
+    std::unique_ptr<ThreadPool> conversation_executor_;
     
     // State
     std::atomic<bool> initialized_;
     std::atomic<AssistantState> current_state_;
     AssistantConfig assistant_config_;
     
-    // Current conversation
-    ConversationId current_conversation_id_;
-    std::vector<Message> conversation_history_;
-    mutable std::mutex conversation_mutex_;
+    // Conversations in memory
+    ConversationRegistry conversations_;
     
     // Event handling
     AssistantEventCallback event_callback_;
@@ -116,11 +170,23 @@ private:
     void initializeComponents();
     bool validateConfiguration();
     
-    // Message processing
-    std::string generateResponse(const std::string& user_input);
-    std::string buildPromptWithContext(const std::string& user_input);
-    void addMessageToHistory(const Message& message);
-    void trimConversationHistory();
+    size_t maxPendingMessages() const { return static_cast<size_t>(std::max(1, assistant_config_.max_pending_messages)); }
+
+    // Message processing. A turn adds the user message and copies the
+    // LLM request under the conversation's mutex, calls the LLM with no
+    // lock held, then stores the reply if the conversation was not cleared
+    // in between.
+    struct TurnSnapshot {
+        std::vector<Message> messages; // request for the LLM
+        uint64_t version = 0;          // conversation version after the user message
+    };
+    TurnSnapshot beginTurn(ConversationState& conversation, const std::string& user_input);
+    std::vector<Message> buildLLMMessages(const std::vector<Message>& history, const std::string& user_input);
+    static std::string replyFromLLMResponse(const LLMResponse& response);
+    void completeTextInput(ConversationState& conversation, const std::string& response, uint64_t snapshot_version);
+    // The caller holds the conversation's mutex
+    void addMessageToHistory(ConversationState& conversation, const Message& message);
+    void trimConversationHistory(std::vector<Message>& history);
     
     // Event handling
     void fireEvent(AssistantEvent event, const std::string& data = "");
@@ -132,7 +198,7 @@ private:
     
     // Utility
     std::string generateConversationTitle(const std::string& first_message);
-    bool updateConversationInDatabase();
+    bool updateConversationInDatabase(ConversationState& conversation);
 };
 
 } // namespace AITextAssistant
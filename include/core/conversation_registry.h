@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common/types.h"
+#include "utils/mailbox.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace AITextAssistant {
+
+// In-memory state of one conversation. Every request for the conversation
+// works on the same instance through a ConversationHandle; `mutex` guards
+// the fields below it.
+struct ConversationState {
+    explicit ConversationState(ConversationId conversation_id, size_t max_pending = Mailbox::DEFAULT_CAPACITY)
+        : id(std::move(conversation_id)), mailbox(max_pending) {}
+
+    const ConversationId id; // empty for a conversation that is never stored
+    Mailbox mailbox;         // messages are answered one at a time, in order
+
+    mutable std::mutex mutex;
+    std::vector<Message> history;
+    uint64_t version = 0;         // bumped by every change to history
+    uint64_t cleared_version = 0; // version at which history was last cleared
+    bool deleted = false;         // removed from the database; store nothing more
+};
+
+using ConversationHandle = std::shared_ptr<ConversationState>;
+
+// Conversations held in memory, keyed by id. The map is split into
+// SHARD_COUNT independently locked shards, so requests for different
+// conversations rarely touch the same lock, and a shard lock is only held
+// for the map operation itself.
+class ConversationRegistry {
+public:
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+    // Past about `capacity` conversations, a shard drops the ones no
+    // handle refers to any more before it takes a new one; they are
+    // loaded from the database again when next opened
+    explicit ConversationRegistry(size_t capacity = DEFAULT_CAPACITY);
+    ConversationRegistry(const ConversationRegistry&) = delete;
+    ConversationRegistry& operator=(const ConversationRegistry&) = delete;
+
+    // nullptr when the conversation is not in memory
+    ConversationHandle find(const ConversationId& id) const;
+    // Adds `state`; if a state with its id was added first, that one is
+    // kept and returned instead
+    ConversationHandle insert(ConversationHandle state);
+    // The removed state; nullptr when absent
+    ConversationHandle remove(const ConversationId& id);
+
+    size_t size() const;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<ConversationId, ConversationHandle> conversations;
+    };
+
+    Shard& shardFor(const ConversationId& id);
+    const Shard& shardFor(const ConversationId& id) const;
+
+    size_t shard_capacity_;
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+} // namespace AITextAssistant
@@ -6,9 +6,12 @@
 #include <vector>
 #include <memory>
 #include <optional>
+#include <mutex>
 
 namespace AITextAssistant {
 
+// Safe to call from several threads: public methods run one at a time on
+// the shared sqlite handle.
 class ConversationDB {
 public:
     explicit ConversationDB(const std::string& db_path);
@@ -57,6 +60,7 @@ private:
     sqlite3* db_;
     std::string db_path_;
     bool in_transaction_;
+    mutable std::recursive_mutex mutex_; // public methods may call each other
     
     // Database schema creation
     bool createTables();
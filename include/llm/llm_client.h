@@ -1,10 +1,15 @@
 #pragma once
 
 #include "common/types.h"
+#include "llm/sse_parser.h"
+#include "utils/task.h"
 #include <curl/curl.h>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <functional>
 
 namespace AITextAssistant {
@@ -18,7 +23,9 @@ struct HTTPResponse {
     std::string error_message;
 };
 
-// HTTP Client for API calls
+// HTTP Client for API calls. Safe to share between threads: each request
+// takes an easy handle of its own, and finished handles are kept, with
+// their connections, for later requests.
 class HTTPClient {
 public:
     HTTPClient();
@@ -30,19 +37,96 @@ public:
     
     HTTPResponse get(const std::string& url,
                     const std::map<std::string, std::string>& headers = {});
+
+    // Receives body bytes as they arrive; return false to abort the transfer
+    using DataCallback = std::function<bool(const char* data, size_t length)>;
+
+    // POST whose 2xx body is delivered through on_data instead of being
+    // collected; error bodies are still returned in HTTPResponse::body
+    HTTPResponse postStream(const std::string& url,
+                           const std::string& data,
+                           const std::map<std::string, std::string>& headers,
+                           DataCallback on_data);
     
     void setTimeout(long timeout_seconds);
     void setUserAgent(const std::string& user_agent);
 
 private:
-    CURL* curl_;
+    friend class AsyncHTTPClient;
+
+    static constexpr size_t MAX_IDLE_HANDLES = 8;
+
+    // A handle set up with the common options; nullptr if curl fails
+    CURL* acquireHandle();
+    // Makes a handle from acquireHandle() available to the next request
+    void releaseHandle(CURL* curl);
+
+    std::mutex mutex_;
+    std::vector<CURL*> idle_handles_;
+    long timeout_seconds_ = 30;
+    std::string user_agent_ = "AITextAssistant/1.0";
+
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
     static size_t HeaderCallback(void* contents, size_t size, size_t nmemb, std::map<std::string, std::string>* userp);
+    struct StreamContext;
+    static size_t StreamWriteCallback(void* contents, size_t size, size_t nmemb, StreamContext* context);
     
-    void setupCommonOptions();
+    void setupCommonOptions(CURL* curl);
     struct curl_slist* buildHeaders(const std::map<std::string, std::string>& headers);
 };
 
+// HTTP client whose requests complete through callbacks. One background
+// thread drives every transfer with curl's multi interface, so any number
+// of requests can wait on slow upstreams without a thread each; idle
+// connections are kept for reuse by later requests.
+class AsyncHTTPClient {
+public:
+    // Runs on the transfer thread; keep it short, it delays other transfers
+    using Completion = std::function<void(HTTPResponse)>;
+
+    AsyncHTTPClient();
+    // Transfers still in flight complete with an error
+    ~AsyncHTTPClient();
+
+    AsyncHTTPClient(const AsyncHTTPClient&) = delete;
+    AsyncHTTPClient& operator=(const AsyncHTTPClient&) = delete;
+
+    // Any thread
+    void post(const std::string& url,
+              const std::string& data,
+              const std::map<std::string, std::string>& headers,
+              Completion done);
+    // Like HTTPClient::postStream(): a 2xx body goes to on_data as it
+    // arrives, on the transfer thread, so on_data must not block either;
+    // `done` then receives the status, or the error and its body
+    void postStream(const std::string& url,
+                    const std::string& data,
+                    const std::map<std::string, std::string>& headers,
+                    HTTPClient::DataCallback on_data,
+                    Completion done);
+
+    void setTimeout(long timeout_seconds) { timeout_seconds_ = timeout_seconds; }
+    size_t pendingTransfers() const { return pending_; }
+
+private:
+    struct Transfer;
+
+    CURLM* multi_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Transfer>> submitted_; // waiting for the transfer thread
+    bool stopping_;
+    std::thread thread_; // started by the first request
+    std::atomic<long> timeout_seconds_;
+    std::atomic<size_t> pending_;
+
+    // nullptr, after completing `done` with the error, if curl fails
+    std::unique_ptr<Transfer> createTransfer(const std::string& url, const std::string& data,
+                                             const std::map<std::string, std::string>& headers, Completion done);
+    void submit(std::unique_ptr<Transfer> transfer);
+    void run();
+    void complete(Transfer& transfer, CURLcode result);
+};
+
 // LLM Client interface
 class LLMClient {
 public:
@@ -51,10 +135,27 @@ public:
     
     // Main chat completion method
     virtual LLMResponse chatCompletion(const std::vector<Message>& messages);
+
+    // Same request without blocking: `done` is called once with the result,
+    // on the transfer thread (or right away if the request cannot be built)
+    using CompletionCallback = std::function<void(LLMResponse)>;
+    virtual void chatCompletionAsync(const std::vector<Message>& messages, CompletionCallback done);
+    // The same as a coroutine; the awaiter continues on the transfer thread
+    Task<LLMResponse> chatCompletionTask(std::vector<Message> messages);
     
-    // Stream chat completion (for real-time responses)
-    virtual void streamChatCompletion(const std::vector<Message>& messages,
-                                    std::function<void(const std::string&)> callback);
+    // Stream chat completion (for real-time responses). `callback` receives
+    // each content delta as it arrives; the assembled reply (or the error)
+    // is returned once the stream ends. When the callback returns false the
+    // request is abandoned: the response fails with `cancelled` set, and its
+    // content is what was delivered so far.
+    using DeltaCallback = std::function<bool(const std::string&)>;
+    virtual LLMResponse streamChatCompletion(const std::vector<Message>& messages, DeltaCallback callback);
+    // Same stream without blocking: `callback` and then `done` are called
+    // on the transfer thread, so the callback must not block
+    virtual void streamChatCompletionAsync(const std::vector<Message>& messages, DeltaCallback callback,
+                                           CompletionCallback done);
+    // The same as a coroutine; the awaiter continues on the transfer thread
+    Task<LLMResponse> streamChatCompletionTask(std::vector<Message> messages, DeltaCallback callback);
     
     // Configuration management
     void updateConfig(const LLMConfig& config);
@@ -64,46 +165,79 @@ public:
     static std::unique_ptr<LLMClient> createClient(const LLMConfig& config);
 
 protected:
+    // Outcome of interpreting one upstream stream event
+    enum class StreamStatus {
+        CONTINUE,
+        DONE,
+        ERROR
+    };
+
     LLMConfig config_;
     std::unique_ptr<HTTPClient> http_client_;
+    std::unique_ptr<AsyncHTTPClient> async_http_client_;
     
     // Abstract methods for different providers
     virtual std::string buildRequestPayload(const std::vector<Message>& messages) = 0;
     virtual LLMResponse parseResponse(const HTTPResponse& http_response) = 0;
     virtual std::map<std::string, std::string> buildHeaders() = 0;
+
+    // Streaming: the request payload with streaming enabled, and the text
+    // delta carried by one SSE event. Errors and usage go into `response`.
+    virtual std::string buildStreamRequestPayload(const std::vector<Message>& messages);
+    virtual StreamStatus parseStreamEvent(const SSEEvent& event, std::string& delta, LLMResponse& response) = 0;
+
+    // Fails async requests still in flight and waits for their callbacks.
+    // Providers call it from their destructors, while the completions can
+    // still reach their parseResponse().
+    void stopAsyncRequests();
+
+private:
+    // Parser and partial reply of one streamed completion
+    struct StreamState;
+    bool streamEvent(StreamState& state, const SSEEvent& event);
+    // Upstream bytes in; false to stop the transfer
+    bool feedStream(StreamState& state, const char* data, size_t length);
+    LLMResponse finishStream(StreamState& state, const HTTPResponse& http_response);
 };
 
 // OpenAI API client
 class OpenAIClient : public LLMClient {
 public:
     explicit OpenAIClient(const LLMConfig& config);
+    ~OpenAIClient() override { stopAsyncRequests(); }
     
 protected:
     std::string buildRequestPayload(const std::vector<Message>& messages) override;
+    std::string buildStreamRequestPayload(const std::vector<Message>& messages) override;
     LLMResponse parseResponse(const HTTPResponse& http_response) override;
     std::map<std::string, std::string> buildHeaders() override;
+    StreamStatus parseStreamEvent(const SSEEvent& event, std::string& delta, LLMResponse& response) override;
 };
 
 // Anthropic Claude API client
 class AnthropicClient : public LLMClient {
 public:
     explicit AnthropicClient(const LLMConfig& config);
+    ~AnthropicClient() override { stopAsyncRequests(); }
     
 protected:
     std::string buildRequestPayload(const std::vector<Message>& messages) override;
     LLMResponse parseResponse(const HTTPResponse& http_response) override;
     std::map<std::string, std::string> buildHeaders() override;
+    StreamStatus parseStreamEvent(const SSEEvent& event, std::string& delta, LLMResponse& response) override;
 };
 
 // Generic/Custom API client
 class CustomClient : public LLMClient {
 public:
     explicit CustomClient(const LLMConfig& config);
+    ~CustomClient() override { stopAsyncRequests(); }
     
 protected:
     std::string buildRequestPayload(const std::vector<Message>& messages) override;
     LLMResponse parseResponse(const HTTPResponse& http_response) override;
     std::map<std::string, std::string> buildHeaders() override;
+    StreamStatus parseStreamEvent(const SSEEvent& event, std::string& delta, LLMResponse& response) override;
 };
 
 } // namespace AITextAssistant
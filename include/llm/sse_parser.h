@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace AITextAssistant {
+
+// One dispatched server-sent event
+struct SSEEvent {
+    std::string event;  // "event:" field, empty for the default type
+    std::string data;   // "data:" lines joined with '\n'
+};
+
+// Incremental text/event-stream decoder (WHATWG SSE). Network reads may
+// split lines and events anywhere; feed() keeps the partial tail and
+// dispatches each complete event as soon as its blank line arrives.
+class SSEParser {
+public:
+    // Return false to stop dispatching the rest of the input
+    using EventCallback = std::function<bool(const SSEEvent&)>;
+
+    bool feed(const char* data, size_t length, const EventCallback& callback);
+
+    // Dispatch a final event that was not followed by a blank line
+    bool finish(const EventCallback& callback);
+
+    void reset();
+
+private:
+    std::string line_buffer_;
+    SSEEvent current_;
+    bool has_data_ = false;
+    bool skip_line_feed_ = false;
+
+    bool processLine(const std::string& line, const EventCallback& callback);
+    bool dispatch(const EventCallback& callback);
+};
+
+} // namespace AITextAssistant
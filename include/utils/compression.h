@@ -0,0 +1,71 @@
+#pragma once
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <memory>
+
+namespace AITextAssistant {
+
+// HTTP content codings the server can produce
+enum class ContentEncoding {
+    IDENTITY,
+    GZIP,
+    DEFLATE,
+    BROTLI
+};
+
+namespace Compression {
+
+// Token for Content-Encoding and the file suffix of a precompressed sibling
+const char* encodingName(ContentEncoding encoding);
+const char* fileSuffix(ContentEncoding encoding);
+
+bool isAvailable(ContentEncoding encoding);
+
+// Pick the best available coding the client accepts (RFC 9110 12.5.3)
+// among `candidates`; ties on q-value go to the earlier candidate
+ContentEncoding negotiate(std::string_view accept_encoding,
+                          std::initializer_list<ContentEncoding> candidates = {ContentEncoding::BROTLI,
+                                                                               ContentEncoding::GZIP});
+
+// Whether a MIME type benefits from compression (text, JSON, JS, SVG)
+bool isCompressible(const std::string& content_type);
+
+// One-shot compression; level -1 picks the coding's maximum, which is
+// the right trade-off for output that is compressed once and cached
+bool compress(ContentEncoding encoding, const std::string& input, std::string& output, int level = -1);
+
+// Incremental gzip/deflate encoder. Input is fed in pieces and the
+// compressed bytes are appended straight to the caller's buffer, so a body
+// is compressed in a single pass without staging copies.
+class StreamCompressor {
+public:
+    explicit StreamCompressor(ContentEncoding encoding, int level = 6);
+    ~StreamCompressor();
+
+    StreamCompressor(const StreamCompressor&) = delete;
+    StreamCompressor& operator=(const StreamCompressor&) = delete;
+
+    bool isValid() const { return valid_; }
+
+    // Compress `length` bytes, appending whatever output is ready to `output`
+    bool write(const char* data, size_t length, std::string& output);
+
+    // Emit everything buffered so far; the stream stays open
+    bool flush(std::string& output);
+
+    // Terminate the stream; no more writes are accepted
+    bool finish(std::string& output);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+    bool valid_;
+
+    bool run(const char* data, size_t length, int flush_mode, std::string& output);
+};
+
+} // namespace Compression
+
+} // namespace AITextAssistant
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "utils/thread_pool.h"
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace AITextAssistant {
+
+// Actor-style mailbox: the work posted to one mailbox runs one turn at a
+// time, in arrival order, while different mailboxes sharing a ThreadPool
+// run in parallel. A turn lasts as long as its Turn object, so it may
+// await I/O without letting the next one start. At most `capacity` turns
+// wait or run at once; past that, entry is refused.
+class Mailbox {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 8;
+
+    // Holds the mailbox's current turn; ending it starts the next one
+    class Turn {
+    public:
+        Turn() = default;
+        Turn(Turn&& other) noexcept;
+        Turn& operator=(Turn&& other) noexcept;
+        ~Turn() { end(); }
+
+        // False when entry was refused
+        explicit operator bool() const { return mailbox_ != nullptr; }
+        void end();
+
+    private:
+        friend class Mailbox;
+        explicit Turn(Mailbox* mailbox) : mailbox_(mailbox) {}
+
+        Mailbox* mailbox_ = nullptr;
+    };
+
+    class EnterAwaiter {
+    public:
+        bool await_ready() noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        Turn await_resume() noexcept { return admitted_ ? Turn(&mailbox_) : Turn(); }
+
+    private:
+        friend class Mailbox;
+        EnterAwaiter(Mailbox& mailbox, ThreadPool& pool) : mailbox_(mailbox), pool_(pool) {}
+
+        Mailbox& mailbox_;
+        ThreadPool& pool_;
+        bool admitted_ = false;
+    };
+
+    explicit Mailbox(size_t capacity = DEFAULT_CAPACITY) : capacity_(capacity) {}
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    // `co_await enter(pool)` yields the turn once every earlier one ended;
+    // a coroutine that had to wait continues on one of the pool's threads.
+    // The Turn is empty when the mailbox is full.
+    EnterAwaiter enter(ThreadPool& pool) { return EnterAwaiter(*this, pool); }
+    // Same, blocking the calling thread until the turn starts
+    Turn enterBlocking();
+
+    // Turns waiting or running
+    size_t depth() const;
+    size_t capacity() const { return capacity_; }
+
+private:
+    enum class Admission {
+        REFUSED,
+        STARTED,
+        QUEUED
+    };
+
+    // `start` runs, from the thread ending the previous turn, if the new
+    // turn has to wait
+    Admission admit(std::function<void()> start);
+    void endTurn();
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::deque<std::function<void()>> waiting_;
+    size_t depth_ = 0;
+};
+
+} // namespace AITextAssistant
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "utils/logger.h"
+#include "utils/thread_pool.h"
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace AITextAssistant {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    // Hands control back to the awaiting coroutine, if any
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& result) {
+        value.emplace(std::forward<U>(result));
+    }
+
+    T result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+// Runs a task to completion on its own; the frame frees itself at the end
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T.
+//
+// The body runs when the task is co_awaited, on the awaiting thread, and
+// the awaiting coroutine continues wherever the task finishes: after a
+// resumeOn() or awaitCallback() that may be a different thread. Exceptions
+// propagate to the awaiter. Top-level tasks are started with spawn().
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend promise_type;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+template <typename T, typename Done>
+DetachedTask runDetached(Task<T> task, Done on_done) {
+    std::optional<T> result;
+    try {
+        result.emplace(co_await std::move(task));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Unhandled exception in task: " + std::string(e.what()));
+    }
+    if (!result) {
+        co_return;
+    }
+    // A throwing callback must not reach DetachedTask, which terminates
+    try {
+        on_done(std::move(*result));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Unhandled exception in task callback: " + std::string(e.what()));
+    }
+}
+
+template <typename Done>
+DetachedTask runDetached(Task<void> task, Done on_done) {
+    bool finished = false;
+    try {
+        co_await std::move(task);
+        finished = true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("Unhandled exception in task: " + std::string(e.what()));
+    }
+    if (!finished) {
+        co_return;
+    }
+    try {
+        on_done();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Unhandled exception in task callback: " + std::string(e.what()));
+    }
+}
+
+} // namespace detail
+
+// Start `task` now, on this thread, and pass its result to `on_done` from
+// wherever it finishes. If the task throws, the exception is logged and
+// `on_done` is destroyed without being called; if `on_done` throws, that
+// is logged too.
+template <typename T, typename Done>
+void spawn(Task<T> task, Done on_done) {
+    detail::runDetached(std::move(task), std::move(on_done));
+}
+
+// `co_await resumeOn(pool)` continues the coroutine on one of the pool's
+// threads. If the pool refuses the task (full or stopping) or drops it on
+// shutdown, the coroutine continues on the thread where that happens
+// instead, so it is never lost.
+inline auto resumeOn(ThreadPool& pool) {
+    struct Awaiter {
+        ThreadPool& pool;
+
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            // Resumes when the last copy of the task goes away: after it
+            // ran, or when it is refused or dropped
+            std::shared_ptr<void> resume(handle.address(), [](void* address) {
+                std::coroutine_handle<>::from_address(address).resume();
+            });
+            pool.trySubmit([resume = std::move(resume)]() mutable { resume.reset(); });
+        }
+        void await_resume() noexcept {}
+    };
+    return Awaiter{pool};
+}
+
+// Awaits an operation that reports its result through a callback: `start`
+// receives a callable taking a T, which must be invoked exactly once. The
+// coroutine continues on the thread that invokes it.
+template <typename T, typename Start>
+auto awaitCallback(Start start) {
+    struct Awaiter {
+        Start start;
+        std::optional<T> result;
+
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            // The callback may finish the coroutine, and free this awaiter,
+            // before `start` returns
+            Start run = std::move(start);
+            run([this, handle](T value) {
+                result.emplace(std::move(value));
+                handle.resume();
+            });
+        }
+        T await_resume() { return std::move(*result); }
+    };
+    return Awaiter{std::move(start), std::nullopt};
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AITextAssistant {
+
+// Fixed-size worker pool with a bounded FIFO queue. Submission never
+// blocks: when the queue is full trySubmit() refuses the task so the
+// caller can shed load instead of piling up work.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    ThreadPool(size_t thread_count, size_t max_queue_size);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Returns false if the pool is saturated or shutting down
+    bool trySubmit(Task task);
+
+    // Drop queued tasks, wait for running ones and join the workers
+    void shutdown();
+    // Refuse new tasks, run the queued ones and join the workers
+    void drain();
+
+    // Statistics
+    size_t getThreadCount() const { return workers_.size(); }
+    size_t getMaxQueueSize() const { return max_queue_size_; }
+    size_t getQueueSize() const;
+    size_t getActiveCount() const;
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<Task> queue_;
+    size_t max_queue_size_;
+    size_t active_count_;
+    bool stopping_;
+    bool draining_; // queued tasks still run after stopping_
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+
+    void workerLoop();
+};
+
+} // namespace AITextAssistant
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct msghdr;
+struct io_uring_sqe;
+
+namespace AITextAssistant {
+
+class IoUring;
+
+// Single-threaded reactor. All fd callbacks run on the thread that calls
+// loop(); other threads hand work over with queueInLoop().
+//
+// The EPOLL backend dispatches readiness through addFd(). The IO_URING
+// backend additionally offers completion-based socket I/O (multishot
+// accept, multishot recv into provided buffers, send with a linked
+// close) so a request/response cycle needs no per-operation syscalls;
+// addFd() there is served by multishot poll.
+class EventLoop {
+public:
+    enum class Backend {
+        EPOLL,
+        IO_URING
+    };
+
+    using IoCallback = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+    // io_uring completions: `result` is the syscall return value or -errno;
+    // `more` stays set while a multishot operation remains armed
+    using CompletionCallback = std::function<void(int result, bool more)>;
+    using RecvCallback = std::function<void(int result, const char* data, bool more)>;
+
+    explicit EventLoop(Backend backend = Backend::EPOLL);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool isValid() const { return valid_; }
+    bool usesIoUring() const { return ring_ != nullptr; }
+
+    // Run until quit() is called
+    void loop();
+    void quit();
+
+    // Cross-thread task handoff
+    void runInLoop(Task task);
+    void queueInLoop(Task task);
+    bool isInLoopThread() const { return thread_id_.load() == std::this_thread::get_id(); }
+
+    // Periodic timer backed by a timerfd (call before loop() or on the loop thread)
+    bool runEvery(std::chrono::milliseconds interval, Task task);
+
+    // fd registration (loop thread only)
+    bool addFd(int fd, uint32_t events, IoCallback callback);
+    bool modifyFd(int fd, uint32_t events);
+    void removeFd(int fd);
+
+    // Completion-based I/O (io_uring backend, loop thread only). Each call
+    // returns an id for cancel(), or 0 if the operation could not be queued.
+    uint64_t submitAccept(int listen_fd, CompletionCallback callback);
+    uint64_t submitRecv(int fd, RecvCallback callback);
+    // `message` must stay valid until completion. With close_after the send
+    // waits for all bytes and a close of `fd` is linked behind it, which
+    // runs only if the whole message went out.
+    uint64_t submitSend(int fd, const struct msghdr* message, bool close_after, CompletionCallback callback);
+    uint64_t submitPoll(int fd, uint32_t events, CompletionCallback callback);
+    // Ask the kernel to stop an operation; its callback still sees any
+    // completions already posted, then a final one with -ECANCELED
+    void cancel(uint64_t id);
+
+private:
+    using CompletionHandler = std::function<void(int32_t result, uint32_t flags)>;
+
+    int epoll_fd_;
+    int wakeup_fd_;
+    bool valid_;
+    std::atomic<bool> quit_;
+    std::atomic<std::thread::id> thread_id_;
+
+    std::mutex pending_mutex_;
+    std::vector<Task> pending_tasks_;
+
+    std::unordered_map<int, std::shared_ptr<IoCallback>> callbacks_;
+    std::vector<int> timer_fds_;
+
+    // io_uring backend
+    std::unique_ptr<IoUring> ring_;
+    std::unordered_map<uint64_t, std::shared_ptr<CompletionHandler>> ops_;
+    std::unordered_map<int, uint64_t> poll_ops_; // addFd() registrations
+    uint64_t next_op_id_;
+    size_t in_flight_; // includes cancelled operations not yet retired
+
+    void wakeup();
+    void handleWakeup();
+    void runPendingTasks();
+
+    void loopIoUring();
+    io_uring_sqe* prepareOp(uint64_t& id, CompletionHandler handler);
+    void handleCompletion(uint64_t user_data, int32_t result, uint32_t flags);
+    bool armPoll(int fd, uint32_t events);
+    void drainIoUring();
+
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr unsigned RING_ENTRIES = 256;
+    static constexpr uint16_t RECV_BUFFER_GROUP = 0;
+    static constexpr unsigned RECV_BUFFER_COUNT = 256;
+    static constexpr size_t RECV_BUFFER_SIZE = 4096;
+};
+
+} // namespace AITextAssistant
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace AITextAssistant {
+
+using HeaderField = std::pair<std::string, std::string>;
+
+// HPACK (RFC 7541) header block decoder for one HTTP/2 connection.
+//
+// Keeps the dynamic table that later blocks refer back to, so every block
+// has to be decoded in the order it arrived, including blocks for streams
+// that are then refused. Any error is fatal to the connection.
+class HpackDecoder {
+public:
+    explicit HpackDecoder(size_t max_table_size = 4096);
+
+    // Decode one complete header block, appending its fields to `headers`
+    bool decode(std::string_view block, std::vector<HeaderField>& headers);
+
+    size_t tableSize() const { return table_size_; }
+
+private:
+    std::deque<HeaderField> table_; // newest first
+    size_t table_size_;             // per RFC 7541 section 4.1
+    size_t capacity_;               // current limit, set by size updates
+    size_t max_table_size_;         // the limit we advertised
+
+    const HeaderField* lookup(uint64_t index) const;
+    void insert(HeaderField field);
+    void evict(size_t capacity);
+};
+
+// Append one field to a header block. No dynamic table is used, so the
+// encoder is stateless: static table matches are indexed and everything
+// else is a literal, Huffman-coded when that is shorter.
+void hpackEncodeHeader(std::string_view name, std::string_view value, std::string& block);
+
+// Huffman coding of string literals (RFC 7541 Appendix B)
+std::string hpackHuffmanEncode(std::string_view input);
+bool hpackHuffmanDecode(std::string_view input, std::string& output);
+
+} // namespace AITextAssistant
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "web/hpack.h"
+#include "web/http_message.h"
+#include "web/http_parser.h"
+#include "web/upgraded_protocol.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace AITextAssistant {
+
+class EventLoop;
+class HttpConnection;
+class RequestBodyReader;
+
+enum class Http2Error : uint32_t {
+    NO_ERROR = 0x0,
+    PROTOCOL_ERROR = 0x1,
+    INTERNAL_ERROR = 0x2,
+    FLOW_CONTROL_ERROR = 0x3,
+    SETTINGS_TIMEOUT = 0x4,
+    STREAM_CLOSED = 0x5,
+    FRAME_SIZE_ERROR = 0x6,
+    REFUSED_STREAM = 0x7,
+    CANCEL = 0x8,
+    COMPRESSION_ERROR = 0x9,
+    CONNECT_ERROR = 0xA,
+    ENHANCE_YOUR_CALM = 0xB,
+    INADEQUATE_SECURITY = 0xC,
+    HTTP_1_1_REQUIRED = 0xD
+};
+
+// Server side of one cleartext HTTP/2 connection (RFC 9113).
+//
+// The connection's event loop feeds input through consume(). Each request
+// stream is turned into an HttpRequest, so the same route handlers serve
+// both protocols: bodies are buffered up to max_body_bytes, or handed over
+// through a RequestBodyReader for streaming routes, whose stream window is
+// only reopened as the handler drains it.
+//
+// Responses are given as the HTTP/1 head the server already builds and
+// are re-encoded with HPACK. Their bodies go out as DATA frames, one per
+// ready stream in turn, within the peer's connection and stream windows
+// and only while the socket keeps up, so one slow or large response does
+// not hold back the others.
+class Http2Session : public UpgradedProtocol, public std::enable_shared_from_this<Http2Session> {
+public:
+    using RequestCallback = std::function<void(const std::shared_ptr<Http2Session>&, uint32_t stream_id, HttpRequest)>;
+    // The stream is answered with an error status instead (413, 431)
+    using ErrorCallback = std::function<void(const std::shared_ptr<Http2Session>&, uint32_t stream_id, int status)>;
+    using BodyStreamCallback = std::function<bool(const HttpRequest& head)>;
+
+    Http2Session(const std::shared_ptr<HttpConnection>& connection, const HttpParserLimits& limits,
+                 RequestCallback on_request, ErrorCallback on_error);
+
+    Http2Session(const Http2Session&) = delete;
+    Http2Session& operator=(const Http2Session&) = delete;
+
+    // Set before the session is installed
+    void setBodyStreamCallback(BodyStreamCallback callback) { body_stream_callback_ = std::move(callback); }
+
+    // For "Upgrade: h2c": `request` becomes stream 1 and `settings` is its
+    // HTTP2-Settings header. False if the settings are malformed.
+    bool setUpgradeRequest(HttpRequest request, std::string_view settings);
+
+    // Any thread. `head` is a serialized HTTP/1 response head; its
+    // connection-specific headers are dropped.
+    void sendResponse(uint32_t stream_id, std::string head, std::shared_ptr<const std::string> body = nullptr,
+                      std::shared_ptr<HttpFileBody> file = nullptr);
+    void beginStream(uint32_t stream_id, std::string head);
+    // Blocks while too much of this stream is unsent; false once the
+    // stream was reset or the peer stopped reading for SEND_TIMEOUT
+    bool writeStream(uint32_t stream_id, std::string data);
+    // Never blocks: false once the stream was reset or more than
+    // MAX_STREAM_BACKLOG of it is unsent, in which case it is reset
+    bool pushStream(uint32_t stream_id, std::string data);
+    void endStream(uint32_t stream_id);
+    void resetStream(uint32_t stream_id, Http2Error error = Http2Error::INTERNAL_ERROR);
+
+    // Connection side (event loop thread)
+    void start() override;
+    void consume(std::string& buffer) override;
+    bool isBacklogged() override;
+    void onOutputFlushed() override;
+    void onClosed() override;
+
+    static constexpr uint32_t MAX_CONCURRENT_STREAMS = 100;
+    // Receive windows we advertise
+    static constexpr int32_t STREAM_WINDOW = 256 * 1024;
+    static constexpr int32_t CONNECTION_WINDOW = 1024 * 1024;
+    // Unsent response data above which DATA frames are held back, per
+    // stream for writeStream() and pushStream(), and for the connection as a whole
+    static constexpr size_t MAX_STREAM_BACKLOG = 256 * 1024;
+    static constexpr size_t MAX_OUTPUT_BACKLOG = 256 * 1024;
+    static constexpr std::chrono::seconds SEND_TIMEOUT{30};
+
+private:
+    struct Stream {
+        HttpRequest request; // head, until dispatched
+        std::string body;
+        std::shared_ptr<RequestBodyReader> body_reader;
+        size_t body_received = 0;
+        bool remote_closed = false;
+        bool dispatched = false;
+        bool rejected = false; // answered with an error; further DATA is dropped
+
+        int32_t recv_window = STREAM_WINDOW;
+        int32_t recv_unacked = 0;
+        int64_t send_window = 0;
+
+        // Response
+        bool head_sent = false;
+        bool streamed = false; // data comes from writeStream() or pushStream(), counted in backlog_
+        bool end_queued = false;
+        bool ready = false;    // in ready_
+        std::deque<std::shared_ptr<const std::string>> output;
+        size_t output_offset = 0;
+        std::shared_ptr<HttpFileBody> file;
+    };
+
+    std::weak_ptr<HttpConnection> connection_;
+    EventLoop* loop_;
+    HttpParserLimits limits_;
+    RequestCallback on_request_;
+    ErrorCallback on_error_;
+    BodyStreamCallback body_stream_callback_;
+
+    // Event loop only
+    HpackDecoder decoder_;
+    std::map<uint32_t, Stream> streams_;
+    std::unordered_set<uint32_t> reset_handlers_; // closed streams whose handler has not answered yet
+    std::shared_ptr<RequestArena> arena_; // reused by streams once free
+    std::deque<uint32_t> ready_; // streams with output to send, in turn
+    std::string output_;         // frames not yet handed to the connection
+    bool preface_received_;
+    bool goaway_sent_;
+    bool goaway_received_;
+    bool closed_;
+    uint32_t last_stream_id_;
+    uint32_t continuation_stream_; // expecting CONTINUATION frames for it
+    bool continuation_end_stream_;
+    std::string header_block_;
+    int32_t recv_window_;
+    int32_t recv_unacked_;
+    int64_t send_window_;
+    int64_t peer_initial_window_;
+    size_t peer_max_frame_size_;
+    bool output_paused_;
+    std::unique_ptr<HttpRequest> upgrade_request_;
+
+    // Per-stream data accepted by writeStream() or pushStream() and not yet framed
+    std::mutex mutex_;
+    std::condition_variable drained_;
+    std::unordered_map<uint32_t, size_t> backlog_;
+    bool open_;
+
+    void post(std::function<void(Http2Session&)> task);
+    // Hands a piece counted in backlog_ to the loop
+    void queueStreamData(uint32_t stream_id, std::string data);
+    bool handleFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool handleHeaders(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool handleContinuation(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool handleData(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool handleSettings(uint8_t flags, uint32_t stream_id, std::string_view payload);
+    bool handleWindowUpdate(uint32_t stream_id, std::string_view payload);
+    bool handleRstStream(uint32_t stream_id, std::string_view payload);
+    Http2Error applySettings(std::string_view payload);
+    bool finishHeaders(uint32_t stream_id, bool end_stream);
+    void openStream(uint32_t stream_id, std::vector<HeaderField>& fields, bool end_stream);
+    void rejectStream(uint32_t stream_id, Stream& stream, int status);
+    void dispatch(uint32_t stream_id, Stream& stream);
+    void receiveData(uint32_t stream_id, Stream& stream, std::string_view data, int32_t flow, bool end_stream);
+    void releaseStreamWindow(uint32_t stream_id);
+
+    void queueHead(uint32_t stream_id, const std::string& head, bool end_stream);
+    bool hasOutput(const Stream& stream) const;
+    void markReady(uint32_t stream_id, Stream& stream);
+    void sendData();
+    // False only when the connection window is exhausted
+    bool sendDataFrame(uint32_t stream_id, Stream& stream);
+    void finishStream(uint32_t stream_id, Stream& stream);
+    void closeStream(uint32_t stream_id);
+    void releaseBacklog(uint32_t stream_id, size_t bytes, bool erase);
+
+    void writeFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload);
+    void writeRstStream(uint32_t stream_id, Http2Error error);
+    void writeWindowUpdate(uint32_t stream_id, uint32_t increment);
+    bool connectionError(Http2Error error);
+    void flush();
+};
+
+} // namespace AITextAssistant
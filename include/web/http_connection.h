@@ -0,0 +1,219 @@
+#pragma once
+
+#include "web/http_message.h"
+#include "web/http_parser.h"
+#include "web/request_body.h"
+#include "web/timer_wheel.h"
+#include "web/upgraded_protocol.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace AITextAssistant {
+
+class EventLoop;
+
+// Per-socket state machine driven by an EventLoop. The socket is
+// non-blocking and registered edge-triggered, so every readiness
+// notification drains the kernel buffer until EAGAIN.
+//
+// Connections are persistent: after a response is flushed the state
+// returns to READING and any pipelined request already sitting in the
+// input buffer is dispatched. Requests are handled one at a time so
+// responses always go out in request order.
+//
+// While reading, one deadline on the loop's timer wheel bounds each phase:
+// idle until the first byte of a request, then the header block, then the
+// body. Bytes arriving do not extend the running deadline, so a client
+// trickling a request slowly is closed just like a silent one.
+//
+// A request whose head the body-stream callback accepts is dispatched as
+// soon as its headers are parsed, and the body follows through the
+// request's RequestBodyReader as it arrives. Reading from the socket stops
+// while the reader is full, so a large upload is never held in memory.
+//
+// After an upgrade (WebSocket, or HTTP/2 either via "Upgrade: h2c" or a
+// connection that opens with the HTTP/2 preface) the connection stays in
+// a streamed response for good: input goes to the upgraded protocol and
+// its output is written as stream pieces.
+//
+// On an io_uring loop the same state machine is fed by completions
+// instead: a multishot recv delivers input, and each output batch is one
+// sendmsg submission, with the close linked behind the final response.
+class HttpConnection : public std::enable_shared_from_this<HttpConnection> {
+public:
+    using RequestCallback = std::function<void(const std::shared_ptr<HttpConnection>&, HttpRequest)>;
+    using ParseErrorCallback = std::function<void(const std::shared_ptr<HttpConnection>&, int status)>;
+    using CloseCallback = std::function<void(const std::shared_ptr<HttpConnection>&)>;
+    // Decides from the request head whether its body is streamed
+    using BodyStreamCallback = std::function<bool(const HttpRequest& head)>;
+    // Creates the session for a connection that opens with the HTTP/2 preface
+    using Http2Callback = std::function<std::shared_ptr<UpgradedProtocol>(const std::shared_ptr<HttpConnection>&)>;
+    struct Timeouts {
+        std::chrono::milliseconds idle{5000};
+        std::chrono::milliseconds header{10000};
+        std::chrono::milliseconds body{30000};
+    };
+
+    enum class State {
+        READING,
+        PROCESSING,
+        WRITING,
+        CLOSED
+    };
+
+    HttpConnection(EventLoop* loop, int fd, const HttpParserLimits& limits = HttpParserLimits());
+    ~HttpConnection();
+
+    HttpConnection(const HttpConnection&) = delete;
+    HttpConnection& operator=(const HttpConnection&) = delete;
+
+    // Read deadlines are enforced only when a wheel is set (before start())
+    void setTimeouts(TimerWheel* timers, const Timeouts& timeouts) {
+        timers_ = timers;
+        timeouts_ = timeouts;
+    }
+
+    // Register with the loop (loop thread only)
+    bool start();
+
+    // Queue a response; safe to call from any thread. When keep_alive is
+    // false the connection closes once it is flushed. `head` and `body` go
+    // out together with one gathered write, and a file body, if given,
+    // follows via sendfile(); neither is copied in user space.
+    void sendResponse(std::string head, bool keep_alive = false,
+                      std::shared_ptr<const std::string> body = nullptr,
+                      std::shared_ptr<HttpFileBody> file = nullptr);
+
+    // Streamed response: the head goes out first and the body follows in
+    // pieces as it is produced. Safe to call from any thread; pieces are
+    // written in call order and endStream() completes the response.
+    void beginStream(std::string head);
+    void writeStream(std::string data);
+    void endStream(std::string data, bool keep_alive);
+
+    // Producer-side flow control for streams: wait until at most `bytes`
+    // of stream data are still unsent. False on timeout or once closed.
+    bool waitForOutputBelow(size_t bytes, std::chrono::milliseconds timeout);
+
+    // Stream data queued by writeStream() and not yet written
+    size_t outputBacklog();
+
+    // Send the 101 response and hand all further input to `protocol`.
+    // Safe to call from any thread while the upgrade request is in flight.
+    void upgrade(std::string head, std::shared_ptr<UpgradedProtocol> protocol);
+
+    // Safe from any thread: read again after a consumer made room
+    void resumeReading();
+
+    // Safe from any thread: close without flushing pending output
+    void abort();
+
+    // Set once the socket is closed; stream producers use it to stop early
+    bool isClosed() const { return closed_; }
+
+    // Tear down immediately (loop thread only)
+    void forceClose();
+
+    int fd() const { return fd_; }
+    EventLoop* getLoop() const { return loop_; }
+    State getState() const { return state_; }
+    size_t getRequestCount() const { return request_count_; }
+
+    void setRequestCallback(RequestCallback callback) { request_callback_ = std::move(callback); }
+    void setParseErrorCallback(ParseErrorCallback callback) { parse_error_callback_ = std::move(callback); }
+    void setCloseCallback(CloseCallback callback) { close_callback_ = std::move(callback); }
+    // Set before start()
+    void setBodyStreamCallback(BodyStreamCallback callback) {
+        body_stream_callback_ = std::move(callback);
+        parser_.setPauseAfterHeaders(body_stream_callback_ != nullptr);
+    }
+    // Set before start(); without it the preface is just a bad request
+    void setHttp2Callback(Http2Callback callback) { http2_callback_ = std::move(callback); }
+
+private:
+    EventLoop* loop_;
+    int fd_;
+    State state_;
+    std::string input_buffer_;
+    HttpRequestParser parser_;
+    std::shared_ptr<RequestArena> arena_; // handed to each request in turn
+    std::string output_buffer_;
+    std::shared_ptr<const std::string> output_body_;
+    size_t output_offset_; // across output_buffer_ followed by output_body_
+    std::shared_ptr<HttpFileBody> output_file_;
+    size_t request_count_;
+    bool keep_alive_;
+    bool peer_closed_;
+    bool streaming_;
+    std::atomic<bool> closed_;
+    std::shared_ptr<RequestBodyReader> body_reader_; // body still being streamed
+    std::shared_ptr<UpgradedProtocol> upgraded_;     // set once upgraded
+
+    // Stream bytes queued by writeStream() and not yet flushed
+    std::mutex output_mutex_;
+    std::condition_variable output_drained_;
+    size_t stream_backlog_;
+    size_t stream_unflushed_; // appended to the output, loop thread only
+
+    enum class Deadline {
+        NONE,
+        IDLE,
+        HEADER,
+        BODY
+    };
+    TimerWheel* timers_;
+    Timeouts timeouts_;
+    TimerWheel::Entry deadline_;
+    Deadline deadline_phase_;
+
+    // io_uring mode
+    uint64_t recv_op_;           // armed multishot recv, 0 when paused
+    bool send_in_flight_;        // output buffers are owned by the kernel
+    bool fd_released_;           // closed by a linked close submission
+    std::string pending_output_; // stream data queued behind the send
+    struct msghdr send_message_;
+    struct iovec send_iov_[2];
+
+    RequestCallback request_callback_;
+    ParseErrorCallback parse_error_callback_;
+    CloseCallback close_callback_;
+    BodyStreamCallback body_stream_callback_;
+    Http2Callback http2_callback_;
+
+    void handleEvents(uint32_t events);
+    void handleRead();
+    void handleWrite();
+    void finishOutput();
+    bool writeBuffers();
+    bool writeFileBody();
+    void handleClose();
+    void processInput();
+    bool detectHttp2Preface();
+    void beginBodyStream(HttpRequest head);
+    void pumpBody();
+    bool canBufferInput();
+    void abandonBody();
+    void releaseBacklog(size_t bytes);
+    void updateDeadline();
+    void appendOutput(const std::string& data);
+
+    void armRecv();
+    void handleReceive(int result, const char* data, bool more);
+    void submitOutput();
+    void handleSendComplete(int result, size_t length, bool close_after);
+
+    static constexpr size_t READ_CHUNK_SIZE = 4096;
+    // Upper bound on pipelined bytes buffered while a request is in flight
+    static constexpr size_t MAX_PIPELINE_BUFFER = 64 * 1024;
+    // Streamed body bytes queued for the handler before reading pauses
+    static constexpr size_t STREAM_BODY_HIGH_WATER = 256 * 1024;
+};
+
+} // namespace AITextAssistant
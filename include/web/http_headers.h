@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AITextAssistant {
+
+// Header names the server reads or writes on its hot paths. A name is
+// recognized once, when its field is stored, so later lookups compare ids
+// instead of strings.
+enum class HeaderId : uint8_t {
+    OTHER,
+    ACCEPT_ENCODING,
+    ACCESS_CONTROL_ALLOW_HEADERS,
+    ACCESS_CONTROL_ALLOW_METHODS,
+    ACCESS_CONTROL_ALLOW_ORIGIN,
+    ACCESS_CONTROL_MAX_AGE,
+    CACHE_CONTROL,
+    CONNECTION,
+    CONTENT_ENCODING,
+    CONTENT_LENGTH,
+    CONTENT_RANGE,
+    CONTENT_TYPE,
+    HOST,
+    HTTP2_SETTINGS,
+    IF_MODIFIED_SINCE,
+    IF_NONE_MATCH,
+    IF_RANGE,
+    KEEP_ALIVE,
+    RANGE,
+    RETRY_AFTER,
+    SEC_WEBSOCKET_ACCEPT,
+    SEC_WEBSOCKET_KEY,
+    SEC_WEBSOCKET_VERSION,
+    TRANSFER_ENCODING,
+    UPGRADE,
+    VARY,
+    COUNT
+};
+
+// Id of `name`, matched case-insensitively; OTHER for any other name
+HeaderId headerId(std::string_view name);
+// Canonical spelling of a known name ("Content-Type"); empty for OTHER
+std::string_view headerName(HeaderId id);
+bool headerNameEquals(std::string_view a, std::string_view b);
+
+// Request header fields as views into the buffer the request was parsed
+// from. The first INLINE_CAPACITY fields are kept inline, so a typical
+// request is indexed without allocating. Lookups are case-insensitive and
+// return the first field with that name.
+class RequestHeaders {
+public:
+    struct Field {
+        std::string_view name;
+        std::string_view value;
+        HeaderId id = HeaderId::OTHER;
+    };
+
+    static constexpr size_t INLINE_CAPACITY = 16;
+
+    void add(std::string_view name, std::string_view value);
+    void clear();
+
+    // nullptr when absent
+    const std::string_view* find(HeaderId id) const;
+    const std::string_view* find(std::string_view name) const;
+    // Empty when absent
+    std::string_view get(HeaderId id) const;
+    std::string_view get(std::string_view name) const;
+    bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Field* begin() const { return data(); }
+    const Field* end() const { return data() + size_; }
+
+    // Re-point the views after the bytes they refer to were copied from
+    // `from` to `to`
+    void rebase(const char* from, const char* to);
+
+private:
+    Field* data() { return overflow_.empty() ? inline_.data() : overflow_.data(); }
+    const Field* data() const { return overflow_.empty() ? inline_.data() : overflow_.data(); }
+
+    std::array<Field, INLINE_CAPACITY> inline_;
+    std::vector<Field> overflow_; // every field, once there are more than fit inline
+    size_t size_ = 0;
+};
+
+// Response header fields in insertion order. Known names are stored as
+// ids and written with their canonical spelling, so only custom names and
+// values own memory. Names are matched case-insensitively.
+class ResponseHeaders {
+public:
+    struct Field {
+        HeaderId id = HeaderId::OTHER;
+        std::string custom_name; // set for OTHER only
+        std::string value;
+
+        std::string_view name() const { return id == HeaderId::OTHER ? std::string_view(custom_name) : headerName(id); }
+    };
+
+    // Value of the field, added empty if absent
+    std::string& operator[](HeaderId id);
+    std::string& operator[](std::string_view name);
+
+    // nullptr when absent
+    const std::string* find(HeaderId id) const;
+    const std::string* find(std::string_view name) const;
+    bool contains(HeaderId id) const { return find(id) != nullptr; }
+    bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+    size_t erase(HeaderId id);
+    size_t erase(std::string_view name);
+    void clear() { fields_.clear(); }
+
+    size_t size() const { return fields_.size(); }
+    bool empty() const { return fields_.empty(); }
+    std::vector<Field>::const_iterator begin() const { return fields_.begin(); }
+    std::vector<Field>::const_iterator end() const { return fields_.end(); }
+
+private:
+    Field* lookup(HeaderId id, std::string_view name);
+    const Field* lookup(HeaderId id, std::string_view name) const;
+    std::string& insert(HeaderId id, std::string_view name);
+
+    std::vector<Field> fields_;
+};
+
+} // namespace AITextAssistant
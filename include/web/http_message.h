@@ -0,0 +1,168 @@
+#pragma once
+
+#include "web/http_headers.h"
+#include "web/request_arena.h"
+#include <array>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace AITextAssistant {
+
+class RequestBodyReader;
+
+// Values captured from "{name}" segments of a route pattern. Names point
+// into the router and values into the request path; fixed capacity so
+// that matching never allocates.
+struct PathParams {
+    static constexpr size_t MAX_PARAMS = 8;
+
+    std::array<std::pair<std::string_view, std::string_view>, MAX_PARAMS> entries;
+    size_t count = 0;
+
+    // Empty when the route has no parameter of that name
+    std::string_view get(std::string_view name) const {
+        for (size_t i = 0; i < count; ++i) {
+            if (entries[i].first == name) {
+                return entries[i].second;
+            }
+        }
+        return std::string_view();
+    }
+};
+
+// Decoded query parameters as views into the request buffer or, where
+// decoding changed the text, into the request's arena. The first
+// INLINE_CAPACITY pairs are kept inline. A repeated name resolves to its
+// last value.
+class QueryParams {
+public:
+    static constexpr size_t INLINE_CAPACITY = 8;
+    using Entry = std::pair<std::string_view, std::string_view>;
+
+    void add(std::string_view name, std::string_view value) {
+        if (size_ == INLINE_CAPACITY && overflow_.empty()) {
+            overflow_.assign(inline_.begin(), inline_.end());
+        }
+        if (overflow_.empty()) {
+            inline_[size_] = Entry(name, value);
+        } else {
+            overflow_.emplace_back(name, value);
+        }
+        ++size_;
+    }
+
+    // nullptr when absent
+    const std::string_view* find(std::string_view name) const {
+        for (size_t i = size_; i > 0; --i) {
+            if (data()[i - 1].first == name) {
+                return &data()[i - 1].second;
+            }
+        }
+        return nullptr;
+    }
+    // Empty when absent
+    std::string_view get(std::string_view name) const {
+        const std::string_view* value = find(name);
+        return value ? *value : std::string_view();
+    }
+    bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Entry* begin() const { return data(); }
+    const Entry* end() const { return data() + size_; }
+
+private:
+    const Entry* data() const { return overflow_.empty() ? inline_.data() : overflow_.data(); }
+
+    std::array<Entry, INLINE_CAPACITY> inline_;
+    std::vector<Entry> overflow_; // every pair, once there are more than fit inline
+    size_t size_ = 0;
+};
+
+// HTTP request structure. method/path/query/version/body and the header
+// fields are views into `raw`, the connection buffer the request was
+// parsed from, and query_params into `raw` or `arena`, so they stay valid
+// for as long as any copy of the request is alive.
+struct HttpRequest {
+    std::string_view method;
+    std::string_view path;
+    std::string_view query;
+    std::string_view version;
+    std::string_view body;
+    RequestHeaders headers;
+    QueryParams query_params;
+    PathParams path_params;
+    std::shared_ptr<const std::string> raw;
+    // Scratch memory for this request, shared by its copies
+    std::shared_ptr<RequestArena> arena;
+    // Set instead of `body` for routes that stream their request body
+    std::shared_ptr<RequestBodyReader> body_reader;
+};
+
+// A region of an open file sent with sendfile() after the response head.
+// Owns the descriptor; the connection advances offset/length as it sends.
+struct HttpFileBody {
+    int fd = -1;
+    off_t offset = 0;
+    size_t length = 0;
+
+    HttpFileBody() = default;
+    HttpFileBody(const HttpFileBody&) = delete;
+    HttpFileBody& operator=(const HttpFileBody&) = delete;
+    ~HttpFileBody() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+// Writes one piece of a streamed response body; returns false once the
+// client has gone away so the producer can stop early
+using StreamWriter = std::function<bool(const std::string&)>;
+
+// Finishes a pushed response body; false when it was cut short, which the
+// client sees as a failed response
+using StreamEnd = std::function<void(bool complete)>;
+
+// HTTP response structure
+struct HttpResponse {
+    int status_code = 200;
+    std::string body;
+    ResponseHeaders headers;
+
+    // Pre-rendered "Name: value\r\n" lines sent after `headers`
+    std::string header_block;
+
+    // Send the server's CORS headers, in place of any set in `headers`
+    bool cors = false;
+
+    // Immutable body shared with a cache; sent instead of `body` when set
+    std::shared_ptr<const std::string> shared_body;
+
+    // File region sent zero-copy instead of `body` when set
+    std::shared_ptr<HttpFileBody> file_body;
+
+    // When set, the head is sent first and the body is produced by calling
+    // `stream` with a writer; `body` is ignored
+    std::function<void(const StreamWriter&)> stream;
+
+    // Instead of `stream`, for bodies produced from callbacks (an upstream
+    // transfer, say) rather than on a thread of their own: called once with
+    // a writer that never blocks and an end to call once the body is done.
+    // Both may be used from any thread. A client that falls too far behind
+    // is dropped and the writer returns false; a body dropped without
+    // calling end counts as cut.
+    std::function<void(StreamWriter, StreamEnd)> push_stream;
+
+    HttpResponse() {
+        headers[HeaderId::CONTENT_TYPE] = "text/html; charset=utf-8";
+    }
+};
+
+} // namespace AITextAssistant
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "web/http_message.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AITextAssistant {
+
+// Size limits enforced while a request is being read
+struct HttpParserLimits {
+    size_t max_header_bytes = 8 * 1024;               // also caps a chunked body's trailers
+    size_t max_chunk_line_bytes = 256;                 // chunk size plus extensions
+    size_t max_header_count = 100;
+    size_t max_body_bytes = 1024 * 1024;              // bodies buffered whole
+    size_t max_streamed_body_bytes = 64 * 1024 * 1024; // bodies handed over in pieces
+};
+
+// Resumable HTTP/1.x request parser.
+//
+// parse() is called with the connection's input buffer every time new
+// bytes are appended and continues from where the previous call stopped,
+// so each byte is scanned once. Positions are kept as offsets rather than
+// pointers because the buffer may reallocate between calls. Chunked bodies
+// are de-chunked in place, leaving the body contiguous in the buffer.
+//
+// With setPauseAfterHeaders() the parser stops once the header block is
+// complete so the caller can choose, per request, between buffering the
+// body and streaming it out with takeBody() as it arrives.
+class HttpRequestParser {
+public:
+    enum class Result {
+        INCOMPLETE,
+        HEADERS,  // header block done; call continueBody() (pause mode only)
+        COMPLETE,
+        ERROR
+    };
+
+    using Limits = HttpParserLimits;
+
+    explicit HttpRequestParser(const Limits& limits = Limits());
+
+    Result parse(std::string& buffer);
+    void reset();
+
+    // Kept across reset()
+    void setPauseAfterHeaders(bool pause) { pause_after_headers_ = pause; }
+
+    // After HEADERS: read the body whole (subject to max_body_bytes) or as
+    // a stream (max_streamed_body_bytes). False if it is already too large.
+    bool continueBody(bool stream);
+
+    // Streaming only: move the body bytes decoded so far out of `buffer`
+    // into `chunk`, leaving the framing still to be parsed in place
+    void takeBody(std::string& buffer, std::string& chunk);
+
+    // True once the header block is complete and the body is being read
+    bool inBody() const {
+        return state_ != State::REQUEST_LINE && state_ != State::HEADERS && state_ != State::HEADERS_DONE;
+    }
+
+    // Valid after COMPLETE: number of buffer bytes the message occupied
+    size_t getMessageLength() const { return position_; }
+
+    // Valid after ERROR: the status code to answer with
+    int getErrorStatus() const { return error_status_; }
+    const std::string& getErrorMessage() const { return error_message_; }
+
+    // Fill `request` with views into `storage`, which must hold the bytes
+    // that were passed to parse()
+    void buildRequest(const std::shared_ptr<const std::string>& storage, HttpRequest& request) const;
+
+private:
+    enum class State {
+        REQUEST_LINE,
+        HEADERS,
+        HEADERS_DONE,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        TRAILERS,
+        COMPLETE,
+        ERROR
+    };
+
+    struct Span {
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    struct HeaderSpan {
+        Span name;
+        Span value;
+    };
+
+    Limits limits_;
+    State state_;
+    size_t position_;      // first byte not yet consumed
+    size_t scan_position_; // where the search for the next '\n' resumes
+
+    Span method_;
+    Span target_;
+    Span version_;
+    std::vector<HeaderSpan> headers_;
+
+    bool pause_after_headers_;
+    bool streaming_;
+    bool chunked_;
+    bool has_content_length_;
+    size_t content_length_;
+    size_t body_start_;
+    size_t body_length_;   // decoded body bytes in the buffer
+    size_t body_taken_;    // streamed bytes already moved out by takeBody()
+    size_t chunk_remaining_;
+    size_t trailer_bytes_;  // trailer section consumed so far
+
+    int error_status_;
+    std::string error_message_;
+
+    bool nextLine(const std::string& buffer, Span& line);
+    bool parseRequestLine(const std::string& buffer, const Span& line);
+    bool parseHeaderLine(const std::string& buffer, const Span& line);
+    bool finishHeaders();
+    bool startBody();
+    size_t bodyLimit() const { return streaming_ ? limits_.max_streamed_body_bytes : limits_.max_body_bytes; }
+    bool parseChunkSize(const std::string& buffer, const Span& line);
+    Result fail(int status, const std::string& message);
+};
+
+} // namespace AITextAssistant
@@ -1,40 +1,36 @@
 #pragma once
 
+#include "common/types.h"
+#include "web/http_message.h"
+#include "web/http2_session.h"
+#include "web/http_parser.h"
+#include "web/request_body.h"
+#include "web/websocket.h"
+#include "web/router.h"
+#include "utils/compression.h"
+#include "utils/task.h"
 #include <string>
 #include <functional>
 #include <map>
 #include <thread>
 #include <atomic>
+#include <cstdint>
+#include <ctime>
 #include <memory>
+#include <shared_mutex>
 #include <vector>
 
 namespace AITextAssistant {
 
 // Forward declaration
 class TextAssistant;
+class EventLoop;
+class HttpConnection;
+class ThreadPool;
+class StaticFileCache;
 
-// HTTP request structure
-struct HttpRequest {
-    std::string method;
-    std::string path;
-    std::string body;
-    std::map<std::string, std::string> headers;
-    std::map<std::string, std::string> query_params;
-};
-
-// HTTP response structure
-struct HttpResponse {
-    int status_code = 200;
-    std::string body;
-    std::map<std::string, std::string> headers;
-    
-    HttpResponse() {
-        headers["Content-Type"] = "text/html; charset=utf-8";
-        headers["Access-Control-Allow-Origin"] = "*";
-        headers["Access-Control-Allow-Methods"] = "GET, POST, OPTIONS";
-        headers["Access-Control-Allow-Headers"] = "Content-Type";
-    }
-};
+// Handler written as a coroutine; it owns its copy of the request
+using CoroutineHttpHandler = std::function<Task<HttpResponse>(HttpRequest)>;
 
 struct RouteConfig {
     std::string method;
@@ -42,60 +38,150 @@ struct RouteConfig {
     std::function<HttpResponse(const HttpRequest&)> handler;
 };
 
-// HTTP handler function type
-using HttpHandler = std::function<HttpResponse(const HttpRequest&)>;
-
 // Simple HTTP server class
 class HttpServer {
 public:
-    explicit HttpServer(int port = 8080);
+    explicit HttpServer(int port = 8080, const ServerConfig& config = ServerConfig());
     ~HttpServer();
     
     // Server control
     bool start();
     void stop();
     bool isRunning() const { return running_; }
+    int getPort() const { return port_; }
     
-    // Route registration
+    // Route registration; "{name}" segments in `path` are captured into
+    // HttpRequest::path_params
     void addRoute(const std::string& method, const std::string& path, HttpHandler handler);
+    // Like addRoute(), but the handler is called once the headers are in
+    // and reads the body from HttpRequest::body_reader as it arrives, up
+    // to max_streamed_body_bytes, instead of finding it in `body`.
+    // Register before start().
+    void addStreamingRoute(const std::string& method, const std::string& path, HttpHandler handler);
+    // Like addRoute(), but the handler answers through its responder, from
+    // any thread, so a route waiting on the LLM does not hold a worker
+    void addAsyncRoute(const std::string& method, const std::string& path, AsyncHttpHandler handler);
+    // Async route written as a coroutine: it starts on the worker and
+    // answers with whatever it co_returns, wherever it finishes. A task
+    // that throws gets a 500.
+    void addCoroutineRoute(const std::string& method, const std::string& path, CoroutineHttpHandler handler);
+    // WebSocket endpoint: a GET with "Upgrade: websocket" on `path` is
+    // upgraded and each message is passed to `handler` on a worker. Plain
+    // requests to the path get 426. Register before start().
+    void addWebSocketRoute(const std::string& path, WebSocket::MessageHandler handler);
+    // Like addWebSocketRoute(), but a message is handled once the handler
+    // calls `done`, from any thread, so a handler waiting on the LLM does
+    // not hold a worker. Such handlers answer with WebSocket::pushText().
+    void addAsyncWebSocketRoute(const std::string& path, WebSocket::AsyncMessageHandler handler);
     void setAssistant(std::shared_ptr<TextAssistant> assistant) { assistant_ = assistant; }
     
     // Static file serving
     void setStaticDirectory(const std::string& directory) { static_directory_ = directory; }
     
 private:
+    // One event loop per core, each owning the connections handed to it
+    struct LoopThread;
+    // Lets async responses that complete after stop() be dropped
+    struct ResponseGate;
+
+    enum class RangeResult {
+        NONE,           // absent, malformed or multi-range: send the whole file
+        SATISFIABLE,
+        UNSATISFIABLE
+    };
+
     int port_;
+    ServerConfig config_;
     std::atomic<bool> running_;
-    std::thread server_thread_;
-    std::map<std::string, HttpHandler> routes_;
+    Router router_;
+    Router streaming_routes_; // subset of router_ whose bodies are streamed
+    bool has_streaming_routes_;
+    std::map<std::string, WebSocket::AsyncMessageHandler> websocket_routes_;
     std::shared_ptr<TextAssistant> assistant_;
     std::string static_directory_;
-    int server_socket_;
+    bool sharded_accept_;  // one SO_REUSEPORT listener per loop
+    size_t io_thread_count_;
+    std::vector<std::unique_ptr<LoopThread>> loop_threads_;
+    size_t next_loop_;
+    std::unique_ptr<ThreadPool> worker_pool_;
+    std::unique_ptr<StaticFileCache> static_cache_;
+    std::shared_ptr<ResponseGate> response_gate_;
     
     // Server implementation
-    void serverLoop();
-    void handleClient(int client_socket);
-    HttpRequest parseRequest(const std::string& request_data);
-    std::string buildResponse(const HttpResponse& response);
-    HttpResponse handleRequest(const HttpRequest& request);
+    int createListenSocket(bool& reuse_port);
+    // Start delivering the listener's connections to handleAccept() or,
+    // on io_uring, through armAccept()
+    void watchListener(LoopThread* acceptor);
+    void handleAccept(LoopThread* acceptor);
+    void armAccept(LoopThread* acceptor);
+    // Rate-limited: a burst of failures is reported once per interval
+    void logAcceptError(LoopThread* acceptor, int error);
+    void dispatchConnection(LoopThread* acceptor, int client_socket);
+    void addConnection(LoopThread* target, int client_socket);
+    void pinLoopThreads();
+    bool shouldKeepAlive(const HttpRequest& request) const;
+    void onRequest(const std::shared_ptr<HttpConnection>& connection, HttpRequest request);
+    // The response senders are called holding `gate_lock` on `gate` and
+    // return holding it; streamed bodies release it while being produced
+    void sendHttp1Response(const std::shared_ptr<HttpConnection>& connection, const HttpRequest& request,
+                           HttpResponse& response, bool last_allowed, ResponseGate& gate,
+                           std::shared_lock<std::shared_mutex>& gate_lock);
+    void onParseError(const std::shared_ptr<HttpConnection>& connection, int status_code);
+    void acceptWebSocket(const std::shared_ptr<HttpConnection>& connection, const HttpRequest& request,
+                         const WebSocket::AsyncMessageHandler& handler);
+    HttpParserLimits parserLimits() const;
+    // HTTP/2 streams are served by the same handlers as HTTP/1 requests
+    std::shared_ptr<Http2Session> createHttp2Session(const std::shared_ptr<HttpConnection>& connection);
+    bool upgradeToHttp2(const std::shared_ptr<HttpConnection>& connection, const HttpRequest& request);
+    void onHttp2Request(const std::shared_ptr<Http2Session>& session, uint32_t stream_id, HttpRequest request);
+    void onHttp2Error(const std::shared_ptr<Http2Session>& session, uint32_t stream_id, int status_code);
+    void sendHttp2Response(const std::shared_ptr<Http2Session>& session, uint32_t stream_id,
+                           const HttpRequest& request, HttpResponse& response, ResponseGate& gate,
+                           std::shared_lock<std::shared_mutex>& gate_lock);
+    void sendStreamedResponse(const std::shared_ptr<HttpConnection>& connection,
+                              const HttpResponse& response, bool chunked, bool keep_alive,
+                              ResponseGate& gate, std::shared_lock<std::shared_mutex>& gate_lock);
+    // HttpResponse::push_stream bodies: the sender returns once the
+    // producer has its writer, and the body is finished from wherever the
+    // producer ends it
+    void sendPushedResponse(const std::shared_ptr<HttpConnection>& connection, const HttpResponse& response,
+                            bool chunked, bool keep_alive, std::shared_lock<std::shared_mutex>& gate_lock);
+    void sendPushedHttp2Response(const std::shared_ptr<Http2Session>& session, uint32_t stream_id,
+                                 const HttpResponse& response, std::shared_lock<std::shared_mutex>& gate_lock);
+    ContentEncoding selectResponseEncoding(const HttpRequest& request, HttpResponse& response) const;
+    // Serialize the status line and headers; the body to send after them
+    // is handed back through `body` rather than appended to the head
+    std::string buildResponse(HttpResponse& response, std::shared_ptr<const std::string>& body,
+                              ContentEncoding encoding = ContentEncoding::IDENTITY);
+    std::string buildResponseHead(const HttpResponse& response, const std::string& framing_header);
+    static const char* statusText(int status_code);
+    // Runs the route for `request`; `respond` is called exactly once, on
+    // this thread or, for async routes, whenever the handler completes
+    void handleRequest(HttpRequest& request, HttpResponder respond);
+    HttpResponse buildOverloadedResponse();
     
     // Built-in handlers
     HttpResponse handleStaticFile(const HttpRequest& request);
-    HttpResponse handleApiChat(const HttpRequest& request);
+    static bool isNotModified(const HttpRequest& request, const std::string& etag, time_t modified_time);
+    static RangeResult parseByteRange(std::string_view header, uint64_t size,
+                                      uint64_t& start, uint64_t& length);
+    Task<HttpResponse> handleApiChat(HttpRequest request);
     HttpResponse handleApiConversations(const HttpRequest& request);
     HttpResponse handleApiConversationMessages(const HttpRequest& request);
     HttpResponse handleApiDeleteConversation(const HttpRequest& request);
     HttpResponse handleApiStatus(const HttpRequest& request);
     HttpResponse handleResponseOK(const HttpRequest& request);
+    Task<void> handleWebSocketChat(std::shared_ptr<WebSocket> socket, std::string message, bool binary);
 
     // OpenAI-compatible handlers
-    HttpResponse handleOpenAIChat(const HttpRequest& request);
+    Task<HttpResponse> handleOpenAIChat(HttpRequest request);
     HttpResponse handleOpenAIModels(const HttpRequest& request);
     
     // Utility functions
-    std::string getMimeType(const std::string& filename);
-    std::string urlDecode(const std::string& str);
-    std::map<std::string, std::string> parseQueryString(const std::string& query);
+    // Fill request.query_params from request.query; decoded text that
+    // differs from the original goes into the request's arena
+    static void parseQueryString(HttpRequest& request);
+    static std::string_view urlDecode(std::string_view text, HttpRequest& request);
 };
 
 } // namespace AITextAssistant
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace AITextAssistant {
+
+// Monotonic memory for the short-lived data of one request, such as
+// decoded query parameters. The first INLINE_BYTES come from a buffer
+// inside the arena and nothing is freed until reset(), so a typical
+// request allocates nothing beyond the arena itself.
+//
+// Each connection keeps one arena and hands it to its requests in turn:
+// acquire() resets and reuses it once no copy of the previous request
+// holds it any more, and starts a new one otherwise.
+class RequestArena {
+public:
+    static constexpr size_t INLINE_BYTES = 2048;
+
+    RequestArena() : resource_(buffer_.data(), buffer_.size()) {}
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+
+    // Raw bytes, valid until the arena is reset or destroyed
+    char* allocate(size_t bytes) { return static_cast<char*>(resource_.allocate(bytes, 1)); }
+
+    // The arena in `slot`, emptied, if nothing else holds it; otherwise
+    // a new arena, which replaces it in `slot`. Call from one thread.
+    static std::shared_ptr<RequestArena> acquire(std::shared_ptr<RequestArena>& slot) {
+        if (slot && slot.use_count() == 1) {
+            // Pairs with the release of the last other reference, so its
+            // writes into the arena happen before the memory is reused
+            std::atomic_thread_fence(std::memory_order_acquire);
+            slot->resource_.release();
+        } else {
+            slot = std::make_shared<RequestArena>();
+        }
+        return slot;
+    }
+
+private:
+    alignas(std::max_align_t) std::array<std::byte, INLINE_BYTES> buffer_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+} // namespace AITextAssistant
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace AITextAssistant {
+
+// Hands a streamed request body from the connection's event loop to the
+// handler running on a worker thread.
+//
+// The connection push()es pieces as they arrive and stops reading from
+// the socket while isFull(); once the handler has drained the queue to
+// half of that mark the drain callback asks the connection to read again.
+// A handler that returns without reading everything abandons the rest,
+// which the connection then discards so the connection stays usable.
+class RequestBodyReader {
+public:
+    RequestBodyReader(size_t high_water_bytes, std::function<void()> on_drain);
+
+    RequestBodyReader(const RequestBodyReader&) = delete;
+    RequestBodyReader& operator=(const RequestBodyReader&) = delete;
+
+    // Handler side. Blocks until the next piece is available; returns false
+    // at the end of the body, or when it was cut short (see complete()).
+    bool read(std::string& chunk);
+
+    // After read() returned false: whether the whole body was received
+    bool complete() const;
+
+    // Convenience for handlers that want the body in one string after all;
+    // false if it was cut short
+    bool readAll(std::string& body);
+
+    // Connection side (event loop thread)
+    void push(std::string chunk);
+    void finish(bool complete);
+    void abandon();
+    bool isFull();
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::string> chunks_;
+    size_t buffered_;
+    size_t high_water_;
+    bool finished_;
+    bool complete_;
+    bool abandoned_;
+    bool paused_; // the connection stopped reading and awaits on_drain_
+    std::function<void()> on_drain_;
+};
+
+} // namespace AITextAssistant
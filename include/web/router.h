@@ -0,0 +1,78 @@
+#pragma once
+
+#include "web/http_message.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace AITextAssistant {
+
+// HTTP handler function type
+using HttpHandler = std::function<HttpResponse(const HttpRequest&)>;
+
+// Delivers an asynchronous handler's response; call it once, from any
+// thread. A streamed response is written on the calling thread.
+using HttpResponder = std::function<void(HttpResponse)>;
+
+// Handler that returns without answering and calls the responder once the
+// response is ready (e.g. when an upstream call completes), so no worker
+// is held in the meantime. The request is only valid during the call.
+using AsyncHttpHandler = std::function<void(const HttpRequest&, HttpResponder)>;
+
+// What a route resolves to: exactly one of the two handlers is set
+struct Route {
+    HttpHandler handler;
+    AsyncHttpHandler async_handler;
+
+    explicit operator bool() const { return handler || async_handler; }
+};
+
+// Segment trie over route patterns such as "/api/conversations/{id}/messages".
+//
+// Each node holds its literal children sorted by segment, at most one
+// "{name}" parameter child, and one handler slot per method. Lookup walks
+// the request path in place: literal segments win over parameters, with
+// backtracking when a literal branch has no handler for the method.
+// Matching does not allocate; captured values are views into the path.
+class Router {
+public:
+    Router();
+    ~Router();
+
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    // Register or replace the handler for `method` on `pattern`. Fails on
+    // an unknown method, a malformed pattern, or a parameter that clashes
+    // with a differently named one at the same position.
+    bool add(std::string_view method, std::string_view pattern, HttpHandler handler);
+    bool add(std::string_view method, std::string_view pattern, AsyncHttpHandler handler);
+
+    // Find the route for a request; on success `params` holds the
+    // captured path parameters
+    const Route* match(std::string_view method, std::string_view path, PathParams& params) const;
+
+private:
+    enum Method {
+        GET,
+        HEAD,
+        POST,
+        PUT,
+        DELETE,
+        PATCH,
+        OPTIONS,
+        METHOD_COUNT
+    };
+
+    struct Node;
+
+    std::unique_ptr<Node> root_;
+
+    static int methodIndex(std::string_view method);
+    Route* insert(std::string_view method, std::string_view pattern);
+    static const Node* find(const Node* node, std::string_view path, int method, PathParams& params);
+};
+
+} // namespace AITextAssistant
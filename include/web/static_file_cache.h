@@ -0,0 +1,104 @@
+#pragma once
+
+#include "utils/compression.h"
+#include <sys/stat.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace AITextAssistant {
+
+// A static file's validators and the response header lines rendered once
+// at load time. Small files also keep their content in memory; large ones
+// are left on disk for the caller to send with sendfile().
+struct StaticAsset {
+    bool in_memory = true;
+    std::string body;
+    std::string content_type;
+    std::string etag;           // strong: content hash, or file identity when not in memory
+    std::string last_modified;  // IMF-fixdate
+    time_t modified_time = 0;
+
+    // "Name: value\r\n" lines for a 200 response and for a 304
+    std::string header_block;
+    std::string validator_block;
+
+    // File identity used to detect changes on disk
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+
+    // Text-like content that is worth offering compressed
+    bool compressible = false;
+
+    // A compressed representation with its own ETag and header lines
+    struct Variant {
+        std::string body;
+        std::string etag;
+        std::string header_block;
+        std::string validator_block;
+    };
+
+    // Built on first request by StaticFileCache::getVariant(); a ready
+    // slot holding nullptr means compression did not pay off
+    mutable std::mutex variant_mutex;
+    mutable std::shared_ptr<const Variant> variants[2];
+    mutable bool variant_ready[2] = {false, false};
+};
+
+// Path-keyed cache of static files. Lookups are a shared-lock hash probe;
+// each entry re-stats its file at most once per revalidate interval and
+// is reloaded when the inode, size or mtime changed. The byte budget
+// covers identity bodies; compressed variants are a fraction on top.
+class StaticFileCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StaticFileCache(size_t max_file_bytes = 1024 * 1024,
+                             size_t max_total_bytes = 64 * 1024 * 1024,
+                             std::chrono::milliseconds revalidate_interval = std::chrono::seconds(1));
+
+    // Returns nullptr when the file does not exist or cannot be read.
+    // Files of max_file_bytes or more are returned without a body; files
+    // that would exceed the total budget are loaded but not retained.
+    std::shared_ptr<const StaticAsset> get(const std::string& file_path);
+
+    // The asset encoded with `encoding`, taken from a fresh .gz/.br sibling
+    // of the file when one exists and compressed once otherwise. Returns
+    // nullptr when the identity body should be sent instead.
+    std::shared_ptr<const StaticAsset::Variant> getVariant(const std::shared_ptr<const StaticAsset>& asset,
+                                                           const std::string& file_path,
+                                                           ContentEncoding encoding);
+
+    void clear();
+    size_t size() const;
+    size_t totalBytes() const { return total_bytes_; }
+
+    static std::string mimeType(const std::string& file_path);
+
+private:
+    struct Entry {
+        std::shared_ptr<const StaticAsset> asset;
+        std::atomic<int64_t> checked_at_ms;
+    };
+
+    size_t max_file_bytes_;
+    size_t max_total_bytes_;
+    std::chrono::milliseconds revalidate_interval_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries_;
+    std::atomic<size_t> total_bytes_;
+
+    std::shared_ptr<const StaticAsset> load(const std::string& file_path, const struct stat& info);
+    void erase(const std::string& file_path);
+    static int64_t nowMs();
+};
+
+} // namespace AITextAssistant
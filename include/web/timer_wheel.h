@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace AITextAssistant {
+
+// Hierarchical timing wheel for coarse deadlines such as per-connection
+// read timeouts.
+//
+// Four levels of 64 slots: level 0 moves one slot per tick and each level
+// above spans 64 times the one below, so a 100 ms tick covers about 19
+// days. Entries are intrusive, which makes schedule() and cancel() O(1)
+// list operations with no allocation; an entry moves down a level only
+// when the level below wraps. Owned and advanced by a single event loop.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A timer slot embedded in its owner. Destroying it cancels it.
+    class Entry {
+    public:
+        explicit Entry(std::function<void()> callback = nullptr)
+            : callback_(std::move(callback)), wheel_(nullptr), next_(nullptr), pprev_(nullptr), expires_(0) {}
+        ~Entry();
+
+        Entry(const Entry&) = delete;
+        Entry& operator=(const Entry&) = delete;
+
+        void setCallback(std::function<void()> callback) { callback_ = std::move(callback); }
+        bool isScheduled() const { return pprev_ != nullptr; }
+
+    private:
+        friend class TimerWheel;
+
+        std::function<void()> callback_;
+        TimerWheel* wheel_;
+        Entry* next_;
+        Entry** pprev_; // the pointer that points at this entry
+        uint64_t expires_;
+    };
+
+    explicit TimerWheel(std::chrono::milliseconds tick, Clock::time_point now = Clock::now());
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // (Re)arm `entry` to fire `delay` from now, rounded up to whole ticks
+    void schedule(Entry& entry, std::chrono::milliseconds delay);
+    void cancel(Entry& entry);
+
+    // Fire every entry due at `now`; returns how many ran. Callbacks may
+    // schedule or cancel any entry, including their own.
+    size_t advance(Clock::time_point now = Clock::now());
+
+    std::chrono::milliseconds tick() const { return tick_; }
+    size_t size() const { return count_; }
+
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr uint64_t SLOTS = uint64_t(1) << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint64_t MAX_DELTA = (uint64_t(1) << (LEVELS * SLOT_BITS)) - 1;
+
+    std::array<std::array<Entry*, SLOTS>, LEVELS> slots_;
+    std::chrono::milliseconds tick_;
+    Clock::time_point start_;
+    uint64_t current_; // next tick to process
+    size_t count_;
+
+    void insert(Entry& entry);
+    static void link(Entry*& head, Entry& entry);
+    static void unlink(Entry& entry);
+    void cascade(int level);
+};
+
+} // namespace AITextAssistant
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+namespace AITextAssistant {
+
+// A protocol an HttpConnection hands its socket over to after an upgrade
+// (WebSocket, HTTP/2). From then on the connection only moves bytes: input
+// is fed to consume() and output is written as stream pieces. All hooks
+// run on the connection's event loop thread.
+class UpgradedProtocol {
+public:
+    virtual ~UpgradedProtocol() = default;
+
+    // Installed on the connection; output may be written from here on
+    virtual void start() {}
+
+    // Decode what it can from the input, erasing the consumed bytes
+    virtual void consume(std::string& buffer) = 0;
+
+    // True while reading from the socket should pause
+    virtual bool isBacklogged() = 0;
+
+    // Everything written so far has reached the socket
+    virtual void onOutputFlushed() {}
+
+    virtual void onClosed() = 0;
+};
+
+} // namespace AITextAssistant
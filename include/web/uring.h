@@ -0,0 +1,89 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace AITextAssistant {
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing): the SQ/CQ
+// rings, SQE allocation and submission, completion iteration, and one
+// group of provided buffers for multishot recv. Single-threaded, like the
+// EventLoop that owns it.
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool init(unsigned entries);
+    bool isValid() const { return ring_fd_ >= 0; }
+
+    // Next free SQE, zeroed; flushes the queue to the kernel when it is
+    // full. Returns nullptr only if the kernel will not take more.
+    io_uring_sqe* getSqe();
+
+    // Make sure `count` SQEs can be taken without an intermediate flush,
+    // which would split a linked chain across submissions
+    bool reserve(unsigned count);
+
+    // Submit queued SQEs and wait for at least `wait_nr` completions.
+    // Returns the number submitted or -errno.
+    int submitAndWait(unsigned wait_nr);
+
+    // Visit every available CQE; the entry is consumed before `fn` runs,
+    // so the callback may queue new SQEs
+    template <typename Fn>
+    unsigned forEachCompletion(Fn fn);
+
+    // Provided buffers for IOSQE_BUFFER_SELECT recv. Handed over with
+    // IORING_OP_PROVIDE_BUFFERS rather than a registered buffer ring, which
+    // is not reliably usable on every kernel that has multishot recv.
+    bool provideBuffers(uint16_t group, unsigned count, size_t buffer_size);
+    const char* buffer(uint16_t id) const { return buffers_ + static_cast<size_t>(id) * buffer_size_; }
+    // Give a consumed buffer back; queued with the next submission
+    void recycleBuffer(uint16_t id);
+
+private:
+    int ring_fd_;
+
+    void* sq_ring_;
+    size_t sq_ring_size_;
+    void* cq_ring_;
+    size_t cq_ring_size_;
+    io_uring_sqe* sqes_;
+    size_t sqes_size_;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned sqe_tail_; // SQEs handed out, published to *sq_tail_ on submit
+
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned cq_mask_;
+    io_uring_cqe* cqes_;
+
+    char* buffers_;
+    size_t buffer_size_;
+    uint16_t buf_group_;
+
+    bool peekCompletion(io_uring_cqe& cqe);
+    void release();
+};
+
+template <typename Fn>
+unsigned IoUring::forEachCompletion(Fn fn) {
+    unsigned count = 0;
+    io_uring_cqe cqe;
+    while (peekCompletion(cqe)) {
+        fn(cqe);
+        ++count;
+    }
+    return count;
+}
+
+} // namespace AITextAssistant
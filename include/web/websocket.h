@@ -0,0 +1,162 @@
+#pragma once
+
+#include "web/upgraded_protocol.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace AITextAssistant {
+
+class HttpConnection;
+
+enum class WebSocketOpcode : uint8_t {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+};
+
+// Close status codes (RFC 6455 section 7.4.1)
+enum class WebSocketStatus : uint16_t {
+    NORMAL = 1000,
+    GOING_AWAY = 1001,
+    PROTOCOL_ERROR = 1002,
+    UNSUPPORTED_DATA = 1003,
+    INVALID_DATA = 1007,
+    POLICY_VIOLATION = 1008,
+    MESSAGE_TOO_BIG = 1009,
+    INTERNAL_ERROR = 1011,
+    TRY_AGAIN_LATER = 1013
+};
+
+// Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key
+std::string webSocketAccept(std::string_view key);
+
+// One unmasked, unfragmented server frame
+std::string encodeWebSocketFrame(WebSocketOpcode opcode, std::string_view payload);
+
+bool isValidUtf8(std::string_view text);
+
+// Decodes client frames one at a time from the connection's input buffer.
+// Frames must be masked; the payload is unmasked into the frame. Rejects
+// reserved bits and opcodes, oversized or fragmented control frames, and
+// payloads over the size limit before any of it is buffered.
+class WebSocketFrameParser {
+public:
+    enum class Result {
+        INCOMPLETE,
+        FRAME,
+        ERROR
+    };
+
+    struct Frame {
+        WebSocketOpcode opcode = WebSocketOpcode::TEXT;
+        bool fin = false;
+        std::string payload;
+    };
+
+    explicit WebSocketFrameParser(size_t max_payload_bytes) : max_payload_(max_payload_bytes) {}
+
+    // Decode the frame at `offset`; on FRAME `offset` moves past it
+    Result parse(const std::string& buffer, size_t& offset, Frame& frame);
+
+    // Valid after ERROR: the close status to fail the connection with
+    WebSocketStatus getErrorStatus() const { return error_status_; }
+
+private:
+    size_t max_payload_;
+    WebSocketStatus error_status_ = WebSocketStatus::PROTOCOL_ERROR;
+
+    Result fail(WebSocketStatus status);
+};
+
+// Server side of one upgraded connection.
+//
+// The connection's event loop feeds input through consume(), which answers
+// pings and the close handshake itself and reassembles data messages.
+// Messages are handed to the handler on a worker, one at a time and in
+// order; while too many wait, the connection stops reading from the
+// socket. Handlers reply with sendText() from their worker thread, which
+// blocks while the peer is slow to take what was already sent, or with
+// pushText() from threads that must not wait.
+class WebSocket : public UpgradedProtocol, public std::enable_shared_from_this<WebSocket> {
+public:
+    using MessageHandler = std::function<void(const std::shared_ptr<WebSocket>&, const std::string& message, bool binary)>;
+    // The message is handled once `done` is called, from any thread, which
+    // may be after the handler returned; the next one waits until then
+    using AsyncMessageHandler = std::function<void(const std::shared_ptr<WebSocket>&, const std::string& message,
+                                                   bool binary, std::function<void()> done)>;
+    // Runs `task` on a worker thread; false if none can take it
+    using Dispatcher = std::function<bool(std::function<void()> task)>;
+    // Runs `use`, which touches the connection or the dispatcher, unless
+    // the server owning them has stopped; false if it did not
+    using OutputGuard = std::function<bool(const std::function<void()>& use)>;
+
+    WebSocket(std::weak_ptr<HttpConnection> connection, AsyncMessageHandler handler, Dispatcher dispatcher,
+              OutputGuard guard, size_t max_message_bytes);
+
+    WebSocket(const WebSocket&) = delete;
+    WebSocket& operator=(const WebSocket&) = delete;
+
+    // Any thread. False once the socket is closing or the peer stopped
+    // reading for SEND_TIMEOUT, in which case the connection is dropped.
+    bool sendText(std::string_view text);
+    bool sendBinary(std::string_view data);
+    // Never blocks: false, dropping the connection, once more than
+    // MAX_OUTPUT_BACKLOG is unsent
+    bool pushText(std::string_view text);
+
+    // Start the close handshake; the connection closes once it is flushed
+    void close(WebSocketStatus status = WebSocketStatus::NORMAL, std::string_view reason = {});
+    bool isOpen() const { return open_; }
+
+    // Connection side (event loop thread)
+    void consume(std::string& buffer) override;
+    bool isBacklogged() override;
+    void onClosed() override;
+
+    // Unsent output above which sendText() waits
+    static constexpr size_t MAX_OUTPUT_BACKLOG = 256 * 1024;
+    static constexpr std::chrono::seconds SEND_TIMEOUT{30};
+    // Received messages queued for the handler before reading pauses
+    static constexpr size_t MAX_PENDING_MESSAGES = 16;
+
+private:
+    std::weak_ptr<HttpConnection> connection_;
+    AsyncMessageHandler handler_;
+    Dispatcher dispatcher_;
+    OutputGuard guard_;
+    std::atomic<bool> open_; // false once a close frame was sent or the socket closed
+
+    // Event loop only
+    WebSocketFrameParser parser_;
+    size_t max_message_;
+    std::string fragments_;
+    WebSocketOpcode fragment_opcode_;
+    bool in_message_;
+    bool input_closed_;
+
+    std::mutex mutex_;
+    std::deque<std::pair<std::string, bool>> inbox_;
+    bool dispatching_;
+    bool paused_;
+
+    bool send(WebSocketOpcode opcode, std::string_view payload, bool wait);
+    void handleFrame(WebSocketFrameParser::Frame& frame);
+    void deliver(std::string message, bool binary);
+    // Runs drain() on a worker; false if the socket was closed instead
+    bool dispatch();
+    void fail(WebSocketStatus status);
+    void drain();
+};
+
+} // namespace AITextAssistant
@@ -56,6 +56,7 @@ bool ConfigManager::saveConfig(const std::string& config_file) const {
 void ConfigManager::loadDefaultConfig() {
     setDefaultLLMConfig();
     setDefaultPromptConfig();
+    setDefaultServerConfig();
     
     app_config_.database_path = DEFAULT_DATABASE_PATH;
     app_config_.log_level = "INFO";
@@ -83,7 +84,8 @@ void ConfigManager::setPromptConfig(const PromptConfig& config) {
 
 bool ConfigManager::validateConfig() const {
     return validateLLMConfig(app_config_.llm) &&
-           validatePromptConfig(app_config_.prompt);
+           validatePromptConfig(app_config_.prompt) &&
+           validateServerConfig(app_config_.server);
 }
 
 std::vector<std::string> ConfigManager::getAvailablePromptTemplates() const {
@@ -154,6 +156,27 @@ void ConfigManager::fromJson(const nlohmann::json& j) {
         app_config_.prompt.max_history_messages = prompt_json.value("max_history_messages", 10);
     }
 
+    // Parse server config
+    if (j.contains("server")) {
+        const auto& server_json = j["server"];
+        app_config_.server.io_threads = server_json.value("io_threads", 0);
+        app_config_.server.worker_threads = server_json.value("worker_threads", 8);
+        app_config_.server.max_queue_size = server_json.value("max_queue_size", 256);
+        app_config_.server.retry_after_seconds = server_json.value("retry_after_seconds", 1);
+        app_config_.server.keep_alive_timeout_seconds = server_json.value("keep_alive_timeout_seconds", 5);
+        app_config_.server.max_requests_per_connection = server_json.value("max_requests_per_connection", 100);
+        app_config_.server.sendfile_threshold_bytes = server_json.value("sendfile_threshold_bytes", 1048576);
+        app_config_.server.compression_min_bytes = server_json.value("compression_min_bytes", 1024);
+        app_config_.server.pin_io_threads = server_json.value("pin_io_threads", true);
+        app_config_.server.listen_backlog = server_json.value("listen_backlog", 1024);
+        app_config_.server.io_backend = server_json.value("io_backend", "epoll");
+        app_config_.server.header_timeout_seconds = server_json.value("header_timeout_seconds", 10);
+        app_config_.server.body_timeout_seconds = server_json.value("body_timeout_seconds", 30);
+        app_config_.server.max_header_bytes = server_json.value("max_header_bytes", 8192);
+        app_config_.server.max_body_bytes = server_json.value("max_body_bytes", 1048576);
+        app_config_.server.max_streamed_body_bytes = server_json.value("max_streamed_body_bytes", 67108864);
+    }
+
     // Parse general config
     app_config_.database_path = j.value("database_path", DEFAULT_DATABASE_PATH);
     app_config_.log_level = j.value("log_level", "INFO");
@@ -179,6 +202,24 @@ nlohmann::json ConfigManager::toJson() const {
     j["prompt"]["context_template"] = app_config_.prompt.context_template;
     j["prompt"]["max_history_messages"] = app_config_.prompt.max_history_messages;
 
+    // Server config
+    j["server"]["io_threads"] = app_config_.server.io_threads;
+    j["server"]["worker_threads"] = app_config_.server.worker_threads;
+    j["server"]["max_queue_size"] = app_config_.server.max_queue_size;
+    j["server"]["retry_after_seconds"] = app_config_.server.retry_after_seconds;
+    j["server"]["keep_alive_timeout_seconds"] = app_config_.server.keep_alive_timeout_seconds;
+    j["server"]["max_requests_per_connection"] = app_config_.server.max_requests_per_connection;
+    j["server"]["sendfile_threshold_bytes"] = app_config_.server.sendfile_threshold_bytes;
+    j["server"]["compression_min_bytes"] = app_config_.server.compression_min_bytes;
+    j["server"]["pin_io_threads"] = app_config_.server.pin_io_threads;
+    j["server"]["listen_backlog"] = app_config_.server.listen_backlog;
+    j["server"]["io_backend"] = app_config_.server.io_backend;
+    j["server"]["header_timeout_seconds"] = app_config_.server.header_timeout_seconds;
+    j["server"]["body_timeout_seconds"] = app_config_.server.body_timeout_seconds;
+    j["server"]["max_header_bytes"] = app_config_.server.max_header_bytes;
+    j["server"]["max_body_bytes"] = app_config_.server.max_body_bytes;
+    j["server"]["max_streamed_body_bytes"] = app_config_.server.max_streamed_body_bytes;
+
     // General config
     j["database_path"] = app_config_.database_path;
     j["log_level"] = app_config_.log_level;
@@ -229,6 +270,85 @@ bool ConfigManager::validatePromptConfig(const PromptConfig& config) const {
     return true;
 }
 
+bool ConfigManager::validateServerConfig(const ServerConfig& config) const {
+    if (config.io_threads < 0) {
+        LOG_ERROR("Server io_threads cannot be negative");
+        return false;
+    }
+
+    if (config.worker_threads <= 0) {
+        LOG_ERROR("Server worker_threads must be positive");
+        return false;
+    }
+
+    if (config.max_queue_size <= 0) {
+        LOG_ERROR("Server max_queue_size must be positive");
+        return false;
+    }
+
+    if (config.retry_after_seconds < 0) {
+        LOG_ERROR("Server retry_after_seconds cannot be negative");
+        return false;
+    }
+
+    if (config.keep_alive_timeout_seconds <= 0) {
+        LOG_ERROR("Server keep_alive_timeout_seconds must be positive");
+        return false;
+    }
+
+    if (config.max_requests_per_connection < 0) {
+        LOG_ERROR("Server max_requests_per_connection cannot be negative");
+        return false;
+    }
+
+    if (config.sendfile_threshold_bytes <= 0) {
+        LOG_ERROR("Server sendfile_threshold_bytes must be positive");
+        return false;
+    }
+
+    if (config.compression_min_bytes < 0) {
+        LOG_ERROR("Server compression_min_bytes cannot be negative");
+        return false;
+    }
+
+    if (config.listen_backlog <= 0) {
+        LOG_ERROR("Server listen_backlog must be positive");
+        return false;
+    }
+
+    if (config.io_backend != "epoll" && config.io_backend != "io_uring") {
+        LOG_ERROR("Server io_backend must be \"epoll\" or \"io_uring\"");
+        return false;
+    }
+
+    if (config.header_timeout_seconds <= 0) {
+        LOG_ERROR("Server header_timeout_seconds must be positive");
+        return false;
+    }
+
+    if (config.body_timeout_seconds <= 0) {
+        LOG_ERROR("Server body_timeout_seconds must be positive");
+        return false;
+    }
+
+    if (config.max_header_bytes <= 0) {
+        LOG_ERROR("Server max_header_bytes must be positive");
+        return false;
+    }
+
+    if (config.max_body_bytes <= 0) {
+        LOG_ERROR("Server max_body_bytes must be positive");
+        return false;
+    }
+
+    if (config.max_streamed_body_bytes < config.max_body_bytes) {
+        LOG_ERROR("Server max_streamed_body_bytes must be at least max_body_bytes");
+        return false;
+    }
+
+    return true;
+}
+
 void ConfigManager::setDefaultLLMConfig() {
     app_config_.llm.provider = DEFAULT_PROVIDER;
     app_config_.llm.api_endpoint = DEFAULT_API_ENDPOINT;
@@ -246,4 +366,8 @@ void ConfigManager::setDefaultPromptConfig() {
     app_config_.prompt.max_history_messages = DEFAULT_MAX_HISTORY_LENGTH;
 }
 
+void ConfigManager::setDefaultServerConfig() {
+    app_config_.server = ServerConfig();
+}
+
 } // namespace AITextAssistant
@@ -6,6 +6,8 @@
 #include <filesystem>
 #include <regex>
 #include <stdexcept>
+#include <limits>
+#include <thread>
 
 namespace AITextAssistant {
 
@@ -16,12 +18,21 @@ TextAssistant::TextAssistant(const std::string& config_file)
     assistant_config_.auto_save_conversations = true;
     assistant_config_.response_timeout = 30.0;
     assistant_config_.max_conversation_history = 20;
+
+    // Mailboxes keep each conversation in order; the threads only bound
+    // how many conversations do history and database work at once. That
+    // work runs in parallel across conversations, which ConversationDB and
+    // HTTPClient allow: both are safe to share between threads.
+    size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    conversation_executor_ = std::make_unique<ThreadPool>(threads, std::numeric_limits<size_t>::max());
 }
 
 TextAssistant::~TextAssistant() {
-    if (assistant_config_.auto_save_conversations && !current_conversation_id_.empty()) {
-        saveCurrentConversation();
-    }
+    // Finish the queued database steps, then fail the requests still in
+    // flight; their tasks now continue inline, while the rest of the
+    // assistant is intact
+    conversation_executor_->drain();
+    llm_client_.reset();
 }
 
 bool TextAssistant::initialize() {
@@ -101,64 +112,78 @@ bool TextAssistant::saveConfig(const std::string& config_file) const {
     return config_manager_->saveConfig(file_path);
 }
 
-std::string TextAssistant::startNewConversation(const std::string& title) {
-    if (!database_) {
-        LOG_ERROR("Database not initialized");
-        return "";
+ServerConfig TextAssistant::getServerConfig() const {
+    if (!config_manager_) {
+        return ServerConfig();
     }
+    return config_manager_->getServerConfig();
+}
 
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-
-    // Save current conversation if exists
-    if (!current_conversation_id_.empty() && assistant_config_.auto_save_conversations) {
-        updateConversationInDatabase();
+ConversationHandle TextAssistant::startNewConversation(const std::string& title) {
+    if (!database_) {
+        LOG_ERROR("Database not initialized");
+        return nullptr;
     }
 
-    // Create new conversation
-    current_conversation_id_ = database_->createConversation(title);
-    conversation_history_.clear();
-
-    if (!current_conversation_id_.empty()) {
-        LOG_INFO("Started new conversation: " + current_conversation_id_);
-        fireEvent(AssistantEvent::STATE_CHANGED, "New conversation started");
+    ConversationId conversation_id = database_->createConversation(title);
+    if (conversation_id.empty()) {
+        return nullptr;
     }
 
-    return current_conversation_id_;
+    LOG_INFO("Started new conversation: " + conversation_id);
+    fireEvent(AssistantEvent::STATE_CHANGED, "New conversation started");
+    return conversations_.insert(std::make_shared<ConversationState>(conversation_id, maxPendingMessages()));
 }
 
-bool TextAssistant::loadConversation(const ConversationId& conversation_id) {
+ConversationHandle TextAssistant::openConversation(const ConversationId& conversation_id) {
     if (!database_) {
         LOG_ERROR("Database not initialized");
-        return false;
+        return nullptr;
     }
 
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-
-    auto conversation = database_->getConversation(conversation_id);
-    if (!conversation.has_value()) {
-        LOG_ERROR("Conversation not found: " + conversation_id);
-        return false;
+    if (ConversationHandle conversation = conversations_.find(conversation_id)) {
+        return conversation;
     }
 
-    // Save current conversation if exists
-    if (!current_conversation_id_.empty() && assistant_config_.auto_save_conversations) {
-        updateConversationInDatabase();
+    // Loaded without any lock held; if another request loads it at the
+    // same time, the first one registered wins
+    auto stored = database_->getConversation(conversation_id);
+    if (!stored.has_value()) {
+        LOG_ERROR("Conversation not found: " + conversation_id);
+        return nullptr;
     }
 
-    current_conversation_id_ = conversation_id;
-    conversation_history_ = conversation->messages;
+    auto conversation = std::make_shared<ConversationState>(conversation_id, maxPendingMessages());
+    conversation->history = std::move(stored->messages);
 
     LOG_INFO("Loaded conversation: " + conversation_id);
-    return true;
+    return conversations_.insert(std::move(conversation));
+}
+
+Task<ConversationHandle> TextAssistant::startNewConversationTask(std::string title) {
+    co_await resumeOn(*conversation_executor_);
+    co_return startNewConversation(title);
+}
+
+Task<ConversationHandle> TextAssistant::openConversationTask(ConversationId conversation_id) {
+    co_await resumeOn(*conversation_executor_);
+    co_return openConversation(conversation_id);
 }
 
-bool TextAssistant::saveCurrentConversation() {
-    if (current_conversation_id_.empty() || !database_) {
+bool TextAssistant::saveConversation(const ConversationHandle& conversation) {
+    if (!conversation || conversation->id.empty() || !database_) {
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-    return updateConversationInDatabase();
+    std::lock_guard<std::mutex> lock(conversation->mutex);
+    return updateConversationInDatabase(*conversation);
+}
+
+std::optional<Conversation> TextAssistant::getConversation(const ConversationId& conversation_id) {
+    if (!database_) {
+        return std::nullopt;
+    }
+    return database_->getConversation(conversation_id);
 }
 
 std::vector<Conversation> TextAssistant::getRecentConversations(int limit) {
@@ -173,53 +198,180 @@ bool TextAssistant::deleteConversation(const ConversationId& conversation_id) {
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-
-    // If deleting current conversation, clear it
-    if (current_conversation_id_ == conversation_id) {
-        current_conversation_id_.clear();
-        conversation_history_.clear();
+    // Requests still holding the conversation finish without storing
+    if (ConversationHandle conversation = conversations_.remove(conversation_id)) {
+        std::lock_guard<std::mutex> lock(conversation->mutex);
+        conversation->deleted = true;
+        conversation->history.clear();
+        conversation->cleared_version = ++conversation->version;
     }
 
     return database_->deleteConversation(conversation_id);
 }
 
-std::string TextAssistant::processTextInput(const std::string& input) {
-    if (!initialized_ || input.empty()) {
+std::string TextAssistant::processTextInput(const ConversationHandle& conversation, const std::string& input) {
+    return processTextInputStream(conversation, input, nullptr);
+}
+
+std::string TextAssistant::processTextInputStream(const ConversationHandle& conversation, const std::string& input,
+                                                  LLMClient::DeltaCallback on_token) {
+    if (!initialized_ || !conversation || input.empty()) {
         return "Sorry, I'm not ready to process your request.";
     }
 
+    // Wait for the replies to earlier messages in this conversation
+    Mailbox::Turn my_turn = conversation->mailbox.enterBlocking();
+    if (!my_turn) {
+        throw ConversationBusyError(conversation->id);
+    }
+    if (!llm_client_) {
+        return "I'm sorry, I'm not able to process your request right now.";
+    }
+
     setState(AssistantState::PROCESSING);
 
     try {
-        // Add user message to history
-        Message user_message("user", input);
-        addMessageToHistory(user_message);
+        // Add user message to history and take the request with it
+        TurnSnapshot turn = beginTurn(*conversation, input);
+
+        // Generate response; nothing is locked while the LLM answers
+        LLMResponse llm_response = on_token ? llm_client_->streamChatCompletion(turn.messages, on_token)
+                                            : llm_client_->chatCompletion(turn.messages);
+
+        if (llm_response.cancelled) {
+            // Stopped by the caller: the partial reply is not kept, the
+            // user message stays unanswered
+            LOG_INFO("Reply cancelled after " + std::to_string(llm_response.content.size()) +
+                     " bytes; not stored");
+            setState(AssistantState::IDLE);
+            return llm_response.content;
+        }
 
-        // Generate response
-        std::string response = generateResponse(input);
+        std::string response = replyFromLLMResponse(llm_response);
+        completeTextInput(*conversation, response, turn.version);
+        return response;
 
-        // Add assistant response to history
-        Message assistant_message("assistant", response);
-        addMessageToHistory(assistant_message);
+    } catch (const std::exception& e) {
+        handleError("Error processing input: " + std::string(e.what()));
+        return "I'm sorry, I encountered an error processing your request.";
+    }
+}
 
-        setState(AssistantState::IDLE);
-        fireEvent(AssistantEvent::RESPONSE_GENERATED, response);
+Task<std::string> TextAssistant::processTextInputTask(ConversationHandle conversation, std::string input) {
+    return processTextInputStreamTask(std::move(conversation), std::move(input), nullptr);
+}
 
-        return response;
+Task<std::string> TextAssistant::processTextInputStreamTask(ConversationHandle conversation, std::string input,
+                                                            LLMClient::DeltaCallback on_token) {
+    if (!initialized_ || !conversation || input.empty()) {
+        co_return "Sorry, I'm not ready to process your request.";
+    }
+
+    // Wait for the replies to earlier messages in this conversation; the
+    // turn ends when this coroutine does
+    Mailbox::Turn my_turn = co_await conversation->mailbox.enter(*conversation_executor_);
+    if (!my_turn) {
+        throw ConversationBusyError(conversation->id);
+    }
+    if (!llm_client_) {
+        co_return "I'm sorry, I'm not able to process your request right now.";
+    }
 
+    setState(AssistantState::PROCESSING);
+    co_await resumeOn(*conversation_executor_);
+
+    TurnSnapshot turn;
+    std::string error_msg;
+    try {
+        turn = beginTurn(*conversation, input);
     } catch (const std::exception& e) {
-        setState(AssistantState::ERROR);
-        std::string error_msg = "Error processing input: " + std::string(e.what());
-        LOG_ERROR(error_msg);
-        fireEvent(AssistantEvent::ERROR_OCCURRED, error_msg);
-        return "I'm sorry, I encountered an error processing your request.";
+        error_msg = "Error processing input: " + std::string(e.what());
+    }
+    if (!error_msg.empty()) {
+        handleError(error_msg);
+        co_return "I'm sorry, I encountered an error processing your request.";
+    }
+
+    LLMResponse llm_response;
+    if (on_token) {
+        llm_response = co_await llm_client_->streamChatCompletionTask(std::move(turn.messages), std::move(on_token));
+    } else {
+        llm_response = co_await llm_client_->chatCompletionTask(std::move(turn.messages));
+    }
+
+    co_await resumeOn(*conversation_executor_);
+    if (llm_response.cancelled) {
+        LOG_INFO("Reply cancelled after " + std::to_string(llm_response.content.size()) +
+                 " bytes; not stored");
+        setState(AssistantState::IDLE);
+        co_return llm_response.content;
+    }
+
+    std::string response = replyFromLLMResponse(llm_response);
+    try {
+        completeTextInput(*conversation, response, turn.version);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error storing response: " + std::string(e.what()));
     }
+    co_return response;
 }
 
-std::vector<Message> TextAssistant::getCurrentConversationHistory() const {
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-    return conversation_history_;
+void TextAssistant::processTextInputAsync(const ConversationHandle& conversation, const std::string& input,
+                                          std::function<void(const std::string&)> on_done) {
+    spawn(processTextInputTask(conversation, input), std::move(on_done));
+}
+
+TextAssistant::TurnSnapshot TextAssistant::beginTurn(ConversationState& conversation, const std::string& user_input) {
+    std::lock_guard<std::mutex> lock(conversation.mutex);
+
+    TurnSnapshot turn;
+    turn.messages = buildLLMMessages(conversation.history, user_input);
+    addMessageToHistory(conversation, Message("user", user_input));
+    turn.version = conversation.version;
+    return turn;
+}
+
+void TextAssistant::completeTextInput(ConversationState& conversation, const std::string& response,
+                                      uint64_t snapshot_version) {
+    {
+        std::lock_guard<std::mutex> lock(conversation.mutex);
+
+        if (conversation.cleared_version > snapshot_version) {
+            // Cleared or deleted while the LLM answered; the reply belongs
+            // to a history that no longer exists
+            LOG_WARNING("Conversation changed while generating a reply; reply not stored");
+        } else {
+            if (conversation.version != snapshot_version) {
+                LOG_DEBUG("Conversation received other messages while generating a reply");
+            }
+
+            // Add assistant response to history
+            Message assistant_message("assistant", response);
+            addMessageToHistory(conversation, assistant_message);
+
+            // Title a new conversation after its first exchange
+            if (assistant_config_.auto_save_conversations && !conversation.id.empty() &&
+                conversation.history.size() <= 2 && !conversation.deleted) {
+                updateConversationInDatabase(conversation);
+            }
+        }
+    }
+
+    setState(AssistantState::IDLE);
+    fireEvent(AssistantEvent::RESPONSE_GENERATED, response);
+}
+
+size_t TextAssistant::getPendingMessageCount(const ConversationId& conversation_id) const {
+    ConversationHandle conversation = conversations_.find(conversation_id);
+    return conversation ? conversation->mailbox.depth() : 0;
+}
+
+std::vector<Message> TextAssistant::getConversationHistory(const ConversationHandle& conversation) const {
+    if (!conversation) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(conversation->mutex);
+    return conversation->history;
 }
 
 
@@ -257,9 +409,13 @@ bool TextAssistant::setLLMProvider(const LLMConfig& config) {
 
 
 
-void TextAssistant::clearConversationHistory() {
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-    conversation_history_.clear();
+void TextAssistant::clearConversationHistory(const ConversationHandle& conversation) {
+    if (!conversation) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(conversation->mutex);
+    conversation->history.clear();
+    conversation->cleared_version = ++conversation->version;
     LOG_INFO("Conversation history cleared");
 }
 
@@ -350,15 +506,8 @@ int TextAssistant::getTotalMessages() const {
     return database_->getMessageCount();
 }
 
-std::string TextAssistant::generateResponse(const std::string& user_input) {
-    if (!llm_client_) {
-        return "I'm sorry, I'm not able to process your request right now.";
-    }
-
-    // Build prompt with context
-    std::string prompt = buildPromptWithContext(user_input);
-
-    // Prepare messages for LLM
+std::vector<Message> TextAssistant::buildLLMMessages(const std::vector<Message>& history,
+                                                     const std::string& user_input) {
     std::vector<Message> messages;
 
     // Add system message
@@ -368,23 +517,22 @@ std::string TextAssistant::generateResponse(const std::string& user_input) {
     }
 
     // Add conversation history (limited)
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
     int history_limit = std::min(assistant_config_.max_conversation_history,
-                                static_cast<int>(conversation_history_.size()));
+                                static_cast<int>(history.size()));
 
     if (history_limit > 0) {
-        int start_idx = conversation_history_.size() - history_limit;
-        for (int i = start_idx; i < static_cast<int>(conversation_history_.size()); ++i) {
-            messages.push_back(conversation_history_[i]);
+        int start_idx = history.size() - history_limit;
+        for (int i = start_idx; i < static_cast<int>(history.size()); ++i) {
+            messages.push_back(history[i]);
         }
     }
 
     // Add current user input
     messages.emplace_back("user", user_input);
+    return messages;
+}
 
-    // Get response from LLM
-    LLMResponse response = llm_client_->chatCompletion(messages);
-
+std::string TextAssistant::replyFromLLMResponse(const LLMResponse& response) {
     if (response.success) {
         return response.content;
     } else {
@@ -393,68 +541,32 @@ std::string TextAssistant::generateResponse(const std::string& user_input) {
     }
 }
 
-std::string TextAssistant::buildPromptWithContext(const std::string& user_input) {
-    if (!config_manager_) {
-        return user_input;
-    }
-
-    const auto& prompt_config = config_manager_->getPromptConfig();
-
-    // Build context from conversation history
-    std::string context;
-    if (!conversation_history_.empty()) {
-        std::stringstream history_stream;
-
-        int history_limit = std::min(prompt_config.max_history_messages,
-                                   static_cast<int>(conversation_history_.size()));
-
-        int start_idx = conversation_history_.size() - history_limit;
-        for (int i = start_idx; i < static_cast<int>(conversation_history_.size()); ++i) {
-            const auto& msg = conversation_history_[i];
-            history_stream << msg.role << ": " << msg.content << "\n";
-        }
-
-        std::map<std::string, std::string> context_vars = {
-            {"history", history_stream.str()}
-        };
-        context = config_manager_->expandTemplate(prompt_config.context_template, context_vars);
-    }
-
-    // Build final prompt
-    std::map<std::string, std::string> prompt_vars = {
-        {"user_input", user_input},
-        {"context", context}
-    };
-
-    return config_manager_->expandTemplate(prompt_config.user_prompt_template, prompt_vars);
-}
-
-void TextAssistant::addMessageToHistory(const Message& message) {
-    std::lock_guard<std::mutex> lock(conversation_mutex_);
-
+void TextAssistant::addMessageToHistory(ConversationState& conversation, const Message& message) {
     // Set conversation ID and timestamp
     Message msg = message;
-    msg.conversation_id = current_conversation_id_;
+    msg.conversation_id = conversation.id;
     msg.timestamp = std::chrono::system_clock::now();
 
-    conversation_history_.push_back(msg);
+    conversation.history.push_back(msg);
+    ++conversation.version;
 
     // Add to database if auto-save is enabled
-    if (assistant_config_.auto_save_conversations && database_ && !current_conversation_id_.empty()) {
-        database_->addMessage(current_conversation_id_, msg);
+    if (assistant_config_.auto_save_conversations && database_ && !conversation.id.empty() &&
+        !conversation.deleted) {
+        database_->addMessage(conversation.id, msg);
     }
 
     // Trim history if it gets too long
-    trimConversationHistory();
+    trimConversationHistory(conversation.history);
 }
 
-void TextAssistant::trimConversationHistory() {
-    if (conversation_history_.size() > static_cast<size_t>(assistant_config_.max_conversation_history * 2)) {
+void TextAssistant::trimConversationHistory(std::vector<Message>& history) {
+    if (history.size() > static_cast<size_t>(assistant_config_.max_conversation_history * 2)) {
         // Keep only the most recent messages
         int keep_count = assistant_config_.max_conversation_history;
-        conversation_history_.erase(
-            conversation_history_.begin(),
-            conversation_history_.end() - keep_count
+        history.erase(
+            history.begin(),
+            history.end() - keep_count
         );
     }
 }
@@ -491,17 +603,17 @@ std::string TextAssistant::generateConversationTitle(const std::string& first_me
     return title.empty() ? "New Conversation" : title;
 }
 
-bool TextAssistant::updateConversationInDatabase() {
-    if (!database_ || current_conversation_id_.empty()) {
+bool TextAssistant::updateConversationInDatabase(ConversationState& conversation) {
+    if (!database_ || conversation.id.empty()) {
         return false;
     }
 
     // Update conversation title if it's empty and we have messages
-    if (!conversation_history_.empty()) {
-        auto conversation = database_->getConversation(current_conversation_id_);
-        if (conversation.has_value() && conversation->title.empty()) {
-            std::string title = generateConversationTitle(conversation_history_[0].content);
-            database_->updateConversationTitle(current_conversation_id_, title);
+    if (!conversation.history.empty()) {
+        auto stored = database_->getConversation(conversation.id);
+        if (stored.has_value() && stored->title.empty()) {
+            std::string title = generateConversationTitle(conversation.history[0].content);
+            database_->updateConversationTitle(conversation.id, title);
         }
     }
 
@@ -0,0 +1,65 @@
+#include "core/conversation_registry.h"
+#include <algorithm>
+#include <functional>
+
+namespace AITextAssistant {
+
+ConversationRegistry::ConversationRegistry(size_t capacity)
+    : shard_capacity_(std::max<size_t>(1, (capacity + SHARD_COUNT - 1) / SHARD_COUNT)) {}
+
+ConversationRegistry::Shard& ConversationRegistry::shardFor(const ConversationId& id) {
+    return shards_[std::hash<ConversationId>()(id) % SHARD_COUNT];
+}
+
+const ConversationRegistry::Shard& ConversationRegistry::shardFor(const ConversationId& id) const {
+    return shards_[std::hash<ConversationId>()(id) % SHARD_COUNT];
+}
+
+ConversationHandle ConversationRegistry::find(const ConversationId& id) const {
+    const Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.conversations.find(id);
+    return it != shard.conversations.end() ? it->second : nullptr;
+}
+
+ConversationHandle ConversationRegistry::insert(ConversationHandle state) {
+    Shard& shard = shardFor(state->id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto existing = shard.conversations.find(state->id);
+    if (existing != shard.conversations.end()) {
+        return existing->second;
+    }
+
+    // New handles are only taken under this lock, so a state the map
+    // alone refers to stays unused while it is dropped
+    if (shard.conversations.size() >= shard_capacity_) {
+        std::erase_if(shard.conversations, [](const auto& entry) { return entry.second.use_count() == 1; });
+    }
+
+    shard.conversations.emplace(state->id, state);
+    return state;
+}
+
+ConversationHandle ConversationRegistry::remove(const ConversationId& id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.conversations.find(id);
+    if (it == shard.conversations.end()) {
+        return nullptr;
+    }
+    ConversationHandle state = std::move(it->second);
+    shard.conversations.erase(it);
+    return state;
+}
+
+size_t ConversationRegistry::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.conversations.size();
+    }
+    return total;
+}
+
+} // namespace AITextAssistant
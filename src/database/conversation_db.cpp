@@ -19,6 +19,7 @@ ConversationDB::~ConversationDB() {
 }
 
 bool ConversationDB::initialize() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     int rc = sqlite3_open(db_path_.c_str(), &db_);
     if (rc != SQLITE_OK) {
         LOG_ERROR("Cannot open database: " + std::string(sqlite3_errmsg(db_)));
@@ -81,6 +82,7 @@ bool ConversationDB::createIndexes() {
 }
 
 std::string ConversationDB::createConversation(const std::string& title) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string conversation_id = generateId();
     std::string timestamp = formatTimestamp(std::chrono::system_clock::now());
     
@@ -110,6 +112,7 @@ std::string ConversationDB::createConversation(const std::string& title) {
 }
 
 bool ConversationDB::deleteConversation(const ConversationId& conversation_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = "DELETE FROM conversations WHERE id = ?;";
     
     sqlite3_stmt* stmt = prepareStatement(sql);
@@ -130,6 +133,7 @@ bool ConversationDB::deleteConversation(const ConversationId& conversation_id) {
 }
 
 bool ConversationDB::updateConversationTitle(const ConversationId& conversation_id, const std::string& title) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = R"(
         UPDATE conversations 
         SET title = ?, updated_at = ? 
@@ -152,6 +156,7 @@ bool ConversationDB::updateConversationTitle(const ConversationId& conversation_
 }
 
 MessageId ConversationDB::addMessage(const ConversationId& conversation_id, const Message& message) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string message_id = generateId();
     std::string timestamp = formatTimestamp(message.timestamp);
     
@@ -192,6 +197,7 @@ MessageId ConversationDB::addMessage(const ConversationId& conversation_id, cons
 }
 
 bool ConversationDB::updateMessage(const MessageId& message_id, const std::string& content) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = "UPDATE messages SET content = ? WHERE id = ?;";
     
     sqlite3_stmt* stmt = prepareStatement(sql);
@@ -207,6 +213,7 @@ bool ConversationDB::updateMessage(const MessageId& message_id, const std::strin
 }
 
 bool ConversationDB::deleteMessage(const MessageId& message_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = "DELETE FROM messages WHERE id = ?;";
 
     sqlite3_stmt* stmt = prepareStatement(sql);
@@ -221,6 +228,7 @@ bool ConversationDB::deleteMessage(const MessageId& message_id) {
 }
 
 std::optional<Conversation> ConversationDB::getConversation(const ConversationId& conversation_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = R"(
         SELECT id, title, created_at, updated_at
         FROM conversations
@@ -247,6 +255,7 @@ std::optional<Conversation> ConversationDB::getConversation(const ConversationId
 }
 
 std::vector<Conversation> ConversationDB::getAllConversations() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = R"(
         SELECT id, title, created_at, updated_at
         FROM conversations
@@ -266,6 +275,7 @@ std::vector<Conversation> ConversationDB::getAllConversations() {
 }
 
 std::vector<Conversation> ConversationDB::getRecentConversations(int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = R"(
         SELECT id, title, created_at, updated_at
         FROM conversations
@@ -288,6 +298,7 @@ std::vector<Conversation> ConversationDB::getRecentConversations(int limit) {
 }
 
 std::vector<Message> ConversationDB::getConversationMessages(const ConversationId& conversation_id, int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string sql = R"(
         SELECT id, conversation_id, role, content, timestamp
         FROM messages
@@ -314,6 +325,7 @@ std::vector<Message> ConversationDB::getConversationMessages(const ConversationI
 }
 
 std::vector<Message> ConversationDB::getRecentMessages(const ConversationId& conversation_id, int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = R"(
         SELECT id, conversation_id, role, content, timestamp
         FROM messages
@@ -341,6 +353,7 @@ std::vector<Message> ConversationDB::getRecentMessages(const ConversationId& con
 }
 
 std::vector<Conversation> ConversationDB::searchConversations(const std::string& query) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = R"(
         SELECT DISTINCT c.id, c.title, c.created_at, c.updated_at
         FROM conversations c
@@ -366,6 +379,7 @@ std::vector<Conversation> ConversationDB::searchConversations(const std::string&
 }
 
 std::vector<Message> ConversationDB::searchMessages(const std::string& query, const ConversationId& conversation_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string sql = R"(
         SELECT id, conversation_id, role, content, timestamp
         FROM messages
@@ -398,6 +412,7 @@ std::vector<Message> ConversationDB::searchMessages(const std::string& query, co
 }
 
 int ConversationDB::getConversationCount() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     const std::string sql = "SELECT COUNT(*) FROM conversations;";
 
     sqlite3_stmt* stmt = prepareStatement(sql);
@@ -413,6 +428,7 @@ int ConversationDB::getConversationCount() {
 }
 
 int ConversationDB::getMessageCount(const ConversationId& conversation_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string sql = "SELECT COUNT(*) FROM messages";
     if (!conversation_id.empty()) {
         sql += " WHERE conversation_id = ?";
@@ -435,10 +451,12 @@ int ConversationDB::getMessageCount(const ConversationId& conversation_id) {
 }
 
 bool ConversationDB::vacuum() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     return executeSQL("VACUUM;");
 }
 
 bool ConversationDB::backup(const std::string& backup_path) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     sqlite3* backup_db;
     int rc = sqlite3_open(backup_path.c_str(), &backup_db);
     if (rc != SQLITE_OK) {
@@ -467,6 +485,7 @@ bool ConversationDB::backup(const std::string& backup_path) {
 }
 
 bool ConversationDB::restore(const std::string& backup_path) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     sqlite3* backup_db;
     int rc = sqlite3_open(backup_path.c_str(), &backup_db);
     if (rc != SQLITE_OK) {
@@ -495,6 +514,7 @@ bool ConversationDB::restore(const std::string& backup_path) {
 }
 
 bool ConversationDB::beginTransaction() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (in_transaction_) {
         LOG_WARNING("Transaction already in progress");
         return false;
@@ -508,6 +528,7 @@ bool ConversationDB::beginTransaction() {
 }
 
 bool ConversationDB::commitTransaction() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!in_transaction_) {
         LOG_WARNING("No transaction in progress");
         return false;
@@ -521,6 +542,7 @@ bool ConversationDB::commitTransaction() {
 }
 
 bool ConversationDB::rollbackTransaction() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!in_transaction_) {
         LOG_WARNING("No transaction in progress");
         return false;
@@ -534,9 +556,8 @@ bool ConversationDB::rollbackTransaction() {
 }
 
 std::string ConversationDB::generateId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
+    thread_local std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<> dis(0, 15);
 
     std::stringstream ss;
     for (int i = 0; i < 32; ++i) {
@@ -560,8 +581,10 @@ Timestamp ConversationDB::parseTimestamp(const std::string& timestamp_str) {
 
 std::string ConversationDB::formatTimestamp(const Timestamp& timestamp) {
     auto time_t = std::chrono::system_clock::to_time_t(timestamp);
+    std::tm tm = {};
+    localtime_r(&time_t, &tm);
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
     return ss.str();
 }
 
@@ -3,32 +3,73 @@
 #include <nlohmann/json.hpp>
 #include <sstream>
 #include <algorithm>
+#include <mutex>
 
 namespace AITextAssistant {
 
+namespace {
+
+// curl_global_init is not thread-safe on older libcurl, so it runs once
+// for the process; the matching cleanup is left to process exit
+void initCurl() {
+    static std::once_flag once;
+    std::call_once(once, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+} // namespace
+
 // HTTPClient implementation
 HTTPClient::HTTPClient() {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl_ = curl_easy_init();
-    if (curl_) {
-        setupCommonOptions();
-    }
+    initCurl();
 }
 
 HTTPClient::~HTTPClient() {
-    if (curl_) {
-        curl_easy_cleanup(curl_);
+    for (CURL* curl : idle_handles_) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+void HTTPClient::setupCommonOptions(CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    // Requests run on many threads; timeouts must not use signals
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+}
+
+CURL* HTTPClient::acquireHandle() {
+    CURL* curl = nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!idle_handles_.empty()) {
+        curl = idle_handles_.back();
+        idle_handles_.pop_back();
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            return nullptr;
+        }
+        setupCommonOptions(curl);
     }
-    curl_global_cleanup();
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds_);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, user_agent_.c_str());
+    return curl;
 }
 
-void HTTPClient::setupCommonOptions() {
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl_, CURLOPT_HEADERFUNCTION, HeaderCallback);
-    curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl_, CURLOPT_USERAGENT, "AITextAssistant/1.0");
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 1L);
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYHOST, 2L);
+void HTTPClient::releaseHandle(CURL* curl) {
+    // Drop what pointed into the finished request
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, nullptr);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_handles_.size() < MAX_IDLE_HANDLES) {
+        idle_handles_.push_back(curl);
+    } else {
+        curl_easy_cleanup(curl);
+    }
 }
 
 HTTPResponse HTTPClient::post(const std::string& url, 
@@ -36,7 +77,8 @@ HTTPResponse HTTPClient::post(const std::string& url,
                              const std::map<std::string, std::string>& headers) {
     HTTPResponse response;
     
-    if (!curl_) {
+    CURL* curl = acquireHandle();
+    if (!curl) {
         response.success = false;
         response.error_message = "CURL not initialized";
         return response;
@@ -45,17 +87,17 @@ HTTPResponse HTTPClient::post(const std::string& url,
     std::string response_body;
     std::map<std::string, std::string> response_headers;
     
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, data.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_body);
-    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &response_headers);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
     
     struct curl_slist* header_list = buildHeaders(headers);
-    if (header_list) {
-        curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, header_list);
-    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
     
-    CURLcode res = curl_easy_perform(curl_);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status_code);
+    releaseHandle(curl);
     
     if (header_list) {
         curl_slist_free_all(header_list);
@@ -67,7 +109,6 @@ HTTPResponse HTTPClient::post(const std::string& url,
         return response;
     }
     
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response.status_code);
     response.body = response_body;
     response.headers = response_headers;
     response.success = (response.status_code >= 200 && response.status_code < 300);
@@ -79,7 +120,8 @@ HTTPResponse HTTPClient::get(const std::string& url,
                             const std::map<std::string, std::string>& headers) {
     HTTPResponse response;
     
-    if (!curl_) {
+    CURL* curl = acquireHandle();
+    if (!curl) {
         response.success = false;
         response.error_message = "CURL not initialized";
         return response;
@@ -88,17 +130,17 @@ HTTPResponse HTTPClient::get(const std::string& url,
     std::string response_body;
     std::map<std::string, std::string> response_headers;
     
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_body);
-    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &response_headers);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
     
     struct curl_slist* header_list = buildHeaders(headers);
-    if (header_list) {
-        curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, header_list);
-    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
     
-    CURLcode res = curl_easy_perform(curl_);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status_code);
+    releaseHandle(curl);
     
     if (header_list) {
         curl_slist_free_all(header_list);
@@ -110,7 +152,6 @@ HTTPResponse HTTPClient::get(const std::string& url,
         return response;
     }
     
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &response.status_code);
     response.body = response_body;
     response.headers = response_headers;
     response.success = (response.status_code >= 200 && response.status_code < 300);
@@ -118,16 +159,71 @@ HTTPResponse HTTPClient::get(const std::string& url,
     return response;
 }
 
-void HTTPClient::setTimeout(long timeout_seconds) {
-    if (curl_) {
-        curl_easy_setopt(curl_, CURLOPT_TIMEOUT, timeout_seconds);
+struct HTTPClient::StreamContext {
+    CURL* curl;
+    DataCallback* on_data;
+    std::string error_body;
+    long status_code = 0;
+    bool aborted = false;
+};
+
+HTTPResponse HTTPClient::postStream(const std::string& url,
+                                   const std::string& data,
+                                   const std::map<std::string, std::string>& headers,
+                                   DataCallback on_data) {
+    HTTPResponse response;
+    response.status_code = 0;
+    
+    CURL* curl = acquireHandle();
+    if (!curl) {
+        response.success = false;
+        response.error_message = "CURL not initialized";
+        return response;
+    }
+    
+    StreamContext context;
+    context.curl = curl;
+    context.on_data = &on_data;
+    std::map<std::string, std::string> response_headers;
+    
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, StreamWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &context);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response_headers);
+    
+    struct curl_slist* header_list = buildHeaders(headers);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+    
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status_code);
+    releaseHandle(curl);
+    
+    if (header_list) {
+        curl_slist_free_all(header_list);
+    }
+    
+    response.body = std::move(context.error_body);
+    response.headers = response_headers;
+    
+    if (res != CURLE_OK && !context.aborted) {
+        response.success = false;
+        response.error_message = curl_easy_strerror(res);
+        return response;
     }
+    
+    response.success = (response.status_code >= 200 && response.status_code < 300);
+    return response;
+}
+
+void HTTPClient::setTimeout(long timeout_seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_seconds_ = timeout_seconds;
 }
 
 void HTTPClient::setUserAgent(const std::string& user_agent) {
-    if (curl_) {
-        curl_easy_setopt(curl_, CURLOPT_USERAGENT, user_agent.c_str());
-    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_agent_ = user_agent;
 }
 
 size_t HTTPClient::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
@@ -136,6 +232,26 @@ size_t HTTPClient::WriteCallback(void* contents, size_t size, size_t nmemb, std:
     return total_size;
 }
 
+size_t HTTPClient::StreamWriteCallback(void* contents, size_t size, size_t nmemb, StreamContext* context) {
+    size_t total_size = size * nmemb;
+    
+    if (context->status_code == 0) {
+        curl_easy_getinfo(context->curl, CURLINFO_RESPONSE_CODE, &context->status_code);
+    }
+    
+    // Error responses are a single JSON document, not a stream
+    if (context->status_code < 200 || context->status_code >= 300) {
+        context->error_body.append(static_cast<char*>(contents), total_size);
+        return total_size;
+    }
+    
+    if (!(*context->on_data)(static_cast<char*>(contents), total_size)) {
+        context->aborted = true;
+        return 0;
+    }
+    return total_size;
+}
+
 size_t HTTPClient::HeaderCallback(void* contents, size_t size, size_t nmemb, 
                                  std::map<std::string, std::string>* userp) {
     size_t total_size = size * nmemb;
@@ -169,11 +285,237 @@ struct curl_slist* HTTPClient::buildHeaders(const std::map<std::string, std::str
     return header_list;
 }
 
+// AsyncHTTPClient implementation
+struct AsyncHTTPClient::Transfer {
+    CURL* curl = nullptr;
+    struct curl_slist* header_list = nullptr;
+    std::string data;
+    std::string response_body;
+    std::map<std::string, std::string> response_headers;
+    Completion done;
+    // postStream(): 2xx bodies go to on_data instead of response_body
+    HTTPClient::DataCallback on_data;
+    std::unique_ptr<HTTPClient::StreamContext> stream;
+
+    ~Transfer() {
+        if (curl) {
+            curl_easy_cleanup(curl);
+        }
+        if (header_list) {
+            curl_slist_free_all(header_list);
+        }
+    }
+};
+
+AsyncHTTPClient::AsyncHTTPClient() : stopping_(false), timeout_seconds_(30), pending_(0) {
+    initCurl();
+    multi_ = curl_multi_init();
+}
+
+AsyncHTTPClient::~AsyncHTTPClient() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    if (thread_.joinable()) {
+        curl_multi_wakeup(multi_);
+        thread_.join();
+    }
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+    }
+}
+
+void AsyncHTTPClient::post(const std::string& url,
+                           const std::string& data,
+                           const std::map<std::string, std::string>& headers,
+                           Completion done) {
+    std::unique_ptr<Transfer> transfer = createTransfer(url, data, headers, std::move(done));
+    if (!transfer) {
+        return;
+    }
+    curl_easy_setopt(transfer->curl, CURLOPT_WRITEFUNCTION, HTTPClient::WriteCallback);
+    curl_easy_setopt(transfer->curl, CURLOPT_WRITEDATA, &transfer->response_body);
+    submit(std::move(transfer));
+}
+
+void AsyncHTTPClient::postStream(const std::string& url,
+                                 const std::string& data,
+                                 const std::map<std::string, std::string>& headers,
+                                 HTTPClient::DataCallback on_data,
+                                 Completion done) {
+    std::unique_ptr<Transfer> transfer = createTransfer(url, data, headers, std::move(done));
+    if (!transfer) {
+        return;
+    }
+    transfer->on_data = std::move(on_data);
+    transfer->stream = std::make_unique<HTTPClient::StreamContext>();
+    transfer->stream->curl = transfer->curl;
+    transfer->stream->on_data = &transfer->on_data;
+    curl_easy_setopt(transfer->curl, CURLOPT_WRITEFUNCTION, HTTPClient::StreamWriteCallback);
+    curl_easy_setopt(transfer->curl, CURLOPT_WRITEDATA, transfer->stream.get());
+    submit(std::move(transfer));
+}
+
+std::unique_ptr<AsyncHTTPClient::Transfer> AsyncHTTPClient::createTransfer(
+    const std::string& url, const std::string& data, const std::map<std::string, std::string>& headers,
+    Completion done) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->done = std::move(done);
+    transfer->curl = multi_ ? curl_easy_init() : nullptr;
+    if (!transfer->curl) {
+        complete(*transfer, CURLE_FAILED_INIT);
+        return nullptr;
+    }
+    transfer->data = data;
+
+    CURL* curl = transfer->curl;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->data.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer->data.size()));
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HTTPClient::HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->response_headers);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds_.load());
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "AITextAssistant/1.0");
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
+    // Timeouts must not use signals off the main thread
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+
+    for (const auto& [key, value] : headers) {
+        std::string header = key + ": " + value;
+        transfer->header_list = curl_slist_append(transfer->header_list, header.c_str());
+    }
+    if (transfer->header_list) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->header_list);
+    }
+    return transfer;
+}
+
+void AsyncHTTPClient::submit(std::unique_ptr<Transfer> transfer) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopping_) {
+            ++pending_;
+            submitted_.push_back(std::move(transfer));
+            if (!thread_.joinable()) {
+                thread_ = std::thread([this]() { run(); });
+            }
+        }
+    }
+    if (transfer) {
+        complete(*transfer, CURLE_ABORTED_BY_CALLBACK);
+        return;
+    }
+    curl_multi_wakeup(multi_);
+}
+
+void AsyncHTTPClient::run() {
+    std::vector<std::unique_ptr<Transfer>> active;
+    std::vector<std::unique_ptr<Transfer>> incoming;
+
+    while (true) {
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            incoming.swap(submitted_);
+            stopping = stopping_;
+        }
+
+        for (auto& transfer : incoming) {
+            if (stopping || curl_multi_add_handle(multi_, transfer->curl) != CURLM_OK) {
+                --pending_;
+                complete(*transfer, CURLE_ABORTED_BY_CALLBACK);
+            } else {
+                active.push_back(std::move(transfer));
+            }
+        }
+        incoming.clear();
+
+        if (stopping) {
+            for (auto& transfer : active) {
+                curl_multi_remove_handle(multi_, transfer->curl);
+                --pending_;
+                complete(*transfer, CURLE_ABORTED_BY_CALLBACK);
+            }
+            return;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi_, &queued)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Transfer* finished = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &finished);
+            CURLcode result = message->data.result;
+            curl_multi_remove_handle(multi_, message->easy_handle);
+
+            auto it = std::find_if(active.begin(), active.end(),
+                                   [finished](const auto& transfer) { return transfer.get() == finished; });
+            if (it != active.end()) {
+                std::unique_ptr<Transfer> transfer = std::move(*it);
+                active.erase(it);
+                --pending_;
+                complete(*transfer, result);
+            }
+        }
+
+        // Sleeps until a socket is ready, a timeout is due or post() wakes us
+        curl_multi_poll(multi_, nullptr, 0, 1000, nullptr);
+    }
+}
+
+void AsyncHTTPClient::complete(Transfer& transfer, CURLcode result) {
+    HTTPResponse response;
+    response.status_code = 0;
+
+    // A stream stopped by its data callback ends normally
+    bool stopped = transfer.stream && transfer.stream->aborted;
+    if (result != CURLE_OK && !stopped) {
+        response.success = false;
+        response.error_message = result == CURLE_ABORTED_BY_CALLBACK ? "Request cancelled"
+                                                                     : curl_easy_strerror(result);
+    } else {
+        curl_easy_getinfo(transfer.curl, CURLINFO_RESPONSE_CODE, &response.status_code);
+        response.body = std::move(transfer.stream ? transfer.stream->error_body : transfer.response_body);
+        response.headers = std::move(transfer.response_headers);
+        response.success = (response.status_code >= 200 && response.status_code < 300);
+    }
+
+    if (!transfer.done) {
+        return;
+    }
+    // A throwing callback must not take the other transfers down with it
+    try {
+        transfer.done(std::move(response));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception in HTTP completion: " + std::string(e.what()));
+    }
+}
+
 // LLMClient implementation
 LLMClient::LLMClient(const LLMConfig& config) : config_(config) {
     http_client_ = std::make_unique<HTTPClient>();
+    async_http_client_ = std::make_unique<AsyncHTTPClient>();
+}
+
+namespace {
+
+LLMResponse failedRequest(const HTTPResponse& http_response) {
+    LLMResponse response;
+    response.success = false;
+    response.error_message = "HTTP request failed: " + http_response.error_message;
+    response.status_code = http_response.status_code;
+    return response;
 }
 
+} // namespace
+
 LLMResponse LLMClient::chatCompletion(const std::vector<Message>& messages) {
     try {
         std::string payload = buildRequestPayload(messages);
@@ -183,11 +525,7 @@ LLMResponse LLMClient::chatCompletion(const std::vector<Message>& messages) {
         HTTPResponse http_response = http_client_->post(config_.api_endpoint, payload, headers);
         
         if (!http_response.success) {
-            LLMResponse response;
-            response.success = false;
-            response.error_message = "HTTP request failed: " + http_response.error_message;
-            response.status_code = http_response.status_code;
-            return response;
+            return failedRequest(http_response);
         }
         
         return parseResponse(http_response);
@@ -199,16 +537,186 @@ LLMResponse LLMClient::chatCompletion(const std::vector<Message>& messages) {
     }
 }
 
-void LLMClient::streamChatCompletion(const std::vector<Message>& messages,
-                                   std::function<void(const std::string&)> callback) {
-    // For now, implement as non-streaming
-    // TODO: Implement actual streaming support
-    LLMResponse response = chatCompletion(messages);
-    if (response.success) {
-        callback(response.content);
-    } else {
-        callback("Error: " + response.error_message);
+void LLMClient::chatCompletionAsync(const std::vector<Message>& messages, CompletionCallback done) {
+    std::string payload;
+    std::map<std::string, std::string> headers;
+    try {
+        payload = buildRequestPayload(messages);
+        headers = buildHeaders();
+    } catch (const std::exception& e) {
+        LLMResponse response;
+        response.success = false;
+        response.error_message = "Exception in chatCompletionAsync: " + std::string(e.what());
+        done(std::move(response));
+        return;
+    }
+
+    LOG_DEBUG("Sending async request to: " + config_.api_endpoint);
+    async_http_client_->post(config_.api_endpoint, payload, headers,
+        [this, done = std::move(done)](HTTPResponse http_response) {
+            done(http_response.success ? parseResponse(http_response) : failedRequest(http_response));
+        });
+}
+
+Task<LLMResponse> LLMClient::chatCompletionTask(std::vector<Message> messages) {
+    co_return co_await awaitCallback<LLMResponse>([this, &messages](CompletionCallback done) {
+        chatCompletionAsync(messages, std::move(done));
+    });
+}
+
+void LLMClient::stopAsyncRequests() {
+    async_http_client_.reset();
+}
+
+struct LLMClient::StreamState {
+    DeltaCallback callback;
+    SSEParser parser;
+    StreamStatus status = StreamStatus::CONTINUE;
+    std::string content;
+    bool abandoned = false;
+    LLMResponse response;
+
+    StreamState() { response.success = false; }
+};
+
+LLMResponse LLMClient::streamChatCompletion(const std::vector<Message>& messages, DeltaCallback callback) {
+    try {
+        std::string payload = buildStreamRequestPayload(messages);
+        auto headers = buildHeaders();
+        headers["Accept"] = "text/event-stream";
+
+        StreamState state;
+        state.callback = std::move(callback);
+
+        LOG_DEBUG("Sending streaming request to: " + config_.api_endpoint);
+        HTTPResponse http_response = http_client_->postStream(config_.api_endpoint, payload, headers,
+            [this, &state](const char* data, size_t length) { return feedStream(state, data, length); });
+        return finishStream(state, http_response);
+    } catch (const std::exception& e) {
+        LLMResponse response;
+        response.success = false;
+        response.error_message = "Exception in streamChatCompletion: " + std::string(e.what());
+        return response;
+    }
+}
+
+void LLMClient::streamChatCompletionAsync(const std::vector<Message>& messages, DeltaCallback callback,
+                                          CompletionCallback done) {
+    std::string payload;
+    std::map<std::string, std::string> headers;
+    try {
+        payload = buildStreamRequestPayload(messages);
+        headers = buildHeaders();
+        headers["Accept"] = "text/event-stream";
+    } catch (const std::exception& e) {
+        LLMResponse response;
+        response.success = false;
+        response.error_message = "Exception in streamChatCompletionAsync: " + std::string(e.what());
+        done(std::move(response));
+        return;
     }
+
+    auto state = std::make_shared<StreamState>();
+    state->callback = std::move(callback);
+
+    LOG_DEBUG("Sending async streaming request to: " + config_.api_endpoint);
+    async_http_client_->postStream(config_.api_endpoint, payload, headers,
+        [this, state](const char* data, size_t length) { return feedStream(*state, data, length); },
+        [this, state, done = std::move(done)](HTTPResponse http_response) {
+            done(finishStream(*state, http_response));
+        });
+}
+
+Task<LLMResponse> LLMClient::streamChatCompletionTask(std::vector<Message> messages, DeltaCallback callback) {
+    co_return co_await awaitCallback<LLMResponse>([this, &messages, &callback](CompletionCallback done) {
+        streamChatCompletionAsync(messages, std::move(callback), std::move(done));
+    });
+}
+
+bool LLMClient::streamEvent(StreamState& state, const SSEEvent& event) {
+    std::string delta;
+    state.status = parseStreamEvent(event, delta, state.response);
+    if (!delta.empty()) {
+        state.content += delta;
+        // Deltas are forwarded from inside curl's write callback, so the
+        // caller sees each token as soon as its event is complete
+        if (state.callback && !state.callback(delta)) {
+            state.abandoned = true;
+            return false;
+        }
+    }
+    return state.status == StreamStatus::CONTINUE;
+}
+
+bool LLMClient::feedStream(StreamState& state, const char* data, size_t length) {
+    // Events after the terminator are ignored; stop only on errors
+    if (state.status == StreamStatus::CONTINUE) {
+        try {
+            state.parser.feed(data, length, [this, &state](const SSEEvent& event) {
+                return streamEvent(state, event);
+            });
+        } catch (const std::exception& e) {
+            state.response.error_message = "Exception in stream callback: " + std::string(e.what());
+            state.status = StreamStatus::ERROR;
+        }
+    }
+    return state.status != StreamStatus::ERROR && !state.abandoned;
+}
+
+LLMResponse LLMClient::finishStream(StreamState& state, const HTTPResponse& http_response) {
+    LLMResponse& response = state.response;
+    response.status_code = http_response.status_code;
+
+    if (!state.abandoned && state.status == StreamStatus::CONTINUE && http_response.success) {
+        try {
+            state.parser.finish([this, &state](const SSEEvent& event) { return streamEvent(state, event); });
+        } catch (const std::exception& e) {
+            response.error_message = "Exception in stream callback: " + std::string(e.what());
+            state.status = StreamStatus::ERROR;
+        }
+    }
+
+    if (state.abandoned) {
+        response.cancelled = true;
+        response.error_message = "Stream cancelled by the caller";
+        response.content = std::move(state.content);
+        return std::move(response);
+    }
+
+    if (state.status == StreamStatus::ERROR) {
+        return std::move(response);
+    }
+
+    if (!http_response.success) {
+        if (!http_response.body.empty()) {
+            // Providers answer errors with a regular JSON body
+            LLMResponse error_response = parseResponse(http_response);
+            if (!error_response.success && !error_response.error_message.empty()) {
+                response.error_message = error_response.error_message;
+                return std::move(response);
+            }
+        }
+        response.error_message = "HTTP request failed: " +
+            (http_response.error_message.empty() ? "status " + std::to_string(http_response.status_code)
+                                                 : http_response.error_message);
+        return std::move(response);
+    }
+
+    // Some servers just close the stream instead of sending a terminator
+    if (state.status == StreamStatus::CONTINUE && state.content.empty()) {
+        response.error_message = "Stream ended without a response";
+        return std::move(response);
+    }
+
+    response.success = true;
+    response.content = std::move(state.content);
+    return std::move(response);
+}
+
+std::string LLMClient::buildStreamRequestPayload(const std::vector<Message>& messages) {
+    nlohmann::json payload = nlohmann::json::parse(buildRequestPayload(messages));
+    payload["stream"] = true;
+    return payload.dump();
 }
 
 void LLMClient::updateConfig(const LLMConfig& config) {
@@ -281,6 +789,48 @@ LLMResponse OpenAIClient::parseResponse(const HTTPResponse& http_response) {
     return response;
 }
 
+std::string OpenAIClient::buildStreamRequestPayload(const std::vector<Message>& messages) {
+    nlohmann::json payload = nlohmann::json::parse(buildRequestPayload(messages));
+    payload["stream"] = true;
+    // Ask for a final usage chunk so token counts survive streaming
+    payload["stream_options"]["include_usage"] = true;
+    return payload.dump();
+}
+
+LLMClient::StreamStatus OpenAIClient::parseStreamEvent(const SSEEvent& event, std::string& delta,
+                                                       LLMResponse& response) {
+    if (event.data == "[DONE]") {
+        return StreamStatus::DONE;
+    }
+
+    try {
+        nlohmann::json chunk = nlohmann::json::parse(event.data);
+
+        if (chunk.contains("error")) {
+            response.error_message = chunk["error"].value("message", "Unknown streaming error");
+            return StreamStatus::ERROR;
+        }
+
+        if (chunk.contains("choices") && !chunk["choices"].empty()) {
+            const auto& choice_delta = chunk["choices"][0]["delta"];
+            if (choice_delta.contains("content") && choice_delta["content"].is_string()) {
+                delta = choice_delta["content"];
+            }
+        }
+
+        if (chunk.contains("usage") && chunk["usage"].is_object()) {
+            response.metadata["prompt_tokens"] = std::to_string(chunk["usage"].value("prompt_tokens", 0));
+            response.metadata["completion_tokens"] = std::to_string(chunk["usage"].value("completion_tokens", 0));
+            response.metadata["total_tokens"] = std::to_string(chunk["usage"].value("total_tokens", 0));
+        }
+    } catch (const std::exception& e) {
+        response.error_message = "Failed to parse stream chunk: " + std::string(e.what());
+        return StreamStatus::ERROR;
+    }
+
+    return StreamStatus::CONTINUE;
+}
+
 std::map<std::string, std::string> OpenAIClient::buildHeaders() {
     std::map<std::string, std::string> headers = config_.headers;
     headers["Authorization"] = "Bearer " + config_.api_key;
@@ -352,6 +902,41 @@ LLMResponse AnthropicClient::parseResponse(const HTTPResponse& http_response) {
     return response;
 }
 
+LLMClient::StreamStatus AnthropicClient::parseStreamEvent(const SSEEvent& event, std::string& delta,
+                                                          LLMResponse& response) {
+    try {
+        nlohmann::json json_event = nlohmann::json::parse(event.data);
+        std::string type = event.event.empty() ? json_event.value("type", "") : event.event;
+
+        if (type == "content_block_delta") {
+            const auto& block_delta = json_event["delta"];
+            if (block_delta.value("type", "") == "text_delta") {
+                delta = block_delta.value("text", "");
+            }
+        } else if (type == "message_start") {
+            const auto& message = json_event["message"];
+            if (message.contains("usage")) {
+                response.metadata["input_tokens"] = std::to_string(message["usage"].value("input_tokens", 0));
+            }
+        } else if (type == "message_delta") {
+            if (json_event.contains("usage")) {
+                response.metadata["output_tokens"] = std::to_string(json_event["usage"].value("output_tokens", 0));
+            }
+        } else if (type == "message_stop") {
+            return StreamStatus::DONE;
+        } else if (type == "error") {
+            response.error_message = json_event["error"].value("message", "Unknown streaming error");
+            return StreamStatus::ERROR;
+        }
+        // ping, content_block_start and content_block_stop carry no text
+    } catch (const std::exception& e) {
+        response.error_message = "Failed to parse stream event: " + std::string(e.what());
+        return StreamStatus::ERROR;
+    }
+
+    return StreamStatus::CONTINUE;
+}
+
 std::map<std::string, std::string> AnthropicClient::buildHeaders() {
     std::map<std::string, std::string> headers = config_.headers;
     headers["x-api-key"] = config_.api_key;
@@ -425,6 +1010,55 @@ LLMResponse CustomClient::parseResponse(const HTTPResponse& http_response) {
     return response;
 }
 
+LLMClient::StreamStatus CustomClient::parseStreamEvent(const SSEEvent& event, std::string& delta,
+                                                       LLMResponse& response) {
+    // Generic implementation - accept the common streaming formats
+    if (event.data == "[DONE]") {
+        return StreamStatus::DONE;
+    }
+
+    try {
+        nlohmann::json chunk = nlohmann::json::parse(event.data);
+
+        if (chunk.contains("error")) {
+            response.error_message = chunk["error"].is_string() ?
+                chunk["error"].get<std::string>() : chunk["error"].value("message", "Unknown streaming error");
+            return StreamStatus::ERROR;
+        }
+
+        if (chunk.contains("choices") && !chunk["choices"].empty()) {
+            // OpenAI-like format
+            const auto& choice = chunk["choices"][0];
+            if (choice.contains("delta") && choice["delta"].contains("content") &&
+                choice["delta"]["content"].is_string()) {
+                delta = choice["delta"]["content"];
+            } else if (choice.contains("text") && choice["text"].is_string()) {
+                delta = choice["text"];
+            }
+        } else if (chunk.value("type", "") == "content_block_delta") {
+            // Anthropic-like format
+            delta = chunk["delta"].value("text", "");
+        } else if (chunk.value("type", "") == "message_stop") {
+            return StreamStatus::DONE;
+        } else if (chunk.contains("message") && chunk["message"].is_object()) {
+            // Chat-style chunk with a partial message
+            delta = chunk["message"].value("content", "");
+        } else if (chunk.contains("response") && chunk["response"].is_string()) {
+            // Generic response field
+            delta = chunk["response"];
+        }
+
+        if (chunk.value("done", false)) {
+            return StreamStatus::DONE;
+        }
+    } catch (const std::exception& e) {
+        response.error_message = "Failed to parse stream chunk: " + std::string(e.what());
+        return StreamStatus::ERROR;
+    }
+
+    return StreamStatus::CONTINUE;
+}
+
 std::map<std::string, std::string> CustomClient::buildHeaders() {
     std::map<std::string, std::string> headers = config_.headers;
     if (!config_.api_key.empty()) {
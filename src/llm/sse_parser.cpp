@@ -0,0 +1,106 @@
+#include "llm/sse_parser.h"
+
+namespace AITextAssistant {
+
+bool SSEParser::feed(const char* data, size_t length, const EventCallback& callback) {
+    size_t position = 0;
+    while (position < length) {
+        // A CRLF pair may be split across two reads
+        if (skip_line_feed_) {
+            skip_line_feed_ = false;
+            if (data[position] == '\n') {
+                ++position;
+                continue;
+            }
+        }
+
+        size_t line_end = position;
+        while (line_end < length && data[line_end] != '\r' && data[line_end] != '\n') {
+            ++line_end;
+        }
+        line_buffer_.append(data + position, line_end - position);
+        if (line_end == length) {
+            break;
+        }
+
+        skip_line_feed_ = (data[line_end] == '\r');
+        position = line_end + 1;
+
+        std::string line;
+        line.swap(line_buffer_);
+        if (!processLine(line, callback)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SSEParser::finish(const EventCallback& callback) {
+    if (!line_buffer_.empty()) {
+        std::string line;
+        line.swap(line_buffer_);
+        if (!processLine(line, callback)) {
+            return false;
+        }
+    }
+    return dispatch(callback);
+}
+
+void SSEParser::reset() {
+    line_buffer_.clear();
+    current_ = SSEEvent();
+    has_data_ = false;
+    skip_line_feed_ = false;
+}
+
+bool SSEParser::processLine(const std::string& line, const EventCallback& callback) {
+    if (line.empty()) {
+        return dispatch(callback);
+    }
+
+    // Comment line, used by servers as a keep-alive
+    if (line[0] == ':') {
+        return true;
+    }
+
+    std::string field;
+    std::string value;
+    size_t colon_pos = line.find(':');
+    if (colon_pos == std::string::npos) {
+        field = line;
+    } else {
+        field = line.substr(0, colon_pos);
+        size_t value_start = colon_pos + 1;
+        if (value_start < line.size() && line[value_start] == ' ') {
+            ++value_start;
+        }
+        value = line.substr(value_start);
+    }
+
+    if (field == "data") {
+        if (has_data_) {
+            current_.data.push_back('\n');
+        }
+        current_.data += value;
+        has_data_ = true;
+    } else if (field == "event") {
+        current_.event = value;
+    }
+    // "id" and "retry" only matter for reconnecting clients
+
+    return true;
+}
+
+bool SSEParser::dispatch(const EventCallback& callback) {
+    if (!has_data_) {
+        current_.event.clear();
+        return true;
+    }
+
+    SSEEvent event;
+    std::swap(event, current_);
+    has_data_ = false;
+    return callback(event);
+}
+
+} // namespace AITextAssistant
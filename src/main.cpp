@@ -170,7 +170,7 @@ void webMode(TextAssistant& assistant, int port) {
     std::cout << "Starting HTTP server on port " << port << "...\n";
 
     // Create HTTP server
-    g_http_server = std::make_unique<HttpServer>(port);
+    g_http_server = std::make_unique<HttpServer>(port, assistant.getServerConfig());
     g_http_server->setAssistant(std::shared_ptr<TextAssistant>(&assistant, [](TextAssistant*){}));
     g_http_server->setStaticDirectory("web");
 
@@ -193,7 +193,7 @@ void webMode(TextAssistant& assistant, int port) {
 }
 
 // Text-based interaction loop
-void textMode(TextAssistant& assistant) {
+void textMode(TextAssistant& assistant, const ConversationHandle& conversation) {
     std::cout << "\n=== Text Mode ===\n";
     std::cout << "Type 'quit' or 'exit' to stop, 'help' for commands\n\n";
     
@@ -220,11 +220,11 @@ void textMode(TextAssistant& assistant) {
             std::cout << "  delete <id>       - Delete a conversation by ID\n\n";
             continue;
         } else if (input == "clear") {
-            assistant.clearConversationHistory();
+            assistant.clearConversationHistory(conversation);
             std::cout << "Conversation history cleared.\n\n";
             continue;
         } else if (input == "save") {
-            if (assistant.saveCurrentConversation()) {
+            if (assistant.saveConversation(conversation)) {
                 std::cout << "Conversation saved.\n\n";
             } else {
                 std::cout << "Failed to save conversation.\n\n";
@@ -295,7 +295,7 @@ void textMode(TextAssistant& assistant) {
         }
         
         // Process user input
-        std::string response = assistant.processTextInput(input);
+        std::string response = assistant.processTextInput(conversation, input);
 
         // Display response with proper UTF-8 formatting
         std::cout << "Assistant: ";
@@ -460,20 +460,21 @@ int main(int argc, char* argv[]) {
             interactiveConfig(*g_assistant);
         }
         
-        // Start new conversation
-        std::string conversation_id = g_assistant->startNewConversation();
-        LOG_INFO("Started new conversation: " + conversation_id);
-
-        // Main interaction loop
+        // Main interaction loop; web requests name their own conversations
         if (args.web_mode) {
             webMode(*g_assistant, args.web_port);
         } else {
-            textMode(*g_assistant);
+            ConversationHandle conversation = g_assistant->startNewConversation();
+            if (!conversation) {
+                LOG_WARNING("Failed to start a conversation; messages will not be stored");
+                conversation = std::make_shared<ConversationState>(ConversationId());
+            }
+            textMode(*g_assistant, conversation);
+
+            // Save conversation before exit
+            g_assistant->saveConversation(conversation);
         }
         
-        // Save conversation before exit
-        g_assistant->saveCurrentConversation();
-        
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in main: " + std::string(e.what()));
         return 1;
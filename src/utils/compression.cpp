@@ -0,0 +1,256 @@
+#include "utils/compression.h"
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <vector>
+
+namespace AITextAssistant {
+
+namespace Compression {
+
+namespace {
+
+// windowBits 15 + 16 selects the gzip wrapper, plain 15 the zlib one
+// that HTTP calls "deflate"
+int zlibWindowBits(ContentEncoding encoding) {
+    return encoding == ContentEncoding::GZIP ? 15 + 16 : 15;
+}
+
+bool compressZlib(ContentEncoding encoding, const std::string& input, std::string& output, int level) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level < 0 ? Z_BEST_COMPRESSION : level, Z_DEFLATED, zlibWindowBits(encoding), 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+#ifdef HAVE_BROTLI
+bool compressBrotli(const std::string& input, std::string& output, int level) {
+    size_t encoded_size = BrotliEncoderMaxCompressedSize(input.size());
+    if (encoded_size == 0) {
+        return false;
+    }
+    output.resize(encoded_size);
+    if (!BrotliEncoderCompress(level < 0 ? BROTLI_MAX_QUALITY : level, BROTLI_DEFAULT_WINDOW,
+                               BROTLI_MODE_TEXT, input.size(),
+                               reinterpret_cast<const uint8_t*>(input.data()), &encoded_size,
+                               reinterpret_cast<uint8_t*>(&output[0]))) {
+        return false;
+    }
+    output.resize(encoded_size);
+    return true;
+}
+#endif
+
+} // namespace
+
+const char* encodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::GZIP: return "gzip";
+        case ContentEncoding::DEFLATE: return "deflate";
+        case ContentEncoding::BROTLI: return "br";
+        default: return "identity";
+    }
+}
+
+const char* fileSuffix(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::GZIP: return ".gz";
+        case ContentEncoding::BROTLI: return ".br";
+        default: return "";
+    }
+}
+
+bool isAvailable(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::IDENTITY:
+        case ContentEncoding::GZIP:
+        case ContentEncoding::DEFLATE:
+            return true;
+        case ContentEncoding::BROTLI:
+#ifdef HAVE_BROTLI
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+ContentEncoding negotiate(std::string_view accept_encoding,
+                          std::initializer_list<ContentEncoding> candidates) {
+    struct Preference {
+        ContentEncoding encoding;
+        double q;
+        bool listed;
+    };
+    std::vector<Preference> preferences;
+    for (ContentEncoding candidate : candidates) {
+        if (isAvailable(candidate) && candidate != ContentEncoding::IDENTITY) {
+            preferences.push_back({candidate, 0.0, false});
+        }
+    }
+    double wildcard_q = -1.0;
+
+    size_t position = 0;
+    while (position < accept_encoding.size()) {
+        size_t end = accept_encoding.find(',', position);
+        if (end == std::string::npos) {
+            end = accept_encoding.size();
+        }
+        std::string item(accept_encoding.substr(position, end - position));
+        position = end + 1;
+
+        // "coding;q=0.5"
+        double q = 1.0;
+        size_t semicolon = item.find(';');
+        std::string coding = item.substr(0, semicolon);
+        if (semicolon != std::string::npos) {
+            size_t q_pos = item.find("q=", semicolon);
+            if (q_pos != std::string::npos) {
+                q = std::strtod(item.c_str() + q_pos + 2, nullptr);
+            }
+        }
+        coding.erase(0, coding.find_first_not_of(" \t"));
+        coding.erase(coding.find_last_not_of(" \t") + 1);
+
+        if (coding == "*") {
+            wildcard_q = q;
+            continue;
+        }
+        if (strcasecmp(coding.c_str(), "x-gzip") == 0) {
+            coding = "gzip";
+        }
+        for (auto& preference : preferences) {
+            if (strcasecmp(coding.c_str(), encodingName(preference.encoding)) == 0) {
+                preference.q = q;
+                preference.listed = true;
+            }
+        }
+    }
+
+    ContentEncoding best = ContentEncoding::IDENTITY;
+    double best_q = 0.0;
+    for (const auto& preference : preferences) {
+        double q = preference.listed ? preference.q : std::max(wildcard_q, 0.0);
+        if (q > best_q) {
+            best = preference.encoding;
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+bool isCompressible(const std::string& content_type) {
+    return content_type.compare(0, 5, "text/") == 0 ||
+           content_type.compare(0, 16, "application/json") == 0 ||
+           content_type.compare(0, 22, "application/javascript") == 0 ||
+           content_type.compare(0, 13, "image/svg+xml") == 0;
+}
+
+bool compress(ContentEncoding encoding, const std::string& input, std::string& output, int level) {
+    switch (encoding) {
+        case ContentEncoding::GZIP:
+        case ContentEncoding::DEFLATE:
+            return compressZlib(encoding, input, output, level);
+        case ContentEncoding::BROTLI:
+#ifdef HAVE_BROTLI
+            return compressBrotli(input, output, level);
+#else
+            return false;
+#endif
+        case ContentEncoding::IDENTITY:
+            output = input;
+            return true;
+    }
+    return false;
+}
+
+struct StreamCompressor::State {
+    z_stream stream;
+    bool finished = false;
+};
+
+StreamCompressor::StreamCompressor(ContentEncoding encoding, int level)
+    : state_(std::make_unique<State>()), valid_(false) {
+    std::memset(&state_->stream, 0, sizeof(state_->stream));
+    if (encoding != ContentEncoding::GZIP && encoding != ContentEncoding::DEFLATE) {
+        return;
+    }
+    // memLevel 8 is zlib's default; responses are short-lived
+    valid_ = deflateInit2(&state_->stream, level, Z_DEFLATED, zlibWindowBits(encoding), 8,
+                          Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+StreamCompressor::~StreamCompressor() {
+    if (valid_) {
+        deflateEnd(&state_->stream);
+    }
+}
+
+bool StreamCompressor::write(const char* data, size_t length, std::string& output) {
+    return run(data, length, Z_NO_FLUSH, output);
+}
+
+bool StreamCompressor::flush(std::string& output) {
+    return run(nullptr, 0, Z_SYNC_FLUSH, output);
+}
+
+bool StreamCompressor::finish(std::string& output) {
+    return run(nullptr, 0, Z_FINISH, output);
+}
+
+bool StreamCompressor::run(const char* data, size_t length, int flush_mode, std::string& output) {
+    if (!valid_ || state_->finished) {
+        return false;
+    }
+
+    z_stream& stream = state_->stream;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(length);
+
+    // Deflate straight into spare capacity at the end of `output`
+    while (true) {
+        size_t used = output.size();
+        size_t room = std::max<size_t>(deflateBound(&stream, stream.avail_in), 4096);
+        output.resize(used + room);
+        stream.next_out = reinterpret_cast<Bytef*>(&output[used]);
+        stream.avail_out = static_cast<uInt>(room);
+
+        int result = deflate(&stream, flush_mode);
+        output.resize(used + room - stream.avail_out);
+
+        if (result == Z_STREAM_END) {
+            state_->finished = true;
+            return true;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR) {
+            return false;
+        }
+        // Done once all input is consumed and deflate left output space unused
+        if (stream.avail_in == 0 && stream.avail_out > 0 && flush_mode != Z_FINISH) {
+            return true;
+        }
+    }
+}
+
+} // namespace Compression
+
+} // namespace AITextAssistant
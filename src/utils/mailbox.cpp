@@ -0,0 +1,88 @@
+#include "utils/mailbox.h"
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace AITextAssistant {
+
+Mailbox::Turn::Turn(Turn&& other) noexcept : mailbox_(std::exchange(other.mailbox_, nullptr)) {}
+
+Mailbox::Turn& Mailbox::Turn::operator=(Turn&& other) noexcept {
+    if (this != &other) {
+        end();
+        mailbox_ = std::exchange(other.mailbox_, nullptr);
+    }
+    return *this;
+}
+
+void Mailbox::Turn::end() {
+    if (Mailbox* mailbox = std::exchange(mailbox_, nullptr)) {
+        mailbox->endTurn();
+    }
+}
+
+bool Mailbox::EnterAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    // Once queued, the coroutine may resume and free this awaiter before
+    // admit() returns, so only locals are used after it
+    ThreadPool& pool = pool_;
+    admitted_ = true;
+    Admission admission = mailbox_.admit([&pool, handle]() {
+        // Resumes when the last copy of the task goes away: after it ran,
+        // or when the pool refuses or drops it
+        std::shared_ptr<void> resume(handle.address(), [](void* address) {
+            std::coroutine_handle<>::from_address(address).resume();
+        });
+        pool.trySubmit([resume = std::move(resume)]() mutable { resume.reset(); });
+    });
+    if (admission == Admission::REFUSED) {
+        admitted_ = false;
+    }
+    return admission == Admission::QUEUED;
+}
+
+Mailbox::Turn Mailbox::enterBlocking() {
+    auto started = std::make_shared<std::promise<void>>();
+    std::future<void> turn = started->get_future();
+    Admission admission = admit([started]() { started->set_value(); });
+    if (admission == Admission::REFUSED) {
+        return Turn();
+    }
+    if (admission == Admission::QUEUED) {
+        turn.wait();
+    }
+    return Turn(this);
+}
+
+size_t Mailbox::depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return depth_;
+}
+
+Mailbox::Admission Mailbox::admit(std::function<void()> start) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (depth_ >= capacity_) {
+        return Admission::REFUSED;
+    }
+    if (depth_++ == 0) {
+        return Admission::STARTED;
+    }
+    waiting_.push_back(std::move(start));
+    return Admission::QUEUED;
+}
+
+void Mailbox::endTurn() {
+    std::function<void()> next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --depth_;
+        if (waiting_.empty()) {
+            return;
+        }
+        next = std::move(waiting_.front());
+        waiting_.pop_front();
+    }
+    // The next turn is already counted and owns the mailbox from here
+    next();
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,108 @@
+#include "utils/thread_pool.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace AITextAssistant {
+
+ThreadPool::ThreadPool(size_t thread_count, size_t max_queue_size)
+    : max_queue_size_(max_queue_size), active_count_(0), stopping_(false), draining_(false) {
+    thread_count = std::max<size_t>(1, thread_count);
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+bool ThreadPool::trySubmit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= max_queue_size_) {
+            return false;
+        }
+        queue_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+    return true;
+}
+
+void ThreadPool::shutdown() {
+    std::deque<Task> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        dropped.swap(queue_);
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    if (!dropped.empty()) {
+        LOG_WARNING("Thread pool dropped " + std::to_string(dropped.size()) + " queued task(s) on shutdown");
+    }
+}
+
+void ThreadPool::drain() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        draining_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t ThreadPool::getQueueSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t ThreadPool::getActiveCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_count_;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_ && (!draining_ || queue_.empty())) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            ++active_count_;
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Unhandled exception in worker task: " + std::string(e.what()));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_count_;
+    }
+}
+
+} // namespace AITextAssistant
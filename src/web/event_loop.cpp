@@ -0,0 +1,459 @@
+#include "web/event_loop.h"
+#include "web/uring.h"
+#include "utils/logger.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+namespace AITextAssistant {
+
+EventLoop::EventLoop(Backend backend)
+    : epoll_fd_(-1),
+      wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      valid_(false),
+      quit_(false),
+      thread_id_(std::thread::id()),
+      next_op_id_(1),
+      in_flight_(0) {
+    if (wakeup_fd_ < 0) {
+        LOG_ERROR("Failed to create event loop: " + std::string(strerror(errno)));
+        return;
+    }
+
+    if (backend == Backend::IO_URING) {
+        ring_ = std::make_unique<IoUring>();
+        if (!ring_->init(RING_ENTRIES) ||
+            !ring_->provideBuffers(RECV_BUFFER_GROUP, RECV_BUFFER_COUNT, RECV_BUFFER_SIZE)) {
+            ring_.reset();
+            return;
+        }
+        valid_ = armPoll(wakeup_fd_, EPOLLIN);
+        return;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        LOG_ERROR("Failed to create event loop: " + std::string(strerror(errno)));
+        return;
+    }
+
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeup_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &ev);
+    valid_ = true;
+}
+
+EventLoop::~EventLoop() {
+    if (ring_) {
+        drainIoUring();
+        ring_.reset();
+    }
+    for (int timer_fd : timer_fds_) {
+        close(timer_fd);
+    }
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+void EventLoop::loop() {
+    thread_id_ = std::this_thread::get_id();
+    if (ring_) {
+        loopIoUring();
+        return;
+    }
+
+    std::vector<struct epoll_event> events(MAX_EVENTS);
+
+    while (!quit_) {
+        int count = epoll_wait(epoll_fd_, events.data(), MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeup_fd_) {
+                handleWakeup();
+                continue;
+            }
+
+            // A callback may unregister itself (or an fd later in this batch),
+            // so hold a reference while it runs and skip stale entries
+            auto it = callbacks_.find(fd);
+            if (it == callbacks_.end()) {
+                continue;
+            }
+            std::shared_ptr<IoCallback> callback = it->second;
+            (*callback)(events[i].events);
+        }
+
+        runPendingTasks();
+    }
+
+    // Drain anything queued during shutdown so captured state is released here
+    runPendingTasks();
+}
+
+void EventLoop::quit() {
+    quit_ = true;
+    if (!isInLoopThread()) {
+        wakeup();
+    }
+}
+
+void EventLoop::runInLoop(Task task) {
+    if (isInLoopThread()) {
+        task();
+    } else {
+        queueInLoop(std::move(task));
+    }
+}
+
+void EventLoop::queueInLoop(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_tasks_.push_back(std::move(task));
+    }
+    wakeup();
+}
+
+bool EventLoop::runEvery(std::chrono::milliseconds interval, Task task) {
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        LOG_ERROR("timerfd_create failed: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    struct itimerspec spec {};
+    spec.it_interval.tv_sec = interval.count() / 1000;
+    spec.it_interval.tv_nsec = (interval.count() % 1000) * 1000000;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+
+    bool added = addFd(timer_fd, EPOLLIN, [timer_fd, task = std::move(task)](uint32_t) {
+        uint64_t expirations = 0;
+        ssize_t n = read(timer_fd, &expirations, sizeof(expirations));
+        (void)n;
+        task();
+    });
+    if (!added) {
+        close(timer_fd);
+        return false;
+    }
+
+    timer_fds_.push_back(timer_fd);
+    return true;
+}
+
+bool EventLoop::addFd(int fd, uint32_t events, IoCallback callback) {
+    if (ring_) {
+        if (!armPoll(fd, events)) {
+            return false;
+        }
+        callbacks_[fd] = std::make_shared<IoCallback>(std::move(callback));
+        return true;
+    }
+
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("epoll_ctl ADD failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    callbacks_[fd] = std::make_shared<IoCallback>(std::move(callback));
+    return true;
+}
+
+bool EventLoop::modifyFd(int fd, uint32_t events) {
+    if (ring_) {
+        if (auto it = poll_ops_.find(fd); it != poll_ops_.end()) {
+            cancel(it->second);
+        }
+        return armPoll(fd, events);
+    }
+
+    struct epoll_event ev {};
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::removeFd(int fd) {
+    if (ring_) {
+        if (auto it = poll_ops_.find(fd); it != poll_ops_.end()) {
+            cancel(it->second);
+            poll_ops_.erase(it);
+        }
+    } else {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    callbacks_.erase(fd);
+}
+
+void EventLoop::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = write(wakeup_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void EventLoop::handleWakeup() {
+    uint64_t value = 0;
+    ssize_t n = read(wakeup_fd_, &value, sizeof(value));
+    (void)n;
+}
+
+void EventLoop::runPendingTasks() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        tasks.swap(pending_tasks_);
+    }
+
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::loopIoUring() {
+    while (!quit_) {
+        // One syscall submits everything queued by the last round and
+        // waits for the next completion
+        int result = ring_->submitAndWait(1);
+        if (result < 0 && result != -EINTR && result != -EAGAIN && result != -EBUSY) {
+            LOG_ERROR("io_uring_enter failed: " + std::string(strerror(-result)));
+            break;
+        }
+
+        ring_->forEachCompletion([this](const io_uring_cqe& cqe) {
+            handleCompletion(cqe.user_data, cqe.res, cqe.flags);
+        });
+
+        runPendingTasks();
+    }
+
+    runPendingTasks();
+}
+
+io_uring_sqe* EventLoop::prepareOp(uint64_t& id, CompletionHandler handler) {
+    io_uring_sqe* sqe = ring_->getSqe();
+    if (!sqe) {
+        LOG_ERROR("io_uring submission queue is full");
+        id = 0;
+        return nullptr;
+    }
+    id = next_op_id_++;
+    sqe->user_data = id;
+    ops_[id] = std::make_shared<CompletionHandler>(std::move(handler));
+    ++in_flight_;
+    return sqe;
+}
+
+void EventLoop::handleCompletion(uint64_t user_data, int32_t result, uint32_t flags) {
+    // Cancel requests and linked closes carry no callback
+    if (user_data == 0) {
+        return;
+    }
+
+    bool more = flags & IORING_CQE_F_MORE;
+    if (!more) {
+        --in_flight_;
+    }
+
+    auto it = ops_.find(user_data);
+    if (it == ops_.end()) {
+        // Cancelled: the data is dropped but its buffer goes back to the ring
+        if (flags & IORING_CQE_F_BUFFER) {
+            ring_->recycleBuffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        return;
+    }
+
+    std::shared_ptr<CompletionHandler> handler = it->second;
+    if (!more) {
+        ops_.erase(it);
+    }
+    (*handler)(result, flags);
+}
+
+uint64_t EventLoop::submitAccept(int listen_fd, CompletionCallback callback) {
+    uint64_t id = 0;
+    io_uring_sqe* sqe = prepareOp(id, [callback = std::move(callback)](int32_t result, uint32_t flags) {
+        callback(result, flags & IORING_CQE_F_MORE);
+    });
+    if (sqe) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listen_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    }
+    return id;
+}
+
+uint64_t EventLoop::submitRecv(int fd, RecvCallback callback) {
+    uint64_t id = 0;
+    io_uring_sqe* sqe = prepareOp(id, [this, callback = std::move(callback)](int32_t result, uint32_t flags) {
+        // The kernel picked one of the provided buffers; it is handed back
+        // as soon as the callback has consumed the bytes
+        const char* data = nullptr;
+        bool has_buffer = flags & IORING_CQE_F_BUFFER;
+        uint16_t buffer_id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (has_buffer) {
+            data = ring_->buffer(buffer_id);
+        }
+        callback(result, data, flags & IORING_CQE_F_MORE);
+        if (has_buffer) {
+            ring_->recycleBuffer(buffer_id);
+        }
+    });
+    if (sqe) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = RECV_BUFFER_GROUP;
+    }
+    return id;
+}
+
+uint64_t EventLoop::submitSend(int fd, const struct msghdr* message, bool close_after,
+                               CompletionCallback callback) {
+    // Both halves of the chain must land in the same submission
+    if (close_after && !ring_->reserve(2)) {
+        close_after = false;
+    }
+
+    uint64_t id = 0;
+    io_uring_sqe* sqe = prepareOp(id, [callback = std::move(callback)](int32_t result, uint32_t flags) {
+        callback(result, flags & IORING_CQE_F_MORE);
+    });
+    if (!sqe) {
+        return 0;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(message);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+
+    if (close_after) {
+        // A short send breaks the link and the close is cancelled
+        sqe->msg_flags |= MSG_WAITALL;
+        sqe->flags |= IOSQE_IO_LINK;
+        io_uring_sqe* close_sqe = ring_->getSqe();
+        close_sqe->opcode = IORING_OP_CLOSE;
+        close_sqe->fd = fd;
+        close_sqe->user_data = 0;
+    }
+    return id;
+}
+
+uint64_t EventLoop::submitPoll(int fd, uint32_t events, CompletionCallback callback) {
+    uint64_t id = 0;
+    io_uring_sqe* sqe = prepareOp(id, [callback = std::move(callback)](int32_t result, uint32_t flags) {
+        callback(result, flags & IORING_CQE_F_MORE);
+    });
+    if (sqe) {
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = events;
+    }
+    return id;
+}
+
+void EventLoop::cancel(uint64_t id) {
+    // The handler stays registered: completions already posted still carry
+    // data, and the final one arrives with -ECANCELED
+    if (ops_.count(id) == 0) {
+        return;
+    }
+    if (io_uring_sqe* sqe = ring_->getSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = id;
+        sqe->user_data = 0;
+    }
+}
+
+bool EventLoop::armPoll(int fd, uint32_t events) {
+    // epoll and poll share bit values for the events used here; the
+    // edge-trigger flag has no poll equivalent and multishot poll
+    // already reports each new wakeup
+    uint32_t poll_events = events & ~static_cast<uint32_t>(EPOLLET);
+
+    // prepareOp() hands out the next id; the handler needs it to tell
+    // whether it is still the live registration for the fd
+    uint64_t id = next_op_id_;
+    io_uring_sqe* sqe = prepareOp(id, [this, fd, events, id](int32_t result, uint32_t flags) {
+        if (!(flags & IORING_CQE_F_MORE)) {
+            // The kernel stopped the multishot poll; re-arm unless it was
+            // replaced or removed
+            auto it = poll_ops_.find(fd);
+            if (it != poll_ops_.end() && it->second == id) {
+                poll_ops_.erase(it);
+                armPoll(fd, events);
+            }
+        }
+        if (result < 0) {
+            return;
+        }
+        if (fd == wakeup_fd_) {
+            handleWakeup();
+            return;
+        }
+        auto it = callbacks_.find(fd);
+        if (it != callbacks_.end()) {
+            std::shared_ptr<IoCallback> callback = it->second;
+            (*callback)(static_cast<uint32_t>(result));
+        }
+    });
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = poll_events;
+    poll_ops_[fd] = id;
+    return true;
+}
+
+void EventLoop::drainIoUring() {
+    // Cancel everything still in flight and wait for the kernel to retire
+    // it, so no operation outlives the buffers its callback keeps alive.
+    // Handlers are held aside rather than invoked.
+    auto retired = std::move(ops_);
+    ops_.clear();
+    poll_ops_.clear();
+    if (io_uring_sqe* sqe = ring_->getSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = 0;
+    }
+
+    for (int attempt = 0; attempt < 1000 && in_flight_ > 0; ++attempt) {
+        ring_->submitAndWait(0);
+        ring_->forEachCompletion([this](const io_uring_cqe& cqe) {
+            handleCompletion(cqe.user_data, cqe.res, cqe.flags);
+        });
+        if (in_flight_ > 0) {
+            usleep(1000);
+        }
+    }
+}
+
+} // namespace AITextAssistant
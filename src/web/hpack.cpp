@@ -0,0 +1,432 @@
+#include "web/hpack.h"
+#include <array>
+
+namespace AITextAssistant {
+
+namespace {
+
+// RFC 7541 Appendix A
+const HeaderField STATIC_TABLE[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+constexpr size_t STATIC_TABLE_SIZE = sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+// Fixed overhead the size of a table entry is charged with
+constexpr size_t ENTRY_OVERHEAD = 32;
+
+struct HuffmanCode {
+    uint32_t code;
+    uint8_t bits;
+};
+
+// Indexed by symbol; 256 is EOS
+const HuffmanCode HUFFMAN_CODES[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+    {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+    {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+    {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+    {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+    {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+    {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+    {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+    {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+    {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+    {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+    {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+    {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+    {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+    {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+    {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+    {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+    {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30},
+};
+
+constexpr int MAX_CODE_BITS = 30;
+constexpr uint16_t EOS = 256;
+
+// The code is canonical: within one length, codes are consecutive in
+// symbol order. Decoding only needs the first code of each length and the
+// symbols sorted by code.
+struct HuffmanDecodeTable {
+    std::array<uint32_t, MAX_CODE_BITS + 1> first_code{};
+    std::array<uint16_t, MAX_CODE_BITS + 1> first_index{};
+    std::array<uint16_t, MAX_CODE_BITS + 1> count{};
+    std::array<uint16_t, 257> symbols{};
+
+    HuffmanDecodeTable() {
+        uint16_t index = 0;
+        for (int bits = 1; bits <= MAX_CODE_BITS; ++bits) {
+            first_index[bits] = index;
+            bool first = true;
+            for (uint16_t symbol = 0; symbol <= EOS; ++symbol) {
+                if (HUFFMAN_CODES[symbol].bits != bits) {
+                    continue;
+                }
+                if (first) {
+                    first_code[bits] = HUFFMAN_CODES[symbol].code;
+                    first = false;
+                }
+                symbols[index++] = symbol;
+                ++count[bits];
+            }
+        }
+    }
+};
+
+const HuffmanDecodeTable& huffmanDecodeTable() {
+    static const HuffmanDecodeTable table;
+    return table;
+}
+
+size_t huffmanEncodedSize(std::string_view input) {
+    uint64_t bits = 0;
+    for (unsigned char c : input) {
+        bits += HUFFMAN_CODES[c].bits;
+    }
+    return static_cast<size_t>((bits + 7) / 8);
+}
+
+bool decodeInteger(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& value) {
+    if (p == end) {
+        return false;
+    }
+    uint64_t max_prefix = (uint64_t(1) << prefix_bits) - 1;
+    value = *p++ & max_prefix;
+    if (value < max_prefix) {
+        return true;
+    }
+    for (int shift = 0; p < end && shift <= 28; shift += 7) {
+        uint8_t byte = *p++;
+        value += uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    // Truncated, or too large for any sane length or index
+    return false;
+}
+
+void encodeInteger(uint64_t value, int prefix_bits, uint8_t first_byte_flags, std::string& out) {
+    uint64_t max_prefix = (uint64_t(1) << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out.push_back(static_cast<char>(first_byte_flags | value));
+        return;
+    }
+    out.push_back(static_cast<char>(first_byte_flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decodeString(const uint8_t*& p, const uint8_t* end, std::string& out) {
+    if (p == end) {
+        return false;
+    }
+    bool huffman = (*p & 0x80) != 0;
+    uint64_t length;
+    if (!decodeInteger(p, end, 7, length) || length > static_cast<uint64_t>(end - p)) {
+        return false;
+    }
+    std::string_view data(reinterpret_cast<const char*>(p), static_cast<size_t>(length));
+    p += length;
+    if (huffman) {
+        out.clear();
+        return hpackHuffmanDecode(data, out);
+    }
+    out.assign(data);
+    return true;
+}
+
+void encodeString(std::string_view value, std::string& out) {
+    size_t huffman_size = huffmanEncodedSize(value);
+    if (huffman_size < value.size()) {
+        encodeInteger(huffman_size, 7, 0x80, out);
+        out += hpackHuffmanEncode(value);
+    } else {
+        encodeInteger(value.size(), 7, 0x00, out);
+        out.append(value);
+    }
+}
+
+} // namespace
+
+std::string hpackHuffmanEncode(std::string_view input) {
+    std::string out;
+    out.reserve(huffmanEncodedSize(input));
+    uint64_t buffer = 0;
+    int pending = 0;
+    for (unsigned char c : input) {
+        const HuffmanCode& code = HUFFMAN_CODES[c];
+        buffer = (buffer << code.bits) | code.code;
+        pending += code.bits;
+        while (pending >= 8) {
+            pending -= 8;
+            out.push_back(static_cast<char>(buffer >> pending));
+        }
+        buffer &= (uint64_t(1) << pending) - 1;
+    }
+    if (pending > 0) {
+        // Pad with the most significant bits of EOS, which are all ones
+        out.push_back(static_cast<char>((buffer << (8 - pending)) | ((1u << (8 - pending)) - 1)));
+    }
+    return out;
+}
+
+bool hpackHuffmanDecode(std::string_view input, std::string& output) {
+    const HuffmanDecodeTable& table = huffmanDecodeTable();
+    uint32_t code = 0;
+    int bits = 0;
+    for (unsigned char byte : input) {
+        for (int bit = 7; bit >= 0; --bit) {
+            code = (code << 1) | ((byte >> bit) & 1);
+            ++bits;
+            uint32_t offset = code - table.first_code[bits];
+            if (table.count[bits] > 0 && code >= table.first_code[bits] && offset < table.count[bits]) {
+                uint16_t symbol = table.symbols[table.first_index[bits] + offset];
+                if (symbol == EOS) {
+                    return false;
+                }
+                output.push_back(static_cast<char>(symbol));
+                code = 0;
+                bits = 0;
+            } else if (bits == MAX_CODE_BITS) {
+                return false;
+            }
+        }
+    }
+    // Only a short run of EOS prefix bits may pad the last byte
+    return bits <= 7 && code == (1u << bits) - 1;
+}
+
+HpackDecoder::HpackDecoder(size_t max_table_size)
+    : table_size_(0), capacity_(max_table_size), max_table_size_(max_table_size) {
+}
+
+bool HpackDecoder::decode(std::string_view block, std::vector<HeaderField>& headers) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(block.data());
+    const uint8_t* end = p + block.size();
+    bool fields_seen = false;
+
+    while (p < end) {
+        uint8_t first = *p;
+        uint64_t index;
+
+        if (first & 0x80) {
+            // Indexed header field
+            if (!decodeInteger(p, end, 7, index)) {
+                return false;
+            }
+            const HeaderField* field = lookup(index);
+            if (!field) {
+                return false;
+            }
+            headers.push_back(*field);
+            fields_seen = true;
+            continue;
+        }
+
+        if ((first & 0xE0) == 0x20) {
+            // Dynamic table size update; only before the first field
+            if (fields_seen || !decodeInteger(p, end, 5, index) || index > max_table_size_) {
+                return false;
+            }
+            capacity_ = static_cast<size_t>(index);
+            evict(capacity_);
+            continue;
+        }
+
+        // Literal: with incremental indexing (01), without indexing (0000)
+        // or never indexed (0001)
+        bool indexing = (first & 0xC0) == 0x40;
+        if (!decodeInteger(p, end, indexing ? 6 : 4, index)) {
+            return false;
+        }
+        HeaderField field;
+        if (index == 0) {
+            if (!decodeString(p, end, field.first)) {
+                return false;
+            }
+        } else {
+            const HeaderField* name = lookup(index);
+            if (!name) {
+                return false;
+            }
+            field.first = name->first;
+        }
+        if (!decodeString(p, end, field.second)) {
+            return false;
+        }
+        if (indexing) {
+            insert(field);
+        }
+        headers.push_back(std::move(field));
+        fields_seen = true;
+    }
+    return true;
+}
+
+const HeaderField* HpackDecoder::lookup(uint64_t index) const {
+    if (index == 0) {
+        return nullptr;
+    }
+    if (index <= STATIC_TABLE_SIZE) {
+        return &STATIC_TABLE[index - 1];
+    }
+    index -= STATIC_TABLE_SIZE + 1;
+    return index < table_.size() ? &table_[static_cast<size_t>(index)] : nullptr;
+}
+
+void HpackDecoder::insert(HeaderField field) {
+    size_t size = field.first.size() + field.second.size() + ENTRY_OVERHEAD;
+    if (size > capacity_) {
+        // Too large for the table: it just empties it
+        evict(0);
+        return;
+    }
+    evict(capacity_ - size);
+    table_size_ += size;
+    table_.push_front(std::move(field));
+}
+
+void HpackDecoder::evict(size_t capacity) {
+    while (table_size_ > capacity) {
+        const HeaderField& oldest = table_.back();
+        table_size_ -= oldest.first.size() + oldest.second.size() + ENTRY_OVERHEAD;
+        table_.pop_back();
+    }
+}
+
+void hpackEncodeHeader(std::string_view name, std::string_view value, std::string& block) {
+    size_t name_index = 0;
+    for (size_t i = 0; i < STATIC_TABLE_SIZE; ++i) {
+        if (STATIC_TABLE[i].first != name) {
+            continue;
+        }
+        if (STATIC_TABLE[i].second == value) {
+            encodeInteger(i + 1, 7, 0x80, block);
+            return;
+        }
+        if (name_index == 0) {
+            name_index = i + 1;
+        }
+    }
+
+    // Literal without indexing
+    encodeInteger(name_index, 4, 0x00, block);
+    if (name_index == 0) {
+        encodeString(name, block);
+    }
+    encodeString(value, block);
+}
+
+} // namespace AITextAssistant
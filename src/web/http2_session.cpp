@@ -0,0 +1,1205 @@
+#include "web/http2_session.h"
+#include "web/event_loop.h"
+#include "web/http_connection.h"
+#include "web/request_body.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace AITextAssistant {
+
+namespace {
+
+constexpr std::string_view CLIENT_PREFACE("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+constexpr std::string_view HTTP2_VERSION("HTTP/2.0");
+
+constexpr size_t FRAME_HEADER_SIZE = 9;
+// We never raise SETTINGS_MAX_FRAME_SIZE above the protocol default
+constexpr size_t MAX_FRAME_SIZE = 16384;
+constexpr int64_t MAX_WINDOW = 0x7FFFFFFF;
+constexpr int32_t DEFAULT_WINDOW = 65535;
+
+enum FrameType : uint8_t {
+    DATA = 0x0,
+    HEADERS = 0x1,
+    PRIORITY = 0x2,
+    RST_STREAM = 0x3,
+    SETTINGS = 0x4,
+    PUSH_PROMISE = 0x5,
+    PING = 0x6,
+    GOAWAY = 0x7,
+    WINDOW_UPDATE = 0x8,
+    CONTINUATION = 0x9
+};
+
+enum FrameFlag : uint8_t {
+    FLAG_END_STREAM = 0x1,
+    FLAG_ACK = 0x1,
+    FLAG_END_HEADERS = 0x4,
+    FLAG_PADDED = 0x8,
+    FLAG_PRIORITY = 0x20
+};
+
+enum SettingId : uint16_t {
+    SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    SETTINGS_ENABLE_PUSH = 0x2,
+    SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    SETTINGS_MAX_FRAME_SIZE = 0x5,
+    SETTINGS_MAX_HEADER_LIST_SIZE = 0x6
+};
+
+uint32_t readUint32(const char* data) {
+    const auto* p = reinterpret_cast<const uint8_t*>(data);
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+void appendUint32(std::string& out, uint32_t value) {
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>(value >> 16));
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+void appendSetting(std::string& out, uint16_t id, uint32_t value) {
+    out.push_back(static_cast<char>(id >> 8));
+    out.push_back(static_cast<char>(id));
+    appendUint32(out, value);
+}
+
+// Drop the pad length byte and the padding it announces
+bool stripPadding(uint8_t flags, std::string_view& payload) {
+    if (!(flags & FLAG_PADDED)) {
+        return true;
+    }
+    if (payload.empty()) {
+        return false;
+    }
+    size_t padding = static_cast<uint8_t>(payload[0]);
+    payload.remove_prefix(1);
+    if (padding > payload.size()) {
+        return false;
+    }
+    payload.remove_suffix(padding);
+    return true;
+}
+
+// Headers that only mean something to an HTTP/1 connection
+bool isConnectionSpecific(std::string_view name) {
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+           name == "transfer-encoding" || name == "upgrade";
+}
+
+bool decodeBase64Url(std::string_view input, std::string& output) {
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : input) {
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '-') {
+            value = 62;
+        } else if (c == '_') {
+            value = 63;
+        } else if (c == '=') {
+            break;
+        } else {
+            return false;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            output.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    return true;
+}
+
+// Re-encode a serialized HTTP/1 response head as an HPACK header block
+std::string encodeResponseHead(const std::string& head) {
+    std::string block;
+    size_t line_end = head.find("\r\n");
+    size_t status = head.find(' ');
+    if (line_end == std::string::npos || status == std::string::npos || status + 4 > line_end) {
+        hpackEncodeHeader(":status", "500", block);
+        return block;
+    }
+    hpackEncodeHeader(":status", std::string_view(head).substr(status + 1, 3), block);
+
+    std::string name;
+    for (size_t pos = line_end + 2; pos < head.size();) {
+        size_t end = head.find("\r\n", pos);
+        if (end == std::string::npos || end == pos) {
+            break;
+        }
+        std::string_view line(head.data() + pos, end - pos);
+        pos = end + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        name.assign(line.substr(0, colon));
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (isConnectionSpecific(name)) {
+            continue;
+        }
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+            value.remove_prefix(1);
+        }
+        hpackEncodeHeader(name, value, block);
+    }
+    return block;
+}
+
+// Point the request's views into `storage`, laid out as method, target,
+// version and body back to back
+void setRequestStorage(HttpRequest& request, std::shared_ptr<const std::string> storage,
+                       size_t method_length, size_t target_length, size_t head_length) {
+    std::string_view data(*storage);
+    if (request.raw) {
+        // Header fields keep their offsets in the new buffer
+        request.headers.rebase(request.raw->data(), data.data());
+    }
+    request.raw = std::move(storage);
+    request.method = data.substr(0, method_length);
+    std::string_view target = data.substr(method_length, target_length);
+    request.version = data.substr(method_length + target_length, HTTP2_VERSION.size());
+    request.body = data.substr(head_length);
+
+    if (size_t query_pos = target.find('?'); query_pos != std::string_view::npos) {
+        request.path = target.substr(0, query_pos);
+        request.query = target.substr(query_pos + 1);
+    } else {
+        request.path = target;
+        request.query = std::string_view();
+    }
+}
+
+} // namespace
+
+Http2Session::Http2Session(const std::shared_ptr<HttpConnection>& connection, const HttpParserLimits& limits,
+                           RequestCallback on_request, ErrorCallback on_error)
+    : connection_(connection), loop_(connection->getLoop()), limits_(limits),
+      on_request_(std::move(on_request)), on_error_(std::move(on_error)), preface_received_(false),
+      goaway_sent_(false), goaway_received_(false), closed_(false), last_stream_id_(0),
+      continuation_stream_(0), continuation_end_stream_(false), recv_window_(CONNECTION_WINDOW),
+      recv_unacked_(0), send_window_(DEFAULT_WINDOW), peer_initial_window_(DEFAULT_WINDOW),
+      peer_max_frame_size_(MAX_FRAME_SIZE), output_paused_(false), open_(true) {
+}
+
+bool Http2Session::setUpgradeRequest(HttpRequest request, std::string_view settings) {
+    std::string payload;
+    if (!decodeBase64Url(settings, payload) || payload.size() % 6 != 0 ||
+        applySettings(payload) != Http2Error::NO_ERROR) {
+        return false;
+    }
+    upgrade_request_ = std::make_unique<HttpRequest>(std::move(request));
+    return true;
+}
+
+void Http2Session::sendResponse(uint32_t stream_id, std::string head, std::shared_ptr<const std::string> body,
+                                std::shared_ptr<HttpFileBody> file) {
+    post([stream_id, head = std::move(head), body = std::move(body), file = std::move(file)](Http2Session& session) {
+        session.reset_handlers_.erase(stream_id);
+        auto it = session.streams_.find(stream_id);
+        if (it == session.streams_.end() || it->second.head_sent) {
+            return;
+        }
+        Stream& stream = it->second;
+        if (stream.body_reader) {
+            stream.body_reader->abandon();
+        }
+        if (body && !body->empty()) {
+            stream.output.push_back(body);
+        }
+        if (file && file->length > 0) {
+            stream.file = file;
+        }
+        bool empty = stream.output.empty() && !stream.file;
+        stream.end_queued = true;
+        session.queueHead(stream_id, head, empty);
+        if (!empty) {
+            session.markReady(stream_id, stream);
+        }
+    });
+}
+
+void Http2Session::beginStream(uint32_t stream_id, std::string head) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (open_) {
+            backlog_.emplace(stream_id, 0);
+        }
+    }
+    post([stream_id, head = std::move(head)](Http2Session& session) {
+        auto it = session.streams_.find(stream_id);
+        if (it == session.streams_.end() || it->second.head_sent) {
+            session.releaseBacklog(stream_id, 0, true);
+            return;
+        }
+        Stream& stream = it->second;
+        if (stream.body_reader) {
+            stream.body_reader->abandon();
+        }
+        stream.streamed = true;
+        session.queueHead(stream_id, head, false);
+    });
+}
+
+bool Http2Session::writeStream(uint32_t stream_id, std::string data) {
+    bool drained;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained = drained_.wait_for(lock, SEND_TIMEOUT, [this, stream_id]() {
+            auto it = backlog_.find(stream_id);
+            return it == backlog_.end() || it->second <= MAX_STREAM_BACKLOG;
+        });
+        auto it = backlog_.find(stream_id);
+        if (it == backlog_.end()) {
+            return false;
+        }
+        if (drained) {
+            it->second += data.size();
+        }
+    }
+    if (!drained) {
+        LOG_WARNING("HTTP/2 peer stopped reading, resetting stream " + std::to_string(stream_id));
+        resetStream(stream_id, Http2Error::CANCEL);
+        return false;
+    }
+    queueStreamData(stream_id, std::move(data));
+    return true;
+}
+
+bool Http2Session::pushStream(uint32_t stream_id, std::string data) {
+    bool stalled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = backlog_.find(stream_id);
+        if (it == backlog_.end()) {
+            return false;
+        }
+        stalled = it->second > MAX_STREAM_BACKLOG;
+        if (!stalled) {
+            it->second += data.size();
+        }
+    }
+    if (stalled) {
+        LOG_WARNING("HTTP/2 peer stopped reading, resetting stream " + std::to_string(stream_id));
+        resetStream(stream_id, Http2Error::CANCEL);
+        return false;
+    }
+    queueStreamData(stream_id, std::move(data));
+    return true;
+}
+
+void Http2Session::queueStreamData(uint32_t stream_id, std::string data) {
+    auto piece = std::make_shared<const std::string>(std::move(data));
+    post([stream_id, piece](Http2Session& session) {
+        auto it = session.streams_.find(stream_id);
+        if (it == session.streams_.end()) {
+            return;
+        }
+        it->second.output.push_back(piece);
+        session.markReady(stream_id, it->second);
+    });
+}
+
+void Http2Session::endStream(uint32_t stream_id) {
+    post([stream_id](Http2Session& session) {
+        session.reset_handlers_.erase(stream_id);
+        auto it = session.streams_.find(stream_id);
+        if (it == session.streams_.end() || !it->second.head_sent) {
+            return;
+        }
+        it->second.end_queued = true;
+        session.markReady(stream_id, it->second);
+    });
+}
+
+void Http2Session::resetStream(uint32_t stream_id, Http2Error error) {
+    post([stream_id, error](Http2Session& session) {
+        if (session.streams_.count(stream_id)) {
+            session.writeRstStream(stream_id, error);
+            session.closeStream(stream_id);
+        }
+        session.reset_handlers_.erase(stream_id);
+    });
+}
+
+void Http2Session::post(std::function<void(Http2Session&)> task) {
+    auto self = shared_from_this();
+    loop_->queueInLoop([self, task = std::move(task)]() {
+        if (self->closed_ || self->goaway_sent_) {
+            return;
+        }
+        task(*self);
+        self->sendData();
+        self->flush();
+    });
+}
+
+void Http2Session::start() {
+    // Server preface. The connection window is opened beyond the default
+    // right away; stream windows through SETTINGS_INITIAL_WINDOW_SIZE.
+    std::string settings;
+    appendSetting(settings, SETTINGS_ENABLE_PUSH, 0);
+    appendSetting(settings, SETTINGS_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS);
+    appendSetting(settings, SETTINGS_INITIAL_WINDOW_SIZE, STREAM_WINDOW);
+    appendSetting(settings, SETTINGS_MAX_HEADER_LIST_SIZE, static_cast<uint32_t>(limits_.max_header_bytes));
+    writeFrame(SETTINGS, 0, 0, settings);
+    writeWindowUpdate(0, CONNECTION_WINDOW - DEFAULT_WINDOW);
+
+    if (upgrade_request_) {
+        // The upgrade request is stream 1, already half-closed by the client
+        Stream& stream = streams_[1];
+        stream.remote_closed = true;
+        stream.dispatched = true;
+        stream.send_window = peer_initial_window_;
+        last_stream_id_ = 1;
+        HttpRequest request = std::move(*upgrade_request_);
+        upgrade_request_.reset();
+        on_request_(shared_from_this(), 1, std::move(request));
+    }
+    flush();
+}
+
+void Http2Session::consume(std::string& buffer) {
+    if (closed_ || goaway_sent_) {
+        buffer.clear();
+        return;
+    }
+
+    if (!preface_received_) {
+        size_t length = std::min(buffer.size(), CLIENT_PREFACE.size());
+        if (std::string_view(buffer).substr(0, length) != CLIENT_PREFACE.substr(0, length)) {
+            LOG_DEBUG("Closing HTTP/2 connection without a client preface");
+            connectionError(Http2Error::PROTOCOL_ERROR);
+            buffer.clear();
+            return;
+        }
+        if (length < CLIENT_PREFACE.size()) {
+            return;
+        }
+        buffer.erase(0, CLIENT_PREFACE.size());
+        preface_received_ = true;
+    }
+
+    size_t offset = 0;
+    while (buffer.size() - offset >= FRAME_HEADER_SIZE) {
+        const auto* header = reinterpret_cast<const uint8_t*>(buffer.data() + offset);
+        size_t length = (size_t(header[0]) << 16) | (size_t(header[1]) << 8) | header[2];
+        if (length > MAX_FRAME_SIZE) {
+            connectionError(Http2Error::FRAME_SIZE_ERROR);
+            break;
+        }
+        if (buffer.size() - offset < FRAME_HEADER_SIZE + length) {
+            break;
+        }
+        uint8_t type = header[3];
+        uint8_t flags = header[4];
+        uint32_t stream_id = readUint32(buffer.data() + offset + 5) & 0x7FFFFFFF;
+        std::string_view payload(buffer.data() + offset + FRAME_HEADER_SIZE, length);
+        offset += FRAME_HEADER_SIZE + length;
+        if (!handleFrame(type, flags, stream_id, payload)) {
+            break;
+        }
+    }
+
+    if (goaway_sent_) {
+        buffer.clear();
+        return;
+    }
+    buffer.erase(0, offset);
+    sendData();
+    flush();
+}
+
+bool Http2Session::isBacklogged() {
+    // DATA is held back by sendData(); this only bounds control frames and
+    // headers a peer keeps provoking without reading the answers
+    auto connection = connection_.lock();
+    if (!connection || connection->outputBacklog() + output_.size() <= 2 * MAX_OUTPUT_BACKLOG) {
+        return false;
+    }
+    output_paused_ = true;
+    return true;
+}
+
+void Http2Session::onOutputFlushed() {
+    if (output_paused_) {
+        output_paused_ = false;
+        if (auto connection = connection_.lock()) {
+            connection->resumeReading();
+        }
+    }
+    sendData();
+    flush();
+}
+
+void Http2Session::onClosed() {
+    closed_ = true;
+    for (auto& entry : streams_) {
+        if (entry.second.body_reader) {
+            entry.second.body_reader->finish(false);
+        }
+    }
+    streams_.clear();
+    ready_.clear();
+    output_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+        backlog_.clear();
+    }
+    drained_.notify_all();
+}
+
+bool Http2Session::handleFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload) {
+    // A header block must arrive in one piece
+    if (continuation_stream_ != 0 && type != CONTINUATION) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+
+    switch (type) {
+        case DATA:
+            return handleData(flags, stream_id, payload);
+        case HEADERS:
+            return handleHeaders(flags, stream_id, payload);
+        case CONTINUATION:
+            return handleContinuation(flags, stream_id, payload);
+        case PRIORITY:
+            // Deprecated by RFC 9113; responses are scheduled round-robin
+            if (stream_id == 0) {
+                return connectionError(Http2Error::PROTOCOL_ERROR);
+            }
+            if (payload.size() != 5) {
+                return connectionError(Http2Error::FRAME_SIZE_ERROR);
+            }
+            return true;
+        case RST_STREAM:
+            return handleRstStream(stream_id, payload);
+        case SETTINGS:
+            return handleSettings(flags, stream_id, payload);
+        case PUSH_PROMISE:
+            // Clients never push
+            return connectionError(Http2Error::PROTOCOL_ERROR);
+        case PING:
+            if (stream_id != 0) {
+                return connectionError(Http2Error::PROTOCOL_ERROR);
+            }
+            if (payload.size() != 8) {
+                return connectionError(Http2Error::FRAME_SIZE_ERROR);
+            }
+            if (!(flags & FLAG_ACK)) {
+                writeFrame(PING, FLAG_ACK, 0, payload);
+            }
+            return true;
+        case GOAWAY:
+            if (stream_id != 0) {
+                return connectionError(Http2Error::PROTOCOL_ERROR);
+            }
+            if (payload.size() < 8) {
+                return connectionError(Http2Error::FRAME_SIZE_ERROR);
+            }
+            // Finish the streams in flight, then close
+            goaway_received_ = true;
+            if (streams_.empty()) {
+                connectionError(Http2Error::NO_ERROR);
+                return false;
+            }
+            return true;
+        case WINDOW_UPDATE:
+            return handleWindowUpdate(stream_id, payload);
+        default:
+            // Unknown frame types are ignored (RFC 9113 section 4.1)
+            return true;
+    }
+}
+
+bool Http2Session::handleHeaders(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+    if (stream_id == 0 || stream_id % 2 == 0) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+    if (!stripPadding(flags, payload)) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+    if (flags & FLAG_PRIORITY) {
+        if (payload.size() < 5) {
+            return connectionError(Http2Error::FRAME_SIZE_ERROR);
+        }
+        payload.remove_prefix(5);
+    }
+
+    header_block_.assign(payload);
+    bool end_stream = (flags & FLAG_END_STREAM) != 0;
+    if (flags & FLAG_END_HEADERS) {
+        return finishHeaders(stream_id, end_stream);
+    }
+    continuation_stream_ = stream_id;
+    continuation_end_stream_ = end_stream;
+    return true;
+}
+
+bool Http2Session::handleContinuation(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+    if (continuation_stream_ == 0 || stream_id != continuation_stream_) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+    header_block_.append(payload);
+    // The decoded list is capped later; this only bounds what is buffered
+    if (header_block_.size() > std::max(2 * limits_.max_header_bytes, MAX_FRAME_SIZE)) {
+        return connectionError(Http2Error::ENHANCE_YOUR_CALM);
+    }
+    if (flags & FLAG_END_HEADERS) {
+        continuation_stream_ = 0;
+        return finishHeaders(stream_id, continuation_end_stream_);
+    }
+    return true;
+}
+
+bool Http2Session::finishHeaders(uint32_t stream_id, bool end_stream) {
+    // Decoded even for streams that are then refused: the dynamic table
+    // has to follow every block the peer sent
+    std::vector<HeaderField> fields;
+    bool decoded = decoder_.decode(header_block_, fields);
+    header_block_.clear();
+    if (!decoded) {
+        return connectionError(Http2Error::COMPRESSION_ERROR);
+    }
+
+    auto it = streams_.find(stream_id);
+    if (it != streams_.end()) {
+        // Trailers: they must end the stream and are not passed on
+        if (it->second.remote_closed || !end_stream) {
+            return connectionError(Http2Error::PROTOCOL_ERROR);
+        }
+        receiveData(stream_id, it->second, {}, 0, true);
+        return true;
+    }
+    if (stream_id <= last_stream_id_) {
+        // Trailers of a stream we already reset
+        return true;
+    }
+    last_stream_id_ = stream_id;
+
+    // Streams the peer reset still count while their handler runs, so
+    // HEADERS followed by RST_STREAM cannot start unbounded work
+    if (streams_.size() + reset_handlers_.size() >= MAX_CONCURRENT_STREAMS) {
+        writeRstStream(stream_id, Http2Error::REFUSED_STREAM);
+        return true;
+    }
+    openStream(stream_id, fields, end_stream);
+    return true;
+}
+
+void Http2Session::openStream(uint32_t stream_id, std::vector<HeaderField>& fields, bool end_stream) {
+    std::string method;
+    std::string target;
+    std::string scheme;
+    std::string authority;
+    std::vector<std::pair<std::string, std::string>> headers;
+    size_t list_size = 0;
+    bool regular_seen = false;
+    bool valid = true;
+
+    for (auto& [name, value] : fields) {
+        list_size += name.size() + value.size() + 32;
+        if (!name.empty() && name[0] == ':') {
+            std::string* slot = nullptr;
+            if (name == ":method") {
+                slot = &method;
+            } else if (name == ":path") {
+                slot = &target;
+            } else if (name == ":scheme") {
+                slot = &scheme;
+            } else if (name == ":authority") {
+                slot = &authority;
+            }
+            // Pseudo-headers come first, once each, and only these four
+            if (regular_seen || !slot || !slot->empty()) {
+                valid = false;
+                break;
+            }
+            *slot = std::move(value);
+            continue;
+        }
+
+        regular_seen = true;
+        bool lowercase = std::none_of(name.begin(), name.end(), [](unsigned char c) { return std::isupper(c); });
+        if (!lowercase || isConnectionSpecific(name) || (name == "te" && value != "trailers")) {
+            valid = false;
+            break;
+        }
+        auto entry = std::find_if(headers.begin(), headers.end(),
+                                  [&name](const auto& header) { return header.first == name; });
+        if (entry == headers.end()) {
+            headers.emplace_back(std::move(name), std::move(value));
+        } else {
+            entry->second.append(name == "cookie" ? "; " : ", ").append(value);
+        }
+    }
+
+    if (!valid || method.empty() || target.empty() || scheme.empty()) {
+        writeRstStream(stream_id, Http2Error::PROTOCOL_ERROR);
+        return;
+    }
+    if (!authority.empty() &&
+        std::none_of(headers.begin(), headers.end(), [](const auto& header) { return header.first == "host"; })) {
+        headers.emplace_back("host", std::move(authority));
+    }
+
+    Stream& stream = streams_[stream_id];
+    stream.send_window = peer_initial_window_;
+    stream.remote_closed = end_stream;
+
+    // The request line and the header fields share one buffer the
+    // request's views point into
+    size_t head_length = method.size() + target.size() + HTTP2_VERSION.size();
+    for (const auto& [name, value] : headers) {
+        head_length += name.size() + value.size();
+    }
+    auto storage = std::make_shared<std::string>();
+    storage->reserve(head_length);
+    storage->append(method).append(target).append(HTTP2_VERSION);
+    std::vector<std::pair<size_t, size_t>> offsets;
+    offsets.reserve(headers.size());
+    for (const auto& [name, value] : headers) {
+        offsets.emplace_back(storage->size(), storage->size() + name.size());
+        storage->append(name).append(value);
+    }
+    std::string_view data(*storage);
+    stream.request.headers.clear();
+    for (size_t i = 0; i < headers.size(); ++i) {
+        stream.request.headers.add(data.substr(offsets[i].first, headers[i].first.size()),
+                                   data.substr(offsets[i].second, headers[i].second.size()));
+    }
+    setRequestStorage(stream.request, std::move(storage), method.size(), target.size(), head_length);
+
+    if (list_size > limits_.max_header_bytes) {
+        rejectStream(stream_id, stream, 431);
+        return;
+    }
+
+    if (end_stream) {
+        dispatch(stream_id, stream);
+        return;
+    }
+
+    if (body_stream_callback_ && body_stream_callback_(stream.request)) {
+        // The handler starts now and reads the body as it arrives
+        std::weak_ptr<Http2Session> weak_self = shared_from_this();
+        stream.body_reader = std::make_shared<RequestBodyReader>(STREAM_WINDOW, [weak_self, stream_id]() {
+            if (auto self = weak_self.lock()) {
+                self->post([stream_id](Http2Session& session) { session.releaseStreamWindow(stream_id); });
+            }
+        });
+        stream.request.body_reader = stream.body_reader;
+        dispatch(stream_id, stream);
+        return;
+    }
+
+    const std::string_view* content_length = stream.request.headers.find(HeaderId::CONTENT_LENGTH);
+    if (content_length && std::strtoull(std::string(*content_length).c_str(), nullptr, 10) > limits_.max_body_bytes) {
+        rejectStream(stream_id, stream, 413);
+    }
+}
+
+void Http2Session::rejectStream(uint32_t stream_id, Stream& stream, int status) {
+    stream.rejected = true;
+    stream.dispatched = true;
+    stream.body.clear();
+    on_error_(shared_from_this(), stream_id, status);
+}
+
+void Http2Session::dispatch(uint32_t stream_id, Stream& stream) {
+    stream.dispatched = true;
+    HttpRequest request = std::move(stream.request);
+    request.arena = RequestArena::acquire(arena_);
+    if (!stream.body.empty()) {
+        // The body joins the head in one buffer the request's views share
+        size_t method_length = request.method.size();
+        size_t head_length = request.raw->size();
+        size_t target_length = static_cast<size_t>(request.version.data() - request.raw->data()) - method_length;
+        auto storage = std::make_shared<std::string>();
+        storage->reserve(head_length + stream.body.size());
+        storage->append(*request.raw).append(stream.body);
+        setRequestStorage(request, std::move(storage), method_length, target_length, head_length);
+        stream.body.clear();
+        stream.body.shrink_to_fit();
+    }
+    on_request_(shared_from_this(), stream_id, std::move(request));
+}
+
+bool Http2Session::handleData(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+    if (stream_id == 0) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+
+    // The whole frame, padding included, counts against both windows
+    int32_t flow = static_cast<int32_t>(payload.size());
+    if (flow > recv_window_) {
+        return connectionError(Http2Error::FLOW_CONTROL_ERROR);
+    }
+    recv_window_ -= flow;
+    recv_unacked_ += flow;
+    if (recv_unacked_ >= CONNECTION_WINDOW / 2) {
+        // Buffered bodies are bounded per stream, so the connection
+        // window is replenished as soon as data is taken in
+        writeWindowUpdate(0, static_cast<uint32_t>(recv_unacked_));
+        recv_window_ += recv_unacked_;
+        recv_unacked_ = 0;
+    }
+
+    if (!stripPadding(flags, payload)) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        if (stream_id > last_stream_id_) {
+            return connectionError(Http2Error::PROTOCOL_ERROR);
+        }
+        // Reset by us; the peer may not have seen that yet
+        return true;
+    }
+    Stream& stream = it->second;
+    if (stream.remote_closed) {
+        writeRstStream(stream_id, Http2Error::STREAM_CLOSED);
+        closeStream(stream_id);
+        return true;
+    }
+    if (flow > stream.recv_window) {
+        writeRstStream(stream_id, Http2Error::FLOW_CONTROL_ERROR);
+        closeStream(stream_id);
+        return true;
+    }
+    stream.recv_window -= flow;
+    stream.recv_unacked += flow;
+
+    receiveData(stream_id, stream, payload, flow, (flags & FLAG_END_STREAM) != 0);
+    return true;
+}
+
+void Http2Session::receiveData(uint32_t stream_id, Stream& stream, std::string_view data, int32_t flow,
+                               bool end_stream) {
+    if (!data.empty() && !stream.rejected) {
+        stream.body_received += data.size();
+        if (stream.body_reader) {
+            if (stream.body_received > limits_.max_streamed_body_bytes) {
+                // The handler sees a truncated body; its answer is dropped
+                LOG_DEBUG("Resetting HTTP/2 stream over the streamed body limit");
+                writeRstStream(stream_id, Http2Error::CANCEL);
+                closeStream(stream_id);
+                return;
+            }
+            stream.body_reader->push(std::string(data));
+        } else if (stream.body_received > limits_.max_body_bytes) {
+            rejectStream(stream_id, stream, 413);
+        } else {
+            stream.body.append(data);
+        }
+    }
+
+    if (end_stream) {
+        stream.remote_closed = true;
+        if (stream.body_reader) {
+            stream.body_reader->finish(true);
+            stream.body_reader.reset();
+        } else if (!stream.dispatched) {
+            dispatch(stream_id, stream);
+        }
+        return;
+    }
+
+    // A streamed body's window only reopens as the handler drains it
+    if (flow > 0 && stream.recv_unacked >= STREAM_WINDOW / 2 &&
+        !(stream.body_reader && stream.body_reader->isFull())) {
+        writeWindowUpdate(stream_id, static_cast<uint32_t>(stream.recv_unacked));
+        stream.recv_window += stream.recv_unacked;
+        stream.recv_unacked = 0;
+    }
+}
+
+void Http2Session::releaseStreamWindow(uint32_t stream_id) {
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end() || it->second.remote_closed || it->second.recv_unacked == 0) {
+        return;
+    }
+    Stream& stream = it->second;
+    writeWindowUpdate(stream_id, static_cast<uint32_t>(stream.recv_unacked));
+    stream.recv_window += stream.recv_unacked;
+    stream.recv_unacked = 0;
+}
+
+bool Http2Session::handleSettings(uint8_t flags, uint32_t stream_id, std::string_view payload) {
+    if (stream_id != 0) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+    if (flags & FLAG_ACK) {
+        if (!payload.empty()) {
+            return connectionError(Http2Error::FRAME_SIZE_ERROR);
+        }
+        return true;
+    }
+    if (payload.size() % 6 != 0) {
+        return connectionError(Http2Error::FRAME_SIZE_ERROR);
+    }
+    Http2Error error = applySettings(payload);
+    if (error != Http2Error::NO_ERROR) {
+        return connectionError(error);
+    }
+    writeFrame(SETTINGS, FLAG_ACK, 0, {});
+    return true;
+}
+
+Http2Error Http2Session::applySettings(std::string_view payload) {
+    for (size_t offset = 0; offset + 6 <= payload.size(); offset += 6) {
+        uint16_t id = static_cast<uint16_t>((uint8_t(payload[offset]) << 8) | uint8_t(payload[offset + 1]));
+        uint32_t value = readUint32(payload.data() + offset + 2);
+        switch (id) {
+            case SETTINGS_ENABLE_PUSH:
+                if (value > 1) {
+                    return Http2Error::PROTOCOL_ERROR;
+                }
+                break;
+            case SETTINGS_INITIAL_WINDOW_SIZE: {
+                if (value > MAX_WINDOW) {
+                    return Http2Error::FLOW_CONTROL_ERROR;
+                }
+                // Applies to the open streams too, and may drive them negative
+                int64_t delta = static_cast<int64_t>(value) - peer_initial_window_;
+                peer_initial_window_ = value;
+                for (auto& [open_id, stream] : streams_) {
+                    stream.send_window += delta;
+                    if (stream.send_window > MAX_WINDOW) {
+                        return Http2Error::FLOW_CONTROL_ERROR;
+                    }
+                    if (delta > 0 && hasOutput(stream)) {
+                        markReady(open_id, stream);
+                    }
+                }
+                break;
+            }
+            case SETTINGS_MAX_FRAME_SIZE:
+                if (value < MAX_FRAME_SIZE || value > 0xFFFFFF) {
+                    return Http2Error::PROTOCOL_ERROR;
+                }
+                peer_max_frame_size_ = value;
+                break;
+            default:
+                // The encoder keeps no dynamic table and we never push, so
+                // the remaining settings do not change what we send
+                break;
+        }
+    }
+    return Http2Error::NO_ERROR;
+}
+
+bool Http2Session::handleWindowUpdate(uint32_t stream_id, std::string_view payload) {
+    if (payload.size() != 4) {
+        return connectionError(Http2Error::FRAME_SIZE_ERROR);
+    }
+    uint32_t increment = readUint32(payload.data()) & 0x7FFFFFFF;
+
+    if (stream_id == 0) {
+        if (increment == 0) {
+            return connectionError(Http2Error::PROTOCOL_ERROR);
+        }
+        send_window_ += increment;
+        if (send_window_ > MAX_WINDOW) {
+            return connectionError(Http2Error::FLOW_CONTROL_ERROR);
+        }
+        return true;
+    }
+
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        return stream_id > last_stream_id_ ? connectionError(Http2Error::PROTOCOL_ERROR) : true;
+    }
+    Stream& stream = it->second;
+    stream.send_window += increment;
+    if (increment == 0 || stream.send_window > MAX_WINDOW) {
+        writeRstStream(stream_id, increment == 0 ? Http2Error::PROTOCOL_ERROR : Http2Error::FLOW_CONTROL_ERROR);
+        closeStream(stream_id);
+        return true;
+    }
+    if (hasOutput(stream)) {
+        markReady(stream_id, stream);
+    }
+    return true;
+}
+
+bool Http2Session::handleRstStream(uint32_t stream_id, std::string_view payload) {
+    if (stream_id == 0 || stream_id > last_stream_id_) {
+        return connectionError(Http2Error::PROTOCOL_ERROR);
+    }
+    if (payload.size() != 4) {
+        return connectionError(Http2Error::FRAME_SIZE_ERROR);
+    }
+    closeStream(stream_id);
+    return true;
+}
+
+void Http2Session::queueHead(uint32_t stream_id, const std::string& head, bool end_stream) {
+    // Headers are not flow controlled; a block larger than the peer's
+    // frame size continues in CONTINUATION frames
+    std::string block = encodeResponseHead(head);
+    std::string_view remaining(block);
+    size_t length = std::min(remaining.size(), peer_max_frame_size_);
+    uint8_t flags = (end_stream ? FLAG_END_STREAM : 0) | (length == remaining.size() ? FLAG_END_HEADERS : 0);
+    writeFrame(HEADERS, flags, stream_id, remaining.substr(0, length));
+    remaining.remove_prefix(length);
+    while (!remaining.empty()) {
+        length = std::min(remaining.size(), peer_max_frame_size_);
+        writeFrame(CONTINUATION, length == remaining.size() ? FLAG_END_HEADERS : 0, stream_id,
+                   remaining.substr(0, length));
+        remaining.remove_prefix(length);
+    }
+
+    auto it = streams_.find(stream_id);
+    it->second.head_sent = true;
+    if (end_stream) {
+        finishStream(stream_id, it->second);
+    }
+}
+
+bool Http2Session::hasOutput(const Stream& stream) const {
+    return stream.head_sent && (!stream.output.empty() || stream.file || stream.end_queued);
+}
+
+void Http2Session::markReady(uint32_t stream_id, Stream& stream) {
+    if (!stream.ready) {
+        stream.ready = true;
+        ready_.push_back(stream_id);
+    }
+}
+
+void Http2Session::sendData() {
+    if (closed_ || goaway_sent_ || ready_.empty()) {
+        return;
+    }
+    auto connection = connection_.lock();
+    if (!connection) {
+        return;
+    }
+
+    // One frame per ready stream in turn, while the socket keeps up
+    size_t backlog = connection->outputBacklog();
+    while (!ready_.empty() && backlog + output_.size() < MAX_OUTPUT_BACKLOG) {
+        uint32_t stream_id = ready_.front();
+        ready_.pop_front();
+        auto it = streams_.find(stream_id);
+        if (it == streams_.end()) {
+            continue;
+        }
+        it->second.ready = false;
+        if (!sendDataFrame(stream_id, it->second)) {
+            // Out of connection window: wait for WINDOW_UPDATE on stream 0
+            it->second.ready = true;
+            ready_.push_front(stream_id);
+            break;
+        }
+    }
+}
+
+bool Http2Session::sendDataFrame(uint32_t stream_id, Stream& stream) {
+    size_t available = 0;
+    if (!stream.output.empty()) {
+        available = stream.output.front()->size() - stream.output_offset;
+    } else if (stream.file) {
+        available = stream.file->length;
+    }
+
+    if (available == 0) {
+        if (stream.end_queued) {
+            writeFrame(DATA, FLAG_END_STREAM, stream_id, {});
+            finishStream(stream_id, stream);
+        }
+        return true;
+    }
+    if (send_window_ <= 0) {
+        return false;
+    }
+    if (stream.send_window <= 0) {
+        // Resumes from the stream's next WINDOW_UPDATE
+        return true;
+    }
+
+    size_t length = std::min({available, peer_max_frame_size_, static_cast<size_t>(send_window_),
+                              static_cast<size_t>(stream.send_window)});
+    std::shared_ptr<const std::string> piece;
+    std::string file_data;
+    std::string_view payload;
+    if (!stream.output.empty()) {
+        piece = stream.output.front();
+        payload = std::string_view(*piece).substr(stream.output_offset, length);
+        stream.output_offset += length;
+        if (stream.output_offset == piece->size()) {
+            stream.output.pop_front();
+            stream.output_offset = 0;
+        }
+    } else {
+        file_data.resize(length);
+        ssize_t bytes_read = pread(stream.file->fd, &file_data[0], length, stream.file->offset);
+        if (bytes_read <= 0) {
+            // The file shrank below the advertised Content-Length
+            writeRstStream(stream_id, Http2Error::INTERNAL_ERROR);
+            closeStream(stream_id);
+            return true;
+        }
+        length = static_cast<size_t>(bytes_read);
+        payload = std::string_view(file_data.data(), length);
+        stream.file->offset += bytes_read;
+        stream.file->length -= length;
+        if (stream.file->length == 0) {
+            stream.file.reset();
+        }
+    }
+
+    send_window_ -= static_cast<int64_t>(length);
+    stream.send_window -= static_cast<int64_t>(length);
+    if (stream.streamed) {
+        releaseBacklog(stream_id, length, false);
+    }
+
+    bool last = stream.end_queued && stream.output.empty() && !stream.file;
+    writeFrame(DATA, last ? FLAG_END_STREAM : 0, stream_id, payload);
+    if (last) {
+        finishStream(stream_id, stream);
+    } else if (hasOutput(stream)) {
+        markReady(stream_id, stream);
+    }
+    return true;
+}
+
+void Http2Session::finishStream(uint32_t stream_id, Stream& stream) {
+    // Answered before the request was complete: tell the peer to stop
+    // sending the rest (RFC 9113 section 8.1)
+    if (!stream.remote_closed) {
+        writeRstStream(stream_id, Http2Error::NO_ERROR);
+    }
+    closeStream(stream_id);
+}
+
+void Http2Session::closeStream(uint32_t stream_id) {
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        return;
+    }
+    if (it->second.body_reader) {
+        it->second.body_reader->finish(false);
+    }
+    if (it->second.dispatched && !it->second.end_queued) {
+        reset_handlers_.insert(stream_id);
+    }
+    streams_.erase(it);
+    releaseBacklog(stream_id, 0, true);
+
+    if (goaway_received_ && streams_.empty()) {
+        connectionError(Http2Error::NO_ERROR);
+    }
+}
+
+void Http2Session::releaseBacklog(uint32_t stream_id, size_t bytes, bool erase) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = backlog_.find(stream_id);
+        if (it == backlog_.end()) {
+            return;
+        }
+        if (erase) {
+            backlog_.erase(it);
+        } else {
+            it->second -= bytes;
+        }
+    }
+    drained_.notify_all();
+}
+
+void Http2Session::writeFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload) {
+    char header[FRAME_HEADER_SIZE] = {
+        static_cast<char>(payload.size() >> 16),
+        static_cast<char>(payload.size() >> 8),
+        static_cast<char>(payload.size()),
+        static_cast<char>(type),
+        static_cast<char>(flags),
+        static_cast<char>((stream_id >> 24) & 0x7F),
+        static_cast<char>(stream_id >> 16),
+        static_cast<char>(stream_id >> 8),
+        static_cast<char>(stream_id),
+    };
+    output_.append(header, FRAME_HEADER_SIZE).append(payload);
+}
+
+void Http2Session::writeRstStream(uint32_t stream_id, Http2Error error) {
+    std::string payload;
+    appendUint32(payload, static_cast<uint32_t>(error));
+    writeFrame(RST_STREAM, 0, stream_id, payload);
+}
+
+void Http2Session::writeWindowUpdate(uint32_t stream_id, uint32_t increment) {
+    std::string payload;
+    appendUint32(payload, increment);
+    writeFrame(WINDOW_UPDATE, 0, stream_id, payload);
+}
+
+bool Http2Session::connectionError(Http2Error error) {
+    if (goaway_sent_) {
+        return false;
+    }
+    if (error != Http2Error::NO_ERROR) {
+        LOG_DEBUG("Closing HTTP/2 connection with error " + std::to_string(static_cast<uint32_t>(error)));
+    }
+    std::string payload;
+    appendUint32(payload, last_stream_id_);
+    appendUint32(payload, static_cast<uint32_t>(error));
+    writeFrame(GOAWAY, 0, 0, payload);
+    goaway_sent_ = true;
+
+    for (auto& entry : streams_) {
+        if (entry.second.body_reader) {
+            entry.second.body_reader->finish(false);
+        }
+    }
+    streams_.clear();
+    ready_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+        backlog_.clear();
+    }
+    drained_.notify_all();
+
+    // Closes the connection once the GOAWAY is flushed
+    flush();
+    return false;
+}
+
+void Http2Session::flush() {
+    if (output_.empty()) {
+        return;
+    }
+    auto connection = connection_.lock();
+    if (!connection) {
+        output_.clear();
+        return;
+    }
+    if (goaway_sent_) {
+        connection->endStream(std::move(output_), false);
+    } else {
+        connection->writeStream(std::move(output_));
+    }
+    output_.clear();
+}
+
+} // namespace AITextAssistant
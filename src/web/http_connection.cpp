@@ -0,0 +1,807 @@
+#include "web/http_connection.h"
+#include "web/event_loop.h"
+#include "utils/logger.h"
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <string_view>
+
+namespace AITextAssistant {
+
+namespace {
+
+// What an HTTP/2 client with prior knowledge opens with (RFC 9113 section 3.4)
+constexpr std::string_view HTTP2_PREFACE("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+
+} // namespace
+
+HttpConnection::HttpConnection(EventLoop* loop, int fd, const HttpParserLimits& limits)
+    : loop_(loop), fd_(fd), state_(State::READING), parser_(limits), output_offset_(0),
+      request_count_(0), keep_alive_(false), peer_closed_(false), streaming_(false),
+      closed_(false), stream_backlog_(0), stream_unflushed_(0), timers_(nullptr), deadline_phase_(Deadline::NONE), recv_op_(0), send_in_flight_(false),
+      fd_released_(false), send_message_{}, send_iov_{} {
+}
+
+HttpConnection::~HttpConnection() {
+    if (fd_ >= 0 && !fd_released_) {
+        close(fd_);
+    }
+}
+
+bool HttpConnection::start() {
+    // Runs on the loop thread from advance(). The close callback drops the
+    // server's reference, so hold one here: the connection, its deadline
+    // entry and this callback must outlive the call.
+    std::weak_ptr<HttpConnection> weak_deadline = weak_from_this();
+    deadline_.setCallback([weak_deadline]() {
+        if (auto self = weak_deadline.lock()) {
+            LOG_DEBUG("Closing connection after read timeout");
+            self->handleClose();
+        }
+    });
+    updateDeadline();
+
+    if (loop_->usesIoUring()) {
+        armRecv();
+        return recv_op_ != 0;
+    }
+
+    // The connection object stays alive through the loop's callback table
+    // only as long as the server holds it, so capture a weak reference
+    std::weak_ptr<HttpConnection> weak_self = shared_from_this();
+    return loop_->addFd(fd_, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+        [weak_self](uint32_t events) {
+            if (auto self = weak_self.lock()) {
+                self->handleEvents(events);
+            }
+        });
+}
+
+void HttpConnection::sendResponse(std::string head, bool keep_alive, std::shared_ptr<const std::string> body,
+                                  std::shared_ptr<HttpFileBody> file) {
+    // Always queue, even from the loop thread, so a response never
+    // re-enters the read path that produced its request
+    auto self = shared_from_this();
+    loop_->queueInLoop([self, head = std::move(head), keep_alive, body = std::move(body),
+                        file = std::move(file)]() mutable {
+        if (self->state_ != State::PROCESSING) {
+            return;
+        }
+        self->abandonBody();
+        self->output_buffer_ = std::move(head);
+        self->output_body_ = std::move(body);
+        self->output_offset_ = 0;
+        self->output_file_ = std::move(file);
+        self->keep_alive_ = keep_alive;
+        self->state_ = State::WRITING;
+        self->handleWrite();
+    });
+}
+
+void HttpConnection::beginStream(std::string head) {
+    auto self = shared_from_this();
+    loop_->queueInLoop([self, head = std::move(head)]() mutable {
+        if (self->state_ != State::PROCESSING) {
+            return;
+        }
+        self->abandonBody();
+        self->output_buffer_ = std::move(head);
+        self->output_offset_ = 0;
+        self->streaming_ = true;
+        self->state_ = State::WRITING;
+        self->handleWrite();
+    });
+}
+
+void HttpConnection::writeStream(std::string data) {
+    {
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        stream_backlog_ += data.size();
+    }
+    auto self = shared_from_this();
+    loop_->queueInLoop([self, data = std::move(data)]() {
+        if (self->state_ != State::WRITING || !self->streaming_) {
+            self->releaseBacklog(data.size());
+            return;
+        }
+        self->stream_unflushed_ += data.size();
+        self->appendOutput(data);
+        self->handleWrite();
+    });
+}
+
+void HttpConnection::endStream(std::string data, bool keep_alive) {
+    {
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        stream_backlog_ += data.size();
+    }
+    auto self = shared_from_this();
+    loop_->queueInLoop([self, data = std::move(data), keep_alive]() {
+        if (self->state_ != State::WRITING || !self->streaming_) {
+            self->releaseBacklog(data.size());
+            return;
+        }
+        self->stream_unflushed_ += data.size();
+        self->appendOutput(data);
+        self->streaming_ = false;
+        self->keep_alive_ = keep_alive;
+        self->handleWrite();
+    });
+}
+
+bool HttpConnection::waitForOutputBelow(size_t bytes, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(output_mutex_);
+    output_drained_.wait_for(lock, timeout, [this, bytes]() { return stream_backlog_ <= bytes || closed_; });
+    return stream_backlog_ <= bytes && !closed_;
+}
+
+size_t HttpConnection::outputBacklog() {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    return stream_backlog_;
+}
+
+void HttpConnection::upgrade(std::string head, std::shared_ptr<UpgradedProtocol> protocol) {
+    auto self = shared_from_this();
+    loop_->queueInLoop([self, head = std::move(head), protocol = std::move(protocol)]() mutable {
+        if (self->state_ != State::PROCESSING) {
+            return;
+        }
+        self->output_buffer_ = std::move(head);
+        self->output_offset_ = 0;
+        self->streaming_ = true;
+        self->state_ = State::WRITING;
+        self->upgraded_ = std::move(protocol);
+        self->handleWrite();
+        if (self->upgraded_) {
+            self->upgraded_->start();
+        }
+        // Frames may have arrived right behind the handshake
+        self->processInput();
+    });
+}
+
+void HttpConnection::resumeReading() {
+    std::weak_ptr<HttpConnection> weak_self = shared_from_this();
+    loop_->queueInLoop([weak_self]() {
+        if (auto self = weak_self.lock()) {
+            self->handleRead();
+        }
+    });
+}
+
+void HttpConnection::abort() {
+    auto self = shared_from_this();
+    loop_->queueInLoop([self]() { self->forceClose(); });
+}
+
+void HttpConnection::releaseBacklog(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        stream_backlog_ -= bytes;
+    }
+    output_drained_.notify_all();
+}
+
+void HttpConnection::forceClose() {
+    if (state_ != State::CLOSED) {
+        handleClose();
+    }
+}
+
+void HttpConnection::handleEvents(uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        handleClose();
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLRDHUP)) {
+        handleRead();
+    }
+
+    if (state_ == State::WRITING && (events & EPOLLOUT)) {
+        handleWrite();
+    }
+}
+
+void HttpConnection::handleRead() {
+    if (loop_->usesIoUring()) {
+        // Input arrives through handleReceive(); just resume a paused recv
+        if (state_ != State::CLOSED && !peer_closed_ && recv_op_ == 0 && canBufferInput()) {
+            armRecv();
+        }
+        processInput();
+        return;
+    }
+
+    char buffer[READ_CHUNK_SIZE];
+
+    while (state_ != State::CLOSED && !peer_closed_) {
+        // Leave the rest in the kernel while the handler catches up;
+        // reading resumes when it drains or the response is written
+        if (!canBufferInput()) {
+            break;
+        }
+
+        ssize_t bytes_read = recv(fd_, buffer, sizeof(buffer), 0);
+        if (bytes_read > 0) {
+            input_buffer_.append(buffer, static_cast<size_t>(bytes_read));
+            continue;
+        }
+
+        if (bytes_read == 0) {
+            // Peer closed its side; finish what is buffered, then close
+            peer_closed_ = true;
+            break;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            handleClose();
+            return;
+        }
+        break;
+    }
+
+    processInput();
+}
+
+void HttpConnection::processInput() {
+    if (upgraded_) {
+        upgraded_->consume(input_buffer_);
+        if (peer_closed_) {
+            handleClose();
+        }
+        return;
+    }
+    if (body_reader_) {
+        pumpBody();
+        if (body_reader_) {
+            return;
+        }
+    }
+    if (state_ != State::READING) {
+        return;
+    }
+    if (request_count_ == 0 && http2_callback_ && detectHttp2Preface()) {
+        return;
+    }
+
+    // The parser resumes where it stopped, so only new bytes are scanned
+    HttpRequestParser::Result result = parser_.parse(input_buffer_);
+
+    if (result == HttpRequestParser::Result::HEADERS) {
+        // Only the head is copied; the body stays in the input buffer
+        auto storage = std::make_shared<std::string>(input_buffer_, 0, parser_.getMessageLength());
+        HttpRequest head;
+        parser_.buildRequest(storage, head);
+        head.arena = RequestArena::acquire(arena_);
+        bool stream = body_stream_callback_(head);
+        if (!parser_.continueBody(stream)) {
+            result = HttpRequestParser::Result::ERROR;
+        } else if (stream) {
+            beginBodyStream(std::move(head));
+            return;
+        } else {
+            result = parser_.parse(input_buffer_);
+        }
+    }
+
+    if (result == HttpRequestParser::Result::INCOMPLETE) {
+        if (peer_closed_) {
+            handleClose();
+            return;
+        }
+        updateDeadline();
+        return;
+    }
+
+    state_ = State::PROCESSING;
+    ++request_count_;
+    updateDeadline();
+
+    if (result == HttpRequestParser::Result::ERROR) {
+        LOG_DEBUG("Rejecting malformed request: " + parser_.getErrorMessage());
+        // Framing is unreliable after an error; nothing more is read
+        peer_closed_ = true;
+        if (parse_error_callback_) {
+            parse_error_callback_(shared_from_this(), parser_.getErrorStatus());
+        }
+        return;
+    }
+
+    // Hand the whole buffer over to the request without copying it; only
+    // pipelined bytes that follow the message move to a fresh buffer
+    size_t message_length = parser_.getMessageLength();
+    auto storage = std::make_shared<std::string>(std::move(input_buffer_));
+    input_buffer_.assign(*storage, message_length, std::string::npos);
+
+    HttpRequest request;
+    parser_.buildRequest(storage, request);
+    request.arena = RequestArena::acquire(arena_);
+    parser_.reset();
+
+    if (request_callback_) {
+        request_callback_(shared_from_this(), std::move(request));
+    }
+}
+
+bool HttpConnection::detectHttp2Preface() {
+    size_t length = std::min(input_buffer_.size(), HTTP2_PREFACE.size());
+    if (length == 0 || std::string_view(input_buffer_).substr(0, length) != HTTP2_PREFACE.substr(0, length)) {
+        return false;
+    }
+    if (length < HTTP2_PREFACE.size()) {
+        // Not enough yet to tell it from an HTTP/1 request line
+        if (peer_closed_) {
+            handleClose();
+        } else {
+            updateDeadline();
+        }
+        return true;
+    }
+
+    // The session reads the preface itself and then owns the connection
+    ++request_count_;
+    streaming_ = true;
+    state_ = State::WRITING;
+    upgraded_ = http2_callback_(shared_from_this());
+    updateDeadline();
+    upgraded_->start();
+    processInput();
+    return true;
+}
+
+void HttpConnection::beginBodyStream(HttpRequest head) {
+    state_ = State::PROCESSING;
+    ++request_count_;
+
+    // The handler drains the reader on a worker thread; resume reading on
+    // the loop once it has made room
+    std::weak_ptr<HttpConnection> weak_self = shared_from_this();
+    body_reader_ = std::make_shared<RequestBodyReader>(STREAM_BODY_HIGH_WATER, [weak_self]() {
+        if (auto self = weak_self.lock()) {
+            self->resumeReading();
+        }
+    });
+    head.body_reader = body_reader_;
+
+    // Whatever followed the head in the same read goes out first
+    pumpBody();
+
+    if (request_callback_) {
+        request_callback_(shared_from_this(), std::move(head));
+    }
+}
+
+void HttpConnection::pumpBody() {
+    HttpRequestParser::Result result = parser_.parse(input_buffer_);
+
+    std::string chunk;
+    parser_.takeBody(input_buffer_, chunk);
+    if (!chunk.empty()) {
+        body_reader_->push(std::move(chunk));
+        // A streamed body may take long; the deadline bounds each stall
+        // rather than the whole upload
+        if (timers_) {
+            timers_->schedule(deadline_, timeouts_.body);
+            deadline_phase_ = Deadline::BODY;
+        }
+    }
+
+    if (result == HttpRequestParser::Result::COMPLETE) {
+        body_reader_->finish(true);
+        body_reader_.reset();
+        input_buffer_.erase(0, parser_.getMessageLength());
+        parser_.reset();
+    } else if (result == HttpRequestParser::Result::ERROR) {
+        // The rest of the stream cannot be framed; the handler sees a
+        // truncated body and the connection closes after its response
+        LOG_DEBUG("Aborting streamed request body: " + parser_.getErrorMessage());
+        body_reader_->finish(false);
+        body_reader_.reset();
+        input_buffer_.clear();
+        parser_.reset();
+        peer_closed_ = true;
+    } else if (peer_closed_) {
+        body_reader_->finish(false);
+        body_reader_.reset();
+    }
+    updateDeadline();
+}
+
+bool HttpConnection::canBufferInput() {
+    if (upgraded_) {
+        // Decode as we go so at most one partial frame is held
+        upgraded_->consume(input_buffer_);
+        return !upgraded_->isBacklogged();
+    }
+    if (body_reader_) {
+        pumpBody();
+    }
+    if (body_reader_) {
+        if (!body_reader_->isFull()) {
+            return true;
+        }
+        // Waiting on the handler, not the client: no deadline while paused
+        if (timers_) {
+            timers_->cancel(deadline_);
+            deadline_phase_ = Deadline::NONE;
+        }
+        return false;
+    }
+    // While a request is in flight only buffer a bounded amount of
+    // pipelined data; the rest stays in the kernel until we drain again
+    // after the response is written
+    return state_ == State::READING || input_buffer_.size() < MAX_PIPELINE_BUFFER;
+}
+
+void HttpConnection::abandonBody() {
+    // Answered without reading the whole body: keep reading and discard
+    // the rest so the connection stays usable for the next request
+    if (body_reader_) {
+        body_reader_->abandon();
+    }
+}
+
+void HttpConnection::handleWrite() {
+    if (loop_->usesIoUring()) {
+        submitOutput();
+        return;
+    }
+
+    if (!writeBuffers()) {
+        return;
+    }
+
+    if (output_file_) {
+        if (!writeFileBody()) {
+            return;
+        }
+        output_file_.reset();
+    }
+
+    finishOutput();
+}
+
+void HttpConnection::finishOutput() {
+    output_buffer_.clear();
+    output_body_.reset();
+    output_offset_ = 0;
+    if (stream_unflushed_ > 0) {
+        releaseBacklog(stream_unflushed_);
+        stream_unflushed_ = 0;
+    }
+    if (upgraded_) {
+        upgraded_->onOutputFlushed();
+    }
+
+    if (streaming_) {
+        // Flushed so far; the rest of the body is still being produced
+        return;
+    }
+
+    if (!keep_alive_) {
+        handleClose();
+        return;
+    }
+
+    // Back to reading: drain anything left in the kernel while the
+    // request was in flight, then dispatch a pipelined request if present
+    state_ = State::READING;
+    handleRead();
+}
+
+bool HttpConnection::writeBuffers() {
+    size_t head_size = output_buffer_.size();
+    size_t total = head_size + (output_body_ ? output_body_->size() : 0);
+
+    while (output_offset_ < total) {
+        // Gather whatever is left of the head and body into one call;
+        // a short write just moves the offset and the next pass rebuilds
+        struct iovec iov[2];
+        int iov_count = 0;
+        if (output_offset_ < head_size) {
+            iov[iov_count].iov_base = &output_buffer_[output_offset_];
+            iov[iov_count].iov_len = head_size - output_offset_;
+            ++iov_count;
+        }
+        if (output_body_ && !output_body_->empty()) {
+            size_t body_offset = output_offset_ > head_size ? output_offset_ - head_size : 0;
+            iov[iov_count].iov_base = const_cast<char*>(output_body_->data() + body_offset);
+            iov[iov_count].iov_len = output_body_->size() - body_offset;
+            ++iov_count;
+        }
+
+        // sendmsg rather than writev for MSG_NOSIGNAL
+        struct msghdr message = {};
+        message.msg_iov = iov;
+        message.msg_iovlen = static_cast<size_t>(iov_count);
+        ssize_t sent = sendmsg(fd_, &message, MSG_NOSIGNAL);
+        if (sent > 0) {
+            output_offset_ += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Resume on the next EPOLLOUT edge
+            return false;
+        }
+        handleClose();
+        return false;
+    }
+    return true;
+}
+
+bool HttpConnection::writeFileBody() {
+    // The kernel copies page cache straight to the socket
+    while (output_file_->length > 0) {
+        ssize_t sent = sendfile(fd_, output_file_->fd, &output_file_->offset, output_file_->length);
+        if (sent > 0) {
+            output_file_->length -= static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        // Error, or the file shrank below the advertised Content-Length
+        handleClose();
+        return false;
+    }
+    return true;
+}
+
+void HttpConnection::handleClose() {
+    if (state_ == State::CLOSED) {
+        return;
+    }
+    state_ = State::CLOSED;
+    closed_ = true;
+    if (timers_) {
+        timers_->cancel(deadline_);
+    }
+    if (body_reader_) {
+        body_reader_->finish(false);
+        body_reader_.reset();
+    }
+    if (upgraded_) {
+        upgraded_->onClosed();
+        upgraded_.reset();
+    }
+    {
+        // Wake stream producers waiting for the output to drain
+        std::lock_guard<std::mutex> lock(output_mutex_);
+    }
+    output_drained_.notify_all();
+
+    if (loop_->usesIoUring()) {
+        if (recv_op_ != 0) {
+            loop_->cancel(recv_op_);
+            recv_op_ = 0;
+        }
+        if (send_in_flight_) {
+            // The kernel still reads the output buffers; fail the send so
+            // its completion releases the connection
+            shutdown(fd_, SHUT_RDWR);
+        } else {
+            output_body_.reset();
+            output_file_.reset();
+        }
+    } else {
+        output_body_.reset();
+        output_file_.reset();
+        loop_->removeFd(fd_);
+    }
+
+    auto self = shared_from_this();
+    if (close_callback_) {
+        close_callback_(self);
+    }
+}
+
+void HttpConnection::updateDeadline() {
+    if (!timers_) {
+        return;
+    }
+
+    Deadline phase = Deadline::NONE;
+    if (body_reader_) {
+        phase = Deadline::BODY;
+    } else if (state_ == State::READING) {
+        if (parser_.inBody()) {
+            phase = Deadline::BODY;
+        } else if (!input_buffer_.empty()) {
+            phase = Deadline::HEADER;
+        } else {
+            phase = Deadline::IDLE;
+        }
+    }
+
+    // A phase's deadline is set once on entry; more bytes do not move it
+    if (phase == deadline_phase_) {
+        return;
+    }
+    deadline_phase_ = phase;
+
+    switch (phase) {
+        case Deadline::NONE:
+            timers_->cancel(deadline_);
+            break;
+        case Deadline::IDLE:
+            timers_->schedule(deadline_, timeouts_.idle);
+            break;
+        case Deadline::HEADER:
+            timers_->schedule(deadline_, timeouts_.header);
+            break;
+        case Deadline::BODY:
+            timers_->schedule(deadline_, timeouts_.body);
+            break;
+    }
+}
+
+void HttpConnection::appendOutput(const std::string& data) {
+    if (send_in_flight_) {
+        pending_output_.append(data);
+        return;
+    }
+
+    // Drop what has already been sent before growing the buffer
+    if (output_offset_ > 0) {
+        output_buffer_.erase(0, output_offset_);
+        output_offset_ = 0;
+    }
+    output_buffer_.append(data);
+}
+
+void HttpConnection::armRecv() {
+    std::weak_ptr<HttpConnection> weak_self = shared_from_this();
+    recv_op_ = loop_->submitRecv(fd_, [weak_self](int result, const char* data, bool more) {
+        if (auto self = weak_self.lock()) {
+            self->handleReceive(result, data, more);
+        }
+    });
+}
+
+void HttpConnection::handleReceive(int result, const char* data, bool more) {
+    if (state_ == State::CLOSED) {
+        return;
+    }
+    if (!more) {
+        recv_op_ = 0;
+    }
+
+    if (result > 0) {
+        // After an unrecoverable framing error the rest is discarded
+        if (!peer_closed_) {
+            input_buffer_.append(data, static_cast<size_t>(result));
+        }
+    } else if (result == 0) {
+        peer_closed_ = true;
+    } else if (result != -ENOBUFS && result != -ECANCELED) {
+        // ENOBUFS only means the provided buffers ran dry for a moment
+        handleClose();
+        return;
+    }
+
+    // Same bounds on buffered input as the epoll path
+    bool paused = !canBufferInput();
+    if ((paused || peer_closed_) && recv_op_ != 0) {
+        loop_->cancel(recv_op_);
+        recv_op_ = 0;
+    } else if (!paused && recv_op_ == 0 && !peer_closed_) {
+        armRecv();
+    }
+
+    processInput();
+}
+
+void HttpConnection::submitOutput() {
+    // The completion resumes output once the kernel is done with the buffers
+    if (send_in_flight_ || state_ != State::WRITING) {
+        return;
+    }
+
+    size_t head_size = output_buffer_.size();
+    size_t total = head_size + (output_body_ ? output_body_->size() : 0);
+    auto self = shared_from_this();
+
+    if (output_offset_ < total) {
+        int iov_count = 0;
+        if (output_offset_ < head_size) {
+            send_iov_[iov_count].iov_base = &output_buffer_[output_offset_];
+            send_iov_[iov_count].iov_len = head_size - output_offset_;
+            ++iov_count;
+        }
+        if (output_body_ && !output_body_->empty()) {
+            size_t body_offset = output_offset_ > head_size ? output_offset_ - head_size : 0;
+            send_iov_[iov_count].iov_base = const_cast<char*>(output_body_->data() + body_offset);
+            send_iov_[iov_count].iov_len = output_body_->size() - body_offset;
+            ++iov_count;
+        }
+        send_message_ = {};
+        send_message_.msg_iov = send_iov_;
+        send_message_.msg_iovlen = static_cast<size_t>(iov_count);
+
+        // The last write of a non-persistent response also closes the socket
+        bool close_after = !keep_alive_ && !streaming_ && !output_file_;
+        size_t length = total - output_offset_;
+        uint64_t id = loop_->submitSend(fd_, &send_message_, close_after,
+            [self, length, close_after](int result, bool) {
+                self->handleSendComplete(result, length, close_after);
+            });
+        if (id == 0) {
+            handleClose();
+            return;
+        }
+        send_in_flight_ = true;
+        return;
+    }
+
+    if (output_file_) {
+        // io_uring has no sendfile; keep the zero-copy path and wait for
+        // writability when the socket buffer fills
+        if (!writeFileBody()) {
+            if (state_ == State::CLOSED) {
+                return;
+            }
+            uint64_t id = loop_->submitPoll(fd_, POLLOUT, [self](int result, bool) {
+                self->send_in_flight_ = false;
+                if (result < 0 || self->state_ == State::CLOSED) {
+                    self->handleClose();
+                    self->output_body_.reset();
+                    self->output_file_.reset();
+                    return;
+                }
+                self->submitOutput();
+            });
+            if (id == 0) {
+                handleClose();
+                return;
+            }
+            send_in_flight_ = true;
+            return;
+        }
+        output_file_.reset();
+    }
+
+    finishOutput();
+}
+
+void HttpConnection::handleSendComplete(int result, size_t length, bool close_after) {
+    send_in_flight_ = false;
+    if (state_ == State::CLOSED || result < 0) {
+        handleClose();
+        output_body_.reset();
+        output_file_.reset();
+        return;
+    }
+
+    output_offset_ += static_cast<size_t>(result);
+
+    if (close_after && static_cast<size_t>(result) == length) {
+        // The linked close has taken the descriptor
+        fd_released_ = true;
+        output_buffer_.clear();
+        handleClose();
+        return;
+    }
+
+    if (!pending_output_.empty()) {
+        appendOutput(pending_output_);
+        pending_output_.clear();
+    }
+    submitOutput();
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,221 @@
+#include "web/http_headers.h"
+#include <algorithm>
+
+namespace AITextAssistant {
+
+namespace {
+
+constexpr size_t KNOWN_COUNT = static_cast<size_t>(HeaderId::COUNT);
+
+// Canonical spellings, indexed by HeaderId
+constexpr std::array<std::string_view, KNOWN_COUNT> CANONICAL_NAMES = {
+    "",
+    "Accept-Encoding",
+    "Access-Control-Allow-Headers",
+    "Access-Control-Allow-Methods",
+    "Access-Control-Allow-Origin",
+    "Access-Control-Max-Age",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Host",
+    "HTTP2-Settings",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "Keep-Alive",
+    "Range",
+    "Retry-After",
+    "Sec-WebSocket-Accept",
+    "Sec-WebSocket-Key",
+    "Sec-WebSocket-Version",
+    "Transfer-Encoding",
+    "Upgrade",
+    "Vary",
+};
+
+constexpr char toLower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Perfect hash over the known names: length, first letter and the fourth
+// letter from the end tell all of them apart. Candidates are confirmed
+// with a full comparison, so other names simply miss.
+constexpr size_t HASH_SLOTS = 64;
+constexpr size_t MIN_NAME_LENGTH = 4;
+
+constexpr size_t hashName(std::string_view name) {
+    return (name.size() * 7 + static_cast<unsigned char>(toLower(name[0])) +
+            2 * static_cast<unsigned char>(toLower(name[name.size() - 4]))) % HASH_SLOTS;
+}
+
+constexpr std::array<HeaderId, HASH_SLOTS> buildHashTable() {
+    std::array<HeaderId, HASH_SLOTS> table{};
+    for (size_t i = 1; i < KNOWN_COUNT; ++i) {
+        table[hashName(CANONICAL_NAMES[i])] = static_cast<HeaderId>(i);
+    }
+    return table;
+}
+
+constexpr std::array<HeaderId, HASH_SLOTS> HASH_TABLE = buildHashTable();
+
+constexpr bool hashIsPerfect() {
+    size_t filled = 0;
+    for (HeaderId id : HASH_TABLE) {
+        filled += id != HeaderId::OTHER;
+    }
+    return filled == KNOWN_COUNT - 1;
+}
+
+static_assert(hashIsPerfect(), "Known header names collide in the hash; adjust hashName()");
+
+} // namespace
+
+bool headerNameEquals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return toLower(x) == toLower(y); });
+}
+
+HeaderId headerId(std::string_view name) {
+    if (name.size() < MIN_NAME_LENGTH) {
+        return HeaderId::OTHER;
+    }
+    HeaderId candidate = HASH_TABLE[hashName(name)];
+    if (candidate != HeaderId::OTHER && headerNameEquals(name, CANONICAL_NAMES[static_cast<size_t>(candidate)])) {
+        return candidate;
+    }
+    return HeaderId::OTHER;
+}
+
+std::string_view headerName(HeaderId id) {
+    size_t index = static_cast<size_t>(id);
+    return index < KNOWN_COUNT ? CANONICAL_NAMES[index] : std::string_view();
+}
+
+void RequestHeaders::add(std::string_view name, std::string_view value) {
+    if (size_ == INLINE_CAPACITY && overflow_.empty()) {
+        overflow_.reserve(INLINE_CAPACITY * 2);
+        overflow_.assign(inline_.begin(), inline_.end());
+    }
+
+    Field field{name, value, headerId(name)};
+    if (overflow_.empty()) {
+        inline_[size_] = field;
+    } else {
+        overflow_.push_back(field);
+    }
+    ++size_;
+}
+
+void RequestHeaders::clear() {
+    overflow_.clear();
+    size_ = 0;
+}
+
+const std::string_view* RequestHeaders::find(HeaderId id) const {
+    for (const Field& field : *this) {
+        if (field.id == id) {
+            return &field.value;
+        }
+    }
+    return nullptr;
+}
+
+const std::string_view* RequestHeaders::find(std::string_view name) const {
+    HeaderId id = headerId(name);
+    if (id != HeaderId::OTHER) {
+        return find(id);
+    }
+    for (const Field& field : *this) {
+        if (field.id == HeaderId::OTHER && headerNameEquals(field.name, name)) {
+            return &field.value;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view RequestHeaders::get(HeaderId id) const {
+    const std::string_view* value = find(id);
+    return value ? *value : std::string_view();
+}
+
+std::string_view RequestHeaders::get(std::string_view name) const {
+    const std::string_view* value = find(name);
+    return value ? *value : std::string_view();
+}
+
+void RequestHeaders::rebase(const char* from, const char* to) {
+    auto move = [from, to](std::string_view view) {
+        return std::string_view(to + (view.data() - from), view.size());
+    };
+    Field* fields = data();
+    for (size_t i = 0; i < size_; ++i) {
+        fields[i].name = move(fields[i].name);
+        fields[i].value = move(fields[i].value);
+    }
+}
+
+ResponseHeaders::Field* ResponseHeaders::lookup(HeaderId id, std::string_view name) {
+    for (Field& field : fields_) {
+        if (field.id == id && (id != HeaderId::OTHER || headerNameEquals(field.custom_name, name))) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+const ResponseHeaders::Field* ResponseHeaders::lookup(HeaderId id, std::string_view name) const {
+    return const_cast<ResponseHeaders*>(this)->lookup(id, name);
+}
+
+std::string& ResponseHeaders::insert(HeaderId id, std::string_view name) {
+    if (Field* field = lookup(id, name)) {
+        return field->value;
+    }
+    if (fields_.empty()) {
+        fields_.reserve(8);
+    }
+    Field& field = fields_.emplace_back();
+    field.id = id;
+    if (id == HeaderId::OTHER) {
+        field.custom_name = name;
+    }
+    return field.value;
+}
+
+std::string& ResponseHeaders::operator[](HeaderId id) {
+    return insert(id, std::string_view());
+}
+
+std::string& ResponseHeaders::operator[](std::string_view name) {
+    return insert(headerId(name), name);
+}
+
+const std::string* ResponseHeaders::find(HeaderId id) const {
+    const Field* field = lookup(id, std::string_view());
+    return field ? &field->value : nullptr;
+}
+
+const std::string* ResponseHeaders::find(std::string_view name) const {
+    const Field* field = lookup(headerId(name), name);
+    return field ? &field->value : nullptr;
+}
+
+size_t ResponseHeaders::erase(HeaderId id) {
+    return erase(headerName(id));
+}
+
+size_t ResponseHeaders::erase(std::string_view name) {
+    HeaderId id = headerId(name);
+    auto removed = std::remove_if(fields_.begin(), fields_.end(), [id, name](const Field& field) {
+        return field.id == id && (id != HeaderId::OTHER || headerNameEquals(field.custom_name, name));
+    });
+    size_t count = static_cast<size_t>(fields_.end() - removed);
+    fields_.erase(removed, fields_.end());
+    return count;
+}
+
+} // namespace AITextAssistant
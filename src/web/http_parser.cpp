@@ -0,0 +1,450 @@
+#include "web/http_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+#include <limits>
+
+namespace AITextAssistant {
+
+namespace {
+
+bool isTokenChar(char c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+        return true;
+    }
+    return std::strchr("!#$%&'*+-.^_`|~", c) != nullptr && c != '\0';
+}
+
+bool equalsIgnoreCase(std::string_view a, const char* b) {
+    size_t length = std::strlen(b);
+    return a.size() == length && strncasecmp(a.data(), b, length) == 0;
+}
+
+std::string_view trimWhitespace(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+HttpRequestParser::HttpRequestParser(const Limits& limits) : limits_(limits), pause_after_headers_(false) {
+    reset();
+}
+
+void HttpRequestParser::reset() {
+    state_ = State::REQUEST_LINE;
+    position_ = 0;
+    scan_position_ = 0;
+    method_ = Span();
+    target_ = Span();
+    version_ = Span();
+    headers_.clear();
+    streaming_ = false;
+    chunked_ = false;
+    has_content_length_ = false;
+    content_length_ = 0;
+    body_start_ = 0;
+    body_length_ = 0;
+    body_taken_ = 0;
+    chunk_remaining_ = 0;
+    trailer_bytes_ = 0;
+    error_status_ = 0;
+    error_message_.clear();
+}
+
+HttpRequestParser::Result HttpRequestParser::parse(std::string& buffer) {
+    while (true) {
+        switch (state_) {
+            case State::REQUEST_LINE:
+            case State::HEADERS: {
+                Span line;
+                if (!nextLine(buffer, line)) {
+                    if (buffer.size() > limits_.max_header_bytes) {
+                        return fail(431, "Request header section too large");
+                    }
+                    return Result::INCOMPLETE;
+                }
+                if (position_ > limits_.max_header_bytes) {
+                    return fail(431, "Request header section too large");
+                }
+
+                if (state_ == State::REQUEST_LINE) {
+                    // Tolerate stray CRLFs before the request line (RFC 9112 2.2)
+                    if (line.length == 0) {
+                        continue;
+                    }
+                    if (!parseRequestLine(buffer, line)) {
+                        return Result::ERROR;
+                    }
+                    state_ = State::HEADERS;
+                } else if (line.length == 0) {
+                    if (!finishHeaders()) {
+                        return Result::ERROR;
+                    }
+                } else if (!parseHeaderLine(buffer, line)) {
+                    return Result::ERROR;
+                }
+                break;
+            }
+
+            case State::HEADERS_DONE:
+                return Result::HEADERS;
+
+            case State::BODY: {
+                if (streaming_) {
+                    // Account for whatever has arrived so takeBody() can pass it on
+                    size_t available = std::min(content_length_ - body_taken_ - body_length_,
+                                                buffer.size() - position_);
+                    body_length_ += available;
+                    position_ += available;
+                    if (body_taken_ + body_length_ < content_length_) {
+                        return Result::INCOMPLETE;
+                    }
+                    scan_position_ = position_;
+                    state_ = State::COMPLETE;
+                    break;
+                }
+                if (buffer.size() - body_start_ < content_length_) {
+                    return Result::INCOMPLETE;
+                }
+                body_length_ = content_length_;
+                position_ = body_start_ + content_length_;
+                state_ = State::COMPLETE;
+                break;
+            }
+
+            case State::CHUNK_SIZE:
+            case State::TRAILERS: {
+                Span line;
+                bool complete = nextLine(buffer, line);
+                // Without these caps a peer that never sends the newline
+                // would have the connection buffer input forever
+                if (state_ == State::CHUNK_SIZE) {
+                    size_t length = complete ? line.length : buffer.size() - position_;
+                    if (length > limits_.max_chunk_line_bytes) {
+                        return fail(400, "Chunk size line too long");
+                    }
+                    if (!complete) {
+                        return Result::INCOMPLETE;
+                    }
+                    if (!parseChunkSize(buffer, line)) {
+                        return Result::ERROR;
+                    }
+                    break;
+                }
+
+                size_t consumed = complete ? position_ - line.offset : buffer.size() - position_;
+                if (trailer_bytes_ + consumed > limits_.max_header_bytes) {
+                    return fail(431, "Request trailer section too large");
+                }
+                if (!complete) {
+                    return Result::INCOMPLETE;
+                }
+                trailer_bytes_ += consumed;
+                // Trailer fields are accepted and ignored
+                if (line.length == 0) {
+                    state_ = State::COMPLETE;
+                }
+                break;
+            }
+
+            case State::CHUNK_DATA: {
+                // Slide chunk payload down over the framing that preceded it
+                size_t available = std::min(chunk_remaining_, buffer.size() - position_);
+                if (available > 0) {
+                    std::memmove(&buffer[body_start_ + body_length_], &buffer[position_], available);
+                    body_length_ += available;
+                    position_ += available;
+                    chunk_remaining_ -= available;
+                }
+                if (chunk_remaining_ > 0) {
+                    return Result::INCOMPLETE;
+                }
+                state_ = State::CHUNK_DATA_END;
+                break;
+            }
+
+            case State::CHUNK_DATA_END: {
+                if (buffer.size() - position_ < 2) {
+                    return Result::INCOMPLETE;
+                }
+                if (buffer[position_] != '\r' || buffer[position_ + 1] != '\n') {
+                    return fail(400, "Malformed chunk terminator");
+                }
+                position_ += 2;
+                scan_position_ = position_;
+                state_ = State::CHUNK_SIZE;
+                break;
+            }
+
+            case State::COMPLETE:
+                return Result::COMPLETE;
+
+            case State::ERROR:
+                return Result::ERROR;
+        }
+    }
+}
+
+bool HttpRequestParser::continueBody(bool stream) {
+    if (state_ != State::HEADERS_DONE) {
+        return false;
+    }
+    streaming_ = stream;
+    return startBody();
+}
+
+void HttpRequestParser::takeBody(std::string& buffer, std::string& chunk) {
+    chunk.assign(buffer, body_start_, body_length_);
+    if (body_length_ == 0) {
+        return;
+    }
+    // Close the gap so unparsed bytes keep following the body start
+    buffer.erase(body_start_, body_length_);
+    // Mid-chunk the scan position is stale; position_ is the resume point
+    scan_position_ = std::max(scan_position_, position_) - body_length_;
+    position_ -= body_length_;
+    body_taken_ += body_length_;
+    body_length_ = 0;
+}
+
+void HttpRequestParser::buildRequest(const std::shared_ptr<const std::string>& storage,
+                                     HttpRequest& request) const {
+    std::string_view data(*storage);
+    request.raw = storage;
+    request.method = data.substr(method_.offset, method_.length);
+    request.version = data.substr(version_.offset, version_.length);
+    request.body = data.substr(body_start_, body_length_);
+
+    std::string_view target = data.substr(target_.offset, target_.length);
+    if (size_t query_pos = target.find('?'); query_pos != std::string_view::npos) {
+        request.path = target.substr(0, query_pos);
+        request.query = target.substr(query_pos + 1);
+    } else {
+        request.path = target;
+        request.query = std::string_view();
+    }
+
+    request.headers.clear();
+    for (const auto& header : headers_) {
+        request.headers.add(data.substr(header.name.offset, header.name.length),
+                            data.substr(header.value.offset, header.value.length));
+    }
+}
+
+bool HttpRequestParser::nextLine(const std::string& buffer, Span& line) {
+    const char* begin = buffer.data();
+    const void* newline = std::memchr(begin + scan_position_, '\n', buffer.size() - scan_position_);
+    if (!newline) {
+        scan_position_ = buffer.size();
+        return false;
+    }
+
+    size_t newline_pos = static_cast<const char*>(newline) - begin;
+    line.offset = position_;
+    line.length = newline_pos - position_;
+    if (line.length > 0 && buffer[newline_pos - 1] == '\r') {
+        --line.length;
+    }
+
+    position_ = newline_pos + 1;
+    scan_position_ = position_;
+    return true;
+}
+
+bool HttpRequestParser::parseRequestLine(const std::string& buffer, const Span& line) {
+    std::string_view text(buffer.data() + line.offset, line.length);
+
+    size_t method_end = text.find(' ');
+    if (method_end == std::string_view::npos || method_end == 0) {
+        fail(400, "Malformed request line");
+        return false;
+    }
+    for (size_t i = 0; i < method_end; ++i) {
+        if (!isTokenChar(text[i])) {
+            fail(400, "Invalid request method");
+            return false;
+        }
+    }
+
+    size_t target_end = text.find(' ', method_end + 1);
+    if (target_end == std::string_view::npos || target_end == method_end + 1) {
+        fail(400, "Malformed request line");
+        return false;
+    }
+
+    std::string_view version = text.substr(target_end + 1);
+    if (version.size() != 8 || version.compare(0, 7, "HTTP/1.") != 0) {
+        fail(505, "HTTP version not supported");
+        return false;
+    }
+
+    method_ = {line.offset, method_end};
+    target_ = {line.offset + method_end + 1, target_end - method_end - 1};
+    version_ = {line.offset + target_end + 1, version.size()};
+    return true;
+}
+
+bool HttpRequestParser::parseHeaderLine(const std::string& buffer, const Span& line) {
+    std::string_view text(buffer.data() + line.offset, line.length);
+
+    if (text.front() == ' ' || text.front() == '\t') {
+        fail(400, "Obsolete header line folding is not supported");
+        return false;
+    }
+
+    size_t colon_pos = text.find(':');
+    if (colon_pos == std::string_view::npos || colon_pos == 0) {
+        fail(400, "Malformed header line");
+        return false;
+    }
+    for (size_t i = 0; i < colon_pos; ++i) {
+        if (!isTokenChar(text[i])) {
+            fail(400, "Invalid header name");
+            return false;
+        }
+    }
+
+    if (headers_.size() >= limits_.max_header_count) {
+        fail(431, "Too many request headers");
+        return false;
+    }
+
+    std::string_view name = text.substr(0, colon_pos);
+    std::string_view value = trimWhitespace(text.substr(colon_pos + 1));
+    size_t value_offset = line.offset + static_cast<size_t>(value.data() - text.data());
+
+    // Framing headers are matched case-insensitively
+    if (equalsIgnoreCase(name, "content-length")) {
+        if (value.empty()) {
+            fail(400, "Invalid Content-Length");
+            return false;
+        }
+        size_t length = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9') {
+                fail(400, "Invalid Content-Length");
+                return false;
+            }
+            if (length > (std::numeric_limits<size_t>::max() - 9) / 10) {
+                fail(413, "Request body too large");
+                return false;
+            }
+            length = length * 10 + static_cast<size_t>(c - '0');
+        }
+        if (has_content_length_ && length != content_length_) {
+            fail(400, "Conflicting Content-Length headers");
+            return false;
+        }
+        has_content_length_ = true;
+        content_length_ = length;
+    } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+        // Only "chunked" (as the final coding) is understood
+        std::string_view last = value;
+        if (size_t comma = value.rfind(','); comma != std::string_view::npos) {
+            last = trimWhitespace(value.substr(comma + 1));
+        }
+        if (!equalsIgnoreCase(last, "chunked")) {
+            fail(501, "Unsupported Transfer-Encoding");
+            return false;
+        }
+        chunked_ = true;
+    }
+
+    headers_.push_back({{line.offset, colon_pos}, {value_offset, value.size()}});
+    return true;
+}
+
+bool HttpRequestParser::finishHeaders() {
+    body_start_ = position_;
+    body_length_ = 0;
+
+    // Both framings at once is a request smuggling vector; refuse it
+    if (chunked_ && has_content_length_) {
+        fail(400, "Both Transfer-Encoding and Content-Length present");
+        return false;
+    }
+
+    if (pause_after_headers_) {
+        state_ = State::HEADERS_DONE;
+        return true;
+    }
+    return startBody();
+}
+
+bool HttpRequestParser::startBody() {
+    if (chunked_) {
+        state_ = State::CHUNK_SIZE;
+        return true;
+    }
+
+    if (content_length_ > bodyLimit()) {
+        fail(413, "Request body too large");
+        return false;
+    }
+
+    state_ = content_length_ > 0 ? State::BODY : State::COMPLETE;
+    return true;
+}
+
+bool HttpRequestParser::parseChunkSize(const std::string& buffer, const Span& line) {
+    std::string_view text(buffer.data() + line.offset, line.length);
+    if (size_t ext = text.find(';'); ext != std::string_view::npos) {
+        text = text.substr(0, ext);
+    }
+    text = trimWhitespace(text);
+
+    if (text.empty()) {
+        fail(400, "Malformed chunk size");
+        return false;
+    }
+
+    size_t size = 0;
+    for (char c : text) {
+        int digit = hexValue(c);
+        if (digit < 0) {
+            fail(400, "Malformed chunk size");
+            return false;
+        }
+        if (size > (bodyLimit() >> 4)) {
+            fail(413, "Request body too large");
+            return false;
+        }
+        size = (size << 4) | static_cast<size_t>(digit);
+    }
+
+    if (size == 0) {
+        state_ = State::TRAILERS;
+        return true;
+    }
+
+    if (body_taken_ + body_length_ + size > bodyLimit()) {
+        fail(413, "Request body too large");
+        return false;
+    }
+
+    chunk_remaining_ = size;
+    state_ = State::CHUNK_DATA;
+    return true;
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(int status, const std::string& message) {
+    state_ = State::ERROR;
+    error_status_ = status;
+    error_message_ = message;
+    return Result::ERROR;
+}
+
+} // namespace AITextAssistant
@@ -1,30 +1,196 @@
 #include "web/http_server.h"
 #include "core/assistant.h"
+#include "web/event_loop.h"
+#include "web/http_connection.h"
+#include "web/static_file_cache.h"
+#include "web/timer_wheel.h"
 #include "utils/logger.h"
+#include "utils/thread_pool.h"
+#include <sys/epoll.h>
+#include <sched.h>
+#include <pthread.h>
 #include <sys/socket.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <sstream>
-#include <fstream>
 #include <filesystem>
 #include <nlohmann/json.hpp>
 #include <errno.h>
+#include <cstdio>
 #include <cstring>
+#include <strings.h>
+#include <algorithm>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace AITextAssistant {
 
-HttpServer::HttpServer(int port) : port_(port), running_(false), server_socket_(-1) {
+namespace {
+
+// Resolution of the per-connection read deadlines
+constexpr std::chrono::milliseconds TIMER_TICK(100);
+
+// After accept() runs out of descriptors or memory the listener is left
+// alone this long, rather than reported ready again on every wakeup
+constexpr std::chrono::milliseconds ACCEPT_RETRY_DELAY(500);
+// Repeated accept errors are logged at most once per interval
+constexpr std::chrono::seconds ACCEPT_ERROR_LOG_INTERVAL(5);
+
+bool isAcceptResourceError(int error) {
+    return error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM;
+}
+
+// Longest user message accepted by the chat endpoints, in bytes
+constexpr size_t MAX_USER_MESSAGE_LENGTH = 8000;
+
+// A streamed HTTP/1 body waits while this much is unsent, and gives up on
+// a client that reads nothing for STREAM_SEND_TIMEOUT
+constexpr size_t MAX_STREAM_BACKLOG = 256 * 1024;
+constexpr std::chrono::seconds STREAM_SEND_TIMEOUT(30);
+
+// One piece of a streamed HTTP/1 body as sent on the wire
+std::string streamPiece(const std::string& data, bool chunked) {
+    if (!chunked) {
+        return data;
+    }
+    char size_line[32];
+    int length = snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+    std::string frame;
+    frame.reserve(static_cast<size_t>(length) + data.size() + 2);
+    frame.append(size_line, static_cast<size_t>(length)).append(data).append("\r\n");
+    return frame;
+}
+
+// Whether a comma-separated header value lists `token`, ignoring case
+bool hasHeaderToken(std::string_view value, std::string_view token) {
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        std::string_view item = value.substr(0, comma);
+        size_t first = item.find_first_not_of(" \t");
+        if (first != std::string_view::npos) {
+            item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+            if (headerNameEquals(item, token)) {
+                return true;
+            }
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool equalsIgnoreCase(std::string_view a, const char* b) {
+    size_t length = std::strlen(b);
+    return a.size() == length && strncasecmp(a.data(), b, length) == 0;
+}
+
+// Written from this constant rather than stored per response
+constexpr std::string_view CORS_HEADER_BLOCK =
+    "Access-Control-Allow-Origin: *\r\n"
+    "Access-Control-Allow-Methods: GET, POST, DELETE, OPTIONS\r\n"
+    "Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
+    "Access-Control-Max-Age: 86400\r\n";
+
+bool isCorsHeader(HeaderId id) {
+    return id == HeaderId::ACCESS_CONTROL_ALLOW_ORIGIN || id == HeaderId::ACCESS_CONTROL_ALLOW_METHODS ||
+           id == HeaderId::ACCESS_CONTROL_ALLOW_HEADERS || id == HeaderId::ACCESS_CONTROL_MAX_AGE;
+}
+
+void addCorsHeaders(HttpResponse& response) {
+    response.cors = true;
+}
+
+HttpResponse internalErrorResponse() {
+    HttpResponse response;
+    response.status_code = 500;
+    response.body = "Internal Server Error";
+    addCorsHeaders(response);
+    return response;
+}
+
+// Shared by the copies of one async handler's responder: the first call
+// answers, later ones are ignored, and if every copy is dropped without
+// answering the client gets a 500 instead of waiting forever
+class ResponseSlot {
+public:
+    explicit ResponseSlot(HttpResponder respond) : respond_(std::move(respond)), answered_(false) {}
+
+    ~ResponseSlot() {
+        if (!answered_.exchange(true)) {
+            try {
+                respond_(internalErrorResponse());
+            } catch (const std::exception& e) {
+                LOG_ERROR("Failed to answer abandoned request: " + std::string(e.what()));
+            }
+        }
+    }
+
+    void answer(HttpResponse response) {
+        if (!answered_.exchange(true)) {
+            addCorsHeaders(response);
+            respond_(std::move(response));
+        }
+    }
+
+private:
+    HttpResponder respond_;
+    std::atomic<bool> answered_;
+};
+
+} // namespace
+
+struct HttpServer::ResponseGate {
+    // Held shared while a response is handed to a connection, exclusively
+    // by stop() before the loops go away
+    std::shared_mutex mutex;
+    bool open = true;
+    // Set first thing in stop(): streamed bodies end at their next piece
+    std::atomic<bool> stopping = false;
+};
+
+struct HttpServer::LoopThread {
+    explicit LoopThread(EventLoop::Backend backend) : loop(backend), timers(TIMER_TICK) {}
+
+    EventLoop loop;
+    // Declared before the connections so their timer entries unlink first
+    TimerWheel timers;
+    std::thread thread;
+    std::unordered_map<int, std::shared_ptr<HttpConnection>> connections;
+    int listen_fd = -1;
+    // Watches the listener again once an accept backoff ends
+    TimerWheel::Entry accept_retry;
+    std::chrono::steady_clock::time_point last_accept_error_log;
+    size_t suppressed_accept_errors = 0;
+
+    ~LoopThread() {
+        if (listen_fd >= 0) {
+            close(listen_fd);
+        }
+    }
+};
+
+HttpServer::HttpServer(int port, const ServerConfig& config)
+    : port_(port), config_(config), running_(false), has_streaming_routes_(false), sharded_accept_(false),
+      io_thread_count_(config.io_threads > 0 ? static_cast<size_t>(config.io_threads)
+                                             : std::max(1u, std::thread::hardware_concurrency())),
+      next_loop_(0), static_cache_(std::make_unique<StaticFileCache>(static_cast<size_t>(config.sendfile_threshold_bytes))) {
     // Register default API routes (legacy format)
     std::vector<RouteConfig> defaultRoutes = {
-        {"POST", "/api/chat", std::bind(&HttpServer::handleApiChat, this, std::placeholders::_1)},
         {"GET", "/api/conversations", std::bind(&HttpServer::handleApiConversations, this, std::placeholders::_1)},
         {"GET", "/api/conversations/messages", std::bind(&HttpServer::handleApiConversationMessages, this, std::placeholders::_1)},
         {"DELETE", "/api/conversations", std::bind(&HttpServer::handleApiDeleteConversation, this, std::placeholders::_1)},
+        {"GET", "/api/conversations/{id}/messages", std::bind(&HttpServer::handleApiConversationMessages, this, std::placeholders::_1)},
+        {"DELETE", "/api/conversations/{id}", std::bind(&HttpServer::handleApiDeleteConversation, this, std::placeholders::_1)},
         {"GET", "/api/status", std::bind(&HttpServer::handleApiStatus, this, std::placeholders::_1)},
-        {"POST", "/v1/chat/completions", std::bind(&HttpServer::handleOpenAIChat, this, std::placeholders::_1)},
         {"GET", "/v1/models", std::bind(&HttpServer::handleOpenAIModels, this, std::placeholders::_1)},
         {"OPTIONS", "/api/chat", std::bind(&HttpServer::handleResponseOK, this, std::placeholders::_1)},
         {"OPTIONS", "/api/conversations", std::bind(&HttpServer::handleResponseOK, this, std::placeholders::_1)},
+        {"OPTIONS", "/api/conversations/{id}", std::bind(&HttpServer::handleResponseOK, this, std::placeholders::_1)},
+        {"OPTIONS", "/api/conversations/{id}/messages", std::bind(&HttpServer::handleResponseOK, this, std::placeholders::_1)},
         {"OPTIONS", "/v1/chat/completions", std::bind(&HttpServer::handleResponseOK, this, std::placeholders::_1)},
         {"OPTIONS", "/v1/models", std::bind(&HttpServer::handleResponseOK, this, std::placeholders::_1)},
     };
@@ -32,6 +198,20 @@ HttpServer::HttpServer(int port) : port_(port), running_(false), server_socket_(
     for (const auto& route : defaultRoutes) {
         addRoute(route.method, route.path, route.handler);
     }
+
+    // The chat routes wait on the LLM without holding a worker
+    addCoroutineRoute("POST", "/api/chat", std::bind(&HttpServer::handleApiChat, this, std::placeholders::_1));
+    addCoroutineRoute("POST", "/v1/chat/completions", std::bind(&HttpServer::handleOpenAIChat, this,
+                                                                std::placeholders::_1));
+
+    // The WebSocket chat streams from the LLM without holding a worker;
+    // the next message on the socket starts once the reply is done, or
+    // the task failed and dropped `done`
+    addAsyncWebSocketRoute("/ws/chat", [this](const std::shared_ptr<WebSocket>& socket, const std::string& message,
+                                              bool binary, std::function<void()> done) {
+        auto finish = std::shared_ptr<void>(nullptr, [done = std::move(done)](void*) { done(); });
+        spawn(handleWebSocketChat(socket, message, binary), [finish]() {});
+    });
 }
 
 HttpServer::~HttpServer() {
@@ -42,11 +222,80 @@ bool HttpServer::start() {
     if (running_) {
         return false;
     }
-    
+
+    EventLoop::Backend backend = config_.io_backend == "io_uring" ? EventLoop::Backend::IO_URING
+                                                                   : EventLoop::Backend::EPOLL;
+    for (size_t i = 0; i < io_thread_count_; ++i) {
+        auto loop_thread = std::make_unique<LoopThread>(backend);
+        if (!loop_thread->loop.isValid() && backend == EventLoop::Backend::IO_URING && i == 0) {
+            // Kernel too old, io_uring disabled, or seccomp-filtered
+            LOG_WARNING("io_uring backend unavailable, falling back to epoll");
+            backend = EventLoop::Backend::EPOLL;
+            loop_thread = std::make_unique<LoopThread>(backend);
+        }
+        if (!loop_thread->loop.isValid()) {
+            LOG_ERROR("Failed to create event loop");
+            loop_threads_.clear();
+            return false;
+        }
+        loop_threads_.push_back(std::move(loop_thread));
+    }
+
+    // Each loop gets its own SO_REUSEPORT listener so the kernel spreads
+    // new connections across loops and no single accept queue is shared.
+    // Without SO_REUSEPORT, the first loop accepts for all of them.
+    bool reuse_port = loop_threads_.size() > 1;
+    for (auto& loop_thread : loop_threads_) {
+        loop_thread->listen_fd = createListenSocket(reuse_port);
+        if (loop_thread->listen_fd < 0) {
+            loop_threads_.clear();
+            return false;
+        }
+        if (!reuse_port) {
+            break;
+        }
+    }
+    sharded_accept_ = reuse_port;
+
+    worker_pool_ = std::make_unique<ThreadPool>(static_cast<size_t>(config_.worker_threads),
+                                                 static_cast<size_t>(config_.max_queue_size));
+    response_gate_ = std::make_shared<ResponseGate>();
+
+    // Listeners are level-triggered so a transient accept() failure is
+    // retried on the next wakeup instead of being lost; running out of
+    // descriptors pauses the listener for ACCEPT_RETRY_DELAY instead.
+    // On io_uring one multishot accept keeps delivering connections.
+    for (auto& loop_thread : loop_threads_) {
+        if (loop_thread->listen_fd >= 0) {
+            LoopThread* acceptor = loop_thread.get();
+            acceptor->accept_retry.setCallback([this, acceptor]() {
+                if (running_) {
+                    watchListener(acceptor);
+                }
+            });
+            watchListener(acceptor);
+        }
+    }
+
+    for (auto& loop_thread : loop_threads_) {
+        LoopThread* target = loop_thread.get();
+        target->loop.runEvery(TIMER_TICK, [target]() { target->timers.advance(); });
+    }
+
     running_ = true;
-    server_thread_ = std::thread(&HttpServer::serverLoop, this);
-    
-    LOG_INFO("HTTP server starting on port " + std::to_string(port_));
+    for (auto& loop_thread : loop_threads_) {
+        EventLoop* loop = &loop_thread->loop;
+        loop_thread->thread = std::thread([loop]() { loop->loop(); });
+    }
+    if (config_.pin_io_threads) {
+        pinLoopThreads();
+    }
+
+    LOG_INFO("HTTP server listening on port " + std::to_string(port_) +
+             " with " + std::to_string(io_thread_count_) +
+             (backend == EventLoop::Backend::IO_URING ? " io_uring" : " epoll") + " event loop(s)" +
+             (sharded_accept_ ? " on SO_REUSEPORT listeners" : "") + " and " +
+             std::to_string(config_.worker_threads) + " worker(s)");
     return true;
 }
 
@@ -54,232 +303,931 @@ void HttpServer::stop() {
     if (running_) {
         LOG_INFO("Stopping HTTP server...");
         running_ = false;
+        response_gate_->stopping = true;
 
-        // Close server socket to unblock accept()
-        if (server_socket_ != -1) {
-            LOG_INFO("Closing server socket...");
-            close(server_socket_);
-            server_socket_ = -1;
+        // Finish in-flight handlers first; they post their responses back
+        // to loops that must still exist
+        worker_pool_->shutdown();
+
+        // Async handlers still waiting on upstream calls answer into the
+        // void from now on
+        {
+            std::unique_lock<std::shared_mutex> lock(response_gate_->mutex);
+            response_gate_->open = false;
         }
 
-        if (server_thread_.joinable()) {
-            LOG_INFO("Waiting for server thread to join...");
-            server_thread_.join();
-            LOG_INFO("Server thread joined successfully");
+        // Wake every loop via its eventfd; no accept timeout to wait out
+        for (auto& loop_thread : loop_threads_) {
+            loop_thread->loop.quit();
+        }
+        for (auto& loop_thread : loop_threads_) {
+            if (loop_thread->thread.joinable()) {
+                loop_thread->thread.join();
+            }
         }
+        LOG_INFO("Event loops joined successfully");
+
+        // Loops are stopped, so connections and listeners can be torn down
+        loop_threads_.clear();
         LOG_INFO("HTTP server stopped");
     }
 }
 
 void HttpServer::addRoute(const std::string& method, const std::string& path, HttpHandler handler) {
-    std::string key = method + " " + path;
-    routes_[key] = handler;
+    if (!router_.add(method, path, std::move(handler))) {
+        LOG_ERROR("Invalid route: " + method + " " + path);
+    }
 }
 
-void HttpServer::serverLoop() {
-    server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket_ < 0) {
-        LOG_ERROR("Failed to create socket");
-        running_ = false;
+void HttpServer::addStreamingRoute(const std::string& method, const std::string& path, HttpHandler handler) {
+    if (!streaming_routes_.add(method, path, handler) || !router_.add(method, path, std::move(handler))) {
+        LOG_ERROR("Invalid route: " + method + " " + path);
         return;
     }
+    has_streaming_routes_ = true;
+}
+
+void HttpServer::addAsyncRoute(const std::string& method, const std::string& path, AsyncHttpHandler handler) {
+    if (!router_.add(method, path, std::move(handler))) {
+        LOG_ERROR("Invalid route: " + method + " " + path);
+    }
+}
+
+void HttpServer::addCoroutineRoute(const std::string& method, const std::string& path,
+                                   CoroutineHttpHandler handler) {
+    addAsyncRoute(method, path, [handler = std::move(handler)](const HttpRequest& request, HttpResponder respond) {
+        spawn(handler(request), std::move(respond));
+    });
+}
+
+void HttpServer::addWebSocketRoute(const std::string& path, WebSocket::MessageHandler handler) {
+    addAsyncWebSocketRoute(path, [handler = std::move(handler)](const std::shared_ptr<WebSocket>& socket,
+                                                               const std::string& message, bool binary,
+                                                               std::function<void()> done) {
+        handler(socket, message, binary);
+        done();
+    });
+}
+
+void HttpServer::addAsyncWebSocketRoute(const std::string& path, WebSocket::AsyncMessageHandler handler) {
+    websocket_routes_[path] = std::move(handler);
+    addRoute("GET", path, [](const HttpRequest&) {
+        HttpResponse response;
+        response.status_code = 426;
+        response.headers["Upgrade"] = "websocket";
+        response.headers["Content-Type"] = "application/json";
+        response.body = R"({"error": "This endpoint requires a WebSocket upgrade"})";
+        return response;
+    });
+}
+
+int HttpServer::createListenSocket(bool& reuse_port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create socket");
+        return -1;
+    }
 
     // Allow socket reuse
     int opt = 1;
-    setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    // Set socket timeout to make accept() non-blocking
-    struct timeval timeout;
-    timeout.tv_sec = 1;  // 1 second timeout
-    timeout.tv_usec = 0;
-    setsockopt(server_socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        LOG_WARNING("SO_REUSEPORT unavailable, accepting on a single listener: " + std::string(strerror(errno)));
+        reuse_port = false;
+    }
 
-    struct sockaddr_in server_addr;
+    struct sockaddr_in server_addr {};
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(port_);
 
-    if (bind(server_socket_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         LOG_ERROR("Failed to bind socket to port " + std::to_string(port_));
-        close(server_socket_);
-        server_socket_ = -1;
-        running_ = false;
-        return;
+        close(fd);
+        return -1;
     }
 
-    if (listen(server_socket_, 10) < 0) {
+    if (listen(fd, config_.listen_backlog) < 0) {
         LOG_ERROR("Failed to listen on socket");
-        close(server_socket_);
-        server_socket_ = -1;
-        running_ = false;
+        close(fd);
+        return -1;
+    }
+
+    // Resolve the actual port when an ephemeral one was requested, so the
+    // remaining listeners join the same one
+    socklen_t addr_len = sizeof(server_addr);
+    if (getsockname(fd, (struct sockaddr*)&server_addr, &addr_len) == 0) {
+        port_ = ntohs(server_addr.sin_port);
+    }
+
+    return fd;
+}
+
+void HttpServer::pinLoopThreads() {
+    // Only cores this process may run on (containers often restrict them)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (cpus.size() < 2) {
         return;
     }
 
-    LOG_INFO("HTTP server listening on port " + std::to_string(port_));
+    for (size_t i = 0; i < loop_threads_.size(); ++i) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpus[i % cpus.size()], &cpu_set);
+        int result = pthread_setaffinity_np(loop_threads_[i]->thread.native_handle(), sizeof(cpu_set), &cpu_set);
+        if (result != 0) {
+            LOG_WARNING("Failed to pin event loop thread: " + std::string(strerror(result)));
+        }
+    }
+}
 
-    while (running_) {
+void HttpServer::watchListener(LoopThread* acceptor) {
+    if (acceptor->loop.usesIoUring()) {
+        armAccept(acceptor);
+    } else {
+        acceptor->loop.addFd(acceptor->listen_fd, EPOLLIN, [this, acceptor](uint32_t) { handleAccept(acceptor); });
+    }
+}
+
+void HttpServer::handleAccept(LoopThread* acceptor) {
+    while (true) {
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
 
-        int client_socket = accept(server_socket_, (struct sockaddr*)&client_addr, &client_len);
+        int client_socket = accept4(acceptor->listen_fd, (struct sockaddr*)&client_addr, &client_len,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (client_socket < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // Timeout occurred, check if we should continue
+            int error = errno;
+            if (error == EINTR) {
                 continue;
-            } else if (running_) {
-                LOG_ERROR("Failed to accept client connection: " + std::string(strerror(errno)));
+            }
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                return;
+            }
+            logAcceptError(acceptor, error);
+            // The pending connection stays queued, so a level-triggered
+            // listener would wake the loop again at once
+            if (isAcceptResourceError(error)) {
+                acceptor->loop.removeFd(acceptor->listen_fd);
+                acceptor->timers.schedule(acceptor->accept_retry, ACCEPT_RETRY_DELAY);
+            }
+            return;
+        }
+
+        dispatchConnection(acceptor, client_socket);
+    }
+}
+
+void HttpServer::armAccept(LoopThread* acceptor) {
+    acceptor->loop.submitAccept(acceptor->listen_fd, [this, acceptor](int result, bool more) {
+        if (result >= 0) {
+            dispatchConnection(acceptor, result);
+        } else if (result != -EAGAIN && result != -ECANCELED) {
+            logAcceptError(acceptor, -result);
+        }
+        // The kernel ends a multishot accept on errors and overflow; after
+        // a resource error an immediate re-arm would fail again at once
+        if (!more && running_) {
+            if (result < 0 && isAcceptResourceError(-result)) {
+                acceptor->timers.schedule(acceptor->accept_retry, ACCEPT_RETRY_DELAY);
             } else {
-                // Server is shutting down, break the loop
-                LOG_INFO("Server shutting down, exiting accept loop");
-                break;
+                armAccept(acceptor);
             }
-            continue;
         }
+    });
+}
+
+void HttpServer::logAcceptError(LoopThread* acceptor, int error) {
+    auto now = std::chrono::steady_clock::now();
+    bool logged_before = acceptor->last_accept_error_log != std::chrono::steady_clock::time_point();
+    if (logged_before && now - acceptor->last_accept_error_log < ACCEPT_ERROR_LOG_INTERVAL) {
+        ++acceptor->suppressed_accept_errors;
+        return;
+    }
+    std::string message = "Failed to accept client connection: " + std::string(strerror(error));
+    if (acceptor->suppressed_accept_errors > 0) {
+        message += " (" + std::to_string(acceptor->suppressed_accept_errors) + " more since the last report)";
+    }
+    LOG_ERROR(message);
+    acceptor->last_accept_error_log = now;
+    acceptor->suppressed_accept_errors = 0;
+}
+
+void HttpServer::dispatchConnection(LoopThread* acceptor, int client_socket) {
+    // A sharded listener keeps its connections on its own loop
+    if (sharded_accept_) {
+        addConnection(acceptor, client_socket);
+        return;
+    }
+
+    // Round-robin new connections across the loops
+    LoopThread* target = loop_threads_[next_loop_].get();
+    next_loop_ = (next_loop_ + 1) % loop_threads_.size();
+    target->loop.queueInLoop([this, target, client_socket]() { addConnection(target, client_socket); });
+}
+
+void HttpServer::addConnection(LoopThread* target, int client_socket) {
+    // Pipelined responses go out one write at a time; without this Nagle
+    // holds each small write back until the previous one is acknowledged
+    int nodelay = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    auto connection = std::make_shared<HttpConnection>(&target->loop, client_socket, parserLimits());
+    HttpConnection::Timeouts timeouts;
+    timeouts.idle = std::chrono::seconds(config_.keep_alive_timeout_seconds);
+    timeouts.header = std::chrono::seconds(config_.header_timeout_seconds);
+    timeouts.body = std::chrono::seconds(config_.body_timeout_seconds);
+    connection->setTimeouts(&target->timers, timeouts);
+    connection->setRequestCallback(
+        [this](const std::shared_ptr<HttpConnection>& conn, HttpRequest request) {
+            onRequest(conn, std::move(request));
+        });
+    connection->setParseErrorCallback(
+        [this](const std::shared_ptr<HttpConnection>& conn, int status_code) {
+            onParseError(conn, status_code);
+        });
+    if (has_streaming_routes_) {
+        connection->setBodyStreamCallback([this](const HttpRequest& head) {
+            PathParams params;
+            return streaming_routes_.match(head.method, head.path, params) != nullptr;
+        });
+    }
+    connection->setHttp2Callback([this](const std::shared_ptr<HttpConnection>& conn) {
+        return createHttp2Session(conn);
+    });
+    connection->setCloseCallback([target](const std::shared_ptr<HttpConnection>& conn) {
+        // With io_uring the descriptor may already be closed and reused
+        // by a newer connection, so only drop our own entry
+        auto it = target->connections.find(conn->fd());
+        if (it != target->connections.end() && it->second == conn) {
+            target->connections.erase(it);
+        }
+    });
+
+    if (connection->start()) {
+        target->connections[client_socket] = connection;
+    }
+}
+
+HttpParserLimits HttpServer::parserLimits() const {
+    HttpParserLimits limits;
+    limits.max_header_bytes = static_cast<size_t>(config_.max_header_bytes);
+    limits.max_body_bytes = static_cast<size_t>(config_.max_body_bytes);
+    limits.max_streamed_body_bytes = static_cast<size_t>(config_.max_streamed_body_bytes);
+    return limits;
+}
+
+bool HttpServer::shouldKeepAlive(const HttpRequest& request) const {
+    std::string_view connection = request.headers.get(HeaderId::CONNECTION);
+
+    // HTTP/1.1 is persistent unless the client opts out; HTTP/1.0 only on request
+    if (request.version == "HTTP/1.0") {
+        return equalsIgnoreCase(connection, "keep-alive");
+    }
+    return !equalsIgnoreCase(connection, "close");
+}
+
+void HttpServer::onRequest(const std::shared_ptr<HttpConnection>& connection, HttpRequest request) {
+    // The handshake is cheap, so it is answered here on the loop thread
+    const std::string_view* upgrade = request.headers.find(HeaderId::UPGRADE);
+    if (upgrade && equalsIgnoreCase(*upgrade, "websocket")) {
+        auto route = websocket_routes_.find(std::string(request.path));
+        if (route != websocket_routes_.end()) {
+            acceptWebSocket(connection, request, route->second);
+            return;
+        }
+    }
+    if (upgrade && hasHeaderToken(*upgrade, "h2c") && upgradeToHttp2(connection, request)) {
+        return;
+    }
+
+    bool last_allowed = config_.max_requests_per_connection > 0 &&
+        connection->getRequestCount() >= static_cast<size_t>(config_.max_requests_per_connection);
+
+    // Route handlers may block, so run them on the bounded worker pool;
+    // when it is saturated, shed load instead of queueing. Async routes
+    // return the worker at once and answer from wherever they complete.
+    auto task = [this, connection, last_allowed, request = std::move(request)]() mutable {
+        if (!request.query.empty()) {
+            parseQueryString(request);
+        }
+        auto shared_request = std::make_shared<HttpRequest>(std::move(request));
+        handleRequest(*shared_request,
+            [this, gate = response_gate_, connection, last_allowed, shared_request](HttpResponse response) {
+                std::shared_lock<std::shared_mutex> lock(gate->mutex);
+                if (!gate->open) {
+                    return;
+                }
+                try {
+                    sendHttp1Response(connection, *shared_request, response, last_allowed, *gate, lock);
+                } catch (const std::exception& e) {
+                    // The response may be half written, so drop the connection
+                    LOG_ERROR("Failed to send response: " + std::string(e.what()));
+                    if (!lock.owns_lock()) {
+                        lock.lock();
+                    }
+                    if (gate->open) {
+                        connection->abort();
+                    }
+                }
+            });
+    };
+
+    if (!worker_pool_->trySubmit(std::move(task))) {
+        LOG_WARNING("Worker queue full, rejecting request with 503");
+        HttpResponse response = buildOverloadedResponse();
+        response.headers["Connection"] = "close";
+        std::shared_ptr<const std::string> body;
+        std::string head = buildResponse(response, body);
+        connection->sendResponse(std::move(head), false, std::move(body));
+    }
+}
+
+void HttpServer::sendHttp1Response(const std::shared_ptr<HttpConnection>& connection, const HttpRequest& request,
+                                   HttpResponse& response, bool last_allowed, ResponseGate& gate,
+                                   std::shared_lock<std::shared_mutex>& gate_lock) {
+    ContentEncoding encoding = selectResponseEncoding(request, response);
+
+    // HTTP/1.0 has no chunked coding, so a streamed body there is
+    // delimited by closing the connection
+    bool streamed = response.stream || response.push_stream;
+    bool chunked = streamed && request.version != "HTTP/1.0";
+    bool keep_alive = !last_allowed && shouldKeepAlive(request) && (!streamed || chunked);
+    if (keep_alive) {
+        response.headers["Connection"] = "keep-alive";
+        response.headers["Keep-Alive"] = "timeout=" + std::to_string(config_.keep_alive_timeout_seconds);
+    } else {
+        response.headers["Connection"] = "close";
+    }
+
+    if (response.push_stream) {
+        sendPushedResponse(connection, response, chunked, keep_alive, gate_lock);
+    } else if (response.stream) {
+        sendStreamedResponse(connection, response, chunked, keep_alive, gate, gate_lock);
+    } else {
+        std::shared_ptr<const std::string> body;
+        std::string head = buildResponse(response, body, encoding);
+        connection->sendResponse(std::move(head), keep_alive, std::move(body), std::move(response.file_body));
+    }
+}
+
+void HttpServer::onParseError(const std::shared_ptr<HttpConnection>& connection, int status_code) {
+    HttpResponse response;
+    response.status_code = status_code;
+    response.headers["Content-Type"] = "text/plain";
+    response.headers["Connection"] = "close";
+    response.body = statusText(status_code);
+    std::shared_ptr<const std::string> body;
+    std::string head = buildResponse(response, body);
+    connection->sendResponse(std::move(head), false, std::move(body));
+}
+
+void HttpServer::acceptWebSocket(const std::shared_ptr<HttpConnection>& connection, const HttpRequest& request,
+                                 const WebSocket::AsyncMessageHandler& handler) {
+    const std::string_view* connection_header = request.headers.find(HeaderId::CONNECTION);
+    const std::string_view* key = request.headers.find(HeaderId::SEC_WEBSOCKET_KEY);
+    const std::string_view* version = request.headers.find(HeaderId::SEC_WEBSOCKET_VERSION);
+
+    HttpResponse response;
+    if (request.method != "GET" || request.version != "HTTP/1.1" || !connection_header ||
+        !hasHeaderToken(*connection_header, "upgrade") || !key || key->size() != 24) {
+        response.status_code = 400;
+    } else if (!version || *version != "13") {
+        response.status_code = 426;
+        response.headers["Sec-WebSocket-Version"] = "13";
+    } else {
+        response.status_code = 101;
+        response.headers["Upgrade"] = "websocket";
+        response.headers["Connection"] = "Upgrade";
+        response.headers["Sec-WebSocket-Accept"] = webSocketAccept(*key);
+
+        // Messages larger than a buffered request body are refused
+        // Async handlers may use the socket after stop(); the gate turns
+        // that into a no-op once the loops are going away
+        auto socket = std::make_shared<WebSocket>(connection, handler,
+            [this](std::function<void()> task) { return worker_pool_->trySubmit(std::move(task)); },
+            [gate = response_gate_](const std::function<void()>& use) {
+                std::shared_lock<std::shared_mutex> lock(gate->mutex);
+                if (!gate->open) {
+                    return false;
+                }
+                use();
+                return true;
+            },
+            static_cast<size_t>(config_.max_body_bytes));
+        connection->upgrade(buildResponseHead(response, ""), std::move(socket));
+        return;
+    }
+
+    response.headers["Content-Type"] = "text/plain";
+    response.headers["Connection"] = "close";
+    response.body = statusText(response.status_code);
+    std::shared_ptr<const std::string> body;
+    std::string head = buildResponse(response, body);
+    connection->sendResponse(std::move(head), false, std::move(body));
+}
+
+std::shared_ptr<Http2Session> HttpServer::createHttp2Session(const std::shared_ptr<HttpConnection>& connection) {
+    auto session = std::make_shared<Http2Session>(connection, parserLimits(),
+        [this](const std::shared_ptr<Http2Session>& session, uint32_t stream_id, HttpRequest request) {
+            onHttp2Request(session, stream_id, std::move(request));
+        },
+        [this](const std::shared_ptr<Http2Session>& session, uint32_t stream_id, int status_code) {
+            onHttp2Error(session, stream_id, status_code);
+        });
+    if (has_streaming_routes_) {
+        session->setBodyStreamCallback([this](const HttpRequest& head) {
+            PathParams params;
+            return streaming_routes_.match(head.method, head.path, params) != nullptr;
+        });
+    }
+    return session;
+}
+
+bool HttpServer::upgradeToHttp2(const std::shared_ptr<HttpConnection>& connection, const HttpRequest& request) {
+    // A streamed body is still arriving as HTTP/1, so such a request is
+    // answered without switching; so is one with unusable settings
+    const std::string_view* connection_header = request.headers.find(HeaderId::CONNECTION);
+    const std::string_view* settings = request.headers.find(HeaderId::HTTP2_SETTINGS);
+    if (request.version != "HTTP/1.1" || request.body_reader || !settings || !connection_header ||
+        !hasHeaderToken(*connection_header, "upgrade")) {
+        return false;
+    }
+    auto session = createHttp2Session(connection);
+    if (!session->setUpgradeRequest(request, *settings)) {
+        return false;
+    }
+
+    HttpResponse response;
+    response.status_code = 101;
+    response.headers["Upgrade"] = "h2c";
+    response.headers["Connection"] = "Upgrade";
+    connection->upgrade(buildResponseHead(response, ""), std::move(session));
+    return true;
+}
+
+void HttpServer::onHttp2Request(const std::shared_ptr<Http2Session>& session, uint32_t stream_id,
+                                HttpRequest request) {
+    // Same worker pool and load shedding as HTTP/1 requests; streams of
+    // one connection run concurrently
+    auto task = [this, session, stream_id, request = std::move(request)]() mutable {
+        if (!request.query.empty()) {
+            parseQueryString(request);
+        }
+        auto shared_request = std::make_shared<HttpRequest>(std::move(request));
+        handleRequest(*shared_request,
+            [this, gate = response_gate_, session, stream_id, shared_request](HttpResponse response) {
+                std::shared_lock<std::shared_mutex> lock(gate->mutex);
+                if (!gate->open) {
+                    return;
+                }
+                try {
+                    sendHttp2Response(session, stream_id, *shared_request, response, *gate, lock);
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Failed to send response: " + std::string(e.what()));
+                    if (!lock.owns_lock()) {
+                        lock.lock();
+                    }
+                    if (gate->open) {
+                        session->resetStream(stream_id);
+                    }
+                }
+            });
+    };
+
+    if (!worker_pool_->trySubmit(std::move(task))) {
+        LOG_WARNING("Worker queue full, rejecting HTTP/2 stream with 503");
+        HttpResponse response = buildOverloadedResponse();
+        std::shared_ptr<const std::string> body;
+        std::string head = buildResponse(response, body);
+        session->sendResponse(stream_id, std::move(head), std::move(body));
+    }
+}
+
+void HttpServer::sendHttp2Response(const std::shared_ptr<Http2Session>& session, uint32_t stream_id,
+                                   const HttpRequest& request, HttpResponse& response, ResponseGate& gate,
+                                   std::shared_lock<std::shared_mutex>& gate_lock) {
+    ContentEncoding encoding = selectResponseEncoding(request, response);
+
+    if (response.push_stream) {
+        sendPushedHttp2Response(session, stream_id, response, gate_lock);
+        return;
+    }
+    if (!response.stream) {
+        std::shared_ptr<const std::string> body;
+        std::string head = buildResponse(response, body, encoding);
+        session->sendResponse(stream_id, std::move(head), std::move(body), std::move(response.file_body));
+        return;
+    }
+
+    // DATA frames delimit the body; no chunked coding
+    session->beginStream(stream_id, buildResponseHead(response, ""));
+
+    // As for HTTP/1, the gate is only held while a piece is handed over;
+    // writeStream() applies the stream's own flow control
+    gate_lock.unlock();
+    bool cut = false;
+    StreamWriter writer = [&session, &gate, &cut, stream_id](const std::string& data) {
+        if (gate.stopping) {
+            cut = true;
+            return false;
+        }
+        if (data.empty()) {
+            return true;
+        }
+        std::shared_lock<std::shared_mutex> lock(gate.mutex);
+        if (!gate.open || !session->writeStream(stream_id, data)) {
+            cut = true;
+            return false;
+        }
+        return true;
+    };
+    try {
+        response.stream(writer);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error while streaming response: " + std::string(e.what()));
+        cut = true;
+    }
+
+    gate_lock.lock();
+    if (!gate.open) {
+        return;
+    }
+    if (cut) {
+        session->resetStream(stream_id);
+        return;
+    }
+    session->endStream(stream_id);
+}
+
+void HttpServer::onHttp2Error(const std::shared_ptr<Http2Session>& session, uint32_t stream_id, int status_code) {
+    HttpResponse response;
+    response.status_code = status_code;
+    response.headers["Content-Type"] = "text/plain";
+    response.body = statusText(status_code);
+    std::shared_ptr<const std::string> body;
+    std::string head = buildResponse(response, body);
+    session->sendResponse(stream_id, std::move(head), std::move(body));
+}
+
+HttpResponse HttpServer::buildOverloadedResponse() {
+    HttpResponse response;
+    response.status_code = 503;
+    response.headers["Content-Type"] = "application/json";
+    response.headers["Retry-After"] = std::to_string(config_.retry_after_seconds);
+    response.body = R"({"error": "Server is busy, please retry later"})";
+    addCorsHeaders(response);
+    return response;
+}
 
-        // Handle client in a separate thread
-        std::thread client_thread(&HttpServer::handleClient, this, client_socket);
-        client_thread.detach();
-    }
-
-    if (server_socket_ != -1) {
-        close(server_socket_);
-        server_socket_ = -1;
-    }
-}
-
-void HttpServer::handleClient(int client_socket) {
-    std::string request_data;
-    char buffer[4096];
-    ssize_t bytes_read;
-    
-    // Keep receiving data until we have a complete HTTP request
-    while ((bytes_read = recv(client_socket, buffer, sizeof(buffer) - 1, 0)) > 0) {
-        buffer[bytes_read] = '\0';
-        request_data += std::string(buffer);
-        
-        // Check if we have received the complete HTTP headers (ending with \r\n\r\n)
-        size_t header_end = request_data.find("\r\n\r\n");
-        if (header_end != std::string::npos) {
-            // Parse Content-Length to determine if we need to read more body data
-            size_t content_length = 0;
-            size_t content_length_pos = request_data.find("Content-Length:");
-            if (content_length_pos != std::string::npos) {
-                size_t value_start = request_data.find(":", content_length_pos) + 1;
-                size_t value_end = request_data.find("\r\n", value_start);
-                std::string length_str = request_data.substr(value_start, value_end - value_start);
-                // Trim whitespace
-                length_str.erase(0, length_str.find_first_not_of(" \t"));
-                length_str.erase(length_str.find_last_not_of(" \t") + 1);
-                content_length = std::stoul(length_str);
+void HttpServer::sendStreamedResponse(const std::shared_ptr<HttpConnection>& connection,
+                                      const HttpResponse& response, bool chunked, bool keep_alive,
+                                      ResponseGate& gate, std::shared_lock<std::shared_mutex>& gate_lock) {
+    connection->beginStream(buildResponseHead(response, chunked ? "Transfer-Encoding: chunked" : ""));
+
+    // The body can take as long as an LLM generation, so the gate is only
+    // held while a piece is handed over and stop() need not wait for the
+    // rest. The server itself is not touched until the gate is retaken.
+    gate_lock.unlock();
+    bool cut = false;     // body left unfinished
+    bool stalled = false; // the client stopped reading
+    StreamWriter writer = [&connection, &gate, &cut, &stalled, chunked](const std::string& data) {
+        if (gate.stopping || connection->isClosed()) {
+            cut = true;
+            return false;
+        }
+        // An empty chunk would terminate the body early
+        if (data.empty()) {
+            return true;
+        }
+        // Hold the producer back while the client catches up, rather than
+        // buffer without limit; waking each tick to notice stop()
+        auto deadline = std::chrono::steady_clock::now() + STREAM_SEND_TIMEOUT;
+        while (!connection->waitForOutputBelow(MAX_STREAM_BACKLOG, TIMER_TICK)) {
+            if (gate.stopping || connection->isClosed()) {
+                cut = true;
+                return false;
             }
-            
-            size_t body_start = header_end + 4;
-            size_t current_body_length = request_data.length() - body_start;
-            
-            // If we have all the body data, break
-            if (current_body_length >= content_length) {
-                break;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                cut = true;
+                stalled = true;
+                return false;
             }
         }
+
+        std::shared_lock<std::shared_mutex> lock(gate.mutex);
+        if (!gate.open) {
+            cut = true;
+            return false;
+        }
+        connection->writeStream(streamPiece(data, chunked));
+        return true;
+    };
+
+    try {
+        response.stream(writer);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error while streaming response: " + std::string(e.what()));
+        cut = true;
     }
-    
-    if (bytes_read < 0 || request_data.empty()) {
-        close(client_socket);
+
+    gate_lock.lock();
+    if (!gate.open) {
         return;
     }
-    
-    HttpRequest request = parseRequest(request_data);
-    HttpResponse response = handleRequest(request);
-    std::string response_str = buildResponse(response);
-    
-    send(client_socket, response_str.c_str(), response_str.length(), 0);
-    close(client_socket);
-}
-
-HttpRequest HttpServer::parseRequest(const std::string& request_data) {
-    HttpRequest request;
-    std::istringstream stream(request_data);
-    std::string line;
-    
-    // Parse request line
-    if (std::getline(stream, line)) {
-        std::istringstream line_stream(line);
-        std::string path_with_query;
-        line_stream >> request.method >> path_with_query;
-        
-        // Parse path and query parameters
-        if (size_t query_pos = path_with_query.find('?'); query_pos != std::string::npos) {
-            request.path = path_with_query.substr(0, query_pos);
-            std::string query = path_with_query.substr(query_pos + 1);
-            request.query_params = parseQueryString(query);
-        } else {
-            request.path = path_with_query;
-        }
-    }
-    
-    // Parse headers
-    while (std::getline(stream, line) && line != "\r") {
-        if (size_t colon_pos = line.find(':'); colon_pos != std::string::npos) {
-            std::string key = line.substr(0, colon_pos);
-            std::string value = line.substr(colon_pos + 1);
-            // Trim whitespace
-            value.erase(0, value.find_first_not_of(" \t"));
-            value.erase(value.find_last_not_of(" \t\r") + 1);
-            request.headers[key] = value;
-        }
-    }
-    
-    // Parse body
-    std::string body;
-    while (std::getline(stream, line)) {
-        body += line + "\n";
-    }
-    if (!body.empty()) {
-        body.pop_back(); // Remove last newline
-    }
-    request.body = body;
-    
-    return request;
-}
-
-std::string HttpServer::buildResponse(const HttpResponse& response) {
-    std::ostringstream stream;
-    stream << "HTTP/1.1 " << response.status_code << " ";
-    
-    // Status text
-    switch (response.status_code) {
-        case 200: stream << "OK"; break;
-        case 404: stream << "Not Found"; break;
-        case 500: stream << "Internal Server Error"; break;
-        default: stream << "Unknown"; break;
-    }
-    stream << "\r\n";
-    
-    // Headers
+    if (stalled) {
+        LOG_WARNING("Client stopped reading a streamed response, closing the connection");
+        connection->abort();
+    } else if (cut) {
+        // Leave the body unterminated and close so the client sees the failure
+        connection->endStream("", false);
+    } else {
+        connection->endStream(chunked ? "0\r\n\r\n" : "", keep_alive);
+    }
+}
+
+void HttpServer::sendPushedResponse(const std::shared_ptr<HttpConnection>& connection, const HttpResponse& response,
+                                    bool chunked, bool keep_alive, std::shared_lock<std::shared_mutex>& gate_lock) {
+    connection->beginStream(buildResponseHead(response, chunked ? "Transfer-Encoding: chunked" : ""));
+
+    // Shared by the writer and the end, which run on the producer's
+    // threads; the connection is only touched while the gate is open
+    struct PushedBody {
+        std::shared_ptr<ResponseGate> gate;
+        std::shared_ptr<HttpConnection> connection;
+        bool chunked;
+        bool keep_alive;
+        std::atomic<bool> ended{false};
+
+        void end(bool complete) {
+            if (ended.exchange(true)) {
+                return;
+            }
+            std::shared_lock<std::shared_mutex> lock(gate->mutex);
+            if (!gate->open) {
+                return;
+            }
+            if (complete && !gate->stopping) {
+                connection->endStream(chunked ? "0\r\n\r\n" : "", keep_alive);
+            } else {
+                // Leave the body unterminated and close so the client sees the failure
+                connection->endStream("", false);
+            }
+        }
+        ~PushedBody() { end(false); }
+    };
+    auto body = std::make_shared<PushedBody>();
+    body->gate = response_gate_;
+    body->connection = connection;
+    body->chunked = chunked;
+    body->keep_alive = keep_alive;
+
+    StreamWriter writer = [body](const std::string& data) {
+        if (body->ended || body->gate->stopping || body->connection->isClosed()) {
+            return false;
+        }
+        // An empty chunk would terminate the body early
+        if (data.empty()) {
+            return true;
+        }
+        std::shared_lock<std::shared_mutex> lock(body->gate->mutex);
+        if (!body->gate->open) {
+            return false;
+        }
+        // Nothing waits for the client here, so one that reads nothing is
+        // dropped once MAX_STREAM_BACKLOG is queued for it
+        if (body->connection->outputBacklog() > MAX_STREAM_BACKLOG) {
+            if (!body->ended.exchange(true)) {
+                LOG_WARNING("Client stopped reading a streamed response, closing the connection");
+                body->connection->abort();
+            }
+            return false;
+        }
+        body->connection->writeStream(streamPiece(data, body->chunked));
+        return true;
+    };
+    StreamEnd end = [body](bool complete) { body->end(complete); };
+
+    // The producer may write and end before returning
+    gate_lock.unlock();
+    try {
+        response.push_stream(std::move(writer), std::move(end));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error while starting a streamed response: " + std::string(e.what()));
+    }
+    gate_lock.lock();
+}
+
+void HttpServer::sendPushedHttp2Response(const std::shared_ptr<Http2Session>& session, uint32_t stream_id,
+                                         const HttpResponse& response,
+                                         std::shared_lock<std::shared_mutex>& gate_lock) {
+    // DATA frames delimit the body; no chunked coding
+    session->beginStream(stream_id, buildResponseHead(response, ""));
+
+    // As for HTTP/1, but pushStream() applies the stream's own limits
+    struct PushedBody {
+        std::shared_ptr<ResponseGate> gate;
+        std::shared_ptr<Http2Session> session;
+        uint32_t stream_id;
+        std::atomic<bool> ended{false};
+
+        void end(bool complete) {
+            if (ended.exchange(true)) {
+                return;
+            }
+            std::shared_lock<std::shared_mutex> lock(gate->mutex);
+            if (!gate->open) {
+                return;
+            }
+            if (complete && !gate->stopping) {
+                session->endStream(stream_id);
+            } else {
+                session->resetStream(stream_id);
+            }
+        }
+        ~PushedBody() { end(false); }
+    };
+    auto body = std::make_shared<PushedBody>();
+    body->gate = response_gate_;
+    body->session = session;
+    body->stream_id = stream_id;
+
+    StreamWriter writer = [body](const std::string& data) {
+        if (body->ended || body->gate->stopping) {
+            return false;
+        }
+        if (data.empty()) {
+            return true;
+        }
+        std::shared_lock<std::shared_mutex> lock(body->gate->mutex);
+        return body->gate->open && body->session->pushStream(body->stream_id, data);
+    };
+    StreamEnd end = [body](bool complete) { body->end(complete); };
+
+    gate_lock.unlock();
+    try {
+        response.push_stream(std::move(writer), std::move(end));
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error while starting a streamed response: " + std::string(e.what()));
+    }
+    gate_lock.lock();
+}
+
+ContentEncoding HttpServer::selectResponseEncoding(const HttpRequest& request, HttpResponse& response) const {
+    // Static files negotiate their own cached variants; streamed bodies
+    // and small responses are sent as they are
+    if (config_.compression_min_bytes <= 0 || response.stream || response.push_stream || response.file_body || response.shared_body ||
+        response.body.size() < static_cast<size_t>(config_.compression_min_bytes) ||
+        response.status_code == 204 || response.status_code == 304 ||
+        response.headers.contains(HeaderId::CONTENT_ENCODING)) {
+        return ContentEncoding::IDENTITY;
+    }
+
+    const std::string* content_type = response.headers.find(HeaderId::CONTENT_TYPE);
+    if (!content_type || !Compression::isCompressible(*content_type)) {
+        return ContentEncoding::IDENTITY;
+    }
+
+    auto& vary = response.headers[HeaderId::VARY];
+    vary = vary.empty() ? "Accept-Encoding" : vary + ", Accept-Encoding";
+
+    const std::string_view* accept_encoding = request.headers.find(HeaderId::ACCEPT_ENCODING);
+    if (!accept_encoding) {
+        return ContentEncoding::IDENTITY;
+    }
+    // Dynamic bodies are compressed per request, so stay with zlib's
+    // fast codings rather than brotli
+    return Compression::negotiate(*accept_encoding, {ContentEncoding::GZIP, ContentEncoding::DEFLATE});
+}
+
+std::string HttpServer::buildResponse(HttpResponse& response, std::shared_ptr<const std::string>& body,
+                                      ContentEncoding encoding) {
+    body.reset();
+
+    // 304 carries no body and must not claim one
+    if (response.status_code == 304) {
+        return buildResponseHead(response, "");
+    }
+
+    // A file body is appended by the connection after the head
+    if (response.file_body) {
+        return buildResponseHead(response, "Content-Length: " + std::to_string(response.file_body->length));
+    }
+
+    // The body is handed to the connection as its own buffer and written
+    // after the head with one writev, so it is never copied into the head
+    if (response.shared_body) {
+        body = response.shared_body;
+    } else if (!response.body.empty()) {
+        body = std::make_shared<const std::string>(std::move(response.body));
+    }
+    size_t length = body ? body->size() : 0;
+
+    if (encoding != ContentEncoding::IDENTITY && body) {
+        // The body is fed through the compressor once and the output lands
+        // directly in its own buffer; no intermediate copy of the JSON
+        std::string compressed;
+        compressed.reserve(length / 4);
+        Compression::StreamCompressor compressor(encoding);
+        if (compressor.write(body->data(), length, compressed) && compressor.finish(compressed) &&
+            compressed.size() < length) {
+            body = std::make_shared<const std::string>(std::move(compressed));
+            return buildResponseHead(response,
+                std::string("Content-Encoding: ") + Compression::encodingName(encoding) +
+                "\r\nContent-Length: " + std::to_string(body->size()));
+        }
+    }
+
+    return buildResponseHead(response, "Content-Length: " + std::to_string(length));
+}
+
+std::string HttpServer::buildResponseHead(const HttpResponse& response, const std::string& framing_header) {
+    const char* status_text = statusText(response.status_code);
+
+    size_t size = 32 + std::strlen(status_text) + response.header_block.size() + framing_header.size() +
+                  (response.cors ? CORS_HEADER_BLOCK.size() : 0);
+    for (const auto& header : response.headers) {
+        size += header.name().size() + header.value.size() + 4;
+    }
+
+    std::string head;
+    head.reserve(size);
+    head.append("HTTP/1.1 ").append(std::to_string(response.status_code)).append(" ");
+    head.append(status_text).append("\r\n");
+
     for (const auto& header : response.headers) {
-        stream << header.first << ": " << header.second << "\r\n";
+        if (response.cors && isCorsHeader(header.id)) {
+            continue;
+        }
+        head.append(header.name()).append(": ").append(header.value).append("\r\n");
+    }
+    if (response.cors) {
+        head.append(CORS_HEADER_BLOCK);
+    }
+    head.append(response.header_block);
+    if (!framing_header.empty()) {
+        head.append(framing_header).append("\r\n");
     }
-    stream << "Content-Length: " << response.body.length() << "\r\n";
-    stream << "\r\n";
-    
-    // Body
-    stream << response.body;
-    
-    return stream.str();
+    head.append("\r\n");
+
+    return head;
 }
 
-HttpResponse HttpServer::handleRequest(const HttpRequest& request) {
-    // Try to find exact route match
-    std::string route_key = request.method + " " + request.path;
-    HttpResponse response;
+const char* HttpServer::statusText(int status_code) {
+    switch (status_code) {
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 426: return "Upgrade Required";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+    }
+}
 
-    if (auto route_it = routes_.find(route_key); route_it != routes_.end()) {
+void HttpServer::handleRequest(HttpRequest& request, HttpResponder respond) {
+    const Route* route = router_.match(request.method, request.path, request.path_params);
+
+    if (route && route->async_handler) {
+        auto slot = std::make_shared<ResponseSlot>(std::move(respond));
         try {
-            response = route_it->second(request);
+            route->async_handler(request, [slot](HttpResponse response) { slot->answer(std::move(response)); });
         } catch (const std::exception& e) {
-            LOG_ERROR("Error handling route " + route_key + ": " + e.what());
-            response.status_code = 500;
-            response.body = "Internal Server Error";
+            LOG_ERROR("Error handling route " + std::string(request.method) + " " +
+                      std::string(request.path) + ": " + e.what());
+            slot->answer(internalErrorResponse());
+        }
+        return;
+    }
+
+    HttpResponse response;
+    if (route) {
+        try {
+            response = route->handler(request);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Error handling route " + std::string(request.method) + " " +
+                      std::string(request.path) + ": " + e.what());
+            response = internalErrorResponse();
         }
     } else {
         // Handle route not found
@@ -287,122 +1235,239 @@ HttpResponse HttpServer::handleRequest(const HttpRequest& request) {
     }
 
     // Add CORS headers to all responses
-    response.headers["Access-Control-Allow-Origin"] = "*";
-    response.headers["Access-Control-Allow-Methods"] = "GET, POST, DELETE, OPTIONS";
-    response.headers["Access-Control-Allow-Headers"] = "Content-Type, Authorization";
-    response.headers["Access-Control-Max-Age"] = "86400";
-
-    return response;
+    addCorsHeaders(response);
+    respond(std::move(response));
 }
 
-std::map<std::string, std::string> HttpServer::parseQueryString(const std::string& query) {
-    std::map<std::string, std::string> params;
-    std::istringstream stream(query);
-    std::string pair;
-    
-    while (std::getline(stream, pair, '&')) {
-        if (size_t eq_pos = pair.find('='); eq_pos != std::string::npos) {
-            std::string key = urlDecode(pair.substr(0, eq_pos));
-            std::string value = urlDecode(pair.substr(eq_pos + 1));
-            params[key] = value;
+void HttpServer::parseQueryString(HttpRequest& request) {
+    std::string_view query = request.query;
+    while (!query.empty()) {
+        size_t end = query.find('&');
+        std::string_view pair = query.substr(0, end);
+        query = end == std::string_view::npos ? std::string_view() : query.substr(end + 1);
+
+        if (size_t eq_pos = pair.find('='); eq_pos != std::string_view::npos) {
+            std::string_view key = urlDecode(pair.substr(0, eq_pos), request);
+            std::string_view value = urlDecode(pair.substr(eq_pos + 1), request);
+            request.query_params.add(key, value);
         }
     }
-    
-    return params;
 }
 
-std::string HttpServer::urlDecode(const std::string& str) {
-    std::string result;
-    for (size_t i = 0; i < str.length(); ++i) {
-        if (str[i] == '%' && i + 2 < str.length()) {
-            int hex_value;
-            std::istringstream hex_stream(str.substr(i + 1, 2));
-            if (hex_stream >> std::hex >> hex_value) {
-                result += static_cast<char>(hex_value);
-                i += 2;
-            } else {
-                result += str[i];
-            }
-        } else if (str[i] == '+') {
-            result += ' ';
+std::string_view HttpServer::urlDecode(std::string_view text, HttpRequest& request) {
+    // Most names and values need no decoding and stay views into the request
+    if (text.find_first_of("%+") == std::string_view::npos) {
+        return text;
+    }
+    if (!request.arena) {
+        request.arena = std::make_shared<RequestArena>();
+    }
+
+    auto hexValue = [](char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        c = static_cast<char>(c | 0x20);
+        return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    };
+
+    // Decoding only shrinks the text
+    char* result = request.arena->allocate(text.size());
+    size_t length = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        int high = text[i] == '%' && i + 2 < text.size() ? hexValue(text[i + 1]) : -1;
+        int low = high >= 0 ? hexValue(text[i + 2]) : -1;
+        if (low >= 0) {
+            result[length++] = static_cast<char>(high * 16 + low);
+            i += 2;
+        } else if (text[i] == '+') {
+            result[length++] = ' ';
         } else {
-            result += str[i];
+            result[length++] = text[i];
         }
     }
-    return result;
+    return std::string_view(result, length);
 }
 
-HttpResponse HttpServer::handleApiChat(const HttpRequest& request) {
+Task<HttpResponse> HttpServer::handleApiChat(HttpRequest request) {
     HttpResponse response;
     response.headers["Content-Type"] = "application/json";
 
-    if (!assistant_) {
+    // The task may finish after the server is gone; keep what it needs
+    std::shared_ptr<TextAssistant> assistant = assistant_;
+    int retry_after_seconds = config_.retry_after_seconds;
+    if (!assistant) {
         response.status_code = 500;
         response.body = R"({"error": "Assistant not available"})";
-        return response;
+        co_return response;
     }
 
+    std::string message;
+    std::string conversation_id;
+    std::string error;
     try {
         nlohmann::json request_json = nlohmann::json::parse(request.body);
-        std::string message = request_json["message"];
-
-        // Handle conversation switching
-        std::string conversation_id;
+        message = request_json["message"];
         if (request_json.contains("conversation_id") && !request_json["conversation_id"].is_null()) {
             conversation_id = request_json["conversation_id"];
-
-            // Load the specified conversation if it's different from current
-            if (!conversation_id.empty()) {
-                if (!assistant_->loadConversation(conversation_id)) {
-                    // If conversation doesn't exist, create a new one
-                    conversation_id = assistant_->startNewConversation();
-                    if (conversation_id.empty()) {
-                        response.status_code = 500;
-                        response.body = R"({"error": "Failed to create new conversation"})";
-                        return response;
-                    }
-                }
-            }
-        } else {
-            // Create new conversation if none specified
-            conversation_id = assistant_->startNewConversation();
-            if (conversation_id.empty()) {
-                response.status_code = 500;
-                response.body = R"({"error": "Failed to create new conversation"})";
-                return response;
-            }
         }
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (!error.empty()) {
+        response.status_code = 400;
+        nlohmann::json error_json;
+        error_json["error"] = "Invalid request: " + error;
+        response.body = error_json.dump();
+        co_return response;
+    }
 
-        // Check message length (max 8000 characters for user input)
-        const size_t MAX_USER_MESSAGE_LENGTH = 8000;
-        if (message.length() > MAX_USER_MESSAGE_LENGTH) {
-            response.status_code = 400;
-            nlohmann::json error_json;
-            error_json["error"] = "Message too long. Maximum length is " + std::to_string(MAX_USER_MESSAGE_LENGTH) + " characters.";
-            error_json["current_length"] = message.length();
-            response.body = error_json.dump();
-            return response;
+    // Open the specified conversation, or create a new one if it doesn't
+    // exist or none was specified
+    ConversationHandle conversation;
+    if (!conversation_id.empty()) {
+        conversation = co_await assistant->openConversationTask(conversation_id);
+    }
+    if (!conversation) {
+        conversation = co_await assistant->startNewConversationTask();
+        if (!conversation) {
+            response.status_code = 500;
+            response.body = R"({"error": "Failed to create new conversation"})";
+            co_return response;
         }
+        conversation_id = conversation->id;
+    }
 
-        // Process the message through the assistant
-        std::string assistant_response = assistant_->processTextInput(message);
+    // Check message length (max 8000 characters for user input)
+    if (message.length() > MAX_USER_MESSAGE_LENGTH) {
+        response.status_code = 400;
+        nlohmann::json error_json;
+        error_json["error"] = "Message too long. Maximum length is " + std::to_string(MAX_USER_MESSAGE_LENGTH) + " characters.";
+        error_json["current_length"] = message.length();
+        response.body = error_json.dump();
+        co_return response;
+    }
 
-        nlohmann::json response_json;
-        response_json["status"] = "success";
-        response_json["conversation_id"] = conversation_id;
-        response_json["response"] = assistant_response;
-        response_json["is_split"] = false;
+    // Process the message through the assistant; no thread waits for the
+    // LLM, or for earlier messages in the conversation, meanwhile
+    std::string assistant_response;
+    bool busy = false;
+    try {
+        assistant_response = co_await assistant->processTextInputTask(conversation, message);
+    } catch (const ConversationBusyError&) {
+        busy = true;
+    }
+    if (busy) {
+        response.status_code = 429;
+        response.headers["Retry-After"] = std::to_string(retry_after_seconds);
+        nlohmann::json error_json;
+        error_json["error"] = "Too many messages pending in this conversation, please retry later";
+        error_json["conversation_id"] = conversation_id;
+        error_json["pending_messages"] = assistant->getPendingMessageCount(conversation_id);
+        response.body = error_json.dump();
+        co_return response;
+    }
 
-        response.body = response_json.dump();
+    nlohmann::json response_json;
+    response_json["status"] = "success";
+    response_json["conversation_id"] = conversation_id;
+    response_json["response"] = assistant_response;
+    response_json["is_split"] = false;
+
+    response.body = response_json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    co_return response;
+}
 
+Task<void> HttpServer::handleWebSocketChat(std::shared_ptr<WebSocket> socket, std::string message, bool binary) {
+    // Nothing here waits for the client: events are pushed, and a client
+    // too far behind is dropped. Upstream pieces may split a UTF-8
+    // sequence; never throw mid-stream
+    auto send = [socket](const nlohmann::json& event) {
+        return socket->pushText(event.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+    };
+    auto send_error = [send](const std::string& error) {
+        send({{"type", "error"}, {"error", error}});
+    };
+
+    // The task may finish after the server is gone; keep what it needs
+    std::shared_ptr<TextAssistant> assistant = assistant_;
+    std::shared_ptr<ResponseGate> gate = response_gate_;
+    if (binary) {
+        send_error("Messages must be JSON text");
+        co_return;
+    }
+    if (!assistant) {
+        send_error("Assistant not available");
+        co_return;
+    }
+
+    // Each message is {"message": "...", "conversation_id": "..."}; the
+    // reply streams back as start, token... and done events
+    std::string user_message;
+    std::string conversation_id;
+    try {
+        nlohmann::json request_json = nlohmann::json::parse(message);
+        user_message = request_json.at("message").get<std::string>();
+        if (request_json.contains("conversation_id") && request_json["conversation_id"].is_string()) {
+            conversation_id = request_json["conversation_id"].get<std::string>();
+        }
     } catch (const std::exception& e) {
-        response.status_code = 400;
-        nlohmann::json error_json;
-        error_json["error"] = "Invalid request: " + std::string(e.what());
-        response.body = error_json.dump();
+        send_error("Invalid request: " + std::string(e.what()));
+        co_return;
     }
 
-    return response;
+    if (user_message.length() > MAX_USER_MESSAGE_LENGTH) {
+        send_error("Message too long. Maximum length is " + std::to_string(MAX_USER_MESSAGE_LENGTH) + " characters.");
+        co_return;
+    }
+
+    // The database work runs on the assistant's executor, not this worker
+    ConversationHandle conversation;
+    if (!conversation_id.empty()) {
+        conversation = co_await assistant->openConversationTask(conversation_id);
+    }
+    if (!conversation) {
+        conversation = co_await assistant->startNewConversationTask();
+        if (!conversation) {
+            send_error("Failed to create new conversation");
+            co_return;
+        }
+        conversation_id = conversation->id;
+    }
+
+    if (!send({{"type", "start"}, {"conversation_id", conversation_id}})) {
+        co_return;
+    }
+
+    // Tokens are pushed from the LLM client's transfer thread, one at a
+    // time; the flags are read again only once the task resumes
+    auto streamed = std::make_shared<bool>(false);
+    auto connected = std::make_shared<bool>(true);
+    std::string assistant_response;
+    bool busy = false;
+    try {
+        assistant_response = co_await assistant->processTextInputStreamTask(conversation, user_message,
+            [send, gate, streamed, connected](const std::string& token) {
+                if (!token.empty() && *connected) {
+                    *streamed = true;
+                    *connected = !gate->stopping && send({{"type", "token"}, {"content", token}});
+                }
+                // Stop generating once the client is gone or the server stops
+                return *connected;
+            });
+    } catch (const ConversationBusyError&) {
+        busy = true;
+    }
+    if (busy) {
+        send_error("Too many messages pending in this conversation, please retry later");
+        co_return;
+    }
+
+    // Fallback replies (errors, not initialized) arrive only as the return value
+    if (!*streamed && !assistant_response.empty()) {
+        send({{"type", "token"}, {"content", assistant_response}});
+    }
+    send({{"type", "done"}, {"conversation_id", conversation_id}, {"response", assistant_response}});
 }
 
 HttpResponse HttpServer::handleApiConversations(const HttpRequest& /* request */) {
@@ -452,8 +1517,12 @@ HttpResponse HttpServer::handleApiDeleteConversation(const HttpRequest& request)
     }
 
     try {
-        nlohmann::json request_json = nlohmann::json::parse(request.body);
-        std::string conversation_id = request_json["conversation_id"];
+        // DELETE /api/conversations/{id}, or the legacy JSON body form
+        std::string conversation_id(request.path_params.get("id"));
+        if (conversation_id.empty()) {
+            nlohmann::json request_json = nlohmann::json::parse(request.body);
+            conversation_id = request_json["conversation_id"];
+        }
 
         if (conversation_id.empty()) {
             response.status_code = 400;
@@ -499,6 +1568,13 @@ HttpResponse HttpServer::handleApiStatus(const HttpRequest& /* request */) {
         status_json["total_messages"] = assistant_->getTotalMessages();
     }
 
+    if (worker_pool_) {
+        status_json["workers"]["threads"] = worker_pool_->getThreadCount();
+        status_json["workers"]["active"] = worker_pool_->getActiveCount();
+        status_json["workers"]["queued"] = worker_pool_->getQueueSize();
+        status_json["workers"]["max_queue"] = worker_pool_->getMaxQueueSize();
+    }
+
     response.body = status_json.dump();
     return response;
 }
@@ -506,7 +1582,7 @@ HttpResponse HttpServer::handleApiStatus(const HttpRequest& /* request */) {
 HttpResponse HttpServer::handleStaticFile(const HttpRequest& request) {
     HttpResponse response;
 
-    std::string file_path = static_directory_ + request.path;
+    std::string file_path = static_directory_ + std::string(request.path);
 
     // Default to index.html for root path
     if (request.path == "/") {
@@ -520,55 +1596,217 @@ HttpResponse HttpServer::handleStaticFile(const HttpRequest& request) {
         return response;
     }
 
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
+    auto asset = static_cache_->get(file_path);
+    if (!asset) {
         response.status_code = 404;
         response.body = "File not found";
         return response;
     }
 
-    // Read file content
-    std::ostringstream content_stream;
-    content_stream << file.rdbuf();
-    response.body = content_stream.str();
+    // The asset carries its own Content-Type in the pre-rendered block
+    response.headers.erase(HeaderId::CONTENT_TYPE);
+
+    const std::string_view* range = request.headers.find(HeaderId::RANGE);
+
+    // Compressed representations are offered for whole-body requests only
+    if (asset->compressible && !range) {
+        const std::string_view* accept_encoding = request.headers.find(HeaderId::ACCEPT_ENCODING);
+        ContentEncoding encoding = accept_encoding ? Compression::negotiate(*accept_encoding)
+                                                   : ContentEncoding::IDENTITY;
+        if (auto variant = static_cache_->getVariant(asset, file_path, encoding)) {
+            if (isNotModified(request, variant->etag, asset->modified_time)) {
+                response.status_code = 304;
+                response.header_block = variant->validator_block;
+                return response;
+            }
+            response.header_block = variant->header_block;
+            response.shared_body = std::shared_ptr<const std::string>(variant, &variant->body);
+            return response;
+        }
+    }
 
-    // Set appropriate content type
-    response.headers["Content-Type"] = getMimeType(file_path);
+    if (isNotModified(request, asset->etag, asset->modified_time)) {
+        response.status_code = 304;
+        response.header_block = asset->validator_block;
+        return response;
+    }
+
+    uint64_t size = asset->in_memory ? asset->body.size() : asset->size;
+    uint64_t start = 0;
+    uint64_t length = size;
+
+    // If-Range: only honour Range when the client's copy is still current
+    const std::string_view* if_range = request.headers.find(HeaderId::IF_RANGE);
+    if (range && (!if_range || *if_range == asset->etag || *if_range == asset->last_modified)) {
+        switch (parseByteRange(*range, size, start, length)) {
+            case RangeResult::UNSATISFIABLE:
+                response.status_code = 416;
+                response.headers["Content-Range"] = "bytes */" + std::to_string(size);
+                response.header_block = asset->validator_block;
+                return response;
+            case RangeResult::SATISFIABLE:
+                response.status_code = 206;
+                response.headers["Content-Range"] = "bytes " + std::to_string(start) + "-" +
+                    std::to_string(start + length - 1) + "/" + std::to_string(size);
+                break;
+            case RangeResult::NONE:
+                break;
+        }
+    }
+
+    response.header_block = asset->header_block;
+
+    if (asset->in_memory) {
+        if (length == size) {
+            response.shared_body = std::shared_ptr<const std::string>(asset, &asset->body);
+        } else {
+            response.body = asset->body.substr(start, length);
+        }
+        return response;
+    }
 
+    // Large file: hand the descriptor to the connection for sendfile()
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        response = HttpResponse();
+        response.status_code = 404;
+        response.body = "File not found";
+        return response;
+    }
+    response.file_body = std::make_shared<HttpFileBody>();
+    response.file_body->fd = fd;
+    response.file_body->offset = static_cast<off_t>(start);
+    response.file_body->length = length;
     return response;
 }
 
-std::string HttpServer::getMimeType(const std::string& filename) {
-    size_t dot_pos = filename.find_last_of('.');
-    if (dot_pos == std::string::npos) {
-        return "text/plain";
+HttpServer::RangeResult HttpServer::parseByteRange(std::string_view header, uint64_t size,
+                                                   uint64_t& start, uint64_t& length) {
+    auto parseNumber = [](std::string_view text, uint64_t& value) {
+        if (text.empty() || text.size() > 19) {
+            return false;
+        }
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return true;
+    };
+
+    std::string_view spec(header);
+    if (spec.substr(0, 6) != "bytes=") {
+        return RangeResult::NONE;
     }
+    spec.remove_prefix(6);
 
-    std::string extension = filename.substr(dot_pos + 1);
+    // Multiple ranges would need multipart/byteranges; send the whole file
+    size_t dash = spec.find('-');
+    if (dash == std::string_view::npos || spec.find(',') != std::string_view::npos) {
+        return RangeResult::NONE;
+    }
 
-    if (extension == "html" || extension == "htm") return "text/html";
-    if (extension == "css") return "text/css";
-    if (extension == "js") return "application/javascript";
-    if (extension == "json") return "application/json";
-    if (extension == "png") return "image/png";
-    if (extension == "jpg" || extension == "jpeg") return "image/jpeg";
-    if (extension == "gif") return "image/gif";
-    if (extension == "svg") return "image/svg+xml";
-    if (extension == "ico") return "image/x-icon";
+    std::string_view first_text = spec.substr(0, dash);
+    std::string_view last_text = spec.substr(dash + 1);
+    uint64_t first = 0;
+    uint64_t last = 0;
 
-    return "text/plain";
+    if (first_text.empty()) {
+        // Suffix range: the final N bytes
+        if (!parseNumber(last_text, last)) {
+            return RangeResult::NONE;
+        }
+        if (last == 0 || size == 0) {
+            return RangeResult::UNSATISFIABLE;
+        }
+        length = std::min(last, size);
+        start = size - length;
+        return RangeResult::SATISFIABLE;
+    }
+
+    if (!parseNumber(first_text, first)) {
+        return RangeResult::NONE;
+    }
+    if (last_text.empty()) {
+        last = size > 0 ? size - 1 : 0;
+    } else if (!parseNumber(last_text, last) || last < first) {
+        return RangeResult::NONE;
+    }
+
+    if (first >= size) {
+        return RangeResult::UNSATISFIABLE;
+    }
+    last = std::min(last, size - 1);
+    start = first;
+    length = last - first + 1;
+    return RangeResult::SATISFIABLE;
 }
 
-HttpResponse HttpServer::handleOpenAIChat(const HttpRequest& request) {
+bool HttpServer::isNotModified(const HttpRequest& request, const std::string& etag, time_t modified_time) {
+    // If-None-Match takes precedence over If-Modified-Since (RFC 9110 13.2.2)
+    if (const std::string_view* if_none_match = request.headers.find(HeaderId::IF_NONE_MATCH)) {
+        std::string_view candidates(*if_none_match);
+        if (candidates == "*") {
+            return true;
+        }
+        // Weak comparison: a W/ prefix on the client's copy still matches
+        while (!candidates.empty()) {
+            size_t comma = candidates.find(',');
+            std::string_view tag = candidates.substr(0, comma);
+            while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) {
+                tag.remove_prefix(1);
+            }
+            while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) {
+                tag.remove_suffix(1);
+            }
+            if (tag.substr(0, 2) == "W/") {
+                tag.remove_prefix(2);
+            }
+            if (tag == etag) {
+                return true;
+            }
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            candidates.remove_prefix(comma + 1);
+        }
+        return false;
+    }
+
+    if (const std::string_view* if_modified_since = request.headers.find(HeaderId::IF_MODIFIED_SINCE)) {
+        struct tm tm_utc {};
+        std::string date(*if_modified_since);
+        const char* end = strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+        if (end && *end == '\0') {
+            return timegm(&tm_utc) >= modified_time;
+        }
+    }
+
+    return false;
+}
+
+Task<HttpResponse> HttpServer::handleOpenAIChat(HttpRequest request) {
     HttpResponse response;
     response.headers["Content-Type"] = "application/json";
 
-    if (!assistant_) {
+    // The task may finish after the server is gone; keep what it needs
+    std::shared_ptr<TextAssistant> assistant = assistant_;
+    if (!assistant) {
         response.status_code = 500;
         response.body = R"({"error": {"message": "Assistant not available", "type": "internal_error"}})";
-        return response;
+        co_return response;
     }
 
+    // OpenAI clients send the whole exchange with every request, so each
+    // one is answered in a conversation of its own that is not stored,
+    // seeded with the turns before the last user message
+    auto conversation = std::make_shared<ConversationState>(ConversationId());
+    std::string user_message;
+    bool stream = false;
+    std::string model;
+    std::string error;
     try {
         nlohmann::json request_json = nlohmann::json::parse(request.body);
 
@@ -576,88 +1814,131 @@ HttpResponse HttpServer::handleOpenAIChat(const HttpRequest& request) {
         if (!request_json.contains("messages") || !request_json["messages"].is_array()) {
             response.status_code = 400;
             response.body = R"({"error": {"message": "Missing or invalid messages field", "type": "invalid_request_error"}})";
-            return response;
+            co_return response;
         }
 
         auto messages = request_json["messages"];
-        std::string user_message;
 
         // Get the last user message
-        for (auto it = messages.rbegin(); it != messages.rend(); ++it) {
+        auto last_user = messages.end();
+        for (auto it = messages.begin(); it != messages.end(); ++it) {
             if ((*it)["role"] == "user") {
-                user_message = (*it)["content"];
-                break;
+                last_user = it;
             }
         }
-
-        if (user_message.empty()) {
-            response.status_code = 400;
-            response.body = R"({"error": {"message": "No user message found", "type": "invalid_request_error"}})";
-            return response;
+        if (last_user != messages.end()) {
+            user_message = (*last_user)["content"];
+            for (auto it = messages.begin(); it != last_user; ++it) {
+                std::string role = it->value("role", "");
+                if ((role == "user" || role == "assistant") && (*it)["content"].is_string()) {
+                    conversation->history.emplace_back(role, (*it)["content"].get<std::string>());
+                }
+            }
         }
 
         // Check if streaming is requested
-        bool stream = request_json.value("stream", false);
-
-        // Process the message through the assistant
-        std::string assistant_response = assistant_->processTextInput(user_message);
-
-        if (stream) {
-            // For streaming, we'll send a simple non-streaming response for now
-            // In a full implementation, you'd want to implement Server-Sent Events
-            nlohmann::json response_json;
-            response_json["id"] = "chatcmpl-" + std::to_string(std::time(nullptr));
-            response_json["object"] = "chat.completion";
-            response_json["created"] = std::time(nullptr);
-            response_json["model"] = request_json.value("model", "gpt-3.5-turbo");
-            response_json["choices"] = nlohmann::json::array();
-
-            nlohmann::json choice;
-            choice["index"] = 0;
-            choice["message"]["role"] = "assistant";
-            choice["message"]["content"] = assistant_response;
-            choice["finish_reason"] = "stop";
-
-            response_json["choices"].push_back(choice);
-            response_json["usage"]["prompt_tokens"] = user_message.length() / 4; // Rough estimate
-            response_json["usage"]["completion_tokens"] = assistant_response.length() / 4;
-            response_json["usage"]["total_tokens"] = response_json["usage"]["prompt_tokens"].get<int>() +
-                                                   response_json["usage"]["completion_tokens"].get<int>();
-
-            response.body = response_json.dump();
-        } else {
-            // Non-streaming response
-            nlohmann::json response_json;
-            response_json["id"] = "chatcmpl-" + std::to_string(std::time(nullptr));
-            response_json["object"] = "chat.completion";
-            response_json["created"] = std::time(nullptr);
-            response_json["model"] = request_json.value("model", "gpt-3.5-turbo");
-            response_json["choices"] = nlohmann::json::array();
-
-            nlohmann::json choice;
-            choice["index"] = 0;
-            choice["message"]["role"] = "assistant";
-            choice["message"]["content"] = assistant_response;
-            choice["finish_reason"] = "stop";
-
-            response_json["choices"].push_back(choice);
-            response_json["usage"]["prompt_tokens"] = user_message.length() / 4; // Rough estimate
-            response_json["usage"]["completion_tokens"] = assistant_response.length() / 4;
-            response_json["usage"]["total_tokens"] = response_json["usage"]["prompt_tokens"].get<int>() +
-                                                   response_json["usage"]["completion_tokens"].get<int>();
-
-            response.body = response_json.dump();
-        }
-
+        stream = request_json.value("stream", false);
+        model = request_json.value("model", "gpt-3.5-turbo");
     } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (!error.empty()) {
         response.status_code = 400;
         nlohmann::json error_json;
-        error_json["error"]["message"] = "Invalid request: " + std::string(e.what());
+        error_json["error"]["message"] = "Invalid request: " + error;
         error_json["error"]["type"] = "invalid_request_error";
         response.body = error_json.dump();
+        co_return response;
     }
 
-    return response;
+    if (user_message.empty()) {
+        response.status_code = 400;
+        response.body = R"({"error": {"message": "No user message found", "type": "invalid_request_error"}})";
+        co_return response;
+    }
+
+    if (stream) {
+        // Send the head now and emit chat.completion.chunk events as
+        // tokens arrive, so the first token is not held back until the
+        // whole completion is ready. Tokens are pushed from the LLM
+        // client's transfer thread; no worker waits for them
+        response.headers["Content-Type"] = "text/event-stream";
+        response.headers["Cache-Control"] = "no-cache";
+        response.push_stream = [assistant, conversation, user_message, model](StreamWriter write, StreamEnd end) {
+            std::string id = "chatcmpl-" + std::to_string(std::time(nullptr));
+            std::time_t created = std::time(nullptr);
+
+            auto event = [id, created, model](nlohmann::json delta, const char* finish_reason) {
+                nlohmann::json chunk;
+                chunk["id"] = id;
+                chunk["object"] = "chat.completion.chunk";
+                chunk["created"] = created;
+                chunk["model"] = model;
+
+                nlohmann::json choice;
+                choice["index"] = 0;
+                choice["delta"] = std::move(delta);
+                choice["finish_reason"] = finish_reason ? nlohmann::json(finish_reason) : nlohmann::json();
+                chunk["choices"] = nlohmann::json::array({choice});
+
+                // Upstream pieces may split a UTF-8 sequence; never throw mid-stream
+                return "data: " + chunk.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "\n\n";
+            };
+
+            write(event({{"role", "assistant"}, {"content", ""}}, nullptr));
+
+            // Read again only once the task resumes, after the last token
+            auto streamed = std::make_shared<bool>(false);
+            // A task that throws (busy conversation) drops `end`, cutting the body
+            spawn(assistant->processTextInputStreamTask(conversation, user_message,
+                      [write, event, streamed](const std::string& token) {
+                          if (token.empty()) {
+                              return true;
+                          }
+                          *streamed = true;
+                          // Stop generating once the client is gone or the server stops
+                          return write(event({{"content", token}}, nullptr));
+                      }),
+                  [write, end, event, streamed](const std::string& assistant_response) {
+                      // Fallback replies (errors, not initialized) arrive only as the return value
+                      if (!*streamed && !assistant_response.empty()) {
+                          write(event({{"content", assistant_response}}, nullptr));
+                      }
+
+                      write(event(nlohmann::json::object(), "stop"));
+                      write("data: [DONE]\n\n");
+                      end(true);
+                  });
+        };
+        co_return response;
+    }
+
+    // Process the message through the assistant; the task resumes once
+    // the LLM answers
+    std::string assistant_response = co_await assistant->processTextInputTask(conversation, user_message);
+
+    // Non-streaming response
+    nlohmann::json response_json;
+    response_json["id"] = "chatcmpl-" + std::to_string(std::time(nullptr));
+    response_json["object"] = "chat.completion";
+    response_json["created"] = std::time(nullptr);
+    response_json["model"] = model;
+    response_json["choices"] = nlohmann::json::array();
+
+    nlohmann::json choice;
+    choice["index"] = 0;
+    choice["message"]["role"] = "assistant";
+    choice["message"]["content"] = assistant_response;
+    choice["finish_reason"] = "stop";
+
+    response_json["choices"].push_back(choice);
+    response_json["usage"]["prompt_tokens"] = user_message.length() / 4; // Rough estimate
+    response_json["usage"]["completion_tokens"] = assistant_response.length() / 4;
+    response_json["usage"]["total_tokens"] = response_json["usage"]["prompt_tokens"].get<int>() +
+                                           response_json["usage"]["completion_tokens"].get<int>();
+
+    response.body = response_json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    co_return response;
 }
 
 HttpResponse HttpServer::handleResponseOK(const HttpRequest& request) {
@@ -699,10 +1980,10 @@ HttpResponse HttpServer::handleApiConversationMessages(const HttpRequest& reques
     }
 
     try {
-        // Get conversation_id from query parameters
-        std::string conversation_id;
-        if (request.query_params.find("conversation_id") != request.query_params.end()) {
-            conversation_id = request.query_params.at("conversation_id");
+        // /api/conversations/{id}/messages, or the legacy ?conversation_id= form
+        std::string conversation_id(request.path_params.get("id"));
+        if (conversation_id.empty()) {
+            conversation_id = std::string(request.query_params.get("conversation_id"));
         }
 
         if (conversation_id.empty()) {
@@ -711,17 +1992,19 @@ HttpResponse HttpServer::handleApiConversationMessages(const HttpRequest& reques
             return response;
         }
 
-        // Load conversation from database
-        if (!assistant_->loadConversation(conversation_id)) {
+        // Read the stored messages; conversations in memory keep only
+        // their recent history
+        auto conversation = assistant_->getConversation(conversation_id);
+        if (!conversation.has_value()) {
             response.status_code = 404;
             response.body = R"({"error": "Conversation not found"})";
             return response;
         }
 
-        // Get conversation history from the assistant
-        auto conversation_history = assistant_->getCurrentConversationHistory();
+        const auto& conversation_history = conversation->messages;
         nlohmann::json response_json;
         response_json["conversation_id"] = conversation_id;
+        response_json["pending_messages"] = assistant_->getPendingMessageCount(conversation_id);
         response_json["messages"] = nlohmann::json::array();
 
         // Convert messages to JSON
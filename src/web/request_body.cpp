@@ -0,0 +1,88 @@
+#include "web/request_body.h"
+#include <utility>
+
+namespace AITextAssistant {
+
+RequestBodyReader::RequestBodyReader(size_t high_water_bytes, std::function<void()> on_drain)
+    : buffered_(0), high_water_(high_water_bytes), finished_(false), complete_(false),
+      abandoned_(false), paused_(false), on_drain_(std::move(on_drain)) {
+}
+
+bool RequestBodyReader::read(std::string& chunk) {
+    bool resume = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this]() { return !chunks_.empty() || finished_ || abandoned_; });
+        if (chunks_.empty()) {
+            return false;
+        }
+        chunk = std::move(chunks_.front());
+        chunks_.pop_front();
+        buffered_ -= chunk.size();
+        if (paused_ && buffered_ <= high_water_ / 2) {
+            paused_ = false;
+            resume = true;
+        }
+    }
+    // Outside the lock: the callback posts to the event loop
+    if (resume && on_drain_) {
+        on_drain_();
+    }
+    return true;
+}
+
+bool RequestBodyReader::complete() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return complete_;
+}
+
+bool RequestBodyReader::readAll(std::string& body) {
+    std::string chunk;
+    while (read(chunk)) {
+        body += chunk;
+    }
+    return complete();
+}
+
+void RequestBodyReader::push(std::string chunk) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (abandoned_ || chunk.empty()) {
+            return;
+        }
+        buffered_ += chunk.size();
+        chunks_.push_back(std::move(chunk));
+    }
+    ready_.notify_one();
+}
+
+void RequestBodyReader::finish(bool complete) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        complete_ = complete;
+    }
+    ready_.notify_all();
+}
+
+void RequestBodyReader::abandon() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        abandoned_ = true;
+        chunks_.clear();
+        buffered_ = 0;
+        paused_ = false;
+    }
+    ready_.notify_all();
+}
+
+bool RequestBodyReader::isFull() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffered_ < high_water_) {
+        return false;
+    }
+    paused_ = true;
+    return true;
+}
+
+} // namespace AITextAssistant
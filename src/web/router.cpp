@@ -0,0 +1,168 @@
+#include "web/router.h"
+#include <utility>
+#include <vector>
+
+namespace AITextAssistant {
+
+struct Router::Node {
+    // Literal children; routes fan out little, so a linear scan that
+    // rejects on length first beats a sorted search
+    std::vector<std::pair<std::string, std::unique_ptr<Node>>> children;
+
+    std::string param_name;
+    std::unique_ptr<Node> param_child;
+
+    std::array<Route, METHOD_COUNT> routes;
+};
+
+namespace {
+
+// Split "a/b/c" into its first segment and the remainder after the slash.
+// `last` is set when there is no further slash.
+std::string_view nextSegment(std::string_view& path, bool& last) {
+    size_t slash = path.find('/');
+    std::string_view segment = path.substr(0, slash);
+    last = slash == std::string_view::npos;
+    path = last ? std::string_view() : path.substr(slash + 1);
+    return segment;
+}
+
+template <typename Children>
+auto findChild(Children& children, std::string_view segment) -> decltype(children.begin()) {
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        if (it->first.size() == segment.size() && it->first.compare(0, segment.size(), segment) == 0) {
+            return it;
+        }
+    }
+    return children.end();
+}
+
+} // namespace
+
+Router::Router() : root_(std::make_unique<Node>()) {
+}
+
+Router::~Router() = default;
+
+int Router::methodIndex(std::string_view method) {
+    switch (method.size()) {
+        case 3:
+            if (method == "GET") return GET;
+            if (method == "PUT") return PUT;
+            break;
+        case 4:
+            if (method == "POST") return POST;
+            if (method == "HEAD") return HEAD;
+            break;
+        case 5:
+            if (method == "PATCH") return PATCH;
+            break;
+        case 6:
+            if (method == "DELETE") return DELETE;
+            break;
+        case 7:
+            if (method == "OPTIONS") return OPTIONS;
+            break;
+    }
+    return -1;
+}
+
+bool Router::add(std::string_view method, std::string_view pattern, HttpHandler handler) {
+    Route* route = insert(method, pattern);
+    if (!route) {
+        return false;
+    }
+    *route = Route{std::move(handler), nullptr};
+    return true;
+}
+
+bool Router::add(std::string_view method, std::string_view pattern, AsyncHttpHandler handler) {
+    Route* route = insert(method, pattern);
+    if (!route) {
+        return false;
+    }
+    *route = Route{nullptr, std::move(handler)};
+    return true;
+}
+
+Route* Router::insert(std::string_view method, std::string_view pattern) {
+    int index = methodIndex(method);
+    if (index < 0 || pattern.empty() || pattern.front() != '/') {
+        return nullptr;
+    }
+
+    Node* node = root_.get();
+    std::string_view rest = pattern.substr(1);
+    bool last = false;
+    while (!last) {
+        std::string_view segment = nextSegment(rest, last);
+
+        if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}') {
+            std::string_view name = segment.substr(1, segment.size() - 2);
+            if (name.empty()) {
+                return nullptr;
+            }
+            if (!node->param_child) {
+                node->param_child = std::make_unique<Node>();
+                node->param_name = std::string(name);
+            } else if (node->param_name != name) {
+                return nullptr;
+            }
+            node = node->param_child.get();
+            continue;
+        }
+
+        auto it = findChild(node->children, segment);
+        if (it == node->children.end()) {
+            node->children.emplace_back(std::string(segment), std::make_unique<Node>());
+            it = node->children.end() - 1;
+        }
+        node = it->second.get();
+    }
+
+    return &node->routes[index];
+}
+
+const Route* Router::match(std::string_view method, std::string_view path, PathParams& params) const {
+    params.count = 0;
+    int index = methodIndex(method);
+    if (index < 0 || path.empty() || path.front() != '/') {
+        return nullptr;
+    }
+
+    const Node* node = find(root_.get(), path.substr(1), index, params);
+    return node ? &node->routes[index] : nullptr;
+}
+
+const Router::Node* Router::find(const Node* node, std::string_view path, int method, PathParams& params) {
+    bool last = false;
+    std::string_view segment = nextSegment(path, last);
+
+    auto it = findChild(node->children, segment);
+    if (it != node->children.end()) {
+        const Node* child = it->second.get();
+        const Node* found = last ? (child->routes[method] ? child : nullptr)
+                                 : find(child, path, method, params);
+        if (found) {
+            return found;
+        }
+    }
+
+    // Parameters never capture an empty segment
+    if (node->param_child && !segment.empty() && params.count < PathParams::MAX_PARAMS) {
+        size_t saved_count = params.count;
+        params.entries[params.count++] = {node->param_name, segment};
+
+        const Node* child = node->param_child.get();
+        const Node* found = last ? (child->routes[method] ? child : nullptr)
+                                 : find(child, path, method, params);
+        if (found) {
+            return found;
+        }
+        params.count = saved_count;
+    }
+
+    return nullptr;
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,276 @@
+#include "web/static_file_cache.h"
+#include "utils/logger.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdio>
+#include <mutex>
+
+namespace AITextAssistant {
+
+namespace {
+
+// 64-bit FNV-1a; only needs to change whenever the content does
+uint64_t hashContent(const std::string& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string formatHttpDate(time_t time) {
+    struct tm tm_utc;
+    gmtime_r(&time, &tm_utc);
+    char buffer[64];
+    size_t length = strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+    return std::string(buffer, length);
+}
+
+bool readFile(const std::string& file_path, size_t size, std::string& content) {
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    content.resize(size);
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t n = read(fd, &content[offset], size - offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    close(fd);
+
+    // The file may have shrunk between stat() and read()
+    content.resize(offset);
+    return true;
+}
+
+} // namespace
+
+StaticFileCache::StaticFileCache(size_t max_file_bytes, size_t max_total_bytes,
+                                 std::chrono::milliseconds revalidate_interval)
+    : max_file_bytes_(max_file_bytes), max_total_bytes_(max_total_bytes),
+      revalidate_interval_(revalidate_interval), total_bytes_(0) {
+}
+
+std::shared_ptr<const StaticAsset> StaticFileCache::get(const std::string& file_path) {
+    int64_t now = nowMs();
+    std::shared_ptr<const StaticAsset> cached;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = entries_.find(file_path);
+        if (it != entries_.end()) {
+            Entry& entry = *it->second;
+            int64_t checked_at = entry.checked_at_ms.load(std::memory_order_relaxed);
+            if (now - checked_at < revalidate_interval_.count()) {
+                return entry.asset;
+            }
+            // One caller wins the right to re-stat; others keep serving
+            if (entry.checked_at_ms.compare_exchange_strong(checked_at, now)) {
+                cached = entry.asset;
+            } else {
+                return entry.asset;
+            }
+        }
+    }
+
+    struct stat info;
+    if (stat(file_path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        if (cached) {
+            erase(file_path);
+        }
+        return nullptr;
+    }
+
+    int64_t mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    if (cached && cached->inode == static_cast<uint64_t>(info.st_ino) &&
+        cached->size == static_cast<uint64_t>(info.st_size) && cached->mtime_ns == mtime_ns) {
+        return cached;
+    }
+
+    auto asset = load(file_path, info);
+    if (!asset) {
+        if (cached) {
+            erase(file_path);
+        }
+        return nullptr;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(file_path);
+    size_t previous = (it != entries_.end()) ? it->second->asset->body.size() : 0;
+
+    if (total_bytes_ - previous + asset->body.size() > max_total_bytes_) {
+        // Served, but not retained
+        if (it != entries_.end()) {
+            total_bytes_ -= previous;
+            entries_.erase(it);
+        }
+        return asset;
+    }
+
+    if (it == entries_.end()) {
+        it = entries_.emplace(file_path, std::make_unique<Entry>()).first;
+    } else {
+        LOG_DEBUG("Static file changed, reloaded: " + file_path);
+    }
+    it->second->asset = asset;
+    it->second->checked_at_ms = now;
+    total_bytes_ = total_bytes_ - previous + asset->body.size();
+    return asset;
+}
+
+void StaticFileCache::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    entries_.clear();
+    total_bytes_ = 0;
+}
+
+size_t StaticFileCache::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::shared_ptr<const StaticAsset> StaticFileCache::load(const std::string& file_path, const struct stat& info) {
+    auto asset = std::make_shared<StaticAsset>();
+    asset->in_memory = static_cast<size_t>(info.st_size) < max_file_bytes_;
+    if (asset->in_memory) {
+        if (!readFile(file_path, static_cast<size_t>(info.st_size), asset->body)) {
+            return nullptr;
+        }
+    } else if (access(file_path.c_str(), R_OK) != 0) {
+        return nullptr;
+    }
+
+    asset->inode = static_cast<uint64_t>(info.st_ino);
+    asset->size = static_cast<uint64_t>(info.st_size);
+    asset->mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    asset->modified_time = info.st_mtim.tv_sec;
+    asset->content_type = mimeType(file_path);
+    asset->last_modified = formatHttpDate(info.st_mtim.tv_sec);
+    asset->compressible = asset->in_memory && Compression::isCompressible(asset->content_type);
+
+    // Large files are not read here, so their tag comes from the file identity
+    char etag[64];
+    if (asset->in_memory) {
+        snprintf(etag, sizeof(etag), "\"%016llx-%llx\"",
+                 static_cast<unsigned long long>(hashContent(asset->body)),
+                 static_cast<unsigned long long>(asset->body.size()));
+    } else {
+        snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx\"",
+                 static_cast<unsigned long long>(asset->inode),
+                 static_cast<unsigned long long>(asset->size),
+                 static_cast<unsigned long long>(asset->mtime_ns));
+    }
+    asset->etag = etag;
+
+    // no-cache: browsers may store the file but must revalidate, which
+    // now costs a 304 instead of a full transfer
+    // Caches must keep compressed and identity copies apart
+    std::string vary = asset->compressible ? "Vary: Accept-Encoding\r\n" : "";
+    asset->validator_block = "ETag: " + asset->etag + "\r\n"
+                             "Last-Modified: " + asset->last_modified + "\r\n"
+                             "Cache-Control: no-cache\r\n" + vary;
+    asset->header_block = "Content-Type: " + asset->content_type + "\r\n" +
+                          "Accept-Ranges: bytes\r\n" + asset->validator_block;
+    return asset;
+}
+
+std::shared_ptr<const StaticAsset::Variant> StaticFileCache::getVariant(
+        const std::shared_ptr<const StaticAsset>& asset, const std::string& file_path,
+        ContentEncoding encoding) {
+    if (!asset->compressible || encoding == ContentEncoding::IDENTITY) {
+        return nullptr;
+    }
+    size_t slot = (encoding == ContentEncoding::GZIP) ? 0 : 1;
+
+    // Concurrent first requests wait here rather than all compressing
+    std::lock_guard<std::mutex> lock(asset->variant_mutex);
+    if (asset->variant_ready[slot]) {
+        return asset->variants[slot];
+    }
+    asset->variant_ready[slot] = true;
+
+    auto variant = std::make_shared<StaticAsset::Variant>();
+    bool loaded = false;
+
+    // A precompressed sibling wins if it is at least as new as the file
+    std::string sibling_path = file_path + Compression::fileSuffix(encoding);
+    struct stat sibling;
+    if (stat(sibling_path.c_str(), &sibling) == 0 && S_ISREG(sibling.st_mode)) {
+        int64_t sibling_mtime = static_cast<int64_t>(sibling.st_mtim.tv_sec) * 1000000000LL + sibling.st_mtim.tv_nsec;
+        if (sibling_mtime >= asset->mtime_ns) {
+            loaded = readFile(sibling_path, static_cast<size_t>(sibling.st_size), variant->body);
+        }
+    }
+
+    if (!loaded) {
+        if (!Compression::compress(encoding, asset->body, variant->body)) {
+            LOG_WARNING("Failed to compress static file: " + file_path);
+            return nullptr;
+        }
+        // Not worth a Content-Encoding when it does not shrink
+        if (variant->body.size() >= asset->body.size()) {
+            return nullptr;
+        }
+    }
+
+    // Each representation needs its own strong validator
+    variant->etag = asset->etag.substr(0, asset->etag.size() - 1) + "-" +
+                    Compression::encodingName(encoding) + "\"";
+    variant->validator_block = "ETag: " + variant->etag + "\r\n"
+                               "Last-Modified: " + asset->last_modified + "\r\n"
+                               "Cache-Control: no-cache\r\n"
+                               "Vary: Accept-Encoding\r\n";
+    variant->header_block = "Content-Type: " + asset->content_type + "\r\n" +
+                            "Content-Encoding: " + Compression::encodingName(encoding) + "\r\n" +
+                            variant->validator_block;
+
+    asset->variants[slot] = variant;
+    return variant;
+}
+
+void StaticFileCache::erase(const std::string& file_path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(file_path);
+    if (it != entries_.end()) {
+        total_bytes_ -= it->second->asset->body.size();
+        entries_.erase(it);
+    }
+}
+
+std::string StaticFileCache::mimeType(const std::string& file_path) {
+    size_t dot_pos = file_path.find_last_of('.');
+    if (dot_pos == std::string::npos) {
+        return "text/plain";
+    }
+
+    std::string extension = file_path.substr(dot_pos + 1);
+
+    if (extension == "html" || extension == "htm") return "text/html";
+    if (extension == "css") return "text/css";
+    if (extension == "js") return "application/javascript";
+    if (extension == "json") return "application/json";
+    if (extension == "png") return "image/png";
+    if (extension == "jpg" || extension == "jpeg") return "image/jpeg";
+    if (extension == "gif") return "image/gif";
+    if (extension == "svg") return "image/svg+xml";
+    if (extension == "ico") return "image/x-icon";
+
+    return "text/plain";
+}
+
+int64_t StaticFileCache::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now().time_since_epoch()).count();
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,150 @@
+#include "web/timer_wheel.h"
+#include <algorithm>
+
+namespace AITextAssistant {
+
+TimerWheel::Entry::~Entry() {
+    if (wheel_) {
+        wheel_->cancel(*this);
+    }
+}
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, Clock::time_point now)
+    : tick_(std::max(tick, std::chrono::milliseconds(1))), start_(now), current_(0), count_(0) {
+    for (auto& level : slots_) {
+        level.fill(nullptr);
+    }
+}
+
+TimerWheel::~TimerWheel() {
+    for (auto& level : slots_) {
+        for (Entry*& head : level) {
+            while (head) {
+                Entry* entry = head;
+                unlink(*entry);
+                entry->wheel_ = nullptr;
+            }
+        }
+    }
+}
+
+void TimerWheel::schedule(Entry& entry, std::chrono::milliseconds delay) {
+    cancel(entry);
+
+    // Count from the wall clock rather than the last processed tick, so a
+    // late advance() does not make new deadlines fire early
+    uint64_t now_tick = static_cast<uint64_t>((Clock::now() - start_) / tick_);
+    uint64_t ticks = static_cast<uint64_t>((std::max(delay, std::chrono::milliseconds(0)) + tick_ -
+                                            std::chrono::milliseconds(1)) / tick_);
+    entry.expires_ = std::max(current_, now_tick) + ticks;
+    entry.wheel_ = this;
+    insert(entry);
+    ++count_;
+}
+
+void TimerWheel::cancel(Entry& entry) {
+    if (!entry.isScheduled()) {
+        return;
+    }
+    unlink(entry);
+    entry.wheel_ = nullptr;
+    --count_;
+}
+
+size_t TimerWheel::advance(Clock::time_point now) {
+    if (now < start_) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>((now - start_) / tick_);
+
+    size_t fired = 0;
+    while (current_ <= target) {
+        if (count_ == 0) {
+            // Nothing to cascade or fire; jump straight to the present
+            current_ = target + 1;
+            break;
+        }
+
+        uint64_t index = current_ & SLOT_MASK;
+        if (index == 0) {
+            cascade(1);
+        }
+
+        // Detach the slot first: a callback that re-arms with a zero delay
+        // lands in the next tick instead of this list
+        Entry* pending = slots_[0][index];
+        slots_[0][index] = nullptr;
+        if (pending) {
+            pending->pprev_ = &pending;
+        }
+        ++current_;
+
+        while (pending) {
+            Entry* entry = pending;
+            unlink(*entry);
+            entry->wheel_ = nullptr;
+            --count_;
+            ++fired;
+            if (entry->callback_) {
+                entry->callback_();
+            }
+        }
+    }
+    return fired;
+}
+
+void TimerWheel::insert(Entry& entry) {
+    uint64_t expires = std::max(entry.expires_, current_);
+    uint64_t delta = expires - current_;
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+        expires = current_ + delta;
+    }
+    entry.expires_ = expires;
+
+    int level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << ((level + 1) * SLOT_BITS))) {
+        ++level;
+    }
+    link(slots_[level][(expires >> (level * SLOT_BITS)) & SLOT_MASK], entry);
+}
+
+void TimerWheel::link(Entry*& head, Entry& entry) {
+    entry.next_ = head;
+    if (head) {
+        head->pprev_ = &entry.next_;
+    }
+    head = &entry;
+    entry.pprev_ = &head;
+}
+
+void TimerWheel::unlink(Entry& entry) {
+    *entry.pprev_ = entry.next_;
+    if (entry.next_) {
+        entry.next_->pprev_ = entry.pprev_;
+    }
+    entry.next_ = nullptr;
+    entry.pprev_ = nullptr;
+}
+
+void TimerWheel::cascade(int level) {
+    // Level `level` reached the slot whose entries now fall within the span
+    // of the level below; re-file them one level down
+    uint64_t index = (current_ >> (level * SLOT_BITS)) & SLOT_MASK;
+    Entry* pending = slots_[level][index];
+    slots_[level][index] = nullptr;
+    if (pending) {
+        pending->pprev_ = &pending;
+    }
+    while (pending) {
+        Entry* entry = pending;
+        unlink(*entry);
+        insert(*entry);
+    }
+
+    if (index == 0 && level + 1 < LEVELS) {
+        cascade(level + 1);
+    }
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,204 @@
+#include "web/uring.h"
+#include "utils/logger.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace AITextAssistant {
+
+namespace {
+
+int sysSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// The rings are shared with the kernel: reads of kernel-written indices
+// need acquire and our index updates need release ordering
+unsigned loadAcquire(const unsigned* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* p, unsigned value) {
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+T* offsetPtr(void* base, unsigned offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring()
+    : ring_fd_(-1), sq_ring_(nullptr), sq_ring_size_(0), cq_ring_(nullptr), cq_ring_size_(0),
+      sqes_(nullptr), sqes_size_(0), sq_head_(nullptr), sq_tail_(nullptr), sq_mask_(0), sq_entries_(0),
+      sqe_tail_(0), cq_head_(nullptr), cq_tail_(nullptr), cq_mask_(0), cqes_(nullptr),
+      buffers_(nullptr), buffer_size_(0), buf_group_(0) {
+}
+
+IoUring::~IoUring() {
+    release();
+}
+
+bool IoUring::init(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    // Multishot accept/recv post many CQEs per SQE, so size the CQ generously
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 8;
+
+    ring_fd_ = sysSetup(entries, &params);
+    if (ring_fd_ < 0) {
+        LOG_WARNING("io_uring_setup failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        LOG_WARNING("io_uring kernel support is too old");
+        release();
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // One mapping covers both rings
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        release();
+        return false;
+    }
+    cq_ring_ = sq_ring_;
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        release();
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = offsetPtr<unsigned>(sq_ring_, params.sq_off.head);
+    sq_tail_ = offsetPtr<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_mask_ = *offsetPtr<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_ = *sq_tail_;
+
+    // SQE slots are used in ring order, so the index array is the identity
+    unsigned* sq_array = offsetPtr<unsigned>(sq_ring_, params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        sq_array[i] = i;
+    }
+
+    cq_head_ = offsetPtr<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = offsetPtr<unsigned>(cq_ring_, params.cq_off.tail);
+    cq_mask_ = *offsetPtr<unsigned>(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = offsetPtr<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::reserve(unsigned count) {
+    if (sqe_tail_ + count - loadAcquire(sq_head_) > sq_entries_) {
+        submitAndWait(0);
+    }
+    return sqe_tail_ + count - loadAcquire(sq_head_) <= sq_entries_;
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    if (sqe_tail_ - loadAcquire(sq_head_) >= sq_entries_) {
+        // Hand the full queue to the kernel to free up slots
+        submitAndWait(0);
+        if (sqe_tail_ - loadAcquire(sq_head_) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sqe_tail_;
+    return sqe;
+}
+
+int IoUring::submitAndWait(unsigned wait_nr) {
+    storeRelease(sq_tail_, sqe_tail_);
+    unsigned to_submit = sqe_tail_ - loadAcquire(sq_head_);
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int result = sysEnter(ring_fd_, to_submit, wait_nr, flags);
+    return result < 0 ? -errno : result;
+}
+
+bool IoUring::peekCompletion(io_uring_cqe& cqe) {
+    unsigned head = *cq_head_;
+    if (head == loadAcquire(cq_tail_)) {
+        return false;
+    }
+    cqe = cqes_[head & cq_mask_];
+    storeRelease(cq_head_, head + 1);
+    return true;
+}
+
+bool IoUring::provideBuffers(uint16_t group, unsigned count, size_t buffer_size) {
+    buffers_ = new char[count * buffer_size];
+    buffer_size_ = buffer_size;
+    buf_group_ = group;
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(buffers_);
+    sqe->len = static_cast<uint32_t>(buffer_size);
+    sqe->off = 0;
+    sqe->buf_group = group;
+
+    // Called on a fresh ring, so the only completion is this one
+    int result = submitAndWait(1);
+    io_uring_cqe cqe;
+    if (result < 0 || !peekCompletion(cqe) || cqe.res < 0) {
+        LOG_WARNING("io_uring provided buffers unavailable");
+        return false;
+    }
+    return true;
+}
+
+void IoUring::recycleBuffer(uint16_t id) {
+    if (io_uring_sqe* sqe = getSqe()) {
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = 1;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer(id));
+        sqe->len = static_cast<uint32_t>(buffer_size_);
+        sqe->off = id;
+        sqe->buf_group = buf_group_;
+    }
+}
+
+void IoUring::release() {
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+        cq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    // Only freed once the ring is gone and can no longer write into them
+    delete[] buffers_;
+    buffers_ = nullptr;
+}
+
+} // namespace AITextAssistant
@@ -0,0 +1,513 @@
+#include "web/websocket.h"
+#include "web/http_connection.h"
+#include "utils/logger.h"
+#include <array>
+#include <cstring>
+
+namespace AITextAssistant {
+
+namespace {
+
+// Appended to the client key before hashing (RFC 6455 section 1.3)
+constexpr char HANDSHAKE_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+constexpr size_t MAX_CONTROL_PAYLOAD = 125;
+
+uint32_t rotateLeft(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1 is only used for the handshake, where it is required by the
+// protocol rather than relied on for security
+std::array<uint8_t, 20> sha1(std::string_view data) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string message(data);
+    uint64_t bit_length = static_cast<uint64_t>(data.size()) * 8;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56) {
+        message.push_back('\0');
+    }
+    for (int i = 7; i >= 0; --i) {
+        message.push_back(static_cast<char>((bit_length >> (i * 8)) & 0xFF));
+    }
+
+    for (size_t block = 0; block < message.size(); block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const uint8_t*>(&message[block + i * 4]);
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    std::array<uint8_t, 20> digest;
+    for (int i = 0; i < 5; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+    }
+    return digest;
+}
+
+std::string base64Encode(const uint8_t* data, size_t size) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t group = uint32_t(data[i]) << 16;
+        if (i + 1 < size) {
+            group |= uint32_t(data[i + 1]) << 8;
+        }
+        if (i + 2 < size) {
+            group |= data[i + 2];
+        }
+        encoded.push_back(ALPHABET[(group >> 18) & 0x3F]);
+        encoded.push_back(ALPHABET[(group >> 12) & 0x3F]);
+        encoded.push_back(i + 1 < size ? ALPHABET[(group >> 6) & 0x3F] : '=');
+        encoded.push_back(i + 2 < size ? ALPHABET[group & 0x3F] : '=');
+    }
+    return encoded;
+}
+
+std::string closePayload(WebSocketStatus status, std::string_view reason) {
+    uint16_t code = static_cast<uint16_t>(status);
+    std::string payload;
+    payload.push_back(static_cast<char>(code >> 8));
+    payload.push_back(static_cast<char>(code & 0xFF));
+    payload.append(reason.substr(0, MAX_CONTROL_PAYLOAD - 2));
+    return payload;
+}
+
+bool isValidCloseCode(uint16_t code) {
+    // Codes a peer may send; 1004-1006 and 1015 are reserved for local use
+    if (code >= 3000 && code <= 4999) {
+        return true;
+    }
+    return code >= 1000 && code <= 1014 && code != 1004 && code != 1005 && code != 1006;
+}
+
+} // namespace
+
+std::string webSocketAccept(std::string_view key) {
+    std::string input(key);
+    input += HANDSHAKE_GUID;
+    std::array<uint8_t, 20> digest = sha1(input);
+    return base64Encode(digest.data(), digest.size());
+}
+
+std::string encodeWebSocketFrame(WebSocketOpcode opcode, std::string_view payload) {
+    std::string frame;
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    } else {
+        frame.push_back(static_cast<char>(127));
+        for (int i = 7; i >= 0; --i) {
+            frame.push_back(static_cast<char>((static_cast<uint64_t>(payload.size()) >> (i * 8)) & 0xFF));
+        }
+    }
+    frame.append(payload);
+    return frame;
+}
+
+bool isValidUtf8(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        uint8_t c = static_cast<uint8_t>(text[i]);
+        size_t length;
+        uint32_t code_point;
+        if (c < 0x80) {
+            ++i;
+            continue;
+        } else if ((c & 0xE0) == 0xC0) {
+            length = 2;
+            code_point = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            length = 3;
+            code_point = c & 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            length = 4;
+            code_point = c & 0x07;
+        } else {
+            return false;
+        }
+        if (i + length > text.size()) {
+            return false;
+        }
+        for (size_t j = 1; j < length; ++j) {
+            uint8_t next = static_cast<uint8_t>(text[i + j]);
+            if ((next & 0xC0) != 0x80) {
+                return false;
+            }
+            code_point = (code_point << 6) | (next & 0x3F);
+        }
+        // Overlong forms, surrogates and values past U+10FFFF
+        static const uint32_t MIN_CODE_POINT[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (code_point < MIN_CODE_POINT[length] || code_point > 0x10FFFF ||
+            (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+WebSocketFrameParser::Result WebSocketFrameParser::parse(const std::string& buffer, size_t& offset, Frame& frame) {
+    size_t available = buffer.size() - offset;
+    if (available < 2) {
+        return Result::INCOMPLETE;
+    }
+    const auto* data = reinterpret_cast<const uint8_t*>(buffer.data() + offset);
+
+    bool fin = (data[0] & 0x80) != 0;
+    uint8_t opcode = data[0] & 0x0F;
+    if (data[0] & 0x70) {
+        // No extension was negotiated
+        return fail(WebSocketStatus::PROTOCOL_ERROR);
+    }
+    bool control = (opcode & 0x08) != 0;
+    if (opcode > 0x2 && opcode != 0x8 && opcode != 0x9 && opcode != 0xA) {
+        return fail(WebSocketStatus::PROTOCOL_ERROR);
+    }
+    if (!(data[1] & 0x80)) {
+        // Clients must mask every frame
+        return fail(WebSocketStatus::PROTOCOL_ERROR);
+    }
+
+    size_t header_size = 2;
+    uint64_t length = data[1] & 0x7F;
+    if (length == 126) {
+        header_size = 4;
+        if (available < header_size) {
+            return Result::INCOMPLETE;
+        }
+        length = (uint64_t(data[2]) << 8) | data[3];
+    } else if (length == 127) {
+        header_size = 10;
+        if (available < header_size) {
+            return Result::INCOMPLETE;
+        }
+        length = 0;
+        for (int i = 0; i < 8; ++i) {
+            length = (length << 8) | data[2 + i];
+        }
+        if (length >> 63) {
+            return fail(WebSocketStatus::PROTOCOL_ERROR);
+        }
+    }
+    if (control && (!fin || length > MAX_CONTROL_PAYLOAD)) {
+        return fail(WebSocketStatus::PROTOCOL_ERROR);
+    }
+    if (length > max_payload_) {
+        return fail(WebSocketStatus::MESSAGE_TOO_BIG);
+    }
+
+    header_size += 4;
+    if (available < header_size + length) {
+        return Result::INCOMPLETE;
+    }
+
+    const uint8_t* mask = data + header_size - 4;
+    const uint8_t* payload = data + header_size;
+    frame.opcode = static_cast<WebSocketOpcode>(opcode);
+    frame.fin = fin;
+    frame.payload.resize(static_cast<size_t>(length));
+    for (size_t i = 0; i < length; ++i) {
+        frame.payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+    }
+
+    offset += header_size + static_cast<size_t>(length);
+    return Result::FRAME;
+}
+
+WebSocketFrameParser::Result WebSocketFrameParser::fail(WebSocketStatus status) {
+    error_status_ = status;
+    return Result::ERROR;
+}
+
+WebSocket::WebSocket(std::weak_ptr<HttpConnection> connection, AsyncMessageHandler handler, Dispatcher dispatcher,
+                     OutputGuard guard, size_t max_message_bytes)
+    : connection_(std::move(connection)), handler_(std::move(handler)), dispatcher_(std::move(dispatcher)),
+      guard_(std::move(guard)), open_(true), parser_(max_message_bytes), max_message_(max_message_bytes),
+      fragment_opcode_(WebSocketOpcode::TEXT), in_message_(false), input_closed_(false),
+      dispatching_(false), paused_(false) {
+}
+
+bool WebSocket::sendText(std::string_view text) {
+    return send(WebSocketOpcode::TEXT, text, true);
+}
+
+bool WebSocket::sendBinary(std::string_view data) {
+    return send(WebSocketOpcode::BINARY, data, true);
+}
+
+bool WebSocket::pushText(std::string_view text) {
+    return send(WebSocketOpcode::TEXT, text, false);
+}
+
+bool WebSocket::send(WebSocketOpcode opcode, std::string_view payload, bool wait) {
+    auto connection = connection_.lock();
+    if (!connection || !open_) {
+        return false;
+    }
+    bool ready = wait ? connection->waitForOutputBelow(MAX_OUTPUT_BACKLOG, SEND_TIMEOUT)
+                      : connection->outputBacklog() <= MAX_OUTPUT_BACKLOG && !connection->isClosed();
+    if (!ready) {
+        if (!connection->isClosed()) {
+            LOG_WARNING("WebSocket peer stopped reading, dropping connection");
+            guard_([&connection]() { connection->abort(); });
+        }
+        open_ = false;
+        return false;
+    }
+    return guard_([&connection, opcode, payload]() {
+        connection->writeStream(encodeWebSocketFrame(opcode, payload));
+    });
+}
+
+void WebSocket::close(WebSocketStatus status, std::string_view reason) {
+    if (!open_.exchange(false)) {
+        return;
+    }
+    if (auto connection = connection_.lock()) {
+        guard_([&connection, status, reason]() {
+            connection->endStream(encodeWebSocketFrame(WebSocketOpcode::CLOSE, closePayload(status, reason)), false);
+        });
+    }
+}
+
+void WebSocket::consume(std::string& buffer) {
+    size_t offset = 0;
+    WebSocketFrameParser::Frame frame;
+    while (!input_closed_) {
+        WebSocketFrameParser::Result result = parser_.parse(buffer, offset, frame);
+        if (result == WebSocketFrameParser::Result::INCOMPLETE) {
+            break;
+        }
+        if (result == WebSocketFrameParser::Result::ERROR) {
+            fail(parser_.getErrorStatus());
+            break;
+        }
+        handleFrame(frame);
+    }
+
+    // Nothing after a close frame or a protocol error is read
+    if (input_closed_) {
+        buffer.clear();
+    } else {
+        buffer.erase(0, offset);
+    }
+}
+
+void WebSocket::handleFrame(WebSocketFrameParser::Frame& frame) {
+    switch (frame.opcode) {
+        case WebSocketOpcode::TEXT:
+        case WebSocketOpcode::BINARY:
+            if (in_message_) {
+                fail(WebSocketStatus::PROTOCOL_ERROR);
+                return;
+            }
+            if (frame.fin) {
+                deliver(std::move(frame.payload), frame.opcode == WebSocketOpcode::BINARY);
+                return;
+            }
+            in_message_ = true;
+            fragment_opcode_ = frame.opcode;
+            fragments_ = std::move(frame.payload);
+            return;
+
+        case WebSocketOpcode::CONTINUATION:
+            if (!in_message_) {
+                fail(WebSocketStatus::PROTOCOL_ERROR);
+                return;
+            }
+            if (fragments_.size() + frame.payload.size() > max_message_) {
+                fail(WebSocketStatus::MESSAGE_TOO_BIG);
+                return;
+            }
+            fragments_ += frame.payload;
+            if (frame.fin) {
+                in_message_ = false;
+                deliver(std::move(fragments_), fragment_opcode_ == WebSocketOpcode::BINARY);
+                fragments_.clear();
+            }
+            return;
+
+        case WebSocketOpcode::PING:
+            // Answered from the loop without waiting on the output backlog
+            if (open_) {
+                if (auto connection = connection_.lock()) {
+                    connection->writeStream(encodeWebSocketFrame(WebSocketOpcode::PONG, frame.payload));
+                }
+            }
+            return;
+
+        case WebSocketOpcode::PONG:
+            return;
+
+        case WebSocketOpcode::CLOSE: {
+            input_closed_ = true;
+            if (frame.payload.size() == 1) {
+                fail(WebSocketStatus::PROTOCOL_ERROR);
+                return;
+            }
+            WebSocketStatus status = WebSocketStatus::NORMAL;
+            if (frame.payload.size() >= 2) {
+                uint16_t code = static_cast<uint16_t>((uint8_t(frame.payload[0]) << 8) | uint8_t(frame.payload[1]));
+                if (!isValidCloseCode(code) || !isValidUtf8(std::string_view(frame.payload).substr(2))) {
+                    fail(WebSocketStatus::PROTOCOL_ERROR);
+                    return;
+                }
+                status = static_cast<WebSocketStatus>(code);
+            }
+            // Echo the status to complete the handshake
+            close(status);
+            return;
+        }
+    }
+}
+
+void WebSocket::deliver(std::string message, bool binary) {
+    if (!binary && !isValidUtf8(message)) {
+        fail(WebSocketStatus::INVALID_DATA);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inbox_.emplace_back(std::move(message), binary);
+        if (dispatching_) {
+            return;
+        }
+        dispatching_ = true;
+    }
+
+    if (!dispatch()) {
+        input_closed_ = true;
+    }
+}
+
+bool WebSocket::dispatch() {
+    auto self = shared_from_this();
+    bool dispatched = false;
+    if (!guard_([this, &self, &dispatched]() { dispatched = dispatcher_([self]() { self->drain(); }); })) {
+        // The server stopped; nothing is left to answer
+        return false;
+    }
+    if (dispatched) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inbox_.clear();
+        dispatching_ = false;
+    }
+    LOG_WARNING("Worker queue full, closing WebSocket");
+    close(WebSocketStatus::TRY_AGAIN_LATER, "Server is busy");
+    return false;
+}
+
+void WebSocket::fail(WebSocketStatus status) {
+    LOG_DEBUG("Failing WebSocket connection with status " + std::to_string(static_cast<int>(status)));
+    input_closed_ = true;
+    close(status);
+}
+
+bool WebSocket::isBacklogged() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inbox_.size() < MAX_PENDING_MESSAGES) {
+        return false;
+    }
+    paused_ = true;
+    return true;
+}
+
+void WebSocket::onClosed() {
+    open_ = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    inbox_.clear();
+}
+
+void WebSocket::drain() {
+    auto self = shared_from_this();
+    while (true) {
+        std::pair<std::string, bool> message;
+        bool resume = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (inbox_.empty()) {
+                dispatching_ = false;
+                return;
+            }
+            message = std::move(inbox_.front());
+            inbox_.pop_front();
+            if (paused_ && inbox_.size() <= MAX_PENDING_MESSAGES / 2) {
+                paused_ = false;
+                resume = true;
+            }
+        }
+        if (resume) {
+            if (auto connection = connection_.lock()) {
+                connection->resumeReading();
+            }
+        }
+
+        // Whichever of the handler's return and `done` comes second moves
+        // on to the next message; after a throw, `done` does nothing
+        auto finished = std::make_shared<std::atomic<int>>(0);
+        try {
+            handler_(self, message.first, message.second, [self, finished]() {
+                if (finished->fetch_add(1) == 1) {
+                    self->dispatch();
+                }
+            });
+            if (finished->fetch_add(1) == 0) {
+                return;
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR("WebSocket handler failed: " + std::string(e.what()));
+            finished->fetch_add(2);
+            close(WebSocketStatus::INTERNAL_ERROR);
+        }
+    }
+}
+
+} // namespace AITextAssistant
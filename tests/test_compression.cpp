@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "utils/compression.h"
+#include <zlib.h>
+#include <cstring>
+
+using namespace AITextAssistant;
+
+namespace {
+
+// windowBits 15 + 32 auto-detects the gzip or zlib wrapper
+std::string inflateAll(const std::string& input) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    inflateInit2(&stream, 15 + 32);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    std::string output;
+    char buffer[4096];
+    int result = Z_OK;
+    while (result == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        result = inflate(&stream, Z_NO_FLUSH);
+        output.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return result == Z_STREAM_END ? output : "<corrupt>";
+}
+
+} // namespace
+
+TEST(CompressionTest, NegotiatesAcceptEncoding) {
+    ContentEncoding best_br = Compression::isAvailable(ContentEncoding::BROTLI) ? ContentEncoding::BROTLI
+                                                                                 : ContentEncoding::GZIP;
+
+    EXPECT_EQ(Compression::negotiate(""), ContentEncoding::IDENTITY);
+    EXPECT_EQ(Compression::negotiate("identity"), ContentEncoding::IDENTITY);
+    EXPECT_EQ(Compression::negotiate("gzip"), ContentEncoding::GZIP);
+    EXPECT_EQ(Compression::negotiate("gzip, deflate, br"), best_br);
+    EXPECT_EQ(Compression::negotiate("br;q=0.5, gzip;q=0.8"), ContentEncoding::GZIP);
+    EXPECT_EQ(Compression::negotiate("GZIP;q=0"), ContentEncoding::IDENTITY);
+    EXPECT_EQ(Compression::negotiate("*"), best_br);
+    EXPECT_EQ(Compression::negotiate("*, br;q=0"), ContentEncoding::GZIP);
+
+    auto api = {ContentEncoding::GZIP, ContentEncoding::DEFLATE};
+    EXPECT_EQ(Compression::negotiate("br", api), ContentEncoding::IDENTITY);
+    EXPECT_EQ(Compression::negotiate("deflate", api), ContentEncoding::DEFLATE);
+    EXPECT_EQ(Compression::negotiate("deflate, gzip", api), ContentEncoding::GZIP);
+    EXPECT_EQ(Compression::negotiate("gzip;q=0.2, deflate", api), ContentEncoding::DEFLATE);
+}
+
+TEST(CompressionTest, GzipRoundTrip) {
+    std::string input;
+    for (int i = 0; i < 2000; ++i) {
+        input += "<div class=\"message\">hello " + std::to_string(i % 10) + "</div>\n";
+    }
+
+    std::string compressed;
+    ASSERT_TRUE(Compression::compress(ContentEncoding::GZIP, input, compressed));
+    EXPECT_LT(compressed.size(), input.size() / 5);
+    EXPECT_EQ(inflateAll(compressed), input);
+}
+
+TEST(CompressionTest, StreamCompressorAppendsIncrementally) {
+    for (ContentEncoding encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+        Compression::StreamCompressor compressor(encoding);
+        ASSERT_TRUE(compressor.isValid());
+
+        std::string input;
+        std::string output = "prefix";
+        for (int i = 0; i < 100; ++i) {
+            std::string piece = "{\"role\":\"user\",\"content\":\"message " + std::to_string(i) + "\"},";
+            input += piece;
+            ASSERT_TRUE(compressor.write(piece.data(), piece.size(), output));
+            if (i == 50) {
+                // A sync flush makes everything so far decodable
+                ASSERT_TRUE(compressor.flush(output));
+            }
+        }
+        ASSERT_TRUE(compressor.finish(output));
+        EXPECT_FALSE(compressor.write("x", 1, output));
+
+        ASSERT_EQ(output.compare(0, 6, "prefix"), 0);
+        EXPECT_EQ(inflateAll(output.substr(6)), input);
+    }
+}
+
+TEST(CompressionTest, ClassifiesCompressibleTypes) {
+    EXPECT_TRUE(Compression::isCompressible("text/html"));
+    EXPECT_TRUE(Compression::isCompressible("application/json"));
+    EXPECT_TRUE(Compression::isCompressible("application/javascript"));
+    EXPECT_TRUE(Compression::isCompressible("image/svg+xml"));
+    EXPECT_FALSE(Compression::isCompressible("image/png"));
+}
@@ -173,3 +173,44 @@ TEST_F(ConfigManagerTest, PromptConfigUpdate) {
     EXPECT_EQ(updated_config.max_history_messages, 15);
 }
 
+
+TEST_F(ConfigManagerTest, ServerConfigParsing) {
+    createTestConfigFile(R"({
+        "llm": {
+            "provider": "openai",
+            "api_endpoint": "https://api.openai.com/v1/chat/completions"
+        },
+        "server": {
+            "worker_threads": 4,
+            "max_queue_size": 32,
+            "retry_after_seconds": 3
+        }
+    })");
+
+    EXPECT_TRUE(config_manager->loadConfig(test_config_file));
+
+    const auto& server_config = config_manager->getServerConfig();
+    EXPECT_EQ(server_config.io_threads, 0);
+    EXPECT_EQ(server_config.worker_threads, 4);
+    EXPECT_EQ(server_config.max_queue_size, 32);
+    EXPECT_EQ(server_config.retry_after_seconds, 3);
+    EXPECT_EQ(server_config.sendfile_threshold_bytes, 1048576);
+    EXPECT_EQ(server_config.compression_min_bytes, 1024);
+    EXPECT_TRUE(server_config.pin_io_threads);
+    EXPECT_EQ(server_config.listen_backlog, 1024);
+    EXPECT_EQ(server_config.io_backend, "epoll");
+    EXPECT_EQ(server_config.header_timeout_seconds, 10);
+    EXPECT_EQ(server_config.body_timeout_seconds, 30);
+    EXPECT_EQ(server_config.max_header_bytes, 8192);
+    EXPECT_EQ(server_config.max_body_bytes, 1048576);
+    EXPECT_EQ(server_config.max_streamed_body_bytes, 67108864);
+
+    createTestConfigFile(R"({
+        "llm": {
+            "provider": "openai",
+            "api_endpoint": "https://api.openai.com/v1/chat/completions"
+        },
+        "server": { "worker_threads": 0 }
+    })");
+    EXPECT_FALSE(config_manager->loadConfig(test_config_file));
+}
@@ -0,0 +1,350 @@
+#include <gtest/gtest.h>
+#include "core/conversation_registry.h"
+#include "core/assistant.h"
+#include "web/http_server.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace AITextAssistant;
+
+TEST(ConversationRegistryTest, FindsInsertedConversations) {
+    ConversationRegistry registry;
+    auto state = std::make_shared<ConversationState>("a");
+
+    EXPECT_EQ(registry.find("a"), nullptr);
+    EXPECT_EQ(registry.insert(state), state);
+    EXPECT_EQ(registry.find("a"), state);
+
+    // The first state registered for an id wins
+    auto duplicate = std::make_shared<ConversationState>("a");
+    EXPECT_EQ(registry.insert(duplicate), state);
+    EXPECT_EQ(registry.size(), 1u);
+
+    EXPECT_EQ(registry.remove("a"), state);
+    EXPECT_EQ(registry.find("a"), nullptr);
+    EXPECT_EQ(registry.remove("a"), nullptr);
+}
+
+TEST(ConversationRegistryTest, DropsOnlyUnheldConversationsPastCapacity) {
+    ConversationRegistry registry(ConversationRegistry::SHARD_COUNT);
+    std::vector<ConversationHandle> held;
+    for (int i = 0; i < 200; ++i) {
+        auto state = registry.insert(std::make_shared<ConversationState>("c" + std::to_string(i)));
+        if (i % 2 == 0) {
+            held.push_back(state);
+        }
+    }
+
+    EXPECT_LT(registry.size(), 200u);
+    for (const auto& state : held) {
+        EXPECT_EQ(registry.find(state->id), state);
+    }
+}
+
+TEST(ConversationRegistryTest, ConcurrentInsertsAgreeOnOneState) {
+    ConversationRegistry registry;
+    std::vector<ConversationHandle> results(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&registry, &results, i]() {
+            results[i] = registry.insert(std::make_shared<ConversationState>("shared"));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& result : results) {
+        EXPECT_EQ(result, registry.find("shared"));
+    }
+}
+
+class TextAssistantTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Files named after the test, so tests can run in parallel
+        std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        db_path = "test_assistant_" + name + ".db";
+        config_path = "test_assistant_" + name + "_config.json";
+        std::filesystem::remove(db_path);
+        // Nothing listens on port 1, so every reply is the fallback one
+        std::ofstream(config_path) << R"({
+            "llm": {"provider": "openai", "api_endpoint": "http://127.0.0.1:1/v1/chat/completions",
+                    "api_key": "test", "model_name": "test"},
+            "database_path": ")" << db_path << R"("
+        })";
+        assistant = std::make_unique<TextAssistant>(config_path);
+        ASSERT_TRUE(assistant->initialize());
+    }
+
+    void TearDown() override {
+        assistant.reset();
+        std::filesystem::remove(db_path);
+        std::filesystem::remove(config_path);
+    }
+
+    // Point the assistant at a local upstream that answers "reply" once
+    // `release` is set. The first request body goes to `received`, every
+    // one to `bodies`.
+    void useBlockingUpstream() {
+        upstream = std::make_unique<HttpServer>(0);
+        upstream->addRoute("POST", "/v1/chat/completions", [this](const HttpRequest& request) {
+            {
+                std::lock_guard<std::mutex> lock(bodies_mutex);
+                bodies.emplace_back(request.body);
+                if (bodies.size() == 1) {
+                    received.set_value(bodies.back());
+                }
+            }
+            released.wait_for(std::chrono::seconds(5));
+            HttpResponse response;
+            response.headers["Content-Type"] = "application/json";
+            response.body = R"({"choices": [{"message": {"content": "reply"}}]})";
+            return response;
+        });
+        ASSERT_TRUE(upstream->start());
+
+        LLMConfig config;
+        config.provider = "openai";
+        config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream->getPort()) + "/v1/chat/completions";
+        config.api_key = "test";
+        config.model_name = "test";
+        ASSERT_TRUE(assistant->setLLMProvider(config));
+    }
+
+    std::unique_ptr<HttpServer> upstream;
+    std::promise<std::string> received;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::mutex bodies_mutex;
+    std::vector<std::string> bodies;
+
+    std::string config_path;
+    std::string db_path;
+    std::unique_ptr<TextAssistant> assistant;
+};
+
+TEST_F(TextAssistantTest, ConversationsKeepSeparateHistories) {
+    ConversationHandle first = assistant->startNewConversation();
+    ConversationHandle second = assistant->startNewConversation();
+    ASSERT_TRUE(first && second);
+    ASSERT_NE(first->id, second->id);
+
+    assistant->processTextInput(first, "hello first");
+    assistant->processTextInput(second, "hello second");
+
+    auto history = assistant->getConversationHistory(first);
+    ASSERT_EQ(history.size(), 2u);
+    EXPECT_EQ(history[0].content, "hello first");
+    EXPECT_EQ(history[0].conversation_id, first->id);
+    EXPECT_EQ(assistant->getConversationHistory(second)[0].content, "hello second");
+
+    // Opening by id returns the state in memory
+    EXPECT_EQ(assistant->openConversation(first->id), first);
+
+    auto stored = assistant->getConversation(second->id);
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->messages.size(), 2u);
+    EXPECT_EQ(stored->title, "hello second");
+}
+
+TEST_F(TextAssistantTest, DeletedConversationStoresNothingMore) {
+    ConversationHandle conversation = assistant->startNewConversation();
+    ASSERT_TRUE(conversation);
+    ConversationId id = conversation->id;
+
+    EXPECT_TRUE(assistant->deleteConversation(id));
+    EXPECT_EQ(assistant->openConversation(id), nullptr);
+
+    // A request still holding the handle finishes without storing
+    assistant->processTextInput(conversation, "too late");
+    EXPECT_FALSE(assistant->getConversation(id).has_value());
+    EXPECT_EQ(assistant->getTotalMessages(), 0);
+}
+
+TEST_F(TextAssistantTest, ReadsDoNotWaitForTheLLM) {
+    useBlockingUpstream();
+    ConversationHandle conversation = assistant->startNewConversation();
+    ASSERT_TRUE(conversation);
+
+    auto reply = std::async(std::launch::async, [&]() { return assistant->processTextInput(conversation, "question"); });
+    auto payload = received.get_future();
+    ASSERT_EQ(payload.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    // The user message is visible while the LLM is still answering
+    auto history = std::async(std::launch::async, [&]() { return assistant->getConversationHistory(conversation); });
+    ASSERT_EQ(history.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    auto messages = history.get();
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0].content, "question");
+
+    // ...and is sent to the LLM once
+    nlohmann::json request = nlohmann::json::parse(payload.get());
+    size_t user_messages = 0;
+    for (const auto& message : request["messages"]) {
+        user_messages += message["role"] == "user";
+    }
+    EXPECT_EQ(user_messages, 1u);
+
+    release.set_value();
+    EXPECT_EQ(reply.get(), "reply");
+    messages = assistant->getConversationHistory(conversation);
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[1].content, "reply");
+}
+
+TEST_F(TextAssistantTest, ReplyToAClearedHistoryIsNotStored) {
+    useBlockingUpstream();
+    ConversationHandle conversation = assistant->startNewConversation();
+    ASSERT_TRUE(conversation);
+
+    auto reply = std::async(std::launch::async, [&]() { return assistant->processTextInput(conversation, "question"); });
+    ASSERT_EQ(received.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    assistant->clearConversationHistory(conversation);
+    release.set_value();
+
+    EXPECT_EQ(reply.get(), "reply");
+    EXPECT_TRUE(assistant->getConversationHistory(conversation).empty());
+}
+
+TEST_F(TextAssistantTest, CancelledStreamIsNotStored) {
+    upstream = std::make_unique<HttpServer>(0);
+    upstream->addRoute("POST", "/v1/chat/completions", [](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/event-stream";
+        response.stream = [](const StreamWriter& write) {
+            write("data: {\"choices\":[{\"delta\":{\"content\":\"Hel\"}}]}\n\n");
+            write("data: {\"choices\":[{\"delta\":{\"content\":\"lo\"}}]}\n\n");
+            write("data: [DONE]\n\n");
+        };
+        return response;
+    });
+    ASSERT_TRUE(upstream->start());
+    LLMConfig config;
+    config.provider = "openai";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream->getPort()) + "/v1/chat/completions";
+    config.api_key = "test";
+    config.model_name = "test";
+    ASSERT_TRUE(assistant->setLLMProvider(config));
+
+    ConversationHandle conversation = assistant->startNewConversation();
+    ASSERT_TRUE(conversation);
+
+    // The client goes away after the first piece
+    std::string reply = assistant->processTextInputStream(conversation, "question",
+        [](const std::string&) { return false; });
+    EXPECT_EQ(reply, "Hel");
+
+    // Only the question is kept, in memory and in the database
+    auto history = assistant->getConversationHistory(conversation);
+    ASSERT_EQ(history.size(), 1u);
+    EXPECT_EQ(history[0].content, "question");
+    auto stored = assistant->getConversation(conversation->id);
+    ASSERT_TRUE(stored.has_value());
+    ASSERT_EQ(stored->messages.size(), 1u);
+    EXPECT_EQ(stored->messages[0].role, "user");
+
+    // A stream read to the end is stored whole
+    reply = assistant->processTextInputStream(conversation, "again", [](const std::string&) { return true; });
+    EXPECT_EQ(reply, "Hello");
+    history = assistant->getConversationHistory(conversation);
+    ASSERT_EQ(history.size(), 3u);
+    EXPECT_EQ(history[2].content, "Hello");
+    EXPECT_EQ(assistant->getConversation(conversation->id)->messages.size(), 3u);
+    EXPECT_EQ(assistant->getState(), AssistantState::IDLE);
+}
+
+TEST_F(TextAssistantTest, AnswersOneConversationInOrderAndCapsItsQueue) {
+    AssistantConfig config = assistant->getAssistantConfig();
+    config.max_pending_messages = 2;
+    assistant->setAssistantConfig(config);
+    useBlockingUpstream();
+    ConversationHandle conversation = assistant->startNewConversation();
+    ASSERT_TRUE(conversation);
+
+    auto first = std::async(std::launch::async, [&]() { return assistant->processTextInput(conversation, "one"); });
+    ASSERT_EQ(received.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    std::promise<std::string> second;
+    assistant->processTextInputAsync(conversation, "two", [&second](const std::string& reply) { second.set_value(reply); });
+    EXPECT_EQ(assistant->getPendingMessageCount(conversation->id), 2u);
+    EXPECT_THROW(assistant->processTextInput(conversation, "three"), ConversationBusyError);
+
+    release.set_value();
+    EXPECT_EQ(first.get(), "reply");
+    auto second_reply = second.get_future();
+    ASSERT_EQ(second_reply.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(second_reply.get(), "reply");
+
+    std::vector<std::string> contents;
+    for (const auto& message : assistant->getConversationHistory(conversation)) {
+        contents.push_back(message.content);
+    }
+    EXPECT_EQ(contents, (std::vector<std::string>{"one", "reply", "two", "reply"}));
+
+    // The second request was built after the first reply was stored
+    std::lock_guard<std::mutex> lock(bodies_mutex);
+    ASSERT_EQ(bodies.size(), 2u);
+    EXPECT_EQ(nlohmann::json::parse(bodies[1])["messages"].size(), 4u);
+    EXPECT_EQ(assistant->getPendingMessageCount(conversation->id), 0u);
+}
+
+TEST_F(TextAssistantTest, AnswersSeveralConversationsAtOnce) {
+    useBlockingUpstream();
+    std::vector<ConversationHandle> conversations;
+    for (int i = 0; i < 8; ++i) {
+        conversations.push_back(assistant->startNewConversation());
+        ASSERT_TRUE(conversations.back());
+    }
+
+    std::vector<std::future<std::string>> replies;
+    for (size_t i = 0; i < conversations.size(); ++i) {
+        replies.push_back(std::async(std::launch::async, [&, i]() {
+            return assistant->processTextInput(conversations[i], "question " + std::to_string(i));
+        }));
+    }
+    ASSERT_EQ(received.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    release.set_value();
+
+    for (size_t i = 0; i < conversations.size(); ++i) {
+        EXPECT_EQ(replies[i].get(), "reply");
+        auto history = assistant->getConversationHistory(conversations[i]);
+        ASSERT_EQ(history.size(), 2u);
+        EXPECT_EQ(history[0].content, "question " + std::to_string(i));
+        EXPECT_EQ(history[1].content, "reply");
+    }
+    EXPECT_EQ(assistant->getTotalMessages(), 16);
+
+    std::lock_guard<std::mutex> lock(bodies_mutex);
+    EXPECT_EQ(bodies.size(), 8u);
+}
+
+TEST_F(TextAssistantTest, AnswersSeveralMailboxesAtOnce) {
+    useBlockingUpstream();
+    std::vector<ConversationHandle> conversations;
+    std::vector<std::promise<std::string>> replies(8);
+    for (size_t i = 0; i < replies.size(); ++i) {
+        conversations.push_back(assistant->startNewConversation());
+        ASSERT_TRUE(conversations.back());
+        assistant->processTextInputAsync(conversations[i], "question " + std::to_string(i),
+                                         [&replies, i](const std::string& reply) { replies[i].set_value(reply); });
+    }
+    ASSERT_EQ(received.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    release.set_value();
+
+    for (size_t i = 0; i < replies.size(); ++i) {
+        auto reply = replies[i].get_future();
+        ASSERT_EQ(reply.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_EQ(reply.get(), "reply");
+        EXPECT_EQ(assistant->getConversationHistory(conversations[i]).size(), 2u);
+    }
+    EXPECT_EQ(assistant->getTotalMessages(), 16);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "web/hpack.h"
+#include <string>
+#include <vector>
+
+using namespace AITextAssistant;
+
+namespace {
+
+std::string fromHex(const std::string& hex) {
+    std::string bytes;
+    std::string digits;
+    for (char c : hex) {
+        if (c != ' ') {
+            digits.push_back(c);
+        }
+    }
+    for (size_t i = 0; i + 1 < digits.size(); i += 2) {
+        bytes.push_back(static_cast<char>(std::stoi(digits.substr(i, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+std::vector<HeaderField> decodeBlock(HpackDecoder& decoder, const std::string& hex) {
+    std::vector<HeaderField> headers;
+    EXPECT_TRUE(decoder.decode(fromHex(hex), headers));
+    return headers;
+}
+
+} // namespace
+
+// RFC 7541 C.3: requests on one connection, no Huffman coding
+TEST(HpackTest, DecodesRequestsWithoutHuffman) {
+    HpackDecoder decoder;
+    EXPECT_EQ(decodeBlock(decoder, "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"),
+              (std::vector<HeaderField>{{":method", "GET"}, {":scheme", "http"}, {":path", "/"},
+                                        {":authority", "www.example.com"}}));
+    EXPECT_EQ(decoder.tableSize(), 57u);
+
+    EXPECT_EQ(decodeBlock(decoder, "8286 84be 5808 6e6f 2d63 6163 6865"),
+              (std::vector<HeaderField>{{":method", "GET"}, {":scheme", "http"}, {":path", "/"},
+                                        {":authority", "www.example.com"}, {"cache-control", "no-cache"}}));
+    EXPECT_EQ(decoder.tableSize(), 110u);
+
+    EXPECT_EQ(decodeBlock(decoder, "8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65"),
+              (std::vector<HeaderField>{{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"},
+                                        {":authority", "www.example.com"}, {"custom-key", "custom-value"}}));
+    EXPECT_EQ(decoder.tableSize(), 164u);
+}
+
+// RFC 7541 C.4: the same requests with Huffman coding
+TEST(HpackTest, DecodesRequestsWithHuffman) {
+    HpackDecoder decoder;
+    EXPECT_EQ(decodeBlock(decoder, "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"),
+              (std::vector<HeaderField>{{":method", "GET"}, {":scheme", "http"}, {":path", "/"},
+                                        {":authority", "www.example.com"}}));
+    EXPECT_EQ(decodeBlock(decoder, "8286 84be 5886 a8eb 1064 9cbf").back(),
+              HeaderField("cache-control", "no-cache"));
+    EXPECT_EQ(decodeBlock(decoder, "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf").back(),
+              HeaderField("custom-key", "custom-value"));
+    EXPECT_EQ(decoder.tableSize(), 164u);
+}
+
+// RFC 7541 C.6: responses with Huffman coding and a 256 byte table, so
+// entries are evicted
+TEST(HpackTest, EvictsFromTheDynamicTable) {
+    HpackDecoder decoder(256);
+    auto first = decodeBlock(decoder,
+        "4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 9504 0b81 66e0 82a6"
+        "2d1b ff6e 919d 29ad 1718 63c7 8f0b 97c8 e9ae 82ae 43d3");
+    EXPECT_EQ(first, (std::vector<HeaderField>{{":status", "302"}, {"cache-control", "private"},
+                                               {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+                                               {"location", "https://www.example.com"}}));
+    EXPECT_EQ(decoder.tableSize(), 222u);
+
+    auto second = decodeBlock(decoder, "4883 640e ffc1 c0bf");
+    EXPECT_EQ(second.front(), HeaderField(":status", "307"));
+    EXPECT_EQ(decoder.tableSize(), 222u);
+
+    auto third = decodeBlock(decoder,
+        "88c1 6196 d07a be94 1054 d444 a820 0595 040b 8166 e084 a62d 1bff c05a 839b d9ab"
+        "77ad 94e7 821d d7f2 e6c7 b335 dfdf cd5b 3960 d5af 2708 7f36 72c1 ab27 0fb5 291f"
+        "9587 3160 65c0 03ed 4ee5 b106 3d50 07");
+    EXPECT_EQ(third, (std::vector<HeaderField>{{":status", "200"}, {"cache-control", "private"},
+                                               {"date", "Mon, 21 Oct 2013 20:13:22 GMT"},
+                                               {"location", "https://www.example.com"},
+                                               {"content-encoding", "gzip"},
+                                               {"set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1"}}));
+    EXPECT_EQ(decoder.tableSize(), 215u);
+}
+
+TEST(HpackTest, RejectsMalformedBlocks) {
+    std::vector<HeaderField> headers;
+    // Index past the end of the (empty) dynamic table
+    EXPECT_FALSE(HpackDecoder().decode(fromHex("be"), headers));
+    // Index zero
+    EXPECT_FALSE(HpackDecoder().decode(fromHex("80"), headers));
+    // String length beyond the block
+    EXPECT_FALSE(HpackDecoder().decode(fromHex("4005 6162"), headers));
+    // Integer continuation that never ends
+    EXPECT_FALSE(HpackDecoder().decode(fromHex("ff ff ff"), headers));
+    // Table size update above the advertised limit, or after a field
+    EXPECT_FALSE(HpackDecoder(4096).decode(fromHex("3fe2 1f"), headers));
+    EXPECT_FALSE(HpackDecoder().decode(fromHex("82 20"), headers));
+    EXPECT_TRUE(HpackDecoder().decode(fromHex("20 82"), headers));
+
+    std::string decoded;
+    // Padding longer than 7 bits, and padding that is not all ones
+    EXPECT_FALSE(hpackHuffmanDecode(fromHex("1fff"), decoded));
+    EXPECT_FALSE(hpackHuffmanDecode(fromHex("00"), decoded));
+    // A full EOS symbol
+    EXPECT_FALSE(hpackHuffmanDecode(fromHex("ffff fffc"), decoded));
+}
+
+TEST(HpackTest, EncodedHeadersDecodeBack) {
+    EXPECT_EQ(hpackHuffmanEncode("www.example.com"), fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff"));
+
+    std::string block;
+    hpackEncodeHeader(":status", "200", block);
+    EXPECT_EQ(block, fromHex("88"));
+
+    std::vector<HeaderField> fields = {
+        {":status", "404"},
+        {"content-type", "application/json"},
+        {"x-custom", "value with spaces"},
+        {"content-length", "1234567890"},
+        {"x-binary", std::string("\x00\xff\x7f", 3)},
+        {"access-control-max-age", std::string(300, 'a')},
+    };
+    block.clear();
+    for (const auto& field : fields) {
+        hpackEncodeHeader(field.first, field.second, block);
+    }
+    std::vector<HeaderField> decoded;
+    HpackDecoder decoder;
+    ASSERT_TRUE(decoder.decode(block, decoded));
+    EXPECT_EQ(decoded, fields);
+    // Nothing is added to the peer's table
+    EXPECT_EQ(decoder.tableSize(), 0u);
+}
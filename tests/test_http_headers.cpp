@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "web/http_headers.h"
+#include "web/http_message.h"
+#include <string>
+
+using namespace AITextAssistant;
+
+TEST(HttpHeadersTest, RecognizesKnownNamesInAnyCase) {
+    EXPECT_EQ(headerId("Content-Length"), HeaderId::CONTENT_LENGTH);
+    EXPECT_EQ(headerId("content-length"), HeaderId::CONTENT_LENGTH);
+    EXPECT_EQ(headerId("ACCEPT-ENCODING"), HeaderId::ACCEPT_ENCODING);
+    EXPECT_EQ(headerId("access-control-allow-methods"), HeaderId::ACCESS_CONTROL_ALLOW_METHODS);
+    EXPECT_EQ(headerId("access-control-allow-headers"), HeaderId::ACCESS_CONTROL_ALLOW_HEADERS);
+    EXPECT_EQ(headerId("X-Request-Id"), HeaderId::OTHER);
+    EXPECT_EQ(headerId("Content-Lengths"), HeaderId::OTHER);
+    EXPECT_EQ(headerId("te"), HeaderId::OTHER);
+
+    for (size_t i = 1; i < static_cast<size_t>(HeaderId::COUNT); ++i) {
+        auto id = static_cast<HeaderId>(i);
+        EXPECT_EQ(headerId(headerName(id)), id) << headerName(id);
+    }
+}
+
+TEST(HttpHeadersTest, RequestLookupsIgnoreCase) {
+    std::string raw = "content-lengthHOST12x-trace-idlocalhostabc";
+    std::string_view data(raw);
+    RequestHeaders headers;
+    headers.add(data.substr(0, 14), data.substr(18, 2));
+    headers.add(data.substr(14, 4), data.substr(30, 9));
+    headers.add(data.substr(20, 10), data.substr(39, 3));
+
+    EXPECT_EQ(headers.size(), 3u);
+    EXPECT_EQ(headers.get(HeaderId::CONTENT_LENGTH), "12");
+    EXPECT_EQ(headers.get("Content-Length"), "12");
+    EXPECT_EQ(headers.get("host"), "localhost");
+    EXPECT_EQ(headers.get("X-Trace-Id"), "abc");
+    EXPECT_EQ(headers.find("Accept"), nullptr);
+    EXPECT_EQ(headers.get(HeaderId::UPGRADE), "");
+}
+
+TEST(HttpHeadersTest, RequestHeadersSpillPastInlineCapacity) {
+    std::string names;
+    for (size_t i = 0; i < RequestHeaders::INLINE_CAPACITY + 4; ++i) {
+        names += "x-header-" + std::to_string(i % 10);
+    }
+    std::string_view data(names);
+    RequestHeaders headers;
+    for (size_t i = 0; i < RequestHeaders::INLINE_CAPACITY + 4; ++i) {
+        headers.add(data.substr(i * 10, 10), data.substr(i * 10 + 9, 1));
+    }
+
+    EXPECT_EQ(headers.size(), RequestHeaders::INLINE_CAPACITY + 4);
+    size_t count = 0;
+    for (const auto& field : headers) {
+        EXPECT_EQ(field.value, std::string(1, static_cast<char>('0' + count % 10)));
+        ++count;
+    }
+    EXPECT_EQ(count, headers.size());
+
+    std::string copy = names;
+    headers.rebase(names.data(), copy.data());
+    names.assign(names.size(), '?');
+    EXPECT_EQ(headers.get("X-Header-3"), "3");
+}
+
+TEST(HttpHeadersTest, ResponseFieldsMergeAcrossSpellings) {
+    ResponseHeaders headers;
+    headers["content-type"] = "text/plain";
+    headers[HeaderId::CONTENT_TYPE] = "application/json";
+    headers["X-Custom"] = "1";
+    headers["x-custom"] = "2";
+
+    ASSERT_EQ(headers.size(), 2u);
+    EXPECT_EQ(headers.begin()->name(), "Content-Type");
+    EXPECT_EQ(*headers.find("Content-Type"), "application/json");
+    EXPECT_EQ(*headers.find("X-CUSTOM"), "2");
+
+    EXPECT_EQ(headers.erase("CONTENT-TYPE"), 1u);
+    EXPECT_FALSE(headers.contains(HeaderId::CONTENT_TYPE));
+    EXPECT_EQ(headers.erase(HeaderId::CONTENT_TYPE), 0u);
+    EXPECT_EQ(headers.size(), 1u);
+}
+
+TEST(HttpHeadersTest, DefaultResponseCarriesOnlyContentType) {
+    HttpResponse response;
+    ASSERT_EQ(response.headers.size(), 1u);
+    EXPECT_EQ(*response.headers.find(HeaderId::CONTENT_TYPE), "text/html; charset=utf-8");
+}
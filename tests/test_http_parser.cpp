@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "web/http_parser.h"
+
+using namespace AITextAssistant;
+
+class HttpParserTest : public ::testing::Test {
+protected:
+    // Parse a complete buffer and build the request on success
+    HttpRequestParser::Result parseAll(const std::string& data, HttpRequest& request) {
+        buffer = data;
+        auto result = parser.parse(buffer);
+        if (result == HttpRequestParser::Result::COMPLETE) {
+            parser.buildRequest(std::make_shared<std::string>(buffer), request);
+        }
+        return result;
+    }
+
+    HttpRequestParser parser;
+    std::string buffer;
+};
+
+TEST_F(HttpParserTest, ParsesSimpleGet) {
+    HttpRequest request;
+    auto result = parseAll("GET /api/conversations/messages?conversation_id=abc HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "Accept:   */*  \r\n\r\n", request);
+
+    ASSERT_EQ(result, HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(request.method, "GET");
+    EXPECT_EQ(request.path, "/api/conversations/messages");
+    EXPECT_EQ(request.query, "conversation_id=abc");
+    EXPECT_EQ(request.version, "HTTP/1.1");
+    EXPECT_TRUE(request.body.empty());
+    EXPECT_EQ(request.headers.get("Host"), "localhost");
+    EXPECT_EQ(request.headers.get("Accept"), "*/*");
+}
+
+TEST_F(HttpParserTest, ResumesAcrossByteByByteInput) {
+    std::string data = "POST /api/chat HTTP/1.1\r\ncontent-length: 16\r\n\r\n{\"message\":\"hi\"}X";
+    size_t message_length = data.size() - 1;
+
+    HttpRequestParser::Result result = HttpRequestParser::Result::INCOMPLETE;
+    for (size_t i = 0; i < data.size() && result == HttpRequestParser::Result::INCOMPLETE; ++i) {
+        buffer.push_back(data[i]);
+        result = parser.parse(buffer);
+    }
+
+    ASSERT_EQ(result, HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(parser.getMessageLength(), message_length);
+
+    HttpRequest request;
+    parser.buildRequest(std::make_shared<std::string>(buffer), request);
+    EXPECT_EQ(request.body, "{\"message\":\"hi\"}");
+}
+
+TEST_F(HttpParserTest, StopsAtMessageBoundaryForPipelining) {
+    std::string first = "GET /a HTTP/1.1\r\n\r\n";
+    std::string second = "GET /b HTTP/1.1\r\n\r\n";
+
+    HttpRequest request;
+    ASSERT_EQ(parseAll(first + second, request), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(request.path, "/a");
+    EXPECT_EQ(parser.getMessageLength(), first.size());
+}
+
+TEST_F(HttpParserTest, KeepsEmbeddedNulBytesInBody) {
+    std::string body("a\0b\0c", 5);
+    HttpRequest request;
+    ASSERT_EQ(parseAll("POST /x HTTP/1.1\r\nContent-Length: 5\r\n\r\n" + body, request),
+              HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(request.body, body);
+}
+
+TEST_F(HttpParserTest, DecodesChunkedBodyInPlace) {
+    HttpRequest request;
+    auto result = parseAll("POST /upload HTTP/1.1\r\n"
+                           "Transfer-Encoding: chunked\r\n\r\n"
+                           "5\r\nHello\r\n"
+                           "7;ext=1\r\n, world\r\n"
+                           "0\r\n"
+                           "X-Trailer: ignored\r\n\r\n", request);
+
+    ASSERT_EQ(result, HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(request.body, "Hello, world");
+}
+
+TEST_F(HttpParserTest, RejectsMalformedInput) {
+    HttpRequest request;
+    EXPECT_EQ(parseAll("GARBAGE\r\n\r\n", request), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 400);
+
+    parser.reset();
+    EXPECT_EQ(parseAll("GET / HTTP/2.0\r\n\r\n", request), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 505);
+
+    parser.reset();
+    EXPECT_EQ(parseAll("POST / HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n", request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 400);
+
+    parser.reset();
+    EXPECT_EQ(parseAll("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 501);
+
+    parser.reset();
+    EXPECT_EQ(parseAll("POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n", request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 400);
+}
+
+TEST_F(HttpParserTest, EnforcesSizeLimits) {
+    HttpParserLimits limits;
+    limits.max_header_bytes = 64;
+    limits.max_body_bytes = 8;
+    HttpRequest request;
+
+    parser = HttpRequestParser(limits);
+    EXPECT_EQ(parseAll("GET / HTTP/1.1\r\nX-Long: " + std::string(100, 'a'), request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 431);
+
+    parser = HttpRequestParser(limits);
+    EXPECT_EQ(parseAll("POST / HTTP/1.1\r\nContent-Length: 9\r\n\r\n", request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 413);
+
+    parser = HttpRequestParser(limits);
+    EXPECT_EQ(parseAll("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nabcde\r\n5\r\n", request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 413);
+}
+
+TEST_F(HttpParserTest, CapsChunkSizeLines) {
+    const std::string head = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    HttpRequest request;
+
+    // A size line that never ends is refused once it outgrows the cap
+    EXPECT_EQ(parseAll(head + "5", request), HttpRequestParser::Result::INCOMPLETE);
+    buffer += std::string(HttpParserLimits().max_chunk_line_bytes, '0');
+    EXPECT_EQ(parser.parse(buffer), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 400);
+
+    // ...and so is a complete one padded with extensions
+    parser.reset();
+    EXPECT_EQ(parseAll(head + "5;" + std::string(300, 'x') + "\r\nHello\r\n0\r\n\r\n", request),
+              HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 400);
+}
+
+TEST_F(HttpParserTest, CapsTrailerSection) {
+    HttpParserLimits limits;
+    limits.max_header_bytes = 64;
+    const std::string body = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nHello\r\n0\r\n";
+    HttpRequest request;
+
+    parser = HttpRequestParser(limits);
+    EXPECT_EQ(parseAll(body + "X-A: 1\r\n\r\n", request), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(request.body, "Hello");
+
+    // Many short trailer lines add up to the header limit...
+    parser = HttpRequestParser(limits);
+    std::string trailers;
+    for (int i = 0; i < 10; ++i) {
+        trailers += "X-T: 1234\r\n";
+    }
+    EXPECT_EQ(parseAll(body + trailers, request), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 431);
+
+    // ...as does one line that never ends
+    parser = HttpRequestParser(limits);
+    EXPECT_EQ(parseAll(body + "X-Long: " + std::string(100, 'a'), request), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.getErrorStatus(), 431);
+}
+
+TEST_F(HttpParserTest, StreamsBodyAfterPausingAtHeaders) {
+    HttpParserLimits limits;
+    limits.max_body_bytes = 4;
+    limits.max_streamed_body_bytes = 64;
+    parser = HttpRequestParser(limits);
+    parser.setPauseAfterHeaders(true);
+
+    // Chunked body fed in pieces; each takeBody() returns only new payload
+    buffer = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel";
+    ASSERT_EQ(parser.parse(buffer), HttpRequestParser::Result::HEADERS);
+    size_t head_length = parser.getMessageLength();
+    ASSERT_TRUE(parser.continueBody(true));
+
+    std::string body;
+    std::string chunk;
+    auto feed = [&](const std::string& bytes) {
+        buffer += bytes;
+        HttpRequestParser::Result result = parser.parse(buffer);
+        parser.takeBody(buffer, chunk);
+        body += chunk;
+        return result;
+    };
+    EXPECT_EQ(feed(""), HttpRequestParser::Result::INCOMPLETE);
+    EXPECT_EQ(body, "hel");
+    EXPECT_EQ(feed("lo\r\n6\r\n world\r\n"), HttpRequestParser::Result::INCOMPLETE);
+    EXPECT_EQ(feed("0\r\n\r\nGET /next HTTP/1.1\r\n\r\n"), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(body, "hello world");
+
+    // Only the head and the framing remain; the pipelined request follows
+    EXPECT_EQ(buffer.substr(0, head_length), "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n");
+    EXPECT_EQ(buffer.substr(parser.getMessageLength()), "GET /next HTTP/1.1\r\n\r\n");
+
+    // Content-Length bodies stream too, within the streamed limit
+    parser.reset();
+    buffer = "PUT /upload HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123";
+    ASSERT_EQ(parser.parse(buffer), HttpRequestParser::Result::HEADERS);
+    ASSERT_TRUE(parser.continueBody(true));
+    body.clear();
+    EXPECT_EQ(feed(""), HttpRequestParser::Result::INCOMPLETE);
+    EXPECT_EQ(feed("456789"), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(body, "0123456789");
+
+    // The buffered limit still applies when the caller chooses to buffer
+    parser.reset();
+    buffer = "PUT /upload HTTP/1.1\r\nContent-Length: 10\r\n\r\n";
+    ASSERT_EQ(parser.parse(buffer), HttpRequestParser::Result::HEADERS);
+    EXPECT_FALSE(parser.continueBody(false));
+    EXPECT_EQ(parser.getErrorStatus(), 413);
+
+    parser.reset();
+    buffer = "PUT /upload HTTP/1.1\r\nContent-Length: 65\r\n\r\n";
+    ASSERT_EQ(parser.parse(buffer), HttpRequestParser::Result::HEADERS);
+    EXPECT_FALSE(parser.continueBody(true));
+    EXPECT_EQ(parser.getErrorStatus(), 413);
+}
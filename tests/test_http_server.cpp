@@ -0,0 +1,1720 @@
+#include <gtest/gtest.h>
+#include "web/http_server.h"
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace AITextAssistant;
+
+namespace {
+
+int connectToPort(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string readUntilClosed(int fd) {
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, n);
+    }
+    return response;
+}
+
+// Read exactly one response, using Content-Length to find its end.
+// Bytes past it (a pipelined response) are left in `pending`.
+std::string readResponse(int fd, std::string& pending) {
+    char buffer[4096];
+    while (true) {
+        size_t header_end = pending.find("\r\n\r\n");
+        if (header_end != std::string::npos) {
+            size_t content_length = 0;
+            size_t pos = pending.find("Content-Length: ");
+            if (pos != std::string::npos && pos < header_end) {
+                content_length = std::stoul(pending.substr(pos + 16));
+            }
+            size_t total = header_end + 4 + content_length;
+            if (pending.size() >= total) {
+                std::string response = pending.substr(0, total);
+                pending.erase(0, total);
+                return response;
+            }
+        }
+
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            std::string response;
+            response.swap(pending);
+            return response;
+        }
+        pending.append(buffer, n);
+    }
+}
+
+// Send a raw request on a fresh connection and read one response
+std::string sendRawRequest(int port, const std::string& request) {
+    int fd = connectToPort(port);
+    if (fd < 0) {
+        return "";
+    }
+    send(fd, request.data(), request.size(), 0);
+    std::string pending;
+    std::string response = readResponse(fd, pending);
+    close(fd);
+    return response;
+}
+
+// Run the process out of descriptors with a connection still queued on
+// the listener: the server must neither spin on it nor stop accepting
+void expectAcceptBacksOffWithoutDescriptors(int port) {
+    struct rlimit original {};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &original), 0);
+    size_t open_fds = std::distance(std::filesystem::directory_iterator("/proc/self/fd"),
+                                    std::filesystem::directory_iterator());
+    struct rlimit limited = original;
+    limited.rlim_cur = open_fds + 16;
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limited), 0);
+
+    std::vector<int> fillers;
+    for (int fd = dup(0); fd >= 0; fd = dup(0)) {
+        fillers.push_back(fd);
+    }
+    ASSERT_FALSE(fillers.empty());
+    close(fillers.back());
+    fillers.pop_back();
+    // Takes the last descriptor, so the server cannot accept it
+    int client = connectToPort(port);
+    ASSERT_GE(client, 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    struct rusage before {};
+    struct rusage after {};
+    getrusage(RUSAGE_SELF, &before);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    getrusage(RUSAGE_SELF, &after);
+    auto cpu_us = [](const struct rusage& usage) {
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L + usage.ru_utime.tv_usec +
+               usage.ru_stime.tv_usec;
+    };
+    EXPECT_LT(cpu_us(after) - cpu_us(before), 200000L);
+
+    for (int fd : fillers) {
+        close(fd);
+    }
+    setrlimit(RLIMIT_NOFILE, &original);
+
+    // The listener is watched again once descriptors are back
+    struct timeval timeout {3, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string request = "GET /api/status HTTP/1.1\r\nConnection: close\r\n\r\n";
+    send(client, request.data(), request.size(), 0);
+    EXPECT_EQ(readUntilClosed(client).rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    close(client);
+}
+
+} // namespace
+
+class HttpServerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        server = std::make_unique<HttpServer>(0);
+        ASSERT_TRUE(server->start());
+        ASSERT_GT(server->getPort(), 0);
+    }
+
+    void TearDown() override {
+        server.reset();
+    }
+
+    int connectToServer() {
+        return connectToPort(server->getPort());
+    }
+
+    std::string sendRawRequest(const std::string& request) {
+        return ::sendRawRequest(server->getPort(), request);
+    }
+
+    std::unique_ptr<HttpServer> server;
+};
+
+TEST_F(HttpServerTest, ServesApiStatus) {
+    std::string response = sendRawRequest("GET /api/status HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("application/json"), std::string::npos);
+    EXPECT_NE(response.find("\"assistant_available\":false"), std::string::npos);
+}
+
+TEST_F(HttpServerTest, RequestBodySplitAcrossWrites) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    std::string head = "POST /api/chat HTTP/1.1\r\nContent-Length: 15\r\n\r\n";
+    send(fd, head.data(), head.size(), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send(fd, "{\"message\":\"hi\"", 15, 0);
+
+    std::string pending;
+    std::string response = readResponse(fd, pending);
+    close(fd);
+
+    // No assistant attached, so the handler reports it as unavailable
+    EXPECT_EQ(response.rfind("HTTP/1.1 500", 0), 0u);
+    EXPECT_NE(response.find("Assistant not available"), std::string::npos);
+}
+
+TEST_F(HttpServerTest, UnknownPathFallsBackToStaticFiles) {
+    std::string response = sendRawRequest("GET /does-not-exist.html HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 404", 0), 0u);
+}
+
+TEST_F(HttpServerTest, HandlesManyIdleConnections) {
+    // Idle connections cost a map entry, not a thread
+    std::vector<int> idle;
+    for (int i = 0; i < 200; ++i) {
+        int fd = connectToServer();
+        ASSERT_GE(fd, 0);
+        idle.push_back(fd);
+    }
+
+    std::string response = sendRawRequest("GET /api/status HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0u);
+
+    for (int fd : idle) {
+        close(fd);
+    }
+}
+
+TEST_F(HttpServerTest, StopsPromptly) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    server->stop();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_FALSE(server->isRunning());
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+    close(fd);
+}
+
+TEST_F(HttpServerTest, BacksOffWhenOutOfDescriptors) {
+    expectAcceptBacksOffWithoutDescriptors(server->getPort());
+}
+
+TEST_F(HttpServerTest, AcceptsChunkedRequestBody) {
+    std::string response = sendRawRequest(
+        "POST /api/conversations HTTP/1.1\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n"
+        "4\r\n{\"co\r\n"
+        "14\r\nnversation_id\": \"x\"}\r\n"
+        "0\r\n\r\n");
+
+    // DELETE-only route, so POST falls through to static files
+    EXPECT_EQ(response.rfind("HTTP/1.1 404", 0), 0u);
+}
+
+TEST_F(HttpServerTest, RejectsMalformedRequestAndCloses) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "POST / HTTP/1.1\r\nContent-Length: nope\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response = readUntilClosed(fd);
+    EXPECT_EQ(response.rfind("HTTP/1.1 400 Bad Request\r\n", 0), 0u);
+    EXPECT_NE(response.find("Connection: close\r\n"), std::string::npos);
+    close(fd);
+}
+
+TEST_F(HttpServerTest, KeepsConnectionAliveAcrossRequests) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    std::string pending;
+    for (int i = 0; i < 3; ++i) {
+        std::string request = "GET /api/status HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        send(fd, request.data(), request.size(), 0);
+        std::string response = readResponse(fd, pending);
+        EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0u);
+        EXPECT_NE(response.find("Connection: keep-alive\r\n"), std::string::npos);
+    }
+    close(fd);
+}
+
+TEST_F(HttpServerTest, AnswersPipelinedRequestsInOrder) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    std::string requests =
+        "GET /api/status HTTP/1.1\r\n\r\n"
+        "GET /missing.html HTTP/1.1\r\n\r\n"
+        "GET /v1/models HTTP/1.1\r\nConnection: close\r\n\r\n";
+    send(fd, requests.data(), requests.size(), 0);
+
+    std::string pending;
+    std::string first = readResponse(fd, pending);
+    std::string second = readResponse(fd, pending);
+    std::string third = readResponse(fd, pending);
+
+    EXPECT_NE(first.find("\"status\":\"running\""), std::string::npos);
+    EXPECT_EQ(second.rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_NE(third.find("\"object\":\"list\""), std::string::npos);
+    EXPECT_NE(third.find("Connection: close\r\n"), std::string::npos);
+
+    // Connection: close was honoured
+    EXPECT_EQ(readUntilClosed(fd), "");
+    close(fd);
+}
+
+TEST_F(HttpServerTest, Http10ClosesByDefault) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    std::string request = "GET /api/status HTTP/1.0\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response = readUntilClosed(fd);
+    EXPECT_NE(response.find("Connection: close\r\n"), std::string::npos);
+    close(fd);
+}
+
+// Listening sockets bound to `port`, from the kernel's socket table
+int countListeners(int port) {
+    std::ifstream table("/proc/net/tcp");
+    std::string line;
+    std::getline(table, line);
+    int count = 0;
+    while (std::getline(table, line)) {
+        std::istringstream fields(line);
+        std::string slot, local, remote, state;
+        fields >> slot >> local >> remote >> state;
+        if (state == "0A" && std::stoi(local.substr(local.find(':') + 1), nullptr, 16) == port) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+TEST(HttpServerReusePortTest, ShardsAcceptAcrossLoops) {
+    ServerConfig config;
+    config.io_threads = 4;
+    config.listen_backlog = 64;
+
+    HttpServer server(0, config);
+    ASSERT_TRUE(server.start());
+    EXPECT_EQ(countListeners(server.getPort()), 4);
+
+    // Every listener must be serviced, wherever the kernel hashes a client
+    std::vector<std::future<std::string>> responses;
+    for (int i = 0; i < 32; ++i) {
+        responses.push_back(std::async(std::launch::async, [&server]() {
+            return sendRawRequest(server.getPort(), "GET /api/status HTTP/1.1\r\n\r\n");
+        }));
+    }
+    for (auto& response : responses) {
+        EXPECT_EQ(response.get().rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    }
+
+    server.stop();
+    EXPECT_EQ(countListeners(server.getPort()), 0);
+}
+
+TEST(HttpServerKeepAliveTest, EnforcesRequestLimitAndIdleTimeout) {
+    ServerConfig config;
+    config.max_requests_per_connection = 2;
+    config.keep_alive_timeout_seconds = 1;
+
+    HttpServer server(0, config);
+    ASSERT_TRUE(server.start());
+
+    // Second request is the last one allowed on the connection
+    int fd = connectToPort(server.getPort());
+    std::string pending;
+    std::string request = "GET /api/status HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    EXPECT_NE(readResponse(fd, pending).find("Connection: keep-alive"), std::string::npos);
+    send(fd, request.data(), request.size(), 0);
+    EXPECT_NE(readResponse(fd, pending).find("Connection: close"), std::string::npos);
+    EXPECT_EQ(readUntilClosed(fd), "");
+    close(fd);
+
+    // An idle connection is closed by its idle deadline
+    fd = connectToPort(server.getPort());
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(readUntilClosed(fd), "");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(4));
+    close(fd);
+}
+
+TEST(HttpServerDeadlineTest, ClosesSlowHeadersAndBodies) {
+    ServerConfig config;
+    config.keep_alive_timeout_seconds = 10;
+    config.header_timeout_seconds = 1;
+    config.body_timeout_seconds = 1;
+
+    HttpServer server(0, config);
+    ASSERT_TRUE(server.start());
+
+    // Trickled header bytes do not extend the header deadline
+    int fd = connectToPort(server.getPort());
+    ASSERT_GE(fd, 0);
+    auto start = std::chrono::steady_clock::now();
+    std::string request_line = "GET /api/status HTTP/1.1\r\n";
+    send(fd, request_line.data(), request_line.size(), MSG_NOSIGNAL);
+    bool closed = false;
+    for (int i = 0; i < 40 && !closed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        closed = send(fd, "X", 1, MSG_NOSIGNAL) < 0;
+        char byte;
+        closed = closed || recv(fd, &byte, 1, MSG_DONTWAIT) == 0;
+    }
+    EXPECT_TRUE(closed);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+    close(fd);
+
+    // A body that never arrives runs into the body deadline
+    fd = connectToPort(server.getPort());
+    ASSERT_GE(fd, 0);
+    start = std::chrono::steady_clock::now();
+    std::string head = "POST /api/chat HTTP/1.1\r\nContent-Length: 100\r\n\r\n{";
+    send(fd, head.data(), head.size(), MSG_NOSIGNAL);
+    EXPECT_EQ(readUntilClosed(fd), "");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+    close(fd);
+
+    // A prompt request on a fresh connection is unaffected
+    EXPECT_EQ(sendRawRequest(server.getPort(), "GET /api/status HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 200 OK", 0), 0u);
+}
+
+TEST(HttpServerBackpressureTest, RejectsWith503WhenQueueIsFull) {
+    ServerConfig config;
+    config.worker_threads = 1;
+    config.max_queue_size = 1;
+    config.retry_after_seconds = 7;
+
+    HttpServer server(0, config);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> started{0};
+    server.addRoute("GET", "/slow", [released, &started](const HttpRequest&) {
+        ++started;
+        released.wait();
+        return HttpResponse();
+    });
+    ASSERT_TRUE(server.start());
+
+    // First request occupies the only worker, second waits in the queue
+    auto first = std::async(std::launch::async, [&]() {
+        return sendRawRequest(server.getPort(), "GET /slow HTTP/1.1\r\n\r\n");
+    });
+    while (started.load() == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    auto second = std::async(std::launch::async, [&]() {
+        return sendRawRequest(server.getPort(), "GET /slow HTTP/1.1\r\n\r\n");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::string rejected = sendRawRequest(server.getPort(), "GET /slow HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(rejected.rfind("HTTP/1.1 503 Service Unavailable\r\n", 0), 0u);
+    EXPECT_NE(rejected.find("Retry-After: 7\r\n"), std::string::npos);
+
+    release.set_value();
+    EXPECT_EQ(first.get().rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_EQ(second.get().rfind("HTTP/1.1 200 OK", 0), 0u);
+}
+
+TEST_F(HttpServerTest, StreamsChunkedBodyAsItIsProduced) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    server->addRoute("GET", "/stream", [released](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/event-stream";
+        response.stream = [released](const StreamWriter& write) {
+            write("data: first\n\n");
+            released.wait();
+            write("data: second\n\n");
+        };
+        return response;
+    });
+
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+    std::string request = "GET /stream HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+
+    // The first event must arrive while the producer is still blocked
+    auto readUntil = [fd](std::string& data, const std::string& marker) {
+        char buffer[4096];
+        while (data.find(marker) == std::string::npos) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return false;
+            }
+            data.append(buffer, n);
+        }
+        return true;
+    };
+    std::string data;
+    ASSERT_TRUE(readUntil(data, "d\r\ndata: first\n\n\r\n"));
+    EXPECT_EQ(data.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(data.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+    EXPECT_EQ(data.find("Content-Length"), std::string::npos);
+    EXPECT_EQ(data.find("second"), std::string::npos);
+
+    release.set_value();
+    ASSERT_TRUE(readUntil(data, "e\r\ndata: second\n\n\r\n0\r\n\r\n"));
+
+    // The connection stays usable after the terminating chunk
+    request = "GET /api/status HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string pending;
+    EXPECT_EQ(readResponse(fd, pending).rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    close(fd);
+}
+
+TEST_F(HttpServerTest, HoldsBackStreamsForSlowReadersAndEndsThemOnStop) {
+    const size_t limit = 64 * 1024 * 1024;
+    const std::string piece(16 * 1024, 'x');
+    std::atomic<size_t> produced{0};
+    std::promise<void> finished;
+    server->addRoute("GET", "/stream", [&](const HttpRequest&) {
+        HttpResponse response;
+        response.stream = [&](const StreamWriter& write) {
+            while (produced < limit && write(piece)) {
+                produced += piece.size();
+            }
+            finished.set_value();
+        };
+        return response;
+    });
+
+    // A client that asks and then reads nothing
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int receive_buffer = 16 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server->getPort());
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    ASSERT_EQ(connect(fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    std::string request = "GET /stream HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_LT(produced.load(), limit / 4);
+
+    // The producer is told to stop instead of stop() waiting it out
+    auto start = std::chrono::steady_clock::now();
+    server->stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_EQ(finished.get_future().wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    close(fd);
+}
+
+TEST_F(HttpServerTest, RevalidatesStaticFilesWithEtag) {
+    auto directory = std::filesystem::temp_directory_path() / ("http_static_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    std::ofstream(directory / "index.html") << "<html>cached</html>";
+    server->setStaticDirectory(directory.string());
+
+    std::string response = sendRawRequest("GET / HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Type: text/html\r\n"), std::string::npos);
+    EXPECT_NE(response.find("Last-Modified: "), std::string::npos);
+    EXPECT_NE(response.find("\r\n\r\n<html>cached</html>"), std::string::npos);
+
+    size_t etag_pos = response.find("ETag: ");
+    ASSERT_NE(etag_pos, std::string::npos);
+    std::string etag = response.substr(etag_pos + 6, response.find("\r\n", etag_pos) - etag_pos - 6);
+
+    response = sendRawRequest("GET /index.html HTTP/1.1\r\nIf-None-Match: \"other\", " + etag + "\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 304 Not Modified\r\n", 0), 0u);
+    EXPECT_NE(response.find("ETag: " + etag + "\r\n"), std::string::npos);
+    EXPECT_EQ(response.find("Content-Length"), std::string::npos);
+    EXPECT_EQ(response.substr(response.size() - 4), "\r\n\r\n");
+
+    response = sendRawRequest("GET /index.html HTTP/1.1\r\nIf-None-Match: \"stale\"\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(HttpServerTest, ServesByteRangesOfCachedFiles) {
+    auto directory = std::filesystem::temp_directory_path() / ("http_range_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    std::ofstream(directory / "data.txt") << "0123456789";
+    server->setStaticDirectory(directory.string());
+
+    std::string response = sendRawRequest("GET /data.txt HTTP/1.1\r\nRange: bytes=2-5\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 206 Partial Content\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Range: bytes 2-5/10\r\n"), std::string::npos);
+    EXPECT_EQ(response.substr(response.size() - 4), "2345");
+
+    response = sendRawRequest("GET /data.txt HTTP/1.1\r\nRange: bytes=-3\r\n\r\n");
+    EXPECT_EQ(response.substr(response.size() - 3), "789");
+
+    response = sendRawRequest("GET /data.txt HTTP/1.1\r\nRange: bytes=10-\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 416 Range Not Satisfiable\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Range: bytes */10\r\n"), std::string::npos);
+
+    // A stale If-Range validator means the whole file
+    response = sendRawRequest("GET /data.txt HTTP/1.1\r\nRange: bytes=2-5\r\nIf-Range: \"old\"\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(response.substr(response.size() - 10), "0123456789");
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(HttpServerSendfileTest, SendsLargeFilesAndRangesFromDisk) {
+    auto directory = std::filesystem::temp_directory_path() / ("http_sendfile_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    std::string content;
+    for (int i = 0; content.size() < 3 * 1024 * 1024; ++i) {
+        content += std::to_string(i) + ",";
+    }
+    std::ofstream(directory / "large.bin", std::ios::binary) << content;
+
+    ServerConfig config;
+    config.sendfile_threshold_bytes = 4096;
+    HttpServer server(0, config);
+    server.setStaticDirectory(directory.string());
+    ASSERT_TRUE(server.start());
+
+    // Both responses go over one keep-alive connection
+    int fd = connectToPort(server.getPort());
+    ASSERT_GE(fd, 0);
+    std::string pending;
+    std::string request = "GET /large.bin HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response = readResponse(fd, pending);
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Accept-Ranges: bytes\r\n"), std::string::npos);
+    ASSERT_GE(response.size(), content.size());
+    EXPECT_TRUE(response.compare(response.size() - content.size(), content.size(), content) == 0);
+
+    request = "GET /large.bin HTTP/1.1\r\nRange: bytes=1000000-1000099\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    response = readResponse(fd, pending);
+    EXPECT_EQ(response.rfind("HTTP/1.1 206 Partial Content\r\n", 0), 0u);
+    EXPECT_EQ(response.substr(response.size() - 100), content.substr(1000000, 100));
+    close(fd);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(HttpServerTest, NegotiatesCompressedStaticFiles) {
+    auto directory = std::filesystem::temp_directory_path() / ("http_gzip_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    std::string page;
+    for (int i = 0; i < 500; ++i) {
+        page += "<li>conversation entry</li>\n";
+    }
+    std::ofstream(directory / "index.html") << page;
+    server->setStaticDirectory(directory.string());
+
+    std::string plain = sendRawRequest("GET / HTTP/1.1\r\n\r\n");
+    EXPECT_NE(plain.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+    EXPECT_EQ(plain.find("Content-Encoding"), std::string::npos);
+    EXPECT_NE(plain.find("Content-Length: " + std::to_string(page.size()) + "\r\n"), std::string::npos);
+
+    std::string gzip = sendRawRequest("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    EXPECT_EQ(gzip.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(gzip.find("Content-Encoding: gzip\r\n"), std::string::npos);
+    EXPECT_NE(gzip.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+    EXPECT_LT(gzip.size(), page.size() / 4);
+    EXPECT_EQ(gzip.substr(gzip.find("\r\n\r\n") + 4, 2), "\x1f\x8b");
+
+    // Revalidation uses the variant's own ETag
+    size_t etag_pos = gzip.find("ETag: ");
+    std::string etag = gzip.substr(etag_pos + 6, gzip.find("\r\n", etag_pos) - etag_pos - 6);
+    std::string revalidated = sendRawRequest("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\nIf-None-Match: " +
+                                             etag + "\r\n\r\n");
+    EXPECT_EQ(revalidated.rfind("HTTP/1.1 304 Not Modified\r\n", 0), 0u);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(HttpServerTest, CompressesLargeApiResponses) {
+    std::string payload = "[";
+    for (int i = 0; i < 200; ++i) {
+        payload += "{\"role\":\"assistant\",\"content\":\"reply number " + std::to_string(i) + "\"},";
+    }
+    payload.back() = ']';
+    server->addRoute("GET", "/history", [payload](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "application/json";
+        response.body = payload;
+        return response;
+    });
+
+    std::string plain = sendRawRequest("GET /history HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(plain.find("Content-Encoding"), std::string::npos);
+    EXPECT_NE(plain.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+    EXPECT_EQ(plain.substr(plain.find("\r\n\r\n") + 4), payload);
+
+    std::string deflated = sendRawRequest("GET /history HTTP/1.1\r\nAccept-Encoding: deflate\r\n\r\n");
+    EXPECT_NE(deflated.find("Content-Encoding: deflate\r\n"), std::string::npos);
+    std::string body = deflated.substr(deflated.find("\r\n\r\n") + 4);
+    EXPECT_NE(deflated.find("Content-Length: " + std::to_string(body.size()) + "\r\n"), std::string::npos);
+
+    std::string inflated(payload.size(), '\0');
+    uLongf inflated_size = inflated.size();
+    ASSERT_EQ(uncompress(reinterpret_cast<Bytef*>(&inflated[0]), &inflated_size,
+                         reinterpret_cast<const Bytef*>(body.data()), body.size()), Z_OK);
+    EXPECT_EQ(inflated.substr(0, inflated_size), payload);
+
+    // Below the threshold responses go out as they are
+    std::string status = sendRawRequest("GET /api/status HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    EXPECT_EQ(status.find("Content-Encoding"), std::string::npos);
+}
+
+TEST_F(HttpServerTest, DispatchesRoutesWithPathParameters) {
+    server->addRoute("GET", "/items/{id}", [](const HttpRequest& request) {
+        HttpResponse response;
+        response.body = "item " + std::string(request.path_params.get("id"));
+        return response;
+    });
+
+    std::string response = sendRawRequest("GET /items/42?verbose=1 HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), "item 42");
+
+    // REST form of the conversation routes reaches the same handlers
+    response = sendRawRequest("GET /api/conversations/abc/messages HTTP/1.1\r\n\r\n");
+    EXPECT_NE(response.find("Assistant not available"), std::string::npos);
+}
+
+TEST_F(HttpServerTest, DecodesQueryParameters) {
+    server->addRoute("GET", "/query", [](const HttpRequest& request) {
+        HttpResponse response;
+        for (const auto& [name, value] : request.query_params) {
+            response.body += std::string(name) + "=" + std::string(value) + ";";
+        }
+        response.body += "id=" + std::string(request.query_params.get("id"));
+        return response;
+    });
+
+    std::string response = sendRawRequest(
+        "GET /query?id=1&title=Weekly%20notes+v2&bad=%zz%4&flag&id=7 HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4),
+              "id=1;title=Weekly notes v2;bad=%zz%4;id=7;id=7");
+}
+
+TEST(RequestArenaTest, ReusesTheArenaOnceNoRequestHoldsIt) {
+    std::shared_ptr<RequestArena> slot;
+    auto first = RequestArena::acquire(slot);
+    char* memory = first->allocate(16);
+
+    // Still held by a request: a new arena takes the slot
+    auto second = RequestArena::acquire(slot);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(slot, second);
+
+    // Released: the same arena comes back, emptied
+    first.reset();
+    char* reused = second->allocate(16);
+    second.reset();
+    auto third = RequestArena::acquire(slot);
+    EXPECT_EQ(third, slot);
+    EXPECT_EQ(third->allocate(16), reused);
+    EXPECT_NE(memory, nullptr);
+}
+
+TEST_F(HttpServerTest, ResumesLargeBodiesAfterPartialWrites) {
+    std::string payload(8 * 1024 * 1024, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>('a' + i % 26);
+    }
+    server->addRoute("GET", "/blob", [&payload](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "application/octet-stream";
+        response.body = payload;
+        return response;
+    });
+
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+    // Two requests back to back: the first body is larger than the socket
+    // buffers, so the server has to park on EAGAIN and resume mid-body
+    std::string requests = "GET /blob HTTP/1.1\r\n\r\nGET /api/status HTTP/1.1\r\n\r\n";
+    send(fd, requests.data(), requests.size(), 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // readResponse() rescans for the head on every recv; read the large
+    // body with a plain counted loop instead
+    std::string head_marker = "Content-Length: " + std::to_string(payload.size()) + "\r\n";
+    std::string pending;
+    std::vector<char> buffer(256 * 1024);
+    size_t header_end = std::string::npos;
+    while (header_end == std::string::npos) {
+        ssize_t n = recv(fd, buffer.data(), buffer.size(), 0);
+        ASSERT_GT(n, 0);
+        pending.append(buffer.data(), n);
+        header_end = pending.find("\r\n\r\n");
+    }
+    std::string head = pending.substr(0, header_end + 4);
+    pending.erase(0, header_end + 4);
+    while (pending.size() < payload.size()) {
+        ssize_t n = recv(fd, buffer.data(), buffer.size(), 0);
+        ASSERT_GT(n, 0);
+        pending.append(buffer.data(), n);
+    }
+    std::string body = pending.substr(0, payload.size());
+    pending.erase(0, payload.size());
+    std::string second = readResponse(fd, pending);
+    close(fd);
+
+    EXPECT_EQ(head.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(head.find(head_marker), std::string::npos);
+    EXPECT_TRUE(body == payload);
+    EXPECT_EQ(second.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+}
+
+class HttpServerIoUringTest : public HttpServerTest {
+protected:
+    void SetUp() override {
+        ServerConfig config;
+        config.io_backend = "io_uring";
+        config.sendfile_threshold_bytes = 4096;
+        server = std::make_unique<HttpServer>(0, config);
+        ASSERT_TRUE(server->start());
+        ASSERT_GT(server->getPort(), 0);
+    }
+};
+
+TEST_F(HttpServerIoUringTest, BacksOffWhenOutOfDescriptors) {
+    expectAcceptBacksOffWithoutDescriptors(server->getPort());
+}
+
+TEST_F(HttpServerIoUringTest, AnswersKeepAliveAndPipelinedRequests) {
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+
+    std::string pending;
+    std::string request = "GET /api/status HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    EXPECT_EQ(readResponse(fd, pending).rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+
+    std::string requests =
+        "GET /missing.html HTTP/1.1\r\n\r\n"
+        "GET /v1/models HTTP/1.1\r\nConnection: close\r\n\r\n";
+    send(fd, requests.data(), requests.size(), 0);
+    EXPECT_EQ(readResponse(fd, pending).rfind("HTTP/1.1 404", 0), 0u);
+    std::string last = readResponse(fd, pending);
+    EXPECT_NE(last.find("\"object\":\"list\""), std::string::npos);
+
+    // The linked close runs once the final response is sent
+    EXPECT_EQ(readUntilClosed(fd), "");
+    close(fd);
+}
+
+TEST_F(HttpServerIoUringTest, StreamsAndSendsLargeBodies) {
+    server->addRoute("GET", "/stream", [](const HttpRequest&) {
+        HttpResponse response;
+        response.stream = [](const StreamWriter& write) {
+            for (int i = 0; i < 100; ++i) {
+                write("data: " + std::to_string(i) + "\n\n");
+            }
+        };
+        return response;
+    });
+
+    auto directory = std::filesystem::temp_directory_path() / ("http_uring_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    std::string content;
+    for (int i = 0; content.size() < 2 * 1024 * 1024; ++i) {
+        content += std::to_string(i) + ",";
+    }
+    std::ofstream(directory / "large.bin", std::ios::binary) << content;
+    server->setStaticDirectory(directory.string());
+
+    int fd = connectToServer();
+    ASSERT_GE(fd, 0);
+    std::string request = "GET /stream HTTP/1.1\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string data;
+    char buffer[4096];
+    while (data.find("0\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        data.append(buffer, n);
+    }
+    EXPECT_NE(data.find("data: 0\n\n"), std::string::npos);
+    EXPECT_NE(data.find("data: 99\n\n"), std::string::npos);
+
+    // A sendfile body on the same connection, larger than the socket buffers
+    request = "GET /large.bin HTTP/1.1\r\nConnection: close\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response = readUntilClosed(fd);
+    close(fd);
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    ASSERT_GE(response.size(), content.size());
+    EXPECT_TRUE(response.compare(response.size() - content.size(), content.size(), content) == 0);
+
+    std::filesystem::remove_all(directory);
+}
+
+namespace {
+
+// Register POST /upload, which counts the streamed body in 1 KiB reads,
+// and POST /reject, which answers without reading its body
+void addUploadRoutes(HttpServer& server) {
+    server.addStreamingRoute("POST", "/upload", [](const HttpRequest& request) {
+        size_t total = 0;
+        size_t checksum = 0;
+        std::string chunk;
+        while (request.body_reader->read(chunk)) {
+            for (unsigned char c : chunk) {
+                checksum += c;
+            }
+            total += chunk.size();
+            // A slow consumer, so the connection has to stop reading
+            if (total % (1024 * 1024) < chunk.size()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+        HttpResponse response;
+        response.status_code = request.body_reader->complete() ? 200 : 400;
+        response.body = std::to_string(total) + " " + std::to_string(checksum);
+        return response;
+    });
+    server.addStreamingRoute("POST", "/reject", [](const HttpRequest&) {
+        HttpResponse response;
+        response.status_code = 403;
+        return response;
+    });
+}
+
+// Upload `size` bytes to /upload with Content-Length or chunked framing,
+// then check the same connection still answers
+void expectStreamedUploads(int port) {
+    int fd = connectToPort(port);
+    ASSERT_GE(fd, 0);
+
+    std::string body;
+    size_t checksum = 0;
+    for (size_t i = 0; i < 8 * 1024 * 1024; ++i) {
+        body.push_back(static_cast<char>('a' + i % 26));
+        checksum += static_cast<unsigned char>(body.back());
+    }
+    std::string expected = std::to_string(body.size()) + " " + std::to_string(checksum);
+
+    std::string head = "POST /upload HTTP/1.1\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    ASSERT_EQ(send(fd, head.data(), head.size(), 0), static_cast<ssize_t>(head.size()));
+    for (size_t offset = 0; offset < body.size();) {
+        ssize_t n = send(fd, body.data() + offset, std::min<size_t>(65536, body.size() - offset), 0);
+        ASSERT_GT(n, 0);
+        offset += static_cast<size_t>(n);
+    }
+    std::string pending;
+    std::string response = readResponse(fd, pending);
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(response.substr(response.size() - expected.size()), expected);
+
+    std::string chunked = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (size_t offset = 0; offset < body.size(); offset += 100000) {
+        size_t length = std::min<size_t>(100000, body.size() - offset);
+        char size_line[32];
+        snprintf(size_line, sizeof(size_line), "%zx\r\n", length);
+        chunked.append(size_line).append(body, offset, length).append("\r\n");
+    }
+    chunked += "0\r\n\r\n";
+    for (size_t offset = 0; offset < chunked.size();) {
+        ssize_t n = send(fd, chunked.data() + offset, std::min<size_t>(65536, chunked.size() - offset), 0);
+        ASSERT_GT(n, 0);
+        offset += static_cast<size_t>(n);
+    }
+    response = readResponse(fd, pending);
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_EQ(response.substr(response.size() - expected.size()), expected);
+
+    // An unread body is discarded and the next request is still framed
+    std::string rejected = "POST /reject HTTP/1.1\r\nContent-Length: 1000000\r\n\r\n" + std::string(1000000, 'x');
+    for (size_t offset = 0; offset < rejected.size();) {
+        ssize_t n = send(fd, rejected.data() + offset, rejected.size() - offset, 0);
+        ASSERT_GT(n, 0);
+        offset += static_cast<size_t>(n);
+    }
+    EXPECT_EQ(readResponse(fd, pending).rfind("HTTP/1.1 403", 0), 0u);
+
+    std::string request = "GET /api/status HTTP/1.1\r\nConnection: close\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    EXPECT_EQ(readResponse(fd, pending).rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    close(fd);
+}
+
+} // namespace
+
+TEST(HttpServerBodyStreamTest, StreamsLargeBodiesToHandlers) {
+    for (const char* backend : {"epoll", "io_uring"}) {
+        SCOPED_TRACE(backend);
+        ServerConfig config;
+        config.io_backend = backend;
+        HttpServer server(0, config);
+        addUploadRoutes(server);
+        ASSERT_TRUE(server.start());
+        expectStreamedUploads(server.getPort());
+    }
+}
+
+TEST(HttpServerBodyStreamTest, EnforcesConfiguredSizeLimits) {
+    ServerConfig config;
+    config.max_header_bytes = 1024;
+    config.max_body_bytes = 1000;
+    config.max_streamed_body_bytes = 100000;
+    HttpServer server(0, config);
+    addUploadRoutes(server);
+    ASSERT_TRUE(server.start());
+    int port = server.getPort();
+
+    std::string response = sendRawRequest(port, "GET /api/status HTTP/1.1\r\nX-Big: " + std::string(2000, 'a') + "\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 431", 0), 0u);
+
+    // Buffered routes get the small cap, streamed ones the large cap
+    response = sendRawRequest(port, "POST /api/chat HTTP/1.1\r\nContent-Length: 1001\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 413", 0), 0u);
+    response = sendRawRequest(port, "POST /upload HTTP/1.1\r\nContent-Length: 100001\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 413", 0), 0u);
+    response = sendRawRequest(port, "POST /upload HTTP/1.1\r\nContent-Length: 5000\r\n\r\n" + std::string(5000, 'x'));
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+
+    // A chunked body crossing the cap mid-stream is cut short; the handler
+    // sees it incomplete and the connection closes after its answer
+    int fd = connectToPort(port);
+    ASSERT_GE(fd, 0);
+    std::string request = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (int i = 0; i < 24; ++i) {
+        request += "1000\r\n" + std::string(4096, 'y') + "\r\n";
+    }
+    // Nothing follows the offending size line, so the close is clean
+    request += "1000\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+    response = readUntilClosed(fd);
+    close(fd);
+    EXPECT_EQ(response.rfind("HTTP/1.1 400", 0), 0u);
+}
+
+namespace {
+
+std::string maskedFrame(uint8_t first_byte, const std::string& payload) {
+    const uint8_t mask[4] = {0xA1, 0xB2, 0xC3, 0xD4};
+    std::string frame;
+    frame.push_back(static_cast<char>(first_byte));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(0x80 | payload.size()));
+    } else {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    }
+    frame.append(reinterpret_cast<const char*>(mask), 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame.push_back(static_cast<char>(payload[i] ^ mask[i & 3]));
+    }
+    return frame;
+}
+
+// Read one unmasked server frame; returns the first byte, or -1 on EOF
+int readFrame(int fd, std::string& pending, std::string& payload) {
+    char buffer[4096];
+    while (true) {
+        if (pending.size() >= 2) {
+            size_t length = static_cast<uint8_t>(pending[1]) & 0x7F;
+            size_t header = 2;
+            if (length == 126 && pending.size() >= 4) {
+                length = (static_cast<uint8_t>(pending[2]) << 8) | static_cast<uint8_t>(pending[3]);
+                header = 4;
+            }
+            if ((length < 126 || header == 4) && pending.size() >= header + length) {
+                int first = static_cast<uint8_t>(pending[0]);
+                payload = pending.substr(header, length);
+                pending.erase(0, header + length);
+                return first;
+            }
+        }
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return -1;
+        }
+        pending.append(buffer, n);
+    }
+}
+
+// Connect and upgrade to a WebSocket on `path`; -1 if refused
+int openWebSocket(int port, const std::string& path, std::string& pending) {
+    int fd = connectToPort(port);
+    if (fd < 0) {
+        return -1;
+    }
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                          "Connection: keep-alive, Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string response = readResponse(fd, pending);
+    if (response.rfind("HTTP/1.1 101 Switching Protocols\r\n", 0) != 0 ||
+        response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") == std::string::npos) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+TEST(HttpServerWebSocketTest, ExchangesMessagesAndControlFrames) {
+    for (const char* backend : {"epoll", "io_uring"}) {
+        SCOPED_TRACE(backend);
+        ServerConfig config;
+        config.io_backend = backend;
+        HttpServer server(0, config);
+        server.addWebSocketRoute("/ws/echo", [](const std::shared_ptr<WebSocket>& socket, const std::string& message,
+                                                bool binary) {
+            if (message == "bye") {
+                socket->close(WebSocketStatus::NORMAL, "done");
+                return;
+            }
+            // Several replies per message, larger than the socket buffers in total
+            for (int i = 0; i < 3; ++i) {
+                std::string reply = (binary ? "binary:" : "text:") + message;
+                socket->sendText(reply);
+            }
+        });
+        ASSERT_TRUE(server.start());
+
+        std::string pending;
+        int fd = openWebSocket(server.getPort(), "/ws/echo", pending);
+        ASSERT_GE(fd, 0);
+
+        // A fragmented message with a ping in between, sent in one write
+        std::string frames = maskedFrame(0x01, "hel") + maskedFrame(0x89, "are you there") + maskedFrame(0x80, "lo");
+        send(fd, frames.data(), frames.size(), 0);
+        std::string payload;
+        EXPECT_EQ(readFrame(fd, pending, payload), 0x8A);
+        EXPECT_EQ(payload, "are you there");
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_EQ(readFrame(fd, pending, payload), 0x81);
+            EXPECT_EQ(payload, "text:hello");
+        }
+
+        // Many messages queued at once are all answered in order
+        std::string burst;
+        for (int i = 0; i < 100; ++i) {
+            burst += maskedFrame(0x81, std::to_string(i) + std::string(1000, '.'));
+        }
+        send(fd, burst.data(), burst.size(), 0);
+        for (int i = 0; i < 100; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                ASSERT_EQ(readFrame(fd, pending, payload), 0x81);
+                EXPECT_EQ(payload, "text:" + std::to_string(i) + std::string(1000, '.'));
+            }
+        }
+
+        // The handler starts the close handshake
+        std::string bye = maskedFrame(0x81, "bye");
+        send(fd, bye.data(), bye.size(), 0);
+        EXPECT_EQ(readFrame(fd, pending, payload), 0x88);
+        EXPECT_EQ(payload, std::string("\x03\xE8") + "done");
+        EXPECT_EQ(readUntilClosed(fd), "");
+        close(fd);
+
+        // Protocol errors close with 1002; a client close is echoed
+        fd = openWebSocket(server.getPort(), "/ws/echo", pending);
+        ASSERT_GE(fd, 0);
+        std::string unmasked("\x81\x02hi", 4);
+        send(fd, unmasked.data(), unmasked.size(), 0);
+        EXPECT_EQ(readFrame(fd, pending, payload), 0x88);
+        EXPECT_EQ(payload, std::string("\x03\xEA"));
+        close(fd);
+
+        fd = openWebSocket(server.getPort(), "/ws/echo", pending);
+        ASSERT_GE(fd, 0);
+        std::string goodbye = maskedFrame(0x88, std::string("\x03\xE9", 2));
+        send(fd, goodbye.data(), goodbye.size(), 0);
+        EXPECT_EQ(readFrame(fd, pending, payload), 0x88);
+        EXPECT_EQ(payload, std::string("\x03\xE9"));
+        close(fd);
+    }
+}
+
+TEST_F(HttpServerTest, ServesChatOverWebSocket) {
+    // A plain request or an unsupported version is refused
+    std::string response = sendRawRequest("GET /ws/chat HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 426 Upgrade Required\r\n", 0), 0u);
+    response = sendRawRequest("GET /ws/chat HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                              "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 426 Upgrade Required\r\n", 0), 0u);
+    EXPECT_NE(response.find("Sec-WebSocket-Version: 13\r\n"), std::string::npos);
+
+    // Without an assistant each message is answered with an error event
+    // and the connection stays open for the next one
+    std::string pending;
+    int fd = openWebSocket(server->getPort(), "/ws/chat", pending);
+    ASSERT_GE(fd, 0);
+    for (const char* message : {"not json", R"({"message": "hi"})"}) {
+        std::string frame = maskedFrame(0x81, message);
+        send(fd, frame.data(), frame.size(), 0);
+        std::string payload;
+        ASSERT_EQ(readFrame(fd, pending, payload), 0x81);
+        EXPECT_NE(payload.find("\"type\":\"error\""), std::string::npos);
+    }
+    close(fd);
+}
+
+namespace {
+
+struct Http2Frame {
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint32_t stream_id = 0;
+    std::string payload;
+};
+
+std::string http2Frame(uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload) {
+    std::string frame;
+    frame.push_back(static_cast<char>(payload.size() >> 16));
+    frame.push_back(static_cast<char>(payload.size() >> 8));
+    frame.push_back(static_cast<char>(payload.size()));
+    frame.push_back(static_cast<char>(type));
+    frame.push_back(static_cast<char>(flags));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        frame.push_back(static_cast<char>(stream_id >> shift));
+    }
+    return frame + payload;
+}
+
+std::string http2Uint32(uint32_t value) {
+    std::string bytes;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        bytes.push_back(static_cast<char>(value >> shift));
+    }
+    return bytes;
+}
+
+// A SETTINGS payload entry
+std::string http2Setting(uint16_t id, uint32_t value) {
+    return std::string{static_cast<char>(id >> 8), static_cast<char>(id)} + http2Uint32(value);
+}
+
+std::string http2RequestHeaders(const std::string& method, const std::string& path,
+                                const std::vector<HeaderField>& extra = {}) {
+    std::string block;
+    hpackEncodeHeader(":method", method, block);
+    hpackEncodeHeader(":scheme", "http", block);
+    hpackEncodeHeader(":path", path, block);
+    hpackEncodeHeader(":authority", "localhost", block);
+    for (const auto& field : extra) {
+        hpackEncodeHeader(field.first, field.second, block);
+    }
+    return block;
+}
+
+// Read one frame; false once the connection is closed
+bool readHttp2Frame(int fd, std::string& pending, Http2Frame& frame) {
+    char buffer[16384];
+    while (true) {
+        if (pending.size() >= 9) {
+            size_t length = (size_t(uint8_t(pending[0])) << 16) | (size_t(uint8_t(pending[1])) << 8) |
+                            uint8_t(pending[2]);
+            if (pending.size() >= 9 + length) {
+                frame.type = static_cast<uint8_t>(pending[3]);
+                frame.flags = static_cast<uint8_t>(pending[4]);
+                frame.stream_id = 0;
+                for (int i = 5; i < 9; ++i) {
+                    frame.stream_id = (frame.stream_id << 8) | uint8_t(pending[i]);
+                }
+                frame.payload = pending.substr(9, length);
+                pending.erase(0, 9 + length);
+                return true;
+            }
+        }
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return false;
+        }
+        pending.append(buffer, n);
+    }
+}
+
+// Exchange prefaces with prior knowledge; `settings` is our SETTINGS payload
+int openHttp2(int port, const std::string& settings, std::string& pending) {
+    int fd = connectToPort(port);
+    if (fd < 0) {
+        return -1;
+    }
+    std::string preface = std::string("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n") + http2Frame(0x4, 0, 0, settings);
+    send(fd, preface.data(), preface.size(), 0);
+    Http2Frame frame;
+    if (!readHttp2Frame(fd, pending, frame) || frame.type != 0x4 || frame.flags != 0) {
+        close(fd);
+        return -1;
+    }
+    std::string ack = http2Frame(0x4, 0x1, 0, "");
+    send(fd, ack.data(), ack.size(), 0);
+    return fd;
+}
+
+// Responses collected per stream by readHttp2Responses()
+struct Http2Response {
+    std::vector<HeaderField> headers;
+    std::string body;
+    bool complete = false;
+};
+
+// Read frames until every stream in `until` is complete; false if the
+// connection closed or carried a frame the server should not send
+bool readHttp2Responses(int fd, std::string& pending, HpackDecoder& decoder,
+                        std::map<uint32_t, Http2Response>& responses, const std::vector<uint32_t>& until) {
+    auto done = [&]() {
+        return std::all_of(until.begin(), until.end(), [&](uint32_t id) { return responses[id].complete; });
+    };
+    Http2Frame frame;
+    while (!done()) {
+        if (!readHttp2Frame(fd, pending, frame)) {
+            return false;
+        }
+        Http2Response& response = responses[frame.stream_id];
+        if (frame.type == 0x1) {
+            if (!(frame.flags & 0x4) || !decoder.decode(frame.payload, response.headers)) {
+                return false;
+            }
+        } else if (frame.type == 0x0) {
+            response.body += frame.payload;
+        } else if (frame.type == 0x3 || frame.type == 0x7) {
+            return false;
+        }
+        if ((frame.type == 0x0 || frame.type == 0x1) && (frame.flags & 0x1)) {
+            response.complete = true;
+        }
+    }
+    return true;
+}
+
+std::string headerValue(const std::vector<HeaderField>& headers, const std::string& name) {
+    for (const auto& field : headers) {
+        if (field.first == name) {
+            return field.second;
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+TEST(HttpServerHttp2Test, MultiplexesStreamsWithinFlowControlWindows) {
+    for (const char* backend : {"epoll", "io_uring"}) {
+        SCOPED_TRACE(backend);
+        ServerConfig config;
+        config.io_backend = backend;
+        HttpServer server(0, config);
+        std::string large;
+        for (size_t i = 0; i < 1024 * 1024; ++i) {
+            large.push_back(static_cast<char>('a' + i % 26));
+        }
+        server.addRoute("GET", "/large", [&large](const HttpRequest&) {
+            HttpResponse response;
+            response.headers["Content-Type"] = "text/plain";
+            response.body = large;
+            return response;
+        });
+        server.addRoute("POST", "/echo", [](const HttpRequest& request) {
+            HttpResponse response;
+            response.body = std::string(request.method) + " " + std::string(request.path) + " " +
+                            std::string(request.headers.get("host")) + " " + std::to_string(request.body.size());
+            return response;
+        });
+        server.addRoute("GET", "/pieces", [](const HttpRequest&) {
+            HttpResponse response;
+            response.stream = [](const StreamWriter& write) {
+                for (int i = 0; i < 3; ++i) {
+                    write("piece" + std::to_string(i) + ";");
+                }
+            };
+            return response;
+        });
+        ASSERT_TRUE(server.start());
+
+        // Our stream windows start at 1000 bytes
+        std::string pending;
+        int fd = openHttp2(server.getPort(), http2Setting(0x4, 1000), pending);
+        ASSERT_GE(fd, 0);
+
+        std::string upload(100000, 'u');
+        std::string requests = http2Frame(0x1, 0x5, 1, http2RequestHeaders("GET", "/large")) +
+                               http2Frame(0x1, 0x5, 3, http2RequestHeaders("GET", "/api/status")) +
+                               http2Frame(0x1, 0x4, 5, http2RequestHeaders("POST", "/echo")) +
+                               http2Frame(0x1, 0x5, 7, http2RequestHeaders("GET", "/pieces")) +
+                               http2Frame(0x6, 0, 0, "12345678");
+        for (size_t offset = 0; offset < upload.size(); offset += 16384) {
+            bool last = offset + 16384 >= upload.size();
+            requests += http2Frame(0x0, last ? 0x1 : 0, 5, upload.substr(offset, 16384));
+        }
+        send(fd, requests.data(), requests.size(), 0);
+
+        // The small responses finish while the large one waits for window
+        HpackDecoder decoder;
+        std::map<uint32_t, Http2Response> responses;
+        ASSERT_TRUE(readHttp2Responses(fd, pending, decoder, responses, {3, 5, 7}));
+        EXPECT_EQ(headerValue(responses[3].headers, ":status"), "200");
+        EXPECT_NE(responses[3].body.find("\"status\":\"running\""), std::string::npos);
+        EXPECT_EQ(responses[5].body, "POST /echo localhost 100000");
+        EXPECT_EQ(responses[7].body, "piece0;piece1;piece2;");
+        EXPECT_EQ(headerValue(responses[7].headers, "transfer-encoding"), "");
+        EXPECT_FALSE(responses[1].complete);
+        EXPECT_LE(responses[1].body.size(), 1000u);
+
+        // Open the windows: the rest of the large body follows
+        std::string updates = http2Frame(0x4, 0, 0, http2Setting(0x4, 4 * 1024 * 1024)) +
+                              http2Frame(0x8, 0, 0, http2Uint32(4 * 1024 * 1024));
+        send(fd, updates.data(), updates.size(), 0);
+        ASSERT_TRUE(readHttp2Responses(fd, pending, decoder, responses, {1}));
+        EXPECT_EQ(headerValue(responses[1].headers, ":status"), "200");
+        EXPECT_EQ(headerValue(responses[1].headers, "content-length"), std::to_string(large.size()));
+        EXPECT_TRUE(responses[1].body == large);
+        // The PING was answered along the way
+        EXPECT_EQ(responses[0].body, "");
+
+        // A protocol error closes the connection with GOAWAY
+        std::string bad = http2Frame(0x0, 0x1, 9, "data on an idle stream");
+        send(fd, bad.data(), bad.size(), 0);
+        Http2Frame frame;
+        bool goaway = false;
+        while (readHttp2Frame(fd, pending, frame)) {
+            if (frame.type == 0x7) {
+                goaway = true;
+                EXPECT_EQ(frame.payload.substr(4), http2Uint32(0x1));
+            }
+        }
+        EXPECT_TRUE(goaway);
+        close(fd);
+    }
+}
+
+TEST(HttpServerHttp2Test, UpgradesFromHttp1AndEnforcesLimits) {
+    ServerConfig config;
+    config.max_header_bytes = 1024;
+    config.max_body_bytes = 1000;
+    HttpServer server(0, config);
+    ASSERT_TRUE(server.start());
+
+    // "Upgrade: h2c": the upgrade request is answered as stream 1
+    int fd = connectToPort(server.getPort());
+    ASSERT_GE(fd, 0);
+    std::string request = "GET /api/status HTTP/1.1\r\nHost: localhost\r\nConnection: Upgrade, HTTP2-Settings\r\n"
+                          "Upgrade: h2c\r\nHTTP2-Settings: AAMAAABkAAQAAP__\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string pending;
+    std::string response = readResponse(fd, pending);
+    EXPECT_EQ(response.rfind("HTTP/1.1 101 Switching Protocols\r\n", 0), 0u);
+    EXPECT_NE(response.find("Upgrade: h2c\r\n"), std::string::npos);
+
+    std::string preface = std::string("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n") + http2Frame(0x4, 0, 0, "");
+    send(fd, preface.data(), preface.size(), 0);
+    HpackDecoder decoder;
+    std::map<uint32_t, Http2Response> responses;
+    ASSERT_TRUE(readHttp2Responses(fd, pending, decoder, responses, {1}));
+    EXPECT_EQ(headerValue(responses[1].headers, ":status"), "200");
+    EXPECT_NE(responses[1].body.find("\"status\":\"running\""), std::string::npos);
+
+    // Oversized header lists and bodies are refused per stream
+    std::string requests =
+        http2Frame(0x1, 0x5, 3, http2RequestHeaders("GET", "/api/status", {{"x-large", std::string(2000, 'x')}})) +
+        http2Frame(0x1, 0x4, 5, http2RequestHeaders("POST", "/api/chat")) +
+        http2Frame(0x0, 0x1, 5, std::string(2000, '{'));
+    send(fd, requests.data(), requests.size(), 0);
+    ASSERT_TRUE(readHttp2Responses(fd, pending, decoder, responses, {3, 5}));
+    EXPECT_EQ(headerValue(responses[3].headers, ":status"), "431");
+    EXPECT_EQ(headerValue(responses[5].headers, ":status"), "413");
+
+    // The connection is still usable
+    request = http2Frame(0x1, 0x5, 7, http2RequestHeaders("GET", "/api/status"));
+    send(fd, request.data(), request.size(), 0);
+    ASSERT_TRUE(readHttp2Responses(fd, pending, decoder, responses, {7}));
+    EXPECT_EQ(headerValue(responses[7].headers, ":status"), "200");
+    close(fd);
+}
+
+TEST(HttpServerHttp2Test, CountsResetStreamsUntilTheirHandlerAnswers) {
+    HttpServer server(0);
+    std::mutex mutex;
+    std::vector<HttpResponder> waiting;
+    server.addAsyncRoute("GET", "/parked", [&](const HttpRequest&, HttpResponder respond) {
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting.push_back(std::move(respond));
+    });
+    ASSERT_TRUE(server.start());
+
+    std::string pending;
+    int fd = openHttp2(server.getPort(), "", pending);
+    ASSERT_GE(fd, 0);
+
+    // "Rapid reset": every request is cancelled right after its HEADERS.
+    // Only MAX_CONCURRENT_STREAMS handlers may be running at once
+    constexpr uint32_t REQUESTS = 150;
+    std::string requests;
+    for (uint32_t i = 0; i < REQUESTS; ++i) {
+        uint32_t stream_id = 2 * i + 1;
+        requests += http2Frame(0x1, 0x5, stream_id, http2RequestHeaders("GET", "/parked")) +
+                    http2Frame(0x3, 0, stream_id, http2Uint32(0x8));
+    }
+    // The PING is answered after every frame before it was handled
+    requests += http2Frame(0x6, 0, 0, "12345678");
+    send(fd, requests.data(), requests.size(), 0);
+
+    Http2Frame frame;
+    uint32_t refused = 0;
+    while (readHttp2Frame(fd, pending, frame) && !(frame.type == 0x6 && (frame.flags & 0x1))) {
+        if (frame.type == 0x3 && frame.payload == http2Uint32(0x7)) {
+            ++refused;
+        }
+    }
+    EXPECT_EQ(refused, REQUESTS - Http2Session::MAX_CONCURRENT_STREAMS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::vector<HttpResponder> responders;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(waiting.size(), Http2Session::MAX_CONCURRENT_STREAMS);
+        responders.swap(waiting);
+    }
+
+    // Once the handlers answer, their slots are free again
+    for (auto& respond : responders) {
+        respond(HttpResponse());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::string request = http2Frame(0x1, 0x5, 2 * REQUESTS + 1, http2RequestHeaders("GET", "/api/status"));
+    send(fd, request.data(), request.size(), 0);
+    HpackDecoder decoder;
+    std::map<uint32_t, Http2Response> responses;
+    ASSERT_TRUE(readHttp2Responses(fd, pending, decoder, responses, {2 * REQUESTS + 1}));
+    EXPECT_EQ(headerValue(responses[2 * REQUESTS + 1].headers, ":status"), "200");
+    close(fd);
+}
+
+TEST(HttpServerAsyncRouteTest, AnswersLaterWithoutHoldingAWorker) {
+    ServerConfig config;
+    config.worker_threads = 1;
+    config.max_queue_size = 1;
+    HttpServer server(0, config);
+
+    std::mutex mutex;
+    std::vector<HttpResponder> waiting;
+    server.addAsyncRoute("GET", "/deferred/{id}", [&](const HttpRequest& request, HttpResponder respond) {
+        // The request is gone once the handler returns; keep what is needed
+        std::string id(request.path_params.get("id"));
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting.push_back([id, respond](HttpResponse response) {
+            response.body = "answer " + id;
+            respond(std::move(response));
+        });
+    });
+    server.addAsyncRoute("GET", "/dropped", [](const HttpRequest&, HttpResponder) {});
+    server.addAsyncRoute("GET", "/throws", [](const HttpRequest&, HttpResponder) {
+        throw std::runtime_error("handler failed");
+    });
+    ASSERT_TRUE(server.start());
+
+    auto waitForPending = [&](size_t count) {
+        for (int i = 0; i < 500; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (waiting.size() >= count) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+
+    // More pending requests than the single worker and its queue could
+    // hold; each one returns the worker once it is parked
+    constexpr int PENDING = 6;
+    std::vector<std::future<std::string>> http1;
+    for (int i = 0; i < PENDING; ++i) {
+        http1.push_back(std::async(std::launch::async, [&server, i]() {
+            return sendRawRequest(server.getPort(), "GET /deferred/" + std::to_string(i) + " HTTP/1.1\r\n\r\n");
+        }));
+        ASSERT_TRUE(waitForPending(i + 1));
+    }
+
+    std::string pending;
+    int h2 = openHttp2(server.getPort(), "", pending);
+    ASSERT_GE(h2, 0);
+    std::string request = http2Frame(0x1, 0x5, 1, http2RequestHeaders("GET", "/deferred/h2"));
+    send(h2, request.data(), request.size(), 0);
+    ASSERT_TRUE(waitForPending(PENDING + 1));
+
+    // The worker is free meanwhile
+    std::string status = sendRawRequest(server.getPort(), "GET /api/status HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(status.rfind("HTTP/1.1 200 OK", 0), 0u);
+
+    // Abandoned or failing handlers still get an answer
+    EXPECT_EQ(sendRawRequest(server.getPort(), "GET /dropped HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 500", 0), 0u);
+    EXPECT_EQ(sendRawRequest(server.getPort(), "GET /throws HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 500", 0), 0u);
+
+    // Answer from another thread; a second call is ignored
+    std::thread completer([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& respond : waiting) {
+            respond(HttpResponse());
+            respond(HttpResponse());
+        }
+        waiting.clear();
+    });
+    completer.join();
+
+    for (int i = 0; i < PENDING; ++i) {
+        std::string response = http1[i].get();
+        EXPECT_EQ(response.rfind("HTTP/1.1 200 OK", 0), 0u);
+        EXPECT_NE(response.find("Access-Control-Allow-Origin: *\r\n"), std::string::npos);
+        EXPECT_EQ(response.substr(response.find("\r\n\r\n") + 4), "answer " + std::to_string(i));
+    }
+
+    HpackDecoder decoder;
+    std::map<uint32_t, Http2Response> responses;
+    ASSERT_TRUE(readHttp2Responses(h2, pending, decoder, responses, {1}));
+    EXPECT_EQ(headerValue(responses[1].headers, ":status"), "200");
+    EXPECT_EQ(responses[1].body, "answer h2");
+    close(h2);
+
+    // Responses that complete after stop() are dropped
+    auto late = std::async(std::launch::async, [&server]() {
+        return sendRawRequest(server.getPort(), "GET /deferred/late HTTP/1.1\r\n\r\n");
+    });
+    ASSERT_TRUE(waitForPending(1));
+    server.stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        waiting.front()(HttpResponse());
+        waiting.clear();
+    }
+    EXPECT_EQ(late.get(), "");
+}
+
+TEST(HttpServerAsyncRouteTest, PushesStreamsWithoutHoldingAWorker) {
+    ServerConfig config;
+    config.worker_threads = 1;
+    config.max_queue_size = 1;
+    HttpServer server(0, config);
+
+    std::mutex mutex;
+    std::vector<std::pair<StreamWriter, StreamEnd>> pushed;
+    server.addRoute("GET", "/pushed", [&](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/event-stream";
+        response.push_stream = [&](StreamWriter write, StreamEnd end) {
+            write("data: head\n\n");
+            std::lock_guard<std::mutex> lock(mutex);
+            pushed.emplace_back(std::move(write), std::move(end));
+        };
+        return response;
+    });
+    ASSERT_TRUE(server.start());
+
+    auto waitForPushed = [&](size_t count) {
+        for (int i = 0; i < 500; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (pushed.size() >= count) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+    auto readUntil = [](int fd, std::string& data, const std::string& marker) {
+        char buffer[4096];
+        while (data.find(marker) == std::string::npos) {
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return false;
+            }
+            data.append(buffer, n);
+        }
+        return true;
+    };
+
+    // More open streams than the single worker and its queue could hold
+    constexpr int STREAMS = 4;
+    std::vector<int> http1;
+    std::vector<std::string> received(STREAMS);
+    for (int i = 0; i < STREAMS; ++i) {
+        int fd = connectToPort(server.getPort());
+        ASSERT_GE(fd, 0);
+        std::string request = "GET /pushed HTTP/1.1\r\n\r\n";
+        send(fd, request.data(), request.size(), 0);
+        ASSERT_TRUE(readUntil(fd, received[i], "data: head\n\n\r\n"));
+        EXPECT_NE(received[i].find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+        http1.push_back(fd);
+    }
+    ASSERT_TRUE(waitForPushed(STREAMS));
+
+    std::string pending;
+    int h2 = openHttp2(server.getPort(), "", pending);
+    ASSERT_GE(h2, 0);
+    std::string request = http2Frame(0x1, 0x5, 1, http2RequestHeaders("GET", "/pushed"));
+    send(h2, request.data(), request.size(), 0);
+    ASSERT_TRUE(waitForPushed(STREAMS + 1));
+
+    // The worker is free meanwhile
+    std::string status = sendRawRequest(server.getPort(), "GET /api/status HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(status.rfind("HTTP/1.1 200 OK", 0), 0u);
+
+    // Pushed from another thread; the last HTTP/1 body is dropped unended
+    std::thread producer([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < pushed.size(); ++i) {
+            EXPECT_TRUE(pushed[i].first("data: more\n\n"));
+            if (i != STREAMS - 1) {
+                pushed[i].second(true);
+                EXPECT_FALSE(pushed[i].first("data: late\n\n"));
+            }
+        }
+        pushed.clear();
+    });
+    producer.join();
+
+    for (int i = 0; i < STREAMS; ++i) {
+        if (i != STREAMS - 1) {
+            EXPECT_TRUE(readUntil(http1[i], received[i], "c\r\ndata: more\n\n\r\n0\r\n\r\n"));
+        } else {
+            received[i] += readUntilClosed(http1[i]);
+            EXPECT_NE(received[i].find("data: more"), std::string::npos);
+            EXPECT_EQ(received[i].find("0\r\n\r\n"), std::string::npos);
+        }
+        close(http1[i]);
+    }
+
+    HpackDecoder decoder;
+    std::map<uint32_t, Http2Response> responses;
+    ASSERT_TRUE(readHttp2Responses(h2, pending, decoder, responses, {1}));
+    EXPECT_EQ(headerValue(responses[1].headers, ":status"), "200");
+    EXPECT_EQ(responses[1].body, "data: head\n\ndata: more\n\n");
+    close(h2);
+}
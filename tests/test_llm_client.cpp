@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 #include "llm/llm_client.h"
+#include "web/http_server.h"
 #include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
 
 using namespace AITextAssistant;
 
@@ -244,3 +250,360 @@ TEST_F(HTTPClientTest, UserAgentSetting) {
 
 // Note: We don't test actual HTTP requests in unit tests
 // Those would be integration tests requiring network access
+
+TEST(SSEParserTest, DispatchesEventsSplitAcrossReads) {
+    std::string stream = ": keep-alive\r\n"
+                         "event: content_block_delta\r\n"
+                         "data: {\"a\":1}\r\n\r\n"
+                         "data: line1\n"
+                         "data:line2\n\n"
+                         "id: 7\n\n"
+                         "data: [DONE]\n\n";
+
+    // Feed one byte at a time so every boundary (including CR|LF) is split
+    SSEParser parser;
+    std::vector<SSEEvent> events;
+    for (char c : stream) {
+        parser.feed(&c, 1, [&](const SSEEvent& event) {
+            events.push_back(event);
+            return true;
+        });
+    }
+
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].event, "content_block_delta");
+    EXPECT_EQ(events[0].data, "{\"a\":1}");
+    EXPECT_EQ(events[1].event, "");
+    EXPECT_EQ(events[1].data, "line1\nline2");
+    EXPECT_EQ(events[2].data, "[DONE]");
+}
+
+TEST(SSEParserTest, FinishFlushesUnterminatedEvent) {
+    SSEParser parser;
+    std::vector<std::string> data;
+    auto collect = [&](const SSEEvent& event) {
+        data.push_back(event.data);
+        return true;
+    };
+
+    std::string stream = "data: one\n\ndata: two";
+    parser.feed(stream.data(), stream.size(), collect);
+    EXPECT_EQ(data.size(), 1u);
+    parser.finish(collect);
+    ASSERT_EQ(data.size(), 2u);
+    EXPECT_EQ(data[1], "two");
+}
+
+class LLMClientStreamTest : public ::testing::Test {
+protected:
+    // Expose the protected delta parser
+    template <typename Client>
+    class Testable : public Client {
+    public:
+        using Client::Client;
+        using Status = typename Client::StreamStatus;
+
+        Status parse(const std::string& event_type, const std::string& data, std::string& delta) {
+            SSEEvent event;
+            event.event = event_type;
+            event.data = data;
+            return this->parseStreamEvent(event, delta, response);
+        }
+
+        LLMResponse response;
+    };
+
+    LLMConfig config;
+};
+
+TEST_F(LLMClientStreamTest, ParsesOpenAIDeltas) {
+    Testable<OpenAIClient> client(config);
+    using Status = Testable<OpenAIClient>::Status;
+    std::string delta;
+
+    EXPECT_EQ(client.parse("", R"({"choices":[{"index":0,"delta":{"role":"assistant","content":""}}]})", delta),
+              Status::CONTINUE);
+    EXPECT_EQ(delta, "");
+    EXPECT_EQ(client.parse("", R"({"choices":[{"index":0,"delta":{"content":"Hel"},"finish_reason":null}]})", delta),
+              Status::CONTINUE);
+    EXPECT_EQ(delta, "Hel");
+
+    delta.clear();
+    EXPECT_EQ(client.parse("", R"({"choices":[],"usage":{"prompt_tokens":3,"completion_tokens":2,"total_tokens":5}})", delta),
+              Status::CONTINUE);
+    EXPECT_EQ(client.response.metadata["total_tokens"], "5");
+    EXPECT_EQ(client.parse("", "[DONE]", delta), Status::DONE);
+    EXPECT_EQ(client.parse("", R"({"error":{"message":"overloaded"}})", delta), Status::ERROR);
+    EXPECT_EQ(client.response.error_message, "overloaded");
+}
+
+TEST_F(LLMClientStreamTest, ParsesAnthropicContentBlockDeltas) {
+    Testable<AnthropicClient> client(config);
+    using Status = Testable<AnthropicClient>::Status;
+    std::string delta;
+
+    EXPECT_EQ(client.parse("message_start", R"({"type":"message_start","message":{"usage":{"input_tokens":12}}})", delta),
+              Status::CONTINUE);
+    EXPECT_EQ(client.parse("ping", R"({"type":"ping"})", delta), Status::CONTINUE);
+    EXPECT_EQ(delta, "");
+    EXPECT_EQ(client.parse("content_block_delta",
+                           R"({"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":"Hi"}})", delta),
+              Status::CONTINUE);
+    EXPECT_EQ(delta, "Hi");
+    EXPECT_EQ(client.parse("message_stop", R"({"type":"message_stop"})", delta), Status::DONE);
+    EXPECT_EQ(client.response.metadata["input_tokens"], "12");
+    EXPECT_EQ(client.parse("error", R"({"type":"error","error":{"type":"overloaded_error","message":"Overloaded"}})", delta),
+              Status::ERROR);
+    EXPECT_EQ(client.response.error_message, "Overloaded");
+}
+
+TEST_F(LLMClientStreamTest, ParsesCustomFormats) {
+    Testable<CustomClient> client(config);
+    using Status = Testable<CustomClient>::Status;
+    std::string delta;
+
+    EXPECT_EQ(client.parse("", R"({"choices":[{"delta":{"content":"a"}}]})", delta), Status::CONTINUE);
+    EXPECT_EQ(delta, "a");
+    delta.clear();
+    EXPECT_EQ(client.parse("", R"({"message":{"role":"assistant","content":"b"},"done":false})", delta), Status::CONTINUE);
+    EXPECT_EQ(delta, "b");
+    delta.clear();
+    EXPECT_EQ(client.parse("", R"({"response":"c","done":true})", delta), Status::DONE);
+    EXPECT_EQ(delta, "c");
+}
+
+TEST_F(LLMClientStreamTest, DeliversTokensBeforeStreamEnds) {
+    // A local upstream that holds back the rest of the stream until the
+    // client has seen the first token
+    HttpServer upstream(0);
+    std::promise<void> first_token;
+    std::shared_future<void> first_token_seen = first_token.get_future().share();
+    std::string received_payload;
+    upstream.addRoute("POST", "/v1/chat/completions", [&, first_token_seen](const HttpRequest& request) {
+        received_payload = std::string(request.body);
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/event-stream";
+        response.stream = [first_token_seen](const StreamWriter& write) {
+            write("data: {\"choices\":[{\"delta\":{\"content\":\"Hello\"}}]}\n\n");
+            if (first_token_seen.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+                return;
+            }
+            write(": keep-alive\n\ndata: {\"choices\":[{\"delta\":{\"content\":\", world\"}}]}\n\n");
+            write("data: [DONE]\n\n");
+        };
+        return response;
+    });
+    ASSERT_TRUE(upstream.start());
+
+    config.provider = "openai";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream.getPort()) + "/v1/chat/completions";
+    config.model_name = "gpt-3.5-turbo";
+    auto client = LLMClient::createClient(config);
+
+    std::vector<std::string> deltas;
+    LLMResponse response = client->streamChatCompletion({{"user", "hi"}}, [&](const std::string& delta) {
+        deltas.push_back(delta);
+        if (deltas.size() == 1) {
+            first_token.set_value();
+        }
+        return true;
+    });
+
+    EXPECT_TRUE(response.success) << response.error_message;
+    EXPECT_EQ(response.content, "Hello, world");
+    EXPECT_EQ(deltas, (std::vector<std::string>{"Hello", ", world"}));
+    EXPECT_TRUE(nlohmann::json::parse(received_payload).value("stream", false));
+}
+
+TEST_F(LLMClientStreamTest, AbandonsTheStreamWhenTheCallbackDeclines) {
+    HttpServer upstream(0);
+    upstream.addRoute("POST", "/v1/chat/completions", [](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/event-stream";
+        response.stream = [](const StreamWriter& write) {
+            write("data: {\"choices\":[{\"delta\":{\"content\":\"Hello\"}}]}\n\n");
+            write("data: {\"choices\":[{\"delta\":{\"content\":\", world\"}}]}\n\n");
+            write("data: [DONE]\n\n");
+        };
+        return response;
+    });
+    ASSERT_TRUE(upstream.start());
+
+    config.provider = "openai";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream.getPort()) + "/v1/chat/completions";
+    auto client = LLMClient::createClient(config);
+
+    std::vector<std::string> deltas;
+    LLMResponse response = client->streamChatCompletion({{"user", "hi"}}, [&](const std::string& delta) {
+        deltas.push_back(delta);
+        return false;
+    });
+
+    // Not a reply; the content is what the callback received before declining
+    EXPECT_FALSE(response.success);
+    EXPECT_TRUE(response.cancelled);
+    EXPECT_EQ(response.content, "Hello");
+    EXPECT_EQ(deltas, (std::vector<std::string>{"Hello"}));
+}
+
+TEST_F(LLMClientStreamTest, ReportsUpstreamErrorBody) {
+    HttpServer upstream(0);
+    upstream.addRoute("POST", "/v1/messages", [](const HttpRequest&) {
+        HttpResponse response;
+        response.status_code = 400;
+        response.headers["Content-Type"] = "application/json";
+        response.body = R"({"type":"error","error":{"type":"invalid_request_error","message":"bad model"}})";
+        return response;
+    });
+    ASSERT_TRUE(upstream.start());
+
+    config.provider = "anthropic";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream.getPort()) + "/v1/messages";
+    auto client = LLMClient::createClient(config);
+
+    bool called = false;
+    LLMResponse response = client->streamChatCompletion({{"user", "hi"}}, [&](const std::string&) {
+        called = true;
+        return true;
+    });
+
+    EXPECT_FALSE(response.success);
+    EXPECT_FALSE(called);
+    EXPECT_EQ(response.status_code, 400);
+    EXPECT_EQ(response.error_message, "bad model");
+}
+
+TEST(LLMClientAsyncTest, OverlapsRequestsOnOneTransferThread) {
+    ServerConfig upstream_config;
+    upstream_config.worker_threads = 8;
+    HttpServer upstream(0, upstream_config);
+    upstream.addRoute("POST", "/v1/chat/completions", [](const HttpRequest& request) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        std::string content = nlohmann::json::parse(request.body)["messages"].back()["content"];
+        HttpResponse response;
+        response.headers["Content-Type"] = "application/json";
+        response.body = nlohmann::json({{"choices", {{{"message", {{"content", "re: " + content}}}}}}}).dump();
+        return response;
+    });
+    ASSERT_TRUE(upstream.start());
+
+    LLMConfig config;
+    config.provider = "openai";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream.getPort()) + "/v1/chat/completions";
+    auto client = LLMClient::createClient(config);
+
+    // Eight 300ms upstream calls overlap instead of taking 2.4s in turn
+    constexpr int REQUESTS = 8;
+    std::vector<std::promise<LLMResponse>> results(REQUESTS);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REQUESTS; ++i) {
+        client->chatCompletionAsync({{"user", "message " + std::to_string(i)}},
+                                    [&results, i](LLMResponse response) { results[i].set_value(std::move(response)); });
+    }
+    for (int i = 0; i < REQUESTS; ++i) {
+        LLMResponse response = results[i].get_future().get();
+        EXPECT_TRUE(response.success) << response.error_message;
+        EXPECT_EQ(response.content, "re: message " + std::to_string(i));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1500));
+}
+
+TEST(LLMClientAsyncTest, FailsPendingRequestsWhenDestroyed) {
+    HttpServer upstream(0);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> arrived;
+    upstream.addRoute("POST", "/v1/chat/completions", [&arrived, released](const HttpRequest&) {
+        arrived.set_value();
+        released.wait();
+        return HttpResponse();
+    });
+    ASSERT_TRUE(upstream.start());
+
+    LLMConfig config;
+    config.provider = "openai";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream.getPort()) + "/v1/chat/completions";
+    auto client = LLMClient::createClient(config);
+
+    std::promise<LLMResponse> result;
+    client->chatCompletionAsync({{"user", "hi"}}, [&result](LLMResponse response) {
+        result.set_value(std::move(response));
+    });
+    arrived.get_future().wait();
+    client.reset();
+
+    auto future = result.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    LLMResponse response = future.get();
+    EXPECT_FALSE(response.success);
+    EXPECT_NE(response.error_message.find("cancelled"), std::string::npos);
+    release.set_value();
+
+    // An unreachable endpoint reports the connection failure
+    config.api_endpoint = "http://127.0.0.1:1/v1/chat/completions";
+    client = LLMClient::createClient(config);
+    std::promise<LLMResponse> refused;
+    client->chatCompletionAsync({{"user", "hi"}}, [&refused](LLMResponse response) {
+        refused.set_value(std::move(response));
+    });
+    response = refused.get_future().get();
+    EXPECT_FALSE(response.success);
+    EXPECT_FALSE(response.error_message.empty());
+}
+
+TEST(LLMClientAsyncTest, StreamsOnTheTransferThread) {
+    // Each stream holds back its end until both have delivered a token,
+    // so they only finish if they are read at the same time
+    ServerConfig upstream_config;
+    upstream_config.worker_threads = 4;
+    HttpServer upstream(0, upstream_config);
+    std::atomic<int> first_tokens{0};
+    upstream.addRoute("POST", "/v1/chat/completions", [&first_tokens](const HttpRequest&) {
+        HttpResponse response;
+        response.headers["Content-Type"] = "text/event-stream";
+        response.stream = [&first_tokens](const StreamWriter& write) {
+            write("data: {\"choices\":[{\"delta\":{\"content\":\"Hello\"}}]}\n\n");
+            for (int i = 0; i < 500 && first_tokens < 2; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            write("data: {\"choices\":[{\"delta\":{\"content\":\", world\"}}]}\n\n");
+            write("data: [DONE]\n\n");
+        };
+        return response;
+    });
+    ASSERT_TRUE(upstream.start());
+
+    LLMConfig config;
+    config.provider = "openai";
+    config.api_endpoint = "http://127.0.0.1:" + std::to_string(upstream.getPort()) + "/v1/chat/completions";
+    auto client = LLMClient::createClient(config);
+
+    std::vector<std::promise<LLMResponse>> results(2);
+    std::vector<std::vector<std::string>> deltas(2);
+    for (int i = 0; i < 2; ++i) {
+        client->streamChatCompletionAsync({{"user", "hi"}},
+            [&, i](const std::string& delta) {
+                deltas[i].push_back(delta);
+                if (deltas[i].size() == 1) {
+                    ++first_tokens;
+                }
+                return true;
+            },
+            [&results, i](LLMResponse response) { results[i].set_value(std::move(response)); });
+    }
+    for (int i = 0; i < 2; ++i) {
+        LLMResponse response = results[i].get_future().get();
+        EXPECT_TRUE(response.success) << response.error_message;
+        EXPECT_EQ(response.content, "Hello, world");
+        EXPECT_EQ(deltas[i], (std::vector<std::string>{"Hello", ", world"}));
+    }
+
+    // Declining a delta cancels the stream
+    std::promise<LLMResponse> declined;
+    client->streamChatCompletionAsync({{"user", "hi"}}, [](const std::string&) { return false; },
+        [&declined](LLMResponse response) { declined.set_value(std::move(response)); });
+    LLMResponse response = declined.get_future().get();
+    EXPECT_FALSE(response.success);
+    EXPECT_TRUE(response.cancelled);
+    EXPECT_EQ(response.content, "Hello");
+}
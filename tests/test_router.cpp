@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "web/router.h"
+
+using namespace AITextAssistant;
+
+namespace {
+
+HttpHandler respondWith(const std::string& body) {
+    return [body](const HttpRequest&) {
+        HttpResponse response;
+        response.body = body;
+        return response;
+    };
+}
+
+} // namespace
+
+class RouterTest : public ::testing::Test {
+protected:
+    // Body of the matched handler's response, or "" when nothing matched.
+    // Captured values view `path`, so it must outlive `params`.
+    std::string dispatch(std::string_view method, std::string_view path) {
+        const Route* route = router.match(method, path, params);
+        return route && route->handler ? route->handler(HttpRequest()).body : "";
+    }
+
+    Router router;
+    PathParams params;
+};
+
+TEST_F(RouterTest, MatchesLiteralRoutesByMethod) {
+    ASSERT_TRUE(router.add("GET", "/api/conversations", respondWith("list")));
+    ASSERT_TRUE(router.add("DELETE", "/api/conversations", respondWith("delete")));
+    ASSERT_TRUE(router.add("GET", "/", respondWith("root")));
+
+    EXPECT_EQ(dispatch("GET", "/api/conversations"), "list");
+    EXPECT_EQ(dispatch("DELETE", "/api/conversations"), "delete");
+    EXPECT_EQ(dispatch("GET", "/"), "root");
+    EXPECT_EQ(dispatch("POST", "/api/conversations"), "");
+    EXPECT_EQ(dispatch("GET", "/api/conversations/"), "");
+    EXPECT_EQ(dispatch("GET", "/api"), "");
+    EXPECT_EQ(dispatch("BREW", "/"), "");
+}
+
+TEST_F(RouterTest, CapturesPathParameters) {
+    ASSERT_TRUE(router.add("GET", "/api/conversations/{id}/messages", respondWith("messages")));
+    ASSERT_TRUE(router.add("GET", "/api/users/{user}/conversations/{id}", respondWith("nested")));
+
+    EXPECT_EQ(dispatch("GET", "/api/conversations/7f3a-9c/messages"), "messages");
+    EXPECT_EQ(params.count, 1u);
+    EXPECT_EQ(params.get("id"), "7f3a-9c");
+
+    EXPECT_EQ(dispatch("GET", "/api/users/alice/conversations/42"), "nested");
+    EXPECT_EQ(params.get("user"), "alice");
+    EXPECT_EQ(params.get("id"), "42");
+    EXPECT_EQ(params.get("missing"), "");
+
+    // A parameter never matches an empty segment
+    EXPECT_EQ(dispatch("GET", "/api/conversations//messages"), "");
+    EXPECT_EQ(params.count, 0u);
+}
+
+TEST_F(RouterTest, PrefersLiteralsAndBacktracksToParameters) {
+    ASSERT_TRUE(router.add("GET", "/api/conversations/messages", respondWith("legacy")));
+    ASSERT_TRUE(router.add("GET", "/api/conversations/{id}", respondWith("get")));
+    ASSERT_TRUE(router.add("DELETE", "/api/conversations/{id}", respondWith("delete")));
+
+    EXPECT_EQ(dispatch("GET", "/api/conversations/messages"), "legacy");
+    EXPECT_EQ(params.count, 0u);
+    EXPECT_EQ(dispatch("GET", "/api/conversations/abc"), "get");
+
+    // The literal branch has no DELETE handler, so the parameter route answers
+    EXPECT_EQ(dispatch("DELETE", "/api/conversations/messages"), "delete");
+    EXPECT_EQ(params.get("id"), "messages");
+}
+
+TEST_F(RouterTest, RejectsInvalidPatterns) {
+    EXPECT_FALSE(router.add("GET", "relative", respondWith("x")));
+    EXPECT_FALSE(router.add("BREW", "/coffee", respondWith("x")));
+    EXPECT_FALSE(router.add("GET", "/a/{}", respondWith("x")));
+
+    ASSERT_TRUE(router.add("GET", "/a/{id}", respondWith("x")));
+    EXPECT_FALSE(router.add("GET", "/a/{name}/b", respondWith("x")));
+
+    // Re-registering replaces the handler
+    ASSERT_TRUE(router.add("GET", "/a/{id}", respondWith("y")));
+    EXPECT_EQ(dispatch("GET", "/a/1"), "y");
+}
+
+TEST_F(RouterTest, HoldsAsyncHandlersAlongsideSynchronousOnes) {
+    ASSERT_TRUE(router.add("POST", "/api/chat", AsyncHttpHandler([](const HttpRequest&, HttpResponder respond) {
+        HttpResponse response;
+        response.body = "later";
+        respond(std::move(response));
+    })));
+    ASSERT_TRUE(router.add("GET", "/api/chat", respondWith("sync")));
+
+    const Route* route = router.match("POST", "/api/chat", params);
+    ASSERT_NE(route, nullptr);
+    EXPECT_FALSE(route->handler);
+    ASSERT_TRUE(route->async_handler);
+    std::string body;
+    route->async_handler(HttpRequest(), [&body](HttpResponse response) { body = response.body; });
+    EXPECT_EQ(body, "later");
+    EXPECT_EQ(dispatch("GET", "/api/chat"), "sync");
+
+    // Replacing an async route with a synchronous one clears the former
+    ASSERT_TRUE(router.add("POST", "/api/chat", respondWith("now")));
+    route = router.match("POST", "/api/chat", params);
+    ASSERT_NE(route, nullptr);
+    EXPECT_FALSE(route->async_handler);
+    EXPECT_EQ(dispatch("POST", "/api/chat"), "now");
+}
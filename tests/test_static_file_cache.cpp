@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "web/static_file_cache.h"
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace AITextAssistant;
+
+class StaticFileCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() /
+                    ("static_cache_test_" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::string writeFile(const std::string& name, const std::string& content) {
+        std::string path = (directory / name).string();
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+        return path;
+    }
+
+    std::filesystem::path directory;
+};
+
+TEST_F(StaticFileCacheTest, CachesFileWithValidatorsAndHeaderBlock) {
+    StaticFileCache cache;
+    std::string path = writeFile("index.html", "<h1>hi</h1>");
+
+    auto asset = cache.get(path);
+    ASSERT_NE(asset, nullptr);
+    EXPECT_EQ(asset->body, "<h1>hi</h1>");
+    EXPECT_EQ(asset->content_type, "text/html");
+    EXPECT_EQ(asset->etag.front(), '"');
+    EXPECT_EQ(asset->etag.back(), '"');
+    EXPECT_NE(asset->last_modified.find(" GMT"), std::string::npos);
+    EXPECT_NE(asset->header_block.find("ETag: " + asset->etag + "\r\n"), std::string::npos);
+    EXPECT_NE(asset->header_block.find("Content-Type: text/html\r\n"), std::string::npos);
+    EXPECT_EQ(asset->validator_block.find("Content-Type"), std::string::npos);
+
+    // Second lookup is served from memory
+    EXPECT_EQ(cache.get(path), asset);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.totalBytes(), asset->body.size());
+}
+
+TEST_F(StaticFileCacheTest, ReloadsChangedAndDropsDeletedFiles) {
+    StaticFileCache cache(1024 * 1024, 64 * 1024 * 1024, std::chrono::milliseconds(0));
+    std::string path = writeFile("app.js", "var a = 1;");
+
+    auto first = cache.get(path);
+    ASSERT_NE(first, nullptr);
+
+    writeFile("app.js", "var a = 2; // changed");
+    auto second = cache.get(path);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second->body, "var a = 2; // changed");
+    EXPECT_NE(second->etag, first->etag);
+    // Holders of the old asset keep a consistent copy
+    EXPECT_EQ(first->body, "var a = 1;");
+
+    std::filesystem::remove(path);
+    EXPECT_EQ(cache.get(path), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.totalBytes(), 0u);
+}
+
+TEST_F(StaticFileCacheTest, KeepsOnlyMetadataForLargeFiles) {
+    StaticFileCache cache(8);
+    std::string path = writeFile("big.txt", std::string(64, 'x'));
+
+    auto asset = cache.get(path);
+    ASSERT_NE(asset, nullptr);
+    EXPECT_FALSE(asset->in_memory);
+    EXPECT_TRUE(asset->body.empty());
+    EXPECT_EQ(asset->size, 64u);
+    EXPECT_FALSE(asset->etag.empty());
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.totalBytes(), 0u);
+
+    // Over the total budget: loaded for this caller but not retained
+    StaticFileCache small_budget(1024, 16);
+    auto loaded = small_budget.get(path);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->body.size(), 64u);
+    EXPECT_EQ(small_budget.size(), 0u);
+
+    EXPECT_EQ(cache.get((directory / "missing.txt").string()), nullptr);
+    EXPECT_EQ(cache.get(directory.string()), nullptr);
+}
+
+TEST_F(StaticFileCacheTest, BuildsCompressedVariantsOnce) {
+    StaticFileCache cache;
+    std::string page;
+    for (int i = 0; i < 200; ++i) {
+        page += "<p>repeated paragraph text</p>\n";
+    }
+    std::string path = writeFile("page.html", page);
+
+    auto asset = cache.get(path);
+    ASSERT_NE(asset, nullptr);
+    EXPECT_TRUE(asset->compressible);
+    EXPECT_NE(asset->header_block.find("Vary: Accept-Encoding\r\n"), std::string::npos);
+
+    auto gzip = cache.getVariant(asset, path, ContentEncoding::GZIP);
+    ASSERT_NE(gzip, nullptr);
+    EXPECT_LT(gzip->body.size(), page.size());
+    EXPECT_NE(gzip->etag, asset->etag);
+    EXPECT_NE(gzip->header_block.find("Content-Encoding: gzip\r\n"), std::string::npos);
+    EXPECT_EQ(cache.getVariant(asset, path, ContentEncoding::GZIP), gzip);
+
+    // Tiny or binary files are served as they are
+    std::string tiny = writeFile("tiny.html", "x");
+    EXPECT_EQ(cache.getVariant(cache.get(tiny), tiny, ContentEncoding::GZIP), nullptr);
+    std::string image = writeFile("logo.png", page);
+    EXPECT_EQ(cache.getVariant(cache.get(image), image, ContentEncoding::GZIP), nullptr);
+}
+
+TEST_F(StaticFileCacheTest, PrefersFreshPrecompressedSibling) {
+    StaticFileCache cache;
+    std::string path = writeFile("app.js", std::string(4096, 'a'));
+    writeFile("app.js.gz", "precompressed-bytes");
+
+    auto asset = cache.get(path);
+    auto gzip = cache.getVariant(asset, path, ContentEncoding::GZIP);
+    ASSERT_NE(gzip, nullptr);
+    EXPECT_EQ(gzip->body, "precompressed-bytes");
+}
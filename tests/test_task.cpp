@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "utils/mailbox.h"
+#include "utils/task.h"
+#include "utils/thread_pool.h"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace AITextAssistant;
+
+namespace {
+
+Task<int> answer(bool& started) {
+    started = true;
+    co_return 42;
+}
+
+Task<std::string> describe(bool& started) {
+    int value = co_await answer(started);
+    co_return "value " + std::to_string(value);
+}
+
+Task<int> fail() {
+    throw std::runtime_error("boom");
+    co_return 0;
+}
+
+Task<std::thread::id> threadAfterResumeOn(ThreadPool& pool) {
+    co_await resumeOn(pool);
+    co_return std::this_thread::get_id();
+}
+
+// Records the start and end of its turn, awaiting a pool hop in between
+Task<int> recordTurn(Mailbox& mailbox, ThreadPool& pool, std::mutex& mutex, std::vector<std::string>& log, int id) {
+    Mailbox::Turn turn = co_await mailbox.enter(pool);
+    if (!turn) {
+        co_return -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        log.push_back("start " + std::to_string(id));
+    }
+    co_await resumeOn(pool);
+    std::lock_guard<std::mutex> lock(mutex);
+    log.push_back("end " + std::to_string(id));
+    co_return id;
+}
+
+} // namespace
+
+TEST(TaskTest, StartsWhenAwaitedAndChainsResults) {
+    bool started = false;
+    Task<std::string> task = describe(started);
+    EXPECT_FALSE(started);
+
+    std::optional<std::string> result;
+    spawn(std::move(task), [&](std::string value) { result = std::move(value); });
+    EXPECT_TRUE(started);
+    EXPECT_EQ(result, "value 42");
+}
+
+TEST(TaskTest, DropsTheCompletionWhenTheTaskThrows) {
+    bool called = false;
+    auto destroyed = std::make_shared<int>(0);
+    std::weak_ptr<int> watch = destroyed;
+    spawn(fail(), [&called, destroyed = std::move(destroyed)](int) { called = true; });
+
+    EXPECT_FALSE(called);
+    EXPECT_TRUE(watch.expired());
+}
+
+TEST(TaskTest, SurvivesACompletionThatThrows) {
+    bool called = false;
+    spawn(describe(called), [](std::string) { throw std::runtime_error("callback failed"); });
+    EXPECT_TRUE(called);
+
+    Task<void> done = []() -> Task<void> { co_return; }();
+    spawn(std::move(done), []() { throw std::runtime_error("callback failed"); });
+}
+
+TEST(TaskTest, ResumesOnThePoolAndInlineOnceItIsStopped) {
+    ThreadPool pool(1, 8);
+    std::promise<std::thread::id> on_pool;
+    spawn(threadAfterResumeOn(pool), [&](std::thread::id id) { on_pool.set_value(id); });
+    EXPECT_NE(on_pool.get_future().get(), std::this_thread::get_id());
+
+    pool.drain();
+    std::optional<std::thread::id> inline_id;
+    spawn(threadAfterResumeOn(pool), [&](std::thread::id id) { inline_id = id; });
+    EXPECT_EQ(inline_id, std::this_thread::get_id());
+}
+
+TEST(TaskTest, AwaitCallbackContinuesWhereTheCallbackRuns) {
+    std::function<void(int)> deliver;
+    auto waiting = [&deliver]() -> Task<int> {
+        int value = co_await awaitCallback<int>([&deliver](std::function<void(int)> done) {
+            deliver = std::move(done);
+        });
+        co_return value * 2;
+    };
+
+    std::optional<int> result;
+    spawn(waiting(), [&](int value) { result = value; });
+    ASSERT_TRUE(deliver);
+    EXPECT_FALSE(result);
+
+    std::thread([&deliver]() { deliver(21); }).join();
+    EXPECT_EQ(result, 42);
+}
+
+TEST(ThreadPoolTest, DrainRunsQueuedTasksAndRefusesNewOnes) {
+    ThreadPool pool(1, 16);
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::atomic<int> ran{0};
+
+    ASSERT_TRUE(pool.trySubmit([gate]() { gate.wait(); }));
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(pool.trySubmit([&ran]() { ++ran; }));
+    }
+
+    std::thread drainer([&pool]() { pool.drain(); });
+    release.set_value();
+    drainer.join();
+
+    EXPECT_EQ(ran.load(), 5);
+    EXPECT_FALSE(pool.trySubmit([&ran]() { ++ran; }));
+}
+
+TEST(MailboxTest, RunsTurnsOneAtATimeInArrivalOrder) {
+    ThreadPool pool(4, 64);
+    Mailbox mailbox(16);
+    std::mutex mutex;
+    std::vector<std::string> log;
+    std::vector<std::promise<int>> done(6);
+
+    for (int i = 0; i < 6; ++i) {
+        spawn(recordTurn(mailbox, pool, mutex, log, i), [&done, i](int id) { done[i].set_value(id); });
+    }
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(done[i].get_future().get(), i);
+    }
+
+    std::vector<std::string> expected;
+    for (int i = 0; i < 6; ++i) {
+        expected.push_back("start " + std::to_string(i));
+        expected.push_back("end " + std::to_string(i));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(log, expected);
+    EXPECT_EQ(mailbox.depth(), 0u);
+}
+
+TEST(MailboxTest, RefusesEntryPastCapacity) {
+    ThreadPool pool(1, 8);
+    Mailbox mailbox(2);
+    std::mutex mutex;
+    std::vector<std::string> log;
+
+    Mailbox::Turn first = mailbox.enterBlocking();
+    ASSERT_TRUE(first);
+    std::promise<int> queued;
+    spawn(recordTurn(mailbox, pool, mutex, log, 1), [&queued](int id) { queued.set_value(id); });
+    EXPECT_EQ(mailbox.depth(), 2u);
+
+    EXPECT_FALSE(mailbox.enterBlocking());
+    std::optional<int> refused;
+    spawn(recordTurn(mailbox, pool, mutex, log, 2), [&refused](int id) { refused = id; });
+    EXPECT_EQ(refused, -1);
+
+    first.end();
+    EXPECT_EQ(queued.get_future().get(), 1);
+    EXPECT_EQ(mailbox.depth(), 0u);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "web/timer_wheel.h"
+#include <string>
+#include <vector>
+
+using namespace AITextAssistant;
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    using ms = std::chrono::milliseconds;
+
+    // Advance to `offset` after the wheel's start
+    size_t advanceTo(ms offset) {
+        return wheel.advance(start + offset);
+    }
+
+    TimerWheel::Clock::time_point start = TimerWheel::Clock::now();
+    TimerWheel wheel{ms(10), start};
+    std::vector<std::string> fired;
+};
+
+TEST_F(TimerWheelTest, FiresEntriesInDeadlineOrder) {
+    TimerWheel::Entry late([this]() { fired.push_back("late"); });
+    TimerWheel::Entry early([this]() { fired.push_back("early"); });
+    wheel.schedule(late, ms(50));
+    wheel.schedule(early, ms(20));
+    EXPECT_EQ(wheel.size(), 2u);
+
+    EXPECT_EQ(advanceTo(ms(10)), 0u);
+    EXPECT_EQ(advanceTo(ms(30)), 1u);
+    EXPECT_EQ(advanceTo(ms(100)), 1u);
+    EXPECT_EQ(fired, (std::vector<std::string>{"early", "late"}));
+    EXPECT_FALSE(late.isScheduled());
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST_F(TimerWheelTest, CancelAndRescheduleReplaceTheDeadline) {
+    TimerWheel::Entry entry([this]() { fired.push_back("entry"); });
+    wheel.schedule(entry, ms(20));
+    wheel.cancel(entry);
+    EXPECT_EQ(advanceTo(ms(50)), 0u);
+
+    wheel.schedule(entry, ms(20));
+    wheel.schedule(entry, ms(200));
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_EQ(advanceTo(ms(190)), 0u);
+    EXPECT_EQ(advanceTo(ms(300)), 1u);
+
+    // Destroying a scheduled entry unlinks it
+    {
+        TimerWheel::Entry scoped([this]() { fired.push_back("scoped"); });
+        wheel.schedule(scoped, ms(10));
+    }
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(advanceTo(ms(400)), 0u);
+    EXPECT_EQ(fired, std::vector<std::string>{"entry"});
+}
+
+TEST_F(TimerWheelTest, CascadesLongDeadlinesFromUpperLevels) {
+    // 10 ms ticks: these land on levels 1, 2 and 3
+    TimerWheel::Entry minute([this]() { fired.push_back("minute"); });
+    TimerWheel::Entry hour([this]() { fired.push_back("hour"); });
+    TimerWheel::Entry day([this]() { fired.push_back("day"); });
+    wheel.schedule(day, std::chrono::hours(24));
+    wheel.schedule(hour, std::chrono::hours(1));
+    wheel.schedule(minute, std::chrono::minutes(1));
+
+    EXPECT_EQ(advanceTo(std::chrono::seconds(59)), 0u);
+    EXPECT_EQ(advanceTo(std::chrono::seconds(61)), 1u);
+    EXPECT_EQ(advanceTo(std::chrono::minutes(59)), 0u);
+    EXPECT_EQ(advanceTo(std::chrono::minutes(61)), 1u);
+    EXPECT_EQ(advanceTo(std::chrono::hours(23)), 0u);
+    EXPECT_EQ(advanceTo(std::chrono::hours(25)), 1u);
+    EXPECT_EQ(fired, (std::vector<std::string>{"minute", "hour", "day"}));
+}
+
+TEST_F(TimerWheelTest, CallbacksMayRearmThemselves) {
+    TimerWheel::Entry entry;
+    int count = 0;
+    entry.setCallback([&]() {
+        if (++count < 3) {
+            wheel.schedule(entry, ms(0));
+        }
+    });
+    wheel.schedule(entry, ms(0));
+
+    // A zero-delay re-arm runs on the next tick, not in the same pass
+    EXPECT_EQ(advanceTo(ms(0)), 1u);
+    EXPECT_EQ(advanceTo(ms(10)), 1u);
+    EXPECT_EQ(advanceTo(ms(20)), 1u);
+    EXPECT_EQ(advanceTo(ms(100)), 0u);
+    EXPECT_EQ(count, 3);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "web/websocket.h"
+#include <string>
+
+using namespace AITextAssistant;
+
+namespace {
+
+// A client frame: masked, as the protocol requires
+std::string clientFrame(uint8_t first_byte, const std::string& payload) {
+    const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    std::string frame;
+    frame.push_back(static_cast<char>(first_byte));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(0x80 | payload.size()));
+    } else {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    }
+    frame.append(reinterpret_cast<const char*>(mask), 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame.push_back(static_cast<char>(payload[i] ^ mask[i & 3]));
+    }
+    return frame;
+}
+
+} // namespace
+
+TEST(WebSocketTest, ComputesHandshakeAccept) {
+    // Example from RFC 6455 section 1.3
+    EXPECT_EQ(webSocketAccept("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocketTest, EncodesServerFrames) {
+    EXPECT_EQ(encodeWebSocketFrame(WebSocketOpcode::TEXT, "Hello"), std::string("\x81\x05Hello"));
+
+    std::string medium = encodeWebSocketFrame(WebSocketOpcode::BINARY, std::string(300, 'x'));
+    ASSERT_EQ(medium.size(), 304u);
+    EXPECT_EQ(medium.substr(0, 4), std::string("\x82\x7E\x01\x2C", 4));
+
+    std::string large = encodeWebSocketFrame(WebSocketOpcode::BINARY, std::string(70000, 'x'));
+    ASSERT_EQ(large.size(), 70010u);
+    EXPECT_EQ(large.substr(0, 10), std::string("\x82\x7F\x00\x00\x00\x00\x00\x01\x11\x70", 10));
+}
+
+TEST(WebSocketTest, ParsesMaskedFramesIncrementally) {
+    WebSocketFrameParser parser(1024);
+    std::string data = clientFrame(0x01, "Hel") + clientFrame(0x80, "lo") + clientFrame(0x89, "ping");
+
+    WebSocketFrameParser::Frame frame;
+    size_t offset = 0;
+    std::string partial = data.substr(0, 5);
+    EXPECT_EQ(parser.parse(partial, offset, frame), WebSocketFrameParser::Result::INCOMPLETE);
+    EXPECT_EQ(offset, 0u);
+
+    ASSERT_EQ(parser.parse(data, offset, frame), WebSocketFrameParser::Result::FRAME);
+    EXPECT_EQ(frame.opcode, WebSocketOpcode::TEXT);
+    EXPECT_FALSE(frame.fin);
+    EXPECT_EQ(frame.payload, "Hel");
+
+    ASSERT_EQ(parser.parse(data, offset, frame), WebSocketFrameParser::Result::FRAME);
+    EXPECT_EQ(frame.opcode, WebSocketOpcode::CONTINUATION);
+    EXPECT_TRUE(frame.fin);
+    EXPECT_EQ(frame.payload, "lo");
+
+    ASSERT_EQ(parser.parse(data, offset, frame), WebSocketFrameParser::Result::FRAME);
+    EXPECT_EQ(frame.opcode, WebSocketOpcode::PING);
+    EXPECT_EQ(frame.payload, "ping");
+    EXPECT_EQ(offset, data.size());
+
+    std::string medium = clientFrame(0x82, std::string(500, 'z'));
+    offset = 0;
+    ASSERT_EQ(parser.parse(medium, offset, frame), WebSocketFrameParser::Result::FRAME);
+    EXPECT_EQ(frame.payload, std::string(500, 'z'));
+}
+
+TEST(WebSocketTest, RejectsInvalidFrames) {
+    auto status = [](const std::string& data, size_t limit = 1024) {
+        WebSocketFrameParser parser(limit);
+        WebSocketFrameParser::Frame frame;
+        size_t offset = 0;
+        EXPECT_EQ(parser.parse(data, offset, frame), WebSocketFrameParser::Result::ERROR);
+        return parser.getErrorStatus();
+    };
+
+    // Unmasked, reserved bit, reserved opcode, fragmented and oversized control
+    EXPECT_EQ(status(std::string("\x81\x02hi", 4)), WebSocketStatus::PROTOCOL_ERROR);
+    EXPECT_EQ(status(clientFrame(0xC1, "hi")), WebSocketStatus::PROTOCOL_ERROR);
+    EXPECT_EQ(status(clientFrame(0x83, "hi")), WebSocketStatus::PROTOCOL_ERROR);
+    EXPECT_EQ(status(clientFrame(0x09, "hi")), WebSocketStatus::PROTOCOL_ERROR);
+    EXPECT_EQ(status(clientFrame(0x89, std::string(126, 'x'))), WebSocketStatus::PROTOCOL_ERROR);
+
+    // The size check needs only the header
+    std::string big = clientFrame(0x81, std::string(2000, 'x')).substr(0, 8);
+    EXPECT_EQ(status(big), WebSocketStatus::MESSAGE_TOO_BIG);
+}
+
+TEST(WebSocketTest, ValidatesUtf8) {
+    EXPECT_TRUE(isValidUtf8("plain ascii"));
+    EXPECT_TRUE(isValidUtf8("\xE4\xBD\xA0\xE5\xA5\xBD"));
+    EXPECT_TRUE(isValidUtf8("\xF0\x9F\x98\x80"));
+    EXPECT_FALSE(isValidUtf8("\xE4\xBD"));        // truncated
+    EXPECT_FALSE(isValidUtf8("\xC0\xAF"));        // overlong
+    EXPECT_FALSE(isValidUtf8("\xED\xA0\x80"));    // surrogate
+    EXPECT_FALSE(isValidUtf8("\xF4\x90\x80\x80")); // past U+10FFFF
+}